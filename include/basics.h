@@ -29,6 +29,9 @@
 #include <iostream>             // C++ headers
 #include <iomanip>
 #include <string>
+#include <string_view>
+#include <charconv>
+#include <memory>
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -38,10 +41,15 @@
 #include <map>
 #include <unordered_map>
 #include <algorithm>
+#include <functional>
 #include <thread>
 #include <ctime>
 #include <chrono>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cmath>
+#include <climits>
 
 
 
@@ -62,6 +70,8 @@
 
 #define CLOSE(s)        closesocket(s)
 #define POLL(ps, len)   WSAPoll(ps, len, -1)
+#define POLL_TIMEOUT(ps, len, ms)   WSAPoll(ps, len, ms)
+#define MSG_NOSIGNAL    0               // no SIGPIPE to worry about here
 
 #else
 #include <sys/socket.h>
@@ -69,6 +79,7 @@
 #include <sys/ioctl.h>
 #include <sys/time.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <netdb.h>
@@ -76,6 +87,7 @@
 
 #define CLOSE(s)        close(s)
 #define POLL(ps, len)   poll(ps, len, -1)
+#define POLL_TIMEOUT(ps, len, ms)   poll(ps, len, ms)
 #endif 
 
 
@@ -0,0 +1,136 @@
+/**
+ * @file db-pool.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief A pool of ODBC connections handed out on RAII leases, so threads that
+ *  need the database each get a connection, and statement handles, of their
+ *  own rather than take turns on one.
+ * @version 0.1
+ * @date 2024-03-23
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef DB_POOL_H
+#define DB_POOL_H
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "iQE.h"
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define DB_POOL_SIZE            4           // connections when the config has none
+#define DB_POOL_WAIT            5000        // ms to wait on a connection by default
+
+
+
+
+
+//===============================================================================|
+//          TYPES
+//===============================================================================|
+/**
+ * @brief A connection of the pool; one statement for direct queries and the
+ *  statements prepared on it so far, by their text.
+ */
+typedef struct DB_CONN
+{
+    HDBC hdbc{nullptr};
+    HSTMT hstmt{nullptr};
+    std::unordered_map<std::string, HSTMT> prepared;
+} Db_Conn, *Db_Conn_Ptr;
+
+
+
+class DbPool;
+
+
+
+
+
+//===============================================================================|
+//          CLASS
+//===============================================================================|
+/**
+ * @brief A connection borrowed from the pool for as long as the lease is kept
+ *  in scope; it goes back on its own when the lease does. A lease that came
+ *  back empty handed tests false.
+ *
+ */
+class DbLease
+{
+public:
+
+    DbLease() : ppool{nullptr}, pconn{nullptr} {}
+    DbLease(DbPool *ppool, Db_Conn_Ptr pconn) : ppool{ppool}, pconn{pconn} {}
+    ~DbLease();
+
+    DbLease(DbLease &&lease);
+    DbLease &operator=(DbLease &&lease);
+    DbLease(const DbLease &) = delete;
+    DbLease &operator=(const DbLease &) = delete;
+
+    explicit operator bool() const { return pconn != nullptr; }
+
+    HDBC Get_Dbc() const { return pconn->hdbc; }
+    HSTMT Get_Stmt() const { return pconn->hstmt; }
+    HSTMT Prepare(const char *sql);
+    void Release();
+
+private:
+
+    DbPool *ppool;
+    Db_Conn_Ptr pconn;
+};
+
+
+
+/**
+ * @brief Every connection is made up front by Open, under one environment.
+ *  Acquire hands out an idle one, waiting a while for one to come back if
+ *  they're all out. A statement prepared through a lease stays prepared on its
+ *  connection, so the next lease of that connection finds it ready.
+ *
+ */
+class DbPool
+{
+public:
+
+    DbPool();
+    ~DbPool();
+
+    DbPool(const DbPool &) = delete;
+    DbPool &operator=(const DbPool &) = delete;
+
+    int Open(const std::string &con_str, const u32 size = DB_POOL_SIZE);
+    void Close();
+
+    DbLease Acquire(const u32 timeout_ms = DB_POOL_WAIT);
+    size_t Get_Size() const { return conns.size(); }
+    size_t Get_Idle() const;
+
+private:
+
+    friend class DbLease;
+    void Release(Db_Conn_Ptr pconn);
+    static void Free_Conn(Db_Conn &conn);
+
+    HENV henv;
+    std::vector<Db_Conn> conns;     // sized once by Open; never moves after
+    std::vector<Db_Conn_Ptr> idle;
+
+    mutable std::mutex pool_mutex;  // guards idle
+    std::condition_variable returned;
+};
+
+
+#endif
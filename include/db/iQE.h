@@ -25,7 +25,8 @@
 //          DEFINES
 //=====================================================================================|
 #define DB_ERR_BUFFER_SIZE        1024       /* maximum limit for ODBC buffer size */
-#define DB_BULK_FETCH_SIZE        50         /* amout to fetch in chunks */
+#define DB_BULK_FETCH_SIZE        256        /* rows to fetch with a single call */
+#define DB_BULK_INSERT_SIZE       1000       /* rows sent with a single execute; committed together */
 
 
 
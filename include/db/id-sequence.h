@@ -0,0 +1,80 @@
+/**
+ * @file id-sequence.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Hands out the ids kept in WSISApp.dbo.AutoIncrementFields from blocks
+ *  reserved in one go, rather than reading and bumping the table for each.
+ * @version 0.1
+ * @date 2024-03-25
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef ID_SEQUENCE_H
+#define ID_SEQUENCE_H
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "db-pool.h"
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define ID_BLOCK_SIZE           10000       // ids reserved per round trip by default
+
+
+
+
+
+//===============================================================================|
+//          CLASS
+//===============================================================================|
+/**
+ * @brief A block is reserved by moving LastValue up by the size of the block
+ *  with a single UPDATE ... OUTPUT, which the server runs atomically; so other
+ *  instances, or anything else counting on the table, start past it and never
+ *  hand out the same ids. The block being handed out is kept packed into one
+ *  atomic word, the next id in the low half and the end in the high, and taking
+ *  an id is but a compare and swap on it. Only the thread that finds the block
+ *  used up goes to the database, while the rest wait on it for the next one.
+ *
+ * Blocks are reserved on a pooled connection, never on the caller's, since the
+ *  callers are often in the middle of a fetch. Ids left over when the app quits
+ *  are lost, which leaves gaps, never duplicates.
+ *
+ */
+class IdSequence
+{
+public:
+
+    IdSequence(const char *name, const u32 block_size = ID_BLOCK_SIZE);
+
+    IdSequence(const IdSequence &) = delete;
+    IdSequence &operator=(const IdSequence &) = delete;
+
+    void Set_Pool(DbPool *ppool);
+    int Next(u32 &id);
+    int Peek(u32 &id);
+    u64 Get_Blocks() const { return blocks; }
+
+private:
+
+    int Refill(const u64 seen);
+
+    std::string name;
+    u32 block_size;
+    DbPool *ppool;
+    std::atomic<u64> state;         // end << 32 | next; empty when next == end
+    std::atomic<u64> blocks;        // blocks reserved so far
+    std::mutex refill_mutex;        // one reservation at a time
+};
+
+
+#endif
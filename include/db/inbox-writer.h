@@ -0,0 +1,108 @@
+/**
+ * @file inbox-writer.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Stores the messages sent to us in SmsIn behind the backs of the SMSC
+ *  handlers that take them in; they never wait on the database.
+ * @version 0.1
+ * @date 2024-03-28
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef INBOX_WRITER_H
+#define INBOX_WRITER_H
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "db-pool.h"
+#include "messages.h"
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define INBOX_BATCH_SIZE        256         // messages inserted with a single execute
+#define INBOX_FLUSH_INTERVAL    500         // ms between flushes at most
+#define INBOX_MAX_PENDING       (1 << 16)   // held while the database is away; the oldest go beyond
+#define INBOX_PHONE_SIZE        sizeof(SmsIn::phoneno)
+#define INBOX_MESSAGE_SIZE      sizeof(SmsIn::message)
+
+
+
+
+
+//===============================================================================|
+//          CLASS
+//===============================================================================|
+/**
+ * @brief Enqueue puts a message at the back of the line, cut to fit SmsIn. A
+ *  thread of its own takes the line every flush interval, or as soon as a
+ *  batch worth has built up, and inserts it on a pooled connection as a
+ *  prepared INSERT bound to arrays of parameters, a transaction per batch. A
+ *  batch that fails goes back to the front of the line to be tried again with
+ *  the next flush.
+ *
+ */
+class InboxWriter
+{
+public:
+
+    InboxWriter();
+    ~InboxWriter();
+
+    InboxWriter(const InboxWriter &) = delete;
+    InboxWriter &operator=(const InboxWriter &) = delete;
+
+    int Start(DbPool *ppool, const u32 batch_size = INBOX_BATCH_SIZE, 
+        const u32 interval_ms = INBOX_FLUSH_INTERVAL);
+    void Stop();
+
+    void Enqueue(const std::string_view phone_no, const std::string_view msg, const u8 error = 0);
+    size_t Get_Pending() const;
+    u64 Get_Written() const { return written; }
+    u64 Get_Dropped() const { return dropped; }
+
+private:
+
+    typedef struct INBOX_ROW
+    {
+        std::string phoneno;
+        std::string message;        // UTF-8
+        s64 recvdTicks;
+        u8 error;
+    } Row;
+
+    void Run();
+    void Flush(std::deque<Row> &rows);
+    int Write_Batch(DbLease &lease, std::deque<Row>::const_iterator first, const size_t count);
+
+    DbPool *ppool;
+    std::thread *pwriter;
+    bool running;
+    u32 batch_size;
+    u32 interval_ms;
+    std::atomic<u64> written;       // messages stored so far
+    std::atomic<u64> dropped;       // and lost to a full line
+
+    mutable std::mutex iw_mutex;    // guards pending and running
+    std::condition_variable wake;
+    std::deque<Row> pending;        // oldest first
+
+    // the parameter arrays; reused from batch to batch
+    std::vector<char> phones;
+    std::vector<SQLLEN> phone_lens;
+    std::vector<char> messages;
+    std::vector<SQLLEN> message_lens;
+    std::vector<s64> ticks;
+    std::vector<u8> errors;
+};
+
+
+#endif
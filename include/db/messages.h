@@ -31,7 +31,11 @@
 //          INCLUDES
 //===============================================================================|
 #include "iQE.h"
+#include "db-pool.h"
+#include "id-sequence.h"
 #include "utils.h"
+#include "sms-batch.h"
+#include "msg-template.h"
 
 
 
@@ -68,6 +72,11 @@ typedef struct SMSIN_TABLE_TYPE
 
 
 
+// gets the rows of a query one at a time as they're fetched
+typedef std::function<void(const SmsOut &)> SmsOut_Fn;
+
+
+
 
 
 class Messages
@@ -80,8 +89,11 @@ public:
 
     int Connect_DB(const std::string &con_str);
     int Disconnect_DB();
+    void Set_Pool(DbPool *ppool);
 
-    std::vector<SmsOut> Load_Messages();
+    int Load_Messages(const SmsOut_Fn &fn);
+    int Load_Messages(const u32 after_id, const u32 limit, const SmsOut_Fn &fn);
+    int Load_Messages(SmsBatch &batch);
     int Load_Current_Period();
     int Load_Reading_Period();
     std::string Load_Current_Period_Name();
@@ -91,13 +103,16 @@ public:
     int Update_Last_Message_ID() const;
     std::string Load_SMS_Bill_Format();
     std::string Load_Unread_Format();
-    std::vector<SmsOut> Preview_Bill_SMS(const int subscriber_id = -1);
-    std::vector<SmsOut> Preview_Reading_SMS(const int subscriber_id = -1);
-    std::vector<SmsOut> Preview_General_SMS(const int subscriber_id = -1);
-
-    void Write_SMSOut(std::vector<SmsOut> &msgs);
+    int Preview_Bill_SMS(const SmsOut_Fn &fn, const int subscriber_id = -1);
+    int Preview_Reading_SMS(const SmsOut_Fn &fn, const int subscriber_id = -1);
+    int Preview_General_SMS(const SmsOut_Fn &fn, const int subscriber_id = -1);
+    int Preview_Bill_SMS(SmsBatch &batch, const int subscriber_id = -1);
+    int Preview_Reading_SMS(SmsBatch &batch, const int subscriber_id = -1);
+    int Preview_General_SMS(SmsBatch &batch, const int subscriber_id = -1);
+
+    int Write_SMSOut(const SmsBatch &batch);
     void Update_SMSOut(SmsOut_Ptr msg);
-    void Write_SMSIn(SmsIn_Ptr msg);
+    void Update_SMSOut(const u32 status, const std::string_view msg_id);
 
     
 private:
@@ -107,7 +122,6 @@ private:
     u32 period_id;
     u32 reading_period;
     u32 audit_id;
-    u32 last_msg_id;
 
     std::string period_name;
     std::string bill_format;
@@ -115,10 +129,19 @@ private:
     std::string msg_format;
 
 
+    int Fetch_SMSOut(const char *sql, const SmsOut_Fn &fn);
+    int Prepare_SMSOut_Insert();
+    int Fill_SmsOut(SmsOut &out, const char *phone, const std::string &msg);
+
+
     // ODBC database stuff
     HENV henv;
     HDBC hdbc;
     HSTMT hstmt;
+    HSTMT hinsert;      // the SmsOut insert; prepared once and run with parameter arrays
+    DbPool *ppool;      // for what's called from other threads; e.g. status updates
+    IdSequence msg_ids;     // MessageID; handed out a block at a time
+    IdSequence audit_ids;   // AuditID; taken once per run
 };
 
 
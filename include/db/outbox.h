@@ -0,0 +1,108 @@
+/**
+ * @file outbox.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Streams the unsent messages out of SmsOut to the sender threads. A
+ *  producer thread pages through the table by id and keeps a bounded queue
+ *  topped up; it stalls when the senders fall behind, so memory use has
+ *  nothing to do with how big the backlog is.
+ * @version 0.1
+ * @date 2024-03-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "messages.h"
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define OUTBOX_QUEUE_SIZE       2048        // messages read ahead of the senders
+#define OUTBOX_PAGE_SIZE        512         // messages read per query
+#define OUTBOX_POLL_INTERVAL    5000        // ms between looks for new messages once caught up
+
+
+
+
+
+//===============================================================================|
+//          TYPES
+//===============================================================================|
+/**
+ * @brief A message on its way to a sender; only what it takes to send it and
+ *  to update it after. The strings of the queue's slots are reused from one
+ *  message to the next, and Pop trades the caller's for them.
+ */
+typedef struct OUTBOX_MSG
+{
+    u32 id{0};
+    u32 status{0};
+    std::string phoneno;
+    std::string message;
+    std::string messageID;
+} Outbox_Msg, *Outbox_Msg_Ptr;
+
+
+
+
+
+//===============================================================================|
+//          CLASS
+//===============================================================================|
+/**
+ * @brief The producer has a database connection of its own, so the paging
+ *  cursor never gets in the way of the other queries. It remembers the id of
+ *  the last message it queued and asks for the next page after that; once a
+ *  page comes back short it's caught up, and it checks back every poll
+ *  interval for whatever has been added since. Any number of threads may Pop.
+ *
+ */
+class Outbox
+{
+public:
+
+    Outbox(const size_t capacity = OUTBOX_QUEUE_SIZE, const u32 page_size = OUTBOX_PAGE_SIZE);
+    ~Outbox();
+
+    Outbox(const Outbox &) = delete;
+    Outbox &operator=(const Outbox &) = delete;
+
+    int Start(const std::string &con_str);
+    void Stop();
+
+    bool Pop(Outbox_Msg &out, const u32 timeout_ms);
+    u64 Get_Queued() const;
+
+private:
+
+    void Run();
+    bool Push(const SmsBatch &page, const size_t i);
+
+    Messages db;                    // the producer's own connection
+    std::thread *pproducer;
+    std::atomic<bool> running;
+    u32 page_size;
+    u32 last_id;                    // the last message queued
+
+    mutable std::mutex ob_mutex;    // guards the ring below
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::vector<Outbox_Msg> ring;   // the queue
+    size_t head;                    // next to pop
+    size_t count;                   // messages in the ring
+};
+
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * @file sms-batch.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief A compact batch of outgoing messages. Where SmsOut carries some 3.4 KB
+ *  of fixed buffers per message, a batch keeps a small fixed record per message
+ *  and puts the text of every one of them back to back in a single arena.
+ * @version 0.1
+ * @date 2024-03-20
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef SMS_BATCH_H
+#define SMS_BATCH_H
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "basics.h"
+
+
+
+
+
+//===============================================================================|
+//          TYPES
+//===============================================================================|
+struct SMSOUT_TABLE_TYPE;
+
+
+
+/**
+ * @brief A message of the batch; the text is found in the arena at the offsets
+ *  given, and the status message in the batch's interned strings.
+ */
+typedef struct SMS_RECORD
+{
+    u32 id;
+    u32 phoneno;                // offset into the arena
+    u32 message;                // offset into the arena
+    u32 messageID;              // offset into the arena
+    u16 phoneno_len;
+    u16 message_len;
+    u16 messageID_len;
+    u16 statusMessage;          // index of the interned string
+    u32 status;
+    u32 sequenceNo;
+    u32 aid;
+    u64 logTicks;
+    u64 statusTicks;
+} Sms_Record, *Sms_Record_Ptr;
+
+
+
+
+
+//===============================================================================|
+//          CLASS
+//===============================================================================|
+/**
+ * @brief Adding a message bumps the arena by the length of its strings and
+ *  nothing more; the records and the arena grow as vectors do, so after the
+ *  first few messages there are no allocations at all, and none ever per
+ *  message. Offsets rather than pointers are kept, so growing the arena leaves
+ *  every record as it is. The status messages, of which there are only ever a
+ *  handful, are kept once each. Clear empties the batch but holds on to the
+ *  memory, so one batch can serve a page or a campaign after the other.
+ *
+ */
+class SmsBatch
+{
+public:
+
+    SmsBatch(const size_t rows = 0, const size_t bytes = 0);
+
+    size_t Add(const SMSOUT_TABLE_TYPE &out);
+    size_t Add(const std::string_view phoneno, const std::string_view message);
+    void Clear();
+
+    void Set_Message_ID(const size_t i, const std::string_view id);
+    void Set_Status_Message(const size_t i, const std::string_view text);
+
+    std::string_view Phone_No(const size_t i) const;
+    std::string_view Message(const size_t i) const;
+    std::string_view Message_ID(const size_t i) const;
+    std::string_view Status_Message(const size_t i) const;
+    void To_SmsOut(const size_t i, SMSOUT_TABLE_TYPE &out) const;
+
+    Sms_Record &operator[](const size_t i) { return records[i]; }
+    const Sms_Record &operator[](const size_t i) const { return records[i]; }
+    size_t Size() const { return records.size(); }
+    bool Empty() const { return records.empty(); }
+    size_t Memory() const;
+
+private:
+
+    u32 Put(const std::string_view s, u16 &len);
+    u16 Intern(const std::string_view s);
+
+    std::vector<Sms_Record> records;
+    std::vector<char> arena;            // the text of every message, back to back
+    std::vector<std::string> interned;  // the status messages
+};
+
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ * @file status-writer.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Writes the status changes of outgoing messages to SmsOut behind the
+ *  backs of those reporting them; neither the senders nor the SMSC handlers
+ *  ever wait on the database.
+ * @version 0.1
+ * @date 2024-03-24
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef STATUS_WRITER_H
+#define STATUS_WRITER_H
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "db-pool.h"
+#include "smpp-konstants.h"
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define STATUS_BATCH_SIZE       512         // updates sent with a single execute
+#define STATUS_FLUSH_INTERVAL   500         // ms between flushes at most
+#define STATUS_MSGID_SIZE       50          // as SmsOut's messageID; terminator included
+
+
+
+
+
+//===============================================================================|
+//          CLASS
+//===============================================================================|
+/**
+ * @brief Enqueue files the change under the SmsOut row of the message, along
+ *  with the message_id SMSC gave it once there's one; the id is stored on the
+ *  row with the status. A receipt for a message that's no longer tracked, one
+ *  sent before a restart say, has only the message_id to go by and is filed
+ *  under that. A later change of the same message overwrites an earlier, so
+ *  only the latest state ever gets written; save that a final state (delivered,
+ *  failed or expired) is never taken back by a passing one that comes late. A
+ *  thread of its own takes the lot every flush interval, or as soon as a batch
+ *  worth has built up, and writes it on a pooled connection as prepared UPDATEs
+ *  bound to arrays of parameters, a transaction per batch; the rows first, so
+ *  the message_id's they store are there for the updates that go by them. A
+ *  batch that fails goes back to be tried again with the next flush, minus
+ *  whatever has changed since.
+ *
+ */
+class StatusWriter
+{
+public:
+
+    StatusWriter();
+    ~StatusWriter();
+
+    StatusWriter(const StatusWriter &) = delete;
+    StatusWriter &operator=(const StatusWriter &) = delete;
+
+    int Start(DbPool *ppool, const u32 batch_size = STATUS_BATCH_SIZE, 
+        const u32 interval_ms = STATUS_FLUSH_INTERVAL);
+    void Stop();
+
+    void Enqueue(const u32 row_id, const std::string_view msg_id, const u32 status);
+    size_t Get_Pending() const;
+    u64 Get_Written() const { return written; }
+
+private:
+
+    typedef struct STATUS_UPDATE
+    {
+        u32 status{MSG_STATE_SENT};
+        std::string msg_id;         // SMSC's; empty until it's given one
+    } Status_Update;
+
+    typedef std::unordered_map<u32, Status_Update> Row_Updates;     // by SmsOut id
+    typedef std::unordered_map<std::string, u32> Id_Updates;        // by message_id
+
+    void Run();
+    void Flush(Row_Updates &rows, Id_Updates &ids);
+    int Write_Rows(DbLease &lease, Row_Updates::const_iterator first, const size_t count);
+    int Write_Ids(DbLease &lease, Id_Updates::const_iterator first, const size_t count);
+    int Execute(DbLease &lease, HSTMT hupdate);
+    static void Merge(Status_Update &into, const u32 status, const std::string_view msg_id);
+    static bool Outranks(const u32 status, const u32 over);
+
+    DbPool *ppool;
+    std::thread *pwriter;
+    bool running;
+    u32 batch_size;
+    u32 interval_ms;
+    std::atomic<u64> written;       // updates written so far
+
+    mutable std::mutex sw_mutex;    // guards pending and running
+    std::condition_variable wake;
+    Row_Updates pending;            // the latest status by row
+    Id_Updates pending_ids;         // and of the untracked, by message_id
+
+    // the parameter arrays; reused from batch to batch
+    std::vector<char> ids;
+    std::vector<SQLLEN> id_lens;
+    std::vector<SQLINTEGER> statuses;
+    std::vector<SQLINTEGER> row_ids;
+};
+
+
+#endif
@@ -0,0 +1,169 @@
+/**
+ * @file mpsc-queue.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief A bounded lock-free queue for handing work from many producer threads
+ *  to a single consumer thread.
+ * @version 0.1
+ * @date 2024-03-10
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "basics.h"
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define CACHE_LINE          64          // keeps producer and consumer counters apart
+
+
+
+
+
+//===============================================================================|
+//          CLASS
+//===============================================================================|
+/**
+ * @brief Each slot carries a sequence number telling whose turn it is: a slot
+ *  at position pos is free for the producer that claims pos when its sequence
+ *  equals pos, and holds data for the consumer when it equals pos + 1. The
+ *  producers race for positions with a single CAS on the tail while the lone
+ *  consumer owns the head outright, so neither side ever takes a lock. Push
+ *  fails rather than waits when the queue is full; it's up to the producer to
+ *  back off.
+ *
+ * @tparam T the item type; must be default constructible and movable
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+
+    /**
+     * @brief Construct a new Mpsc Queue object
+     *
+     * @param capacity the number of slots; rounded up to a power of 2
+     */
+    MpscQueue(const size_t capacity)
+    {
+        size_t cap{2};
+        while (cap < capacity)
+            cap <<= 1;
+
+        mask = cap - 1;
+        cells = new Cell[cap];
+        for (size_t i = 0; i < cap; i++)
+            cells[i].seq.store(i, std::memory_order_relaxed);
+
+        tail.store(0, std::memory_order_relaxed);
+        head = 0;
+    } // end Constructor
+
+
+    ~MpscQueue() { delete [] cells; }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+
+    /**
+     * @brief Adds an item at the tail; safe to call from any number of threads.
+     *  The item is only moved from when the call succeeds.
+     *
+     * @param item the item to add
+     *
+     * @return true on success, false when the queue is full
+     */
+    bool Push(T &&item)
+    {
+        Cell *pcell;
+        size_t pos = tail.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            pcell = &cells[pos & mask];
+            size_t seq = pcell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+            if (diff == 0)
+            {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;      // the slot is ours
+            } // end if free
+            else if (diff < 0)
+                return false;   // consumer hasn't got this far yet; full
+            else
+                pos = tail.load(std::memory_order_relaxed);
+        } // end for
+
+        pcell->data = std::move(item);
+        pcell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    } // end Push
+
+
+    /**
+     * @brief Takes the item at the head; must only be called from the consumer
+     *  thread.
+     *
+     * @param item the item is returned here
+     *
+     * @return true when an item was taken, false if the queue is empty
+     */
+    bool Pop(T &item)
+    {
+        Cell *pcell = &cells[head & mask];
+        if (pcell->seq.load(std::memory_order_acquire) != head + 1)
+            return false;
+
+        item = std::move(pcell->data);
+        pcell->seq.store(head + mask + 1, std::memory_order_release);
+        ++head;
+        return true;
+    } // end Pop
+
+
+    /**
+     * @brief Tells whether there is anything to pop; only meaningful to the
+     *  consumer.
+     *
+     * @return true when empty
+     */
+    bool Empty() const
+    {
+        return cells[head & mask].seq.load(std::memory_order_acquire) != head + 1;
+    } // end Empty
+
+
+    size_t Capacity() const { return mask + 1; }
+
+private:
+
+    typedef struct CELL
+    {
+        std::atomic<size_t> seq;    // whose turn it is at this slot
+        T data;                     // the item
+    } Cell;
+
+    Cell *cells;                    // the slots
+    size_t mask;                    // capacity - 1
+
+    alignas(CACHE_LINE) std::atomic<size_t> tail;   // next position for producers
+    alignas(CACHE_LINE) size_t head;                // next position for the consumer
+};
+
+
+#endif
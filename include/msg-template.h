@@ -0,0 +1,81 @@
+/**
+ * @file msg-template.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Message templates, such as the bill and unread formats, compiled once
+ *  into a list of literals and placeholder slots and then rendered row after
+ *  row in a single pass.
+ * @version 0.1
+ * @date 2024-03-21
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef MSG_TEMPLATE_H
+#define MSG_TEMPLATE_H
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "basics.h"
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define TPL_NO_SLOT         -1          // a literal token
+
+
+
+
+
+//===============================================================================|
+//          CLASS
+//===============================================================================|
+/**
+ * @brief The placeholders a template knows are given up front, each taking the
+ *  slot of its position; "$name", "$bill" and so on. Compile splits the text on
+ *  every occurrence of them, the longest name winning where one is the start of
+ *  another ("$contractNo" over "$cont"); whatever isn't a known placeholder
+ *  stays as it's written. Bind folds a slot that's the same for every row into
+ *  the literals around it, so only the values that change are looked at while
+ *  rendering. Render appends into a string the caller keeps, which stops
+ *  allocating once it's grown to the longest message.
+ *
+ */
+class MsgTemplate
+{
+public:
+
+    MsgTemplate(std::initializer_list<std::string_view> names);
+
+    int Compile(const std::string_view text);
+    void Bind(const int slot, const std::string_view value);
+    void Render(std::string &out, const std::string_view *values) const;
+
+    size_t Get_Slots() const { return names.size(); }
+    size_t Get_Tokens() const { return tokens.size(); }
+
+private:
+
+    typedef struct TOKEN
+    {
+        int slot;           // TPL_NO_SLOT for a literal
+        u32 off;            // the literal, in text
+        u32 len;
+    } Token;
+
+    void Add_Literal(const std::string_view s);
+
+    std::vector<std::string> names; // the placeholders by slot
+    std::vector<Token> tokens;
+    std::string text;               // the literals, back to back
+};
+
+
+#endif
@@ -0,0 +1,66 @@
+/**
+ * @file charset.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Puts UTF-8 text into the character sets SMS has: the GSM 7-bit
+ *  default alphabet when every character of it is there, alas UCS-2, and
+ *  picks the data_coding that goes with it; and brings what comes in under
+ *  any data_coding back to UTF-8. The runs of plain ASCII, which is
+ *  most of any text we send, are scanned and copied with SSE2 or AVX2; the
+ *  rest, one character at a time from tables.
+ * @version 0.1
+ * @date 2024-03-27
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef CHARSET_H
+#define CHARSET_H
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "basics.h"
+#include "smpp-konstants.h"
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+// the instruction sets the scans may use; the best the cpu has by default
+#define CHARSET_SCALAR          0
+#define CHARSET_SSE2            1
+#define CHARSET_AVX2            2
+
+#define UCS2_REPLACEMENT        0xFFFD      // stands in for broken UTF-8
+
+
+
+
+
+//===============================================================================|
+//          FUNCTIONS
+//===============================================================================|
+bool Is_GSM7(const std::string_view utf8);
+int Utf8_To_Gsm7(const std::string_view utf8, char *out, const size_t cap);
+int Pack_Gsm7(const char *septets, const size_t count, char *out, const size_t cap);
+int Utf8_To_Ucs2(const std::string_view utf8, char *out, const size_t cap);
+
+void Gsm7_To_Utf8(const std::string_view septets, std::string &out);
+void Ucs2_To_Utf8(const std::string_view ucs2, std::string &out);
+void Latin1_To_Utf8(const std::string_view latin1, std::string &out);
+void Decode_Text(const std::string_view body, const u8 data_coding, std::string &out);
+
+u8 Select_Coding(const std::string_view utf8);
+u8 Encode_Text(const std::string_view utf8, std::string &out);
+
+u8 Set_Charset_Level(const u8 level);
+u8 Get_Charset_Level();
+
+
+#endif
@@ -0,0 +1,133 @@
+/**
+ * @file event-loop.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief An edge triggered epoll reactor. Every descriptor watched by the loop
+ *  is owned by an EventHandler whose address rides along in epoll_event.data,
+ *  so an event is routed to its owner without searching for it.
+ * @version 0.1
+ * @date 2024-03-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "basics.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define EVENT_MAX_EVENTS    256         // events reaped by a single epoll_wait
+
+
+// the usual interest sets
+#define EVENT_READ          (EPOLLIN | EPOLLRDHUP | EPOLLET)
+#define EVENT_READ_WRITE    (EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET)
+
+
+
+
+
+//===============================================================================|
+//          CLASS
+//===============================================================================|
+/**
+ * @brief Anything that wants to be told when its descriptor is ready. Since the
+ *  loop is edge triggered the handler must drain the descriptor (read/accept
+ *  until EAGAIN) each time it is called, or it will not hear of it again.
+ *
+ */
+class EventHandler
+{
+public:
+
+    virtual ~EventHandler() = default;
+
+    virtual int Get_Fd() const = 0;
+    virtual int Handle_Event(const u32 events) = 0;
+    virtual void Handle_Close() {}
+};
+
+
+
+
+/**
+ * @brief The reactor itself. A handler returning -ve from Handle_Event is taken
+ *  out of the loop and then told so through Handle_Close; that is the one place
+ *  a handler may release itself, as the loop never touches it afterwards.
+ *
+ */
+class EventLoop
+{
+public:
+
+    EventLoop(const int max_events = EVENT_MAX_EVENTS);
+    ~EventLoop();
+
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    int Add(EventHandler *phandler, const u32 events = EVENT_READ);
+    int Modify(EventHandler *phandler, const u32 events);
+    int Remove(EventHandler *phandler);
+
+    int Run_Once(const int timeout_ms);
+    size_t Get_Count() const;
+
+private:
+
+    int epfd;                           // the epoll instance
+    size_t count;                       // handlers currently registered
+    std::vector<epoll_event> events;    // where epoll_wait reports to
+};
+
+
+
+
+/**
+ * @brief An eventfd for other threads to knock on a loop that may be sleeping
+ *  in epoll_wait; typically after they have put something in one of its queues.
+ *  The handler merely swallows the knock, the owner of the loop is expected to
+ *  look at its queues each time Run_Once returns.
+ *
+ */
+class EventNotifier : public EventHandler
+{
+public:
+
+    EventNotifier();
+    ~EventNotifier();
+
+    int Get_Fd() const override;
+    int Handle_Event(const u32 events) override;
+
+    void Notify();
+
+private:
+
+    int efd;            // the eventfd
+};
+
+
+
+
+//===============================================================================|
+//          FUNCTIONS
+//===============================================================================|
+int Set_Non_Blocking(const int fd);
+
+
+#endif
@@ -0,0 +1,150 @@
+/**
+ * @file inflight-tracker.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Keeps track of the messages sent to SMSC until their fate is known.
+ *  A message is looked up by the sequence # of its submit_sm when the response
+ *  comes back, and by the message_id SMSC gave it when the receipt does; both
+ *  in constant time.
+ * @version 0.1
+ * @date 2024-03-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef INFLIGHT_TRACKER_H
+#define INFLIGHT_TRACKER_H
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "smpp-pdu.h"
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define INFLIGHT_INIT_SIZE      1024        // records to start with; grows by doubling
+#define INFLIGHT_MAX_SIZE       (1 << 20)   // messages tracked at most per bind
+#define INFLIGHT_NPOS           0xFFFFFFFF  // no such record
+
+
+
+
+
+//===============================================================================|
+//          TYPES
+//===============================================================================|
+/**
+ * @brief This is a structure that is used to keep track of all the active items
+ *  the application needs. By keeping track of sent messages that have not yet been
+ *  confrimed the application has the chance of re-submitting messages or do other
+ *  stuff like change/update or even remove the messages before final arrival.
+ * This litlle struct is used for single messages as distinct from bulk.
+ *
+ */
+typedef struct SMS_INFO_STRUCT
+{
+    u8 msg_state;           // state of our little message
+    std::string id;         // sms id sent from ESME
+    std::string msg;        // the sent message; released once SMSC accepts it
+    std::string dst;        // the destination numerics; same as above
+    Smpp_Options opts;      // extra options associtated with this message
+    u64 timer{0};           // the timeout armed for whatever it awaits next
+    u8 retries{0};          // times this message has been resubmitted, or queried
+    Concat_Info concat;     // its place in a long message, for resubmitting
+    u32 group{0};           // the long message it's a part of; 0 for none
+    u32 row_id{0};          // its row in SmsOut, it's reported under; 0 for none
+} Single_Sms_Info, *Single_Sms_Info_Ptr;
+
+
+
+
+
+//===============================================================================|
+//          CLASS
+//===============================================================================|
+/**
+ * @brief The records live in a slab and are referred to by their index in it;
+ *  freed slots are kept on a list and handed out again, so a steady stream of
+ *  messages allocates nothing once the slab has grown to fit. Two open address
+ *  tables with linear probing map sequence # and message_id onto slots. Both
+ *  are kept at most half full and entries are removed by shifting the rest of
+ *  their cluster back, so there are no tombstones to slow down the probes over
+ *  time. A record is indexed by message_id only once SMSC has given it one.
+ *
+ * Once a message is accepted its owner should let go of the text and the
+ *  destination, which are only kept for resubmitting; what remains while it
+ *  waits on the receipt is the record itself and the id. The slab never holds
+ *  more than INFLIGHT_MAX_SIZE records.
+ *
+ */
+class InflightTracker
+{
+public:
+
+    InflightTracker(const size_t capacity = INFLIGHT_INIT_SIZE);
+
+    InflightTracker(const InflightTracker &) = delete;
+    InflightTracker &operator=(const InflightTracker &) = delete;
+
+    u32 Add(const u32 seq, Single_Sms_Info &&info);
+    void Remove(const u32 slot);
+    void Clear();
+
+    u32 Find_Seq(const u32 seq) const;
+    u32 Find_Id(const std::string_view id) const;
+    u32 Set_Id(const u32 slot, const std::string_view id);
+    u32 Set_Seq(const u32 slot, const u32 seq);
+
+    Single_Sms_Info &Get(const u32 slot) { return slab[slot].info; }
+    u32 Get_Seq(const u32 slot) const { return slab[slot].seq; }
+    bool Has(const u32 slot) const { return slot < slab.size() && slab[slot].used; }
+    size_t Size() const { return count; }
+
+
+    /**
+     * @brief Calls fn(slot, info) for every record; fn may Remove the record
+     *  it's given but no other.
+     */
+    template <typename Fn>
+    void For_Each(Fn fn)
+    {
+        for (u32 i = 0; i < (u32)slab.size(); i++)
+        {
+            if (slab[i].used)
+                fn(i, slab[i].info);
+        } // end for
+    } // end For_Each
+
+private:
+
+    typedef struct SLOT
+    {
+        u32 seq{0};             // sequence # of the submit it was last sent with
+        u32 id_hash{0};         // hash of info.id, once indexed by it
+        bool used{false};       // in use or on the free list
+        bool has_id{false};     // indexed by message_id
+        Single_Sms_Info info;   // the message
+    } Slot;
+
+    void Grow_Index();
+    void Index_Insert(std::vector<u32> &index, const u32 hash, const u32 slot);
+    void Index_Erase(std::vector<u32> &index, const u32 slot, const bool on_id);
+    u32 Home(const u32 slot, const bool on_id) const;
+
+    std::vector<Slot> slab;     // the records
+    std::vector<u32> free_list; // slots up for grabs
+    std::vector<u32> by_seq;    // sequence # -> slot
+    std::vector<u32> by_id;     // message_id -> slot
+    u32 mask;                   // index size - 1
+    size_t count;               // records in use
+};
+
+
+#endif
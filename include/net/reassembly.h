@@ -0,0 +1,98 @@
+/**
+ * @file reassembly.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Puts the parts of long messages sent to us back together. The parts
+ *  of a message are told apart from those of others by the number that sent
+ *  them, their reference # and the count of parts; they may come in any order.
+ *  The table is bounded; a message is waited on only so long from its first
+ *  part and, with the table full, the oldest gives way to a new one. Either
+ *  way it's handed over with what's come of it.
+ * @version 0.1
+ * @date 2024-03-28
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef REASSEMBLY_H
+#define REASSEMBLY_H
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "smpp-pdu.h"
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define REASSEMBLY_MAX          1024        // long messages put together at once
+#define REASSEMBLY_TIMEOUT      120000      // ms the rest of a message is waited on
+
+
+
+
+
+//===============================================================================|
+//          TYPES
+//===============================================================================|
+/**
+ * @brief Gets a message once it's together, or given up on: the number that
+ *  sent it, its text as it came, parts joined in order, under its data_coding
+ *  and whether every part made it.
+ */
+typedef std::function<void(const std::string_view source, const std::string_view body,
+    const u8 data_coding, const bool whole)> Reassembled_Fn;
+
+
+
+
+
+//===============================================================================|
+//          CLASS
+//===============================================================================|
+class Reassembly
+{
+public:
+
+    Reassembly(const size_t max_messages = REASSEMBLY_MAX, const u32 timeout_ms = REASSEMBLY_TIMEOUT);
+
+    int Add(const std::string_view source, const Concat_Info &concat, const u8 data_coding,
+        const std::string_view body, const Reassembled_Fn &fn);
+    size_t Expire(const std::chrono::steady_clock::time_point now, const Reassembled_Fn &fn);
+
+    size_t Get_Count() const { return partials.size(); }
+    u64 Get_Incomplete() const { return incomplete; }
+
+private:
+
+    typedef struct PARTIAL_MESSAGE
+    {
+        std::string source;
+        u8 data_coding{0};
+        u8 have{0};                                 // parts in so far
+        std::vector<std::string> parts;             // by seqnum less one; empty till in
+        std::chrono::steady_clock::time_point first;
+        std::list<std::string>::iterator age;       // its place in ages
+    } Partial;
+
+    typedef std::unordered_map<std::string, Partial> Partials;
+
+    void Finish(Partials::iterator it, const Reassembled_Fn &fn);
+
+    Partials partials;                  // by number, reference # and count of parts
+    std::list<std::string> ages;        // the keys of partials, oldest first
+    std::string key;                    // reused from part to part
+    std::string joined;                 // and message to message
+    size_t max_messages;
+    u32 timeout_ms;
+    u64 incomplete;                     // messages handed over short of parts
+};
+
+
+#endif
@@ -0,0 +1,69 @@
+/**
+ * @file ring-buffer.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief A byte ring used to frame stream oriented protocols such as SMPP. Bytes
+ *  are written at the tail as they arrive from the socket and whole frames are
+ *  read (and consumed) from the head.
+ * @version 0.1
+ * @date 2024-03-04
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "basics.h"
+
+
+
+
+
+//===============================================================================|
+//          CLASS
+//===============================================================================|
+/**
+ * @brief The readable region of the ring is always kept contiguous; instead of
+ *  wrapping the tail around, the left over partial frame is slid back to the
+ *  front of the storage whenever the free space at the end runs short. Since
+ *  that left over is never more than a single frame the copy is cheap, and in
+ *  return the readers get to look at every frame through a plain pointer.
+ *
+ */
+class RingBuffer
+{
+public:
+
+    RingBuffer(const size_t capacity);
+    ~RingBuffer();
+
+    RingBuffer(const RingBuffer &) = delete;
+    RingBuffer &operator=(const RingBuffer &) = delete;
+
+    char *Write_Ptr();
+    size_t Write_Space() const;
+    void Commit(const size_t len);
+
+    const char *Read_Ptr() const;
+    size_t Size() const;
+    void Consume(const size_t len);
+
+    size_t Capacity() const;
+    void Reset();
+
+private:
+
+    char *buf;          // the storage
+    size_t cap;         // size of storage in bytes
+    size_t head;        // offset of the first unread byte
+    size_t tail;        // offset one past the last written byte
+};
+
+
+#endif
@@ -0,0 +1,49 @@
+/**
+ * @file segmenter.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Cuts messages too long for a single SMS into the parts of a
+ *  concatenated one; each as long as a part may be under the data_coding and
+ *  the way the parts are put back together, and none cutting a character in
+ *  two.
+ * @version 0.1
+ * @date 2024-03-26
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef SEGMENTER_H
+#define SEGMENTER_H
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "smpp-pdu.h"
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define SMS_USER_DATA_MAX       140         // octets of user data in an SMS
+#define SMS_SEPTETS_MAX         160         // GSM 7-bit characters in as many octets
+#define GSM_ESCAPE              0x1B        // leads the characters of the extension table
+
+
+
+
+
+//===============================================================================|
+//          FUNCTIONS
+//===============================================================================|
+size_t Single_Limit(const u8 data_coding);
+size_t Part_Limit(const u8 data_coding, const u8 concat_mode);
+size_t Segment_Message(const std::string_view msg, const u8 data_coding, const u8 concat_mode,
+    std::string_view *parts, const size_t max_parts = SMPP_CONCAT_MAX);
+
+
+#endif
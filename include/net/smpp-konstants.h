@@ -108,7 +108,9 @@
 #define ESME_RINVSYSID          0x0000000F      // Invalid System ID
 #define ESME_RCANCELFAIL        0x00000011      // Cancel SM Failed
 #define ESME_RREPLACEFAIL       0x00000013      // Replace SM Failed
+#define ESME_RMSGQFUL           0x00000014      // Message Queue Full
 #define ESME_RSUBMITFAIL        0x00000045      // submit_sm or submit_multi failed
+#define ESME_RTHROTTLED         0x00000058      // Throttling error (ESME has exceeded allowed message limits)
 
 
 
@@ -129,10 +131,12 @@
 #define ESM_DEFAULT             0b00000000      // default store and forward mode
 #define ESM_DATAGRAM            0b00000001      // datagram mode
 #define ESM_FORWARD             0b00000010      // transaction mode (may not be supported)
+#define ESM_SMSC_RECEIPT        0b00000100      // Short Message contains SMSC Delivery Receipt
 #define ESM_DELVIER             0b00001000      // Short Message contains ESME Delivery Acknowledgement
 #define ESM_USR_ACK             0b00010000      // user acknowledgment
 #define ESM_UDHI                0b01000000      // UDHI Indicator (only relevant for MT short messages)
 #define ESM_REP_PATH            0b10000000      // Set Reply Path (only relevant for GSM network)
+#define ESM_TYPE_MASK           0b00111100      // the message type bits; all clear for a plain message
 
 
 
@@ -156,6 +160,15 @@
 
 // data codings
 #define DATA_CODE_DEFAULT        0b00000000      // default data coding (character encoding)
+#define DATA_CODE_IA5            0b00000001      // IA5 (CCITT T.50)/ASCII
+#define DATA_CODE_LATIN1         0b00000011      // Latin 1 (ISO-8859-1)
+#define DATA_CODE_8BIT           0b00000100      // octet unspecified (8-bit binary)
+#define DATA_CODE_UCS2           0b00001000      // UCS2 (ISO/IEC-10646)
+
+
+// concatenation information elements of the user data header
+#define UDH_IE_CONCAT_8BIT       0x00            // 8-bit reference #
+#define UDH_IE_CONCAT_16BIT      0x08            // 16-bit reference #
 
 
 // Optional Paramters (in the native network order)
@@ -164,6 +177,17 @@
 #define USER_MESSAGE_REFERENCE  htons(0x0204)
 
 
+// the same tags in host order, as the PDU encoder wants them
+#define TLV_RECEIPTED_MESSAGE_ID    0x001E
+#define TLV_MESSAGE_PAYLOAD         0x0424
+#define TLV_USER_MESSAGE_REFERENCE  0x0204
+#define TLV_SAR_MSG_REF_NUM         0x020C
+#define TLV_SAR_TOTAL_SEGMENTS      0x020E
+#define TLV_SAR_SEGMENT_SEQNUM      0x020F
+#define TLV_NETWORK_ERROR_CODE      0x0423
+#define TLV_MESSAGE_STATE           0x0427
+
+
 
 // destination flags
 #define DL_SME_ADDRESS          0
@@ -189,6 +213,10 @@
 #define MSG_STATE_SENT          0           // the message is in a sent state but not confirmed
 #define MSG_STATE_SUBMIT        1           // the SMCS has confirmed the message state but not user
 #define MSG_STATE_DELIVERED     2           // the message is delivered to subsciber
+#define MSG_STATE_QUERIED       3           // no receipt in time; asked SMSC with query_sm
+#define MSG_STATE_FAILED        4           // SMSC says it won't be delivered
+#define MSG_STATE_EXPIRED       5           // nothing heard of it; given up on
+#define MSG_STATE_THROTTLED     6           // SMSC said back off; waits to be sent again
 
 
 
@@ -197,6 +225,19 @@
 #define SMPP_VER                0x34            // smpp version
 #define HEARTBEAT_INTERVAL      5              // default heartbeat, every 10 mins or so
 #define SMS_BUFFER_SIZE         96000           // buffer size for incoming connection 
+#define SMS_RING_SIZE           (SMS_BUFFER_SIZE << 1)  // stream buffer; holds many coalesced PDUs
+#define SMPP_HDR_LEN            16              // command_length, id, status and sequence
+#define SMPP_MAX_PDU_LEN        (SMS_BUFFER_SIZE - 1)   // anything longer is a broken stream
+#define SMS_FLUSH_BYTES         32768           // queued output that's written even while corked
+#define SMS_SEND_TIMEOUT        5000            // ms to wait on a full socket before giving up on it
+#define SMPP_WINDOW_DEFAULT     10              // submit_sm's allowed in flight awaiting response
+#define SMPP_WINDOW_MAX         500             // upper bound for the window
+#define SMPP_RESP_TIMEOUT       30000           // ms to wait for a submit_sm_resp before resubmitting
+#define SMPP_MAX_RETRIES        3               // resubmits before giving up on a message
+#define SMPP_THROTTLE_BACKOFF   1000            // ms a throttled submit_sm waits to go again, at most
+#define SMPP_DLR_TIMEOUT        172800          // s to wait on a receipt when there's no validity_period
+#define SMPP_DLR_GRACE          600             // s past validity_period before querying instead
+#define SMPP_QUERY_INTERVAL     3600            // s between queries while SMSC says it's still enroute
 
 
 
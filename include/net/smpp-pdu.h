@@ -0,0 +1,538 @@
+/**
+ * @file smpp-pdu.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief The SMPP v3.4 PDU encoder and decoder. Each command's mandatory body
+ *  is described at compile time as a list of typed fields; the encoder writes
+ *  them straight into a caller supplied buffer from std::string_view's, and the
+ *  decoder hands them back as std::string_view's into the received PDU; so
+ *  nothing is copied into temporaries and nothing is allocated either way.
+ * @version 0.1
+ * @date 2024-03-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef SMPP_PDU_H
+#define SMPP_PDU_H
+
+
+
+//===============================================================================|
+//              INCLUDES
+//===============================================================================|
+#include "basics.h"
+#include "smpp-konstants.h"
+
+
+
+
+
+//===============================================================================|
+//              DEFINES
+//===============================================================================|
+#define SMPP_SHORT_MSG_MAX      254         // longest short_message; beyond goes as payload
+#define SMPP_PAYLOAD_MAX        65'534      // longest message_payload we send at once
+#define SMPP_MULTI_DEST_MAX     254         // destinations in a single submit_multi
+#define SMPP_CONCAT_MAX         255         // parts of a concatenated message
+
+
+// the ways a long message goes to SMSC
+#define CONCAT_UDH8             0           // parts with an 8-bit reference UDH
+#define CONCAT_UDH16            1           // parts with a 16-bit reference UDH
+#define CONCAT_SAR              2           // parts with the sar_* TLVs; SMSC adds the UDH
+#define CONCAT_PAYLOAD          3           // the whole as message_payload; SMSC splits it
+
+
+
+
+
+//===============================================================================|
+//              TYPES
+//===============================================================================|
+/**
+ * @brief A little make life easy structure that captures the mandatory feilds
+ *  for smpp pdu.
+ *
+ */
+#pragma pack(push, 1)
+typedef struct SMPP_PDU_CMD_HDR
+{
+    u32 command_length;         // the length of the command
+    u32 command_id;             // the specific command (see defines above)
+    u32 command_status;         // indicates success or fail state of command
+    u32 sequence_num{0};        // the sequence num; defaulted to 0
+} Command_Hdr, *Command_Hdr_Ptr;
+#pragma pack(pop)
+
+
+
+
+/**
+ * @brief This little struct reprsents all the mandatory paramters in
+ *  SMPP v3.4 as a little option table that can be controlled by users through
+ *  UI's and command interface.
+ *
+ */
+typedef struct SMPP_MANDATORY_PARAMETERS
+{
+    u8 interface_ver{SMPP_VER};                     // SMPP version (0x34 supported by this driver)
+    u8 service_type{ST_NULL};                       // the service type (see defines above)
+    u8 src_ton{TON_NATIONAL};                       // the type of number (see define above)
+    u8 src_npi{NPI_NATIONAL};                       // the numbering plan indicator
+    u8 dest_ton{TON_NATIONAL};                      // the type of number (see define above)
+    u8 dest_npi{NPI_NATIONAL};                      // the numbering plan indicator
+    u8 esm_class{ESM_DEFAULT};                      // indicates message type and mode (see define above)
+    u8 protocol_id{0};                              // set by SMSC, not generally used
+    u8 priority_flag{1};                            // 4 levels. 0 - 3 lowest to highest. >= 4 reservered
+    std::string schedule_delivery_time{""};         // format YYMMDDhhmmsstnnp (see SMPP specs)
+    std::string validity_period{""};                // expiary date (see SMPP specs on date format)
+    u8 registered_delivery{REG_DELV_REQ_RECEIPT};   // require SMSC recipts or SME reciepts?
+    u8 replace_present{1};                          // 0 don't replace, 1 replace, >=2 reserved
+    u8 data_coding{DATA_CODE_DEFAULT};              // defines the encoding scheme of sms
+    u8 sm_id{0};                                    // indicates the id for canned messages to send (0 for custom)
+} Smpp_Options, *Smpp_Options_Ptr;
+
+
+
+
+/**
+ * @brief Where a submit stands in a concatenated message; total is 0 for a
+ *  message sent whole.
+ *
+ */
+typedef struct CONCAT_INFO
+{
+    u16 ref{0};             // the reference # shared by the parts
+    u8 total{0};            // parts in all
+    u8 seqnum{0};           // this one's; from 1
+    u8 mode{CONCAT_UDH8};   // one of CONCAT_*
+} Concat_Info, *Concat_Info_Ptr;
+
+
+
+
+/**
+ * @brief The decoded bodies of the PDUs we receive. Every std::string_view in
+ *  these points into the PDU itself, so they are only good for as long as the
+ *  PDU stays in the receive ring; i.e. while it's being dispatched. Whoever
+ *  needs a field for longer must copy it.
+ *
+ */
+typedef struct BIND_RESP_PDU
+{
+    std::string_view system_id;         // the SMSC's id
+} Bind_Resp_Pdu, *Bind_Resp_Pdu_Ptr;
+
+
+
+typedef struct SUBMIT_RESP_PDU
+{
+    std::string_view message_id;        // the id SMSC gave the message; empty on error
+    u8 no_unsuccess{0};                 // submit_multi_resp only; destinations that failed
+} Submit_Resp_Pdu, *Submit_Resp_Pdu_Ptr;
+
+
+
+typedef struct QUERY_RESP_PDU
+{
+    std::string_view message_id;        // the message queried
+    std::string_view final_date;        // when it reached its final state, if it has
+    u8 message_state{0};                // one of SMPP_ENROUTE ... SMPP_REJECTED
+    u8 error_code{0};                   // network specific error
+} Query_Resp_Pdu, *Query_Resp_Pdu_Ptr;
+
+
+
+typedef struct DELIVER_SM_PDU
+{
+    std::string_view service_type;
+    u8 src_ton{0};
+    u8 src_npi{0};
+    std::string_view source_addr;       // the phone that sent it
+    u8 dest_ton{0};
+    u8 dest_npi{0};
+    std::string_view destination_addr;  // that's us
+    u8 esm_class{0};                    // ESM_SMSC_RECEIPT etc.
+    u8 protocol_id{0};
+    u8 priority_flag{0};
+    std::string_view schedule_delivery_time;
+    std::string_view validity_period;
+    u8 registered_delivery{0};
+    u8 replace_present{0};
+    u8 data_coding{0};
+    u8 sm_id{0};
+    std::string_view short_message;     // the text, or the receipt text for DLR's
+
+    // the optional parameters we care about; the rest are skipped
+    std::string_view receipted_message_id;  // id of the message a receipt is about
+    std::string_view message_payload;       // long text in place of short_message
+    std::string_view network_error_code;    // 3 octets when present
+    u8 message_state{0};                    // final state of the receipted message
+    u16 user_message_reference{0};
+    u16 sar_msg_ref_num{0};                 // concatenation; sar_total_segments is 0
+    u8 sar_total_segments{0};               //  when the message is whole
+    u8 sar_segment_seqnum{0};
+} Deliver_Sm_Pdu, *Deliver_Sm_Pdu_Ptr;
+
+
+
+/**
+ * @brief The fields of a delivery receipt as SMSC's write them in its text;
+ *  "id:IIIIIIIIII sub:SSS dlvrd:DDD submit date:YYMMDDhhmm done date:YYMMDDhhmm
+ *  stat:DDDDDDD err:E text:...", from appendix B of the SMPP 3.4 spec.
+ */
+typedef struct DLR_TEXT
+{
+    std::string_view id;                // the message_id the receipt is about
+    std::string_view sub;               // parts submitted
+    std::string_view dlvrd;             // and delivered
+    std::string_view submit_date;
+    std::string_view done_date;         // when the message reached its final state
+    std::string_view stat;              // DELIVRD, UNDELIV and the like
+    std::string_view err;               // network specific error code
+    std::string_view text;              // the first few characters of the message
+    u8 message_state{0};                // stat as one of SMPP_*; 0 for one we don't know
+    u16 error{0};                       // err as a number
+} Dlr_Text, *Dlr_Text_Ptr;
+
+
+
+
+
+//===============================================================================|
+//              CLASS
+//===============================================================================|
+/**
+ * @brief Appends PDU fields to a fixed buffer. The header is left blank until
+ *  Finish, when the length is known. Rather than checking after every field,
+ *  an overflow or an over long field merely marks the writer bad and Finish
+ *  refuses the PDU; so the field writers stay branch light on the hot path.
+ *
+ */
+class PduWriter
+{
+public:
+
+    PduWriter(char *buf, const size_t cap, const size_t pos = SMPP_HDR_LEN)
+        :buf{buf}, cap{cap}, pos{pos}, ok{cap >= pos} {}
+
+    void Put_U8(const u8 value)
+    {
+        if (pos + 1 > cap) { ok = false; return; }
+        buf[pos++] = (char)value;
+    } // end Put_U8
+
+    void Put_U16(const u16 value)
+    {
+        if (pos + 2 > cap) { ok = false; return; }
+        u16 n = htons(value);
+        iCpy(buf + pos, &n, 2);
+        pos += 2;
+    } // end Put_U16
+
+    // a C-Octet String; max counts the terminating null as SMPP does
+    void Put_CString(const std::string_view value, const size_t max)
+    {
+        if (value.size() >= max || pos + value.size() + 1 > cap) { ok = false; return; }
+        iCpy(buf + pos, value.data(), value.size());
+        pos += value.size();
+        buf[pos++] = 0x0;
+    } // end Put_CString
+
+    void Put_Octets(const std::string_view value)
+    {
+        if (pos + value.size() > cap) { ok = false; return; }
+        iCpy(buf + pos, value.data(), value.size());
+        pos += value.size();
+    } // end Put_Octets
+
+    void Put_TLV(const u16 tag, const std::string_view value)
+    {
+        Put_U16(tag);
+        Put_U16((u16)value.size());
+        Put_Octets(value);
+    } // end Put_TLV
+
+    void Put_TLV_U16(const u16 tag, const u16 value)
+    {
+        Put_U16(tag);
+        Put_U16(sizeof(u16));
+        Put_U16(value);
+    } // end Put_TLV_U16
+
+
+    void Put_TLV_U8(const u16 tag, const u8 value)
+    {
+        Put_U16(tag);
+        Put_U16(sizeof(u8));
+        Put_U8(value);
+    } // end Put_TLV_U8
+
+    // fills in the header; returns the PDU length or -1 if anything didn't fit
+    int Finish(const u32 command_id, const u32 status, const u32 seq)
+    {
+        if (!ok)
+            return -1;
+
+        u32 hdr[4] = {htonl((u32)pos), htonl(command_id), htonl(status), htonl(seq)};
+        iCpy(buf, hdr, SMPP_HDR_LEN);
+        return (int)pos;
+    } // end Finish
+
+    void Fail() { ok = false; }
+    size_t Length() const { return pos; }
+    bool Ok() const { return ok; }
+
+private:
+
+    char *buf;          // where the PDU goes
+    size_t cap;         // size of buf
+    size_t pos;         // the next byte to write
+    bool ok;            // false once something didn't fit
+};
+
+
+
+
+/**
+ * @brief Walks the body of a received PDU. It never reads past the end given by
+ *  command_length: a field that would cross it marks the reader bad, yields an
+ *  empty value and leaves the reader at the end, so the caller only has to look
+ *  at Ok() once when done. C-Octet Strings are taken as long as they're null
+ *  terminated inside the PDU; some SMSC's overstep the lengths in the specs.
+ *
+ */
+class PduReader
+{
+public:
+
+    PduReader(const char *pdu, const size_t len)
+        :ptr{pdu + (len < SMPP_HDR_LEN ? len : SMPP_HDR_LEN)}, end{pdu + len}, 
+         ok{len >= SMPP_HDR_LEN} {}
+
+    void Get_U8(u8 &value)
+    {
+        if (end - ptr < 1) { Fail(); value = 0; return; }
+        value = (u8)*ptr++;
+    } // end Get_U8
+
+    void Get_U16(u16 &value)
+    {
+        if (end - ptr < 2) { Fail(); value = 0; return; }
+        iCpy(&value, ptr, 2);
+        value = ntohs(value);
+        ptr += 2;
+    } // end Get_U16
+
+    void Get_CString(std::string_view &value)
+    {
+        const char *nul = (const char *)memchr(ptr, 0, end - ptr);
+        if (!nul) { Fail(); value = {}; return; }
+        value = std::string_view{ptr, (size_t)(nul - ptr)};
+        ptr = nul + 1;
+    } // end Get_CString
+
+    void Get_Octets(const size_t len, std::string_view &value)
+    {
+        if ((size_t)(end - ptr) < len) { Fail(); value = {}; return; }
+        value = std::string_view{ptr, len};
+        ptr += len;
+    } // end Get_Octets
+
+    void Fail() { ok = false; ptr = end; }
+    size_t Remaining() const { return end - ptr; }
+    bool Ok() const { return ok; }
+
+private:
+
+    const char *ptr;    // the next byte to read
+    const char *end;    // one past the last byte of the PDU
+    bool ok;            // false once a field has overrun the PDU
+};
+
+
+
+
+/**
+ * @brief The field descriptors. Each knows the most bytes it can take on the
+ *  wire (max_len) and how to put itself through a PduWriter.
+ *
+ */
+typedef struct PDU_INT8
+{
+    static constexpr size_t max_len = 1;
+    static void Put(PduWriter &w, const u8 value) { w.Put_U8(value); }
+    static void Get(PduReader &r, u8 &value) { r.Get_U8(value); }
+} Pdu_Int8;
+
+
+
+template <size_t N>
+struct Pdu_CString      // C-Octet String of at most N bytes with the null
+{
+    static constexpr size_t max_len = N;
+    static void Put(PduWriter &w, const std::string_view value) { w.Put_CString(value, N); }
+    static void Get(PduReader &r, std::string_view &value) { r.Get_CString(value); }
+};
+
+
+
+template <size_t N>
+struct Pdu_Short_Msg    // sm_length followed by that many octets of short_message
+{
+    static constexpr size_t max_len = 1 + N;
+    static void Put(PduWriter &w, const std::string_view value)
+    {
+        if (value.size() > N) { w.Fail(); return; }
+        w.Put_U8((u8)value.size());
+        w.Put_Octets(value);
+    } // end Put
+
+    static void Get(PduReader &r, std::string_view &value)
+    {
+        u8 len;
+        r.Get_U8(len);
+        r.Get_Octets(len, value);
+    } // end Get
+};
+
+
+
+
+/**
+ * @brief Puts a list of fields together as the layout of a PDU body. Put and Get
+ *  take exactly one value per field, in order, so a layout can't be encoded or
+ *  decoded with a field missing or out of place; and max_len tells at compile
+ *  time the most room the PDU could ever need.
+ *
+ * @tparam Fields the field descriptors in wire order
+ */
+template <typename... Fields>
+struct Pdu_Layout
+{
+    static constexpr size_t max_body = (Fields::max_len + ... + 0);
+    static constexpr size_t max_len = SMPP_HDR_LEN + max_body;
+
+    template <typename... Args>
+    static void Put(PduWriter &w, const Args &... args)
+    {
+        static_assert(sizeof...(Args) == sizeof...(Fields), "value count does not match the layout");
+        (Fields::Put(w, args), ...);
+    } // end Put
+
+    template <typename... Args>
+    static void Get(PduReader &r, Args &... args)
+    {
+        static_assert(sizeof...(Args) == sizeof...(Fields), "value count does not match the layout");
+        (Fields::Get(r, args), ...);
+    } // end Get
+};
+
+
+
+
+// bind_transmitter/receiver/transceiver: system_id, password, system_type,
+//  interface_version, addr_ton, addr_npi, address_range
+typedef Pdu_Layout<Pdu_CString<16>, Pdu_CString<9>, Pdu_Int8, Pdu_Int8, Pdu_Int8,
+    Pdu_Int8, Pdu_CString<41>> Bind_Layout;
+
+// the leading fields of submit_sm/submit_multi: service_type, source_addr_ton,
+//  source_addr_npi, source_addr; these hardly ever change for a bind
+typedef Pdu_Layout<Pdu_Int8, Pdu_Int8, Pdu_Int8, Pdu_CString<21>> Submit_Prefix_Layout;
+
+// the rest of submit_sm up to the message: dest_addr_ton, dest_addr_npi,
+//  destination_addr, esm_class, protocol_id, priority_flag, schedule_delivery_time,
+//  validity_period, registered_delivery, replace_if_present_flag, data_coding,
+//  sm_default_msg_id; sm_length + short_message follow as a Pdu_Short_Msg unless
+//  the text goes as message_payload.
+typedef Pdu_Layout<Pdu_Int8, Pdu_Int8, Pdu_CString<21>, Pdu_Int8, Pdu_Int8, Pdu_Int8,
+    Pdu_CString<17>, Pdu_CString<17>, Pdu_Int8, Pdu_Int8, Pdu_Int8, Pdu_Int8> Submit_Body_Layout;
+
+// one entry in submit_multi's dest_address list: dest_flag, ton, npi, address
+typedef Pdu_Layout<Pdu_Int8, Pdu_Int8, Pdu_Int8, Pdu_CString<21>> Multi_Dest_Layout;
+
+// the rest of submit_multi after the dest_address list; as submit_sm from
+//  esm_class through sm_default_msg_id
+typedef Pdu_Layout<Pdu_Int8, Pdu_Int8, Pdu_Int8, Pdu_CString<17>, Pdu_CString<17>,
+    Pdu_Int8, Pdu_Int8, Pdu_Int8, Pdu_Int8> Multi_Body_Layout;
+
+// query_sm: message_id, source_addr_ton, source_addr_npi, source_addr
+typedef Pdu_Layout<Pdu_CString<65>, Pdu_Int8, Pdu_Int8, Pdu_CString<21>> Query_Layout;
+
+// cancel_sm: service_type, message_id, source_addr_ton, source_addr_npi,
+//  source_addr, dest_addr_ton, dest_addr_npi, destination_addr
+typedef Pdu_Layout<Pdu_Int8, Pdu_CString<65>, Pdu_Int8, Pdu_Int8, Pdu_CString<21>,
+    Pdu_Int8, Pdu_Int8, Pdu_CString<21>> Cancel_Layout;
+
+// replace_sm: message_id, source_addr_ton, source_addr_npi, source_addr,
+//  schedule_delivery_time, validity_period, registered_delivery,
+//  sm_default_msg_id, sm_length + short_message
+typedef Pdu_Layout<Pdu_CString<65>, Pdu_Int8, Pdu_Int8, Pdu_CString<21>, Pdu_CString<17>,
+    Pdu_CString<17>, Pdu_Int8, Pdu_Int8, Pdu_Short_Msg<SMPP_SHORT_MSG_MAX>> Replace_Layout;
+
+// deliver_sm_resp: message_id (unused, always null)
+typedef Pdu_Layout<Pdu_CString<1>> Deliver_Rsp_Layout;
+
+// deliver_sm, much like a submit_sm in the other direction: service_type,
+//  source_addr_ton, source_addr_npi, source_addr, dest_addr_ton, dest_addr_npi,
+//  destination_addr, esm_class, protocol_id, priority_flag, schedule_delivery_time,
+//  validity_period, registered_delivery, replace_if_present_flag, data_coding,
+//  sm_default_msg_id, sm_length + short_message
+typedef Pdu_Layout<Pdu_CString<6>, Pdu_Int8, Pdu_Int8, Pdu_CString<21>, Pdu_Int8, Pdu_Int8,
+    Pdu_CString<21>, Pdu_Int8, Pdu_Int8, Pdu_Int8, Pdu_CString<17>, Pdu_CString<17>, Pdu_Int8,
+    Pdu_Int8, Pdu_Int8, Pdu_Int8, Pdu_Short_Msg<SMPP_SHORT_MSG_MAX>> Deliver_Sm_Layout;
+
+// query_sm_resp: message_id, final_date, message_state, error_code
+typedef Pdu_Layout<Pdu_CString<65>, Pdu_CString<17>, Pdu_Int8, Pdu_Int8> Query_Resp_Layout;
+
+
+// the longest submit_sm/submit_multi we ever produce; an empty short_message,
+//  a message_payload, the user_message_reference and the three sar_* TLVs
+#define SUBMIT_TLV_MAX      (1 + 4 + SMPP_PAYLOAD_MAX + 6 + 16)
+#define SUBMIT_SM_MAX_LEN   (Submit_Prefix_Layout::max_len + Submit_Body_Layout::max_body \
+    + SUBMIT_TLV_MAX)
+#define SUBMIT_MULTI_MAX_LEN    (Submit_Prefix_Layout::max_len + 1 \
+    + SMPP_MULTI_DEST_MAX * Multi_Dest_Layout::max_body + Multi_Body_Layout::max_body \
+    + SUBMIT_TLV_MAX)
+
+static_assert(SUBMIT_SM_MAX_LEN <= SMS_BUFFER_SIZE, "a submit_sm must fit in SMS_BUFFER_SIZE");
+static_assert(SUBMIT_MULTI_MAX_LEN <= SMS_BUFFER_SIZE, "a submit_multi must fit in SMS_BUFFER_SIZE");
+
+
+
+
+
+//===============================================================================|
+//              FUNCTIONS
+//===============================================================================|
+int Encode_Bind(char *buf, const size_t len, const u32 command_id, const u32 seq,
+    const std::string_view system_id, const std::string_view pwd, const Smpp_Options &opts);
+
+size_t Encode_Submit_Prefix(char *buf, const size_t len, const Smpp_Options &opts,
+    const std::string_view src_addr);
+int Encode_Submit_Sm(char *buf, const size_t len, const size_t prefix_len, const u32 seq,
+    const Smpp_Options &opts, const std::string_view dest_num, const std::string_view msg,
+    const u8 can_id = 0, const Concat_Info *pconcat = nullptr);
+int Encode_Submit_Multi(char *buf, const size_t len, const size_t prefix_len, const u32 seq,
+    const Smpp_Options &opts, const std::string_view *dest_nums, const size_t dest_count,
+    const std::string_view msg, const u8 can_id = 0, const Concat_Info *pconcat = nullptr);
+
+int Encode_Query_Sm(char *buf, const size_t len, const u32 seq, const std::string_view msg_id,
+    const Smpp_Options &opts, const std::string_view src_addr);
+int Encode_Cancel_Sm(char *buf, const size_t len, const u32 seq, const std::string_view msg_id,
+    const Smpp_Options &opts, const std::string_view src_addr);
+int Encode_Replace_Sm(char *buf, const size_t len, const u32 seq, const std::string_view msg_id,
+    const Smpp_Options &opts, const std::string_view msg, const std::string_view src_addr);
+int Encode_Deliver_Rsp(char *buf, const size_t len, const u32 seq, const u32 status);
+
+int Decode_Bind_Resp(const char *pdu, const size_t len, Bind_Resp_Pdu &out);
+int Decode_Submit_Resp(const char *pdu, const size_t len, Submit_Resp_Pdu &out);
+int Decode_Submit_Multi_Resp(const char *pdu, const size_t len, Submit_Resp_Pdu &out);
+int Decode_Query_Resp(const char *pdu, const size_t len, Query_Resp_Pdu &out);
+int Decode_Deliver_Sm(const char *pdu, const size_t len, Deliver_Sm_Pdu &out);
+int Decode_User_Data(const Deliver_Sm_Pdu &dlv, std::string_view &body, Concat_Info &concat);
+int Parse_Receipt(const std::string_view text, Dlr_Text &out);
+
+
+#endif
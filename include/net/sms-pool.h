@@ -0,0 +1,164 @@
+/**
+ * @file sms-pool.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief A pool of binds to one SMSC account. SMSC's cap the rate of a bind
+ *  but let a system_id hold several at once, so messages are spread over as
+ *  many transmitters as the account allows: to the one with the fewest
+ *  submits awaiting response, or to each in turn. Receipts may be taken on
+ *  receiver binds of their own; they find their way back to the transmitter
+ *  the message went out on. A bind that's lost is tried again in a while,
+ *  longer with every attempt that fails and offset by its place in the pool,
+ *  so the binds don't all come knocking at once once the SMSC is back.
+ *
+ *  A receipt may come in on a receiver before the response to its message
+ *  does on the transmitter; it's reported right away, as one for a message
+ *  of an earlier run would be, and kept a while in case the response shows.
+ *
+ *  Every bind of a pool must be read on the same thread; a receipt is settled
+ *  on its transmitter from under the receiver's lock.
+ * @version 0.1
+ * @date 2024-03-30
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef SMS_POOL_H
+#define SMS_POOL_H
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "sms.h"
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+// how messages are spread over the transmitters
+#define POOL_LEAST_IN_FLIGHT    0           // the one with the fewest awaiting response
+#define POOL_ROUND_ROBIN        1           // each in turn, skipping those with no room
+
+// what the pool comes to as a whole
+#define POOL_DOWN               0           // no transmitter bound
+#define POOL_DEGRADED           1           // some binds are, not all
+#define POOL_UP                 2           // every bind is
+
+#define POOL_MAX_BINDS          64          // binds to one account
+#define POOL_RECONNECT_MIN      1000        // ms before a lost bind is first tried again
+#define POOL_RECONNECT_MAX      60000       // ms the wait between attempts grows to
+#define POOL_STAGGER            500         // ms between one bind's attempts and the next's
+#define POOL_EARLY_MAX          4096        // receipts kept for responses yet to come
+
+
+
+
+
+//===============================================================================|
+//          TYPES
+//===============================================================================|
+/**
+ * @brief How the binds of a pool are doing, all told
+ */
+typedef struct POOL_HEALTH
+{
+    u32 binds{0};               // in the pool
+    u32 bound{0};               // of them bound
+    u32 tx_bound{0};            // bound and able to send
+    u32 rx_bound{0};            // bound and able to take receipts
+    u32 in_flight{0};           // submits awaiting response, over every bind
+    u32 window{0};              // what the windows of the bound transmitters add up to
+    u64 reconnects{0};          // binds made again since startup
+    u8 state{POOL_DOWN};        // one of POOL_*
+} Pool_Health;
+
+
+
+/**
+ * @brief Gets a bind that's just been connected again, for it to be watched
+ */
+typedef std::function<void(Sms &sms)> Rebound_Fn;
+
+
+
+
+
+//===============================================================================|
+//          CLASS
+//===============================================================================|
+class SmsPool : public SmsPeers
+{
+public:
+
+    SmsPool();
+    ~SmsPool() override;
+
+    SmsPool(const SmsPool &) = delete;
+    SmsPool &operator=(const SmsPool &) = delete;
+
+    int Open(const std::string &host, const std::string &port, const std::string &sys_id,
+        const std::string &pwd, const u32 tx = 1, const u32 rx = 0);
+    int Startup();
+    void Shutdown();
+    size_t Reconnect(const Rebound_Fn &fn);
+
+    Sms *Pick();
+    void Cork();
+    int Uncork();
+    int Check_Timeouts(char *err, const size_t buf_len);
+
+    void Set_Policy(const u8 policy);
+    void Set_Stagger(const u32 stagger_ms);
+    void Set_Window(const u32 size);
+    void Set_Wait(const bool wait);
+    void Set_Resp_Timeout(const u32 timeout, const u8 retries = SMPP_MAX_RETRIES);
+    void Set_Concat(const u8 mode);
+
+    size_t Get_Size() const { return sessions.size(); }
+    u32 Get_Transmitters() const { return tx_count; }
+    Sms &Get_Session(const size_t i) { return sessions[i]->sms; }
+    Pool_Health Get_Health() const;
+    std::string Get_Err() const { return err; }
+
+    int Settle(const size_t from, const std::string_view msg_id, const u8 status) override;
+    u8 Claim_Early(const std::string_view msg_id) override;
+
+private:
+
+    typedef struct POOL_SESSION
+    {
+        Sms sms;
+        u32 index{0};                               // place in the pool; sets its stagger
+        u32 mode{bind_transceiver};                 // how it binds
+        u32 failures{0};                            // attempts in a row that didn't connect
+        bool down{false};                           // lost and waiting on retry_at
+        std::chrono::steady_clock::time_point retry_at;
+    } Pool_Session;
+
+    void Retry_Later(Pool_Session &s, const std::chrono::steady_clock::time_point now);
+
+    std::string host;
+    std::string port;
+    std::string system_id;
+    std::string pwd;
+
+    std::vector<std::unique_ptr<Pool_Session>> sessions;   // transmitters first; sized by Open
+    u32 tx_count;               // sessions that send
+    u8 policy;                  // one of POOL_LEAST_IN_FLIGHT or POOL_ROUND_ROBIN
+    u32 stagger_ms;
+    std::atomic<u32> cursor;    // where the next pick starts looking
+    u64 reconnects;
+    std::string err;            // the last bind that failed for good
+
+    std::unordered_map<std::string, u8> early;      // receipts by message_id, with their state
+    std::deque<std::string> early_order;            // oldest first; some may be claimed already
+    std::mutex early_mutex;                         // guards the two
+};
+
+
+#endif
@@ -18,7 +18,12 @@
 //              INCLUDES
 //===============================================================================|
 #include "tcp-client.h"
-#include "smpp-konstants.h"
+#include "ring-buffer.h"
+#include "inflight-tracker.h"
+#include "timer-wheel.h"
+#include "segmenter.h"
+#include "charset.h"
+#include "reassembly.h"
 
 
 
@@ -28,7 +33,8 @@
 //              MACROS
 //===============================================================================|
 extern void Print(const std::string);
-extern void Update_Out_SMS_DB(const std::string msg_id, const u8 status);
+extern void Update_Out_SMS_DB(const u32 row_id, const std::string_view msg_id, const u8 status);
+extern void Write_In_SMS_DB(const std::string_view phone_no, const std::string_view msg, const u8 error);
 
 
 
@@ -43,71 +49,6 @@ extern void Update_Out_SMS_DB(const std::string msg_id, const u8 status);
 //===============================================================================|
 //              TYPES
 //===============================================================================|
-/**
- * @brief A little make life easy structure that captures the mandatory feilds
- *  for smpp pdu.
- * 
- */
-#pragma pack(1)
-typedef struct SMPP_PDU_CMD_HDR
-{
-    u32 command_length;         // the length of the command
-    u32 command_id;             // the specific command (see defines above)
-    u32 command_status;         // indicates success or fail state of command
-    u32 sequence_num{0};        // the sequence num; defaulted to 0
-} Command_Hdr, *Command_Hdr_Ptr;
-
-
-
-
-/**
- * @brief This little struct reprsents all the mandatory paramters in 
- *  SMPP v3.4 as a little option table that can be controlled by users through
- *  UI's and command interface.
- * 
- */
-typedef struct SMPP_MANDATORY_PARAMETERS
-{
-    u8 interface_ver{SMPP_VER};                     // SMPP version (0x34 supported by this driver)
-    u8 service_type{ST_NULL};                       // the service type (see defines above)
-    u8 src_ton{TON_NATIONAL};                       // the type of number (see define above)
-    u8 src_npi{NPI_NATIONAL};                       // the numbering plan indicator
-    u8 dest_ton{TON_NATIONAL};                      // the type of number (see define above)
-    u8 dest_npi{NPI_NATIONAL};                      // the numbering plan indicator
-    u8 esm_class{ESM_DEFAULT};                      // indicates message type and mode (see define above)
-    u8 protocol_id{0};                              // set by SMSC, not generally used
-    u8 priority_flag{1};                            // 4 levels. 0 - 3 lowest to highest. >= 4 reservered
-    std::string schedule_delivery_time{""};         // format YYMMDDhhmmsstnnp (see SMPP specs)
-    std::string validity_period{""};                // expiary date (see SMPP specs on date format)
-    u8 registered_delivery{REG_DELV_REQ_RECEIPT};   // require SMSC recipts or SME reciepts?
-    u8 replace_present{1};                          // 0 don't replace, 1 replace, >=2 reserved
-    u8 data_coding{DATA_CODE_DEFAULT};              // defines the encoding scheme of sms
-    u8 sm_id{0};                                    // indicates the id for canned messages to send (0 for custom)
-} Smpp_Options, *Smpp_Options_Ptr;
-
-
-
-
-/**
- * @brief This is a structure that is used to keep track of all the active items
- *  the application needs. By keeping track of sent messages that have not yet been
- *  confrimed the application has the chance of re-submitting messages or do other
- *  stuff like change/update or even remove the messages before final arrival.
- * This litlle struct is used for single messages as distinct from bulk.
- * 
- */
-typedef struct SMS_INFO_STRUCT
-{
-    u8 msg_state;           // state of our little message
-    std::string id;         // sms id sent from ESME
-    std::string msg;        // the sent message
-    std::string dst;        // the destination numerics
-    Smpp_Options opts;      // extra options associtated with this message
-} Single_Sms_Info, *Single_Sms_Info_Ptr;
-
-
-
-
 /**
  * @brief This is the same structure as SMS_INFO_STRUCT. However this has been
  *  slightly modified to handle bulk messages only. The differences in the two
@@ -123,6 +64,8 @@ typedef struct SMS_INFO_STRUCT_BULK
     std::string msg;        // the sent message
     std::queue<std::string> dst;        // the destination numerics
     Smpp_Options opts;      // extra options assc
+    u64 timer{0};           // submit_multi_resp timeout
+    u32 row_id{0};          // the message it's reported as; 0 for none
 } Bulk_Sms_Info, *Bulk_Sms_Info_Ptr;
 
 
@@ -130,6 +73,29 @@ typedef struct SMS_INFO_STRUCT_BULK
 
 
 
+/**
+ * @brief The parts of a long message are tracked as messages of their own; this
+ *  is what they add up to. The message is reported under the first id SMSC
+ *  gives any of its parts: submitted once every part is, delivered once every
+ *  part is, and failed or expired as soon as any one part is.
+ * 
+ */
+typedef struct CONCAT_GROUP
+{
+    std::string id;         // what the message is reported as
+    u8 total{0};            // parts in all
+    u8 accepted{0};         // parts SMSC has taken
+    u8 delivered{0};        // parts with a receipt
+    u8 left{0};             // parts still tracked, or yet to be sent
+    u8 state{MSG_STATE_SENT};   // the last state reported
+    u32 row_id{0};          // the message's row, when it came from one
+} Concat_Group, *Concat_Group_Ptr;
+
+
+
+
+
+
 /**
  * @brief A structure used to hold temporary info on messages that are being recieved 
  *  in our system.
@@ -148,6 +114,30 @@ typedef struct DELIVER_QUEUE
 
 
 
+/**
+ * @brief The other binds to the same account, as a bind sees them; so that a
+ *  receipt finds the bind its message went out on, whichever bind it comes in
+ *  on, and even when it beats the message's response there. See SmsPool.
+ * 
+ */
+class SmsPeers
+{
+public:
+
+    virtual ~SmsPeers() = default;
+
+    // a receipt for a message bind from didn't send; 0 when a peer took it in
+    virtual int Settle(const size_t from, const std::string_view msg_id, const u8 status) = 0;
+
+    // the state a receipt that came early for msg_id had, alas 0
+    virtual u8 Claim_Early(const std::string_view msg_id) = 0;
+};
+
+
+
+
+
+
 /**
  * @brief Main Sms class used to handle all comms using SMPPv3.4 Protocol. The class is threaded
  *  so as to work in async and implement realtime functionalities, i.e. Sms messages trigger
@@ -174,12 +164,17 @@ public:
     int Disconnect();
 
     
-    int Send_Bulk_Message(const std::string msg, std::list<std::string> &dest_nums,
-        const Smpp_Options_Ptr poptions = nullptr);
-    int Send_Message(const std::string msg, const std::string dest_num, 
-        const Smpp_Options_Ptr poptions = nullptr);
+    int Send_Bulk_Message(const std::string_view msg, std::list<std::string> &dest_nums,
+        const Smpp_Options_Ptr poptions = nullptr, const u32 row_id = 0);
+    int Send_Message(const std::string_view msg, const std::string_view dest_num, 
+        const Smpp_Options_Ptr poptions = nullptr, const u32 row_id = 0);
+    size_t Count_Parts(const std::string_view msg, const Smpp_Options_Ptr poptions = nullptr);
     int Process_Incoming(char *err, const size_t buf_len = MAXLINE);
 
+    void Cork();
+    int Uncork();
+    int Flush();
+
 
     // stright up smpp's
     int Bind(const u32 command_id);
@@ -187,33 +182,49 @@ public:
     int Unbind();
     int Unbind_Resp(const u32 resp = ESME_ROK);
     int Generic_Nack();
-    int Submit(const std::string &msg, const std::string &dest_num, 
-        const Smpp_Options_Ptr poptions, const u8 can_id = 0);
-    int Submit_Multi(const std::string &msg, std::queue<std::string> dest_nums,
-        const Smpp_Options_Ptr poptions, const u8 can_id = 0);
-    int Query(const std::string &msg_id, const Smpp_Options_Ptr poptions, 
-        const std::string src_addr = "");
+    int Submit(const std::string_view msg, const std::string_view dest_num, 
+        const Smpp_Options_Ptr poptions, const u8 can_id = 0, 
+        const Concat_Info *pconcat = nullptr, const u32 row_id = 0);
+    int Submit_Multi(const std::string_view msg, const std::string_view *dest_nums,
+        const size_t dest_count, const Smpp_Options_Ptr poptions, const u8 can_id = 0,
+        const Concat_Info *pconcat = nullptr, const u32 row_id = 0);
+    int Query(const std::string_view msg_id, const Smpp_Options_Ptr poptions, 
+        const std::string_view src_addr = "");
     
-    int Cancel(const std::string msg_id, const Smpp_Options_Ptr popts, const std::string src_addr="");
-    int Replace(const std::string msg_id, const Smpp_Options_Ptr popts, 
-        const std::string msg, const std::string src_addr="");
+    int Cancel(const std::string_view msg_id, const Smpp_Options_Ptr popts, 
+        const std::string_view src_addr = "");
+    int Replace(const std::string_view msg_id, const Smpp_Options_Ptr popts, 
+        const std::string_view msg, const std::string_view src_addr = "");
     int Enquire();
     int Enquire_Rsp(const u32 resp = ESME_ROK);
     //int Submit_Rsp(const u32 resp = ESME_ROK);
     int Deliver_Rsp(const u32 resp = ESME_ROK);
 
 
-    int Handle_Bind(char *err, const size_t buf_len);
+    int Handle_Bind(const char *pdu, const size_t pdu_len, char *err, const size_t buf_len);
     int Handle_Unbind(char *err, const size_t buf_len);
-    int Handle_Submit(char *err, const size_t buf_len);
-    int Handle_Deliver(char *err, const size_t buf_len, std::string &phone_no);
-    int Handle_Query(char *err, const size_t buf_len);
+    int Handle_Submit(const char *pdu, const size_t pdu_len, char *err, const size_t buf_len);
+    int Handle_Submit_Multi(const char *pdu, const size_t pdu_len, char *err, const size_t buf_len);
+    int Handle_Deliver(const char *pdu, const size_t pdu_len, char *err, const size_t buf_len, 
+        std::string_view &phone_no);
+    int Handle_Query(const char *pdu, const size_t pdu_len, char *err, const size_t buf_len);
+
+    int Check_Timeouts(char *err, const size_t buf_len);
+    int Settle(const std::string_view msg_id, const u8 status);
 
 
     // accessors
     int Get_Connection() const;
     void Set_HB_Interval(const u32 interval);
     u32 Get_HB_Interval() const;
+    void Set_Window(const u32 size);
+    u32 Get_Window() const;
+    u32 Get_In_Flight() const;
+    void Set_Wait(const bool wait);
+    void Set_Resp_Timeout(const u32 timeout, const u8 retries = SMPP_MAX_RETRIES);
+    void Set_Concat(const u8 mode);
+    u8 Get_Concat() const;
+    void Set_Peers(SmsPeers *ppeers, const size_t index);
 
     int Get_State() const;
     std::string Get_SystemID() const;
@@ -225,9 +236,39 @@ public:
 
 private:
 
+    int Read_Pdus(char *err, const size_t buf_len);
+    int Dispatch_Pdu(const char *pdu, const size_t pdu_len, char *err, const size_t buf_len);
+    char *Reserve_Pdu(const size_t len);
+    int Commit_Pdu(const int len);
+    int Send_Pdu(const char *pdu, const size_t len);
+    size_t Submit_Prefix(const Smpp_Options_Ptr popts);
+    int Wait_Window(std::unique_lock<std::recursive_mutex> &lock);
+    int Expire(const Timer_Event &event, char *err, const size_t buf_len);
+    void Forget(const u32 slot, const u8 report = MSG_STATE_SENT);
+    void Drop_Stale(const u32 slot);
+    Smpp_Options_Ptr Encode(std::string_view &msg, const Smpp_Options_Ptr popt,
+        Smpp_Options &coded);
+    size_t Split(const std::string_view msg, const Smpp_Options_Ptr popt, 
+        std::string_view *parts);
+    void Report(const Single_Sms_Info &info, const u8 status);
+    void Roll_Up(const u32 group, const std::string_view id, const u8 status);
+    void Leave_Group(const u32 group, const u8 parts = 1);
+    void Receipt(const Deliver_Sm_Pdu &dlv);
+    void Receive(const Deliver_Sm_Pdu &dlv);
+
     u8 sms_state;               // state of our little sms
     u32 seq_num;                // the current message sequence #
     u32 heartbeat_interval;     // determines the interval for heartbeat signal
+    u32 window_size;            // max submit's allowed in flight awaiting response
+    u32 window_cap;             // the window as throttling has left it; see Handle_Submit
+    u32 in_flight;              // submit's sent but not yet responded to
+    u32 held;                   // submit's throttled, waiting to go again
+    u32 resp_timeout;           // ms to wait for a response before resubmitting
+    u32 backoff;                // ms a throttled submit waits before it's sent again
+    u8 max_retries;             // resubmits before a message is given up on
+    u8 concat_mode;             // how long messages go; one of CONCAT_*
+    u16 concat_ref;             // reference # of the last long message
+    u32 group_seq;              // id of the last long message tracked
 
     std::string smsc_id;        // idenitifer for smsc, sent as a result of Bind
 
@@ -239,18 +280,33 @@ private:
     Smpp_Options options;       // options for our little smpp client
     Command_Hdr cmd_hdr;        // used for sending
     Command_Hdr cmd_rsp;        // used during reception
-    std::map<u32, Single_Sms_Info> queued_msg;          // messages in queue used for quering stuff
+    InflightTracker queued_msg;                         // messages awaiting response or receipt
+    TimerWheel timers;                                  // their timeouts, and the bulks'
+    std::vector<Timer_Event> fired;                     // timeouts due, reused tick to tick
     std::map<u32, Bulk_Sms_Info> queued_blk_msg;        // same as above, but for bulks
     std::map<std::string, DeliverQueue> deliver_queue;  // queue for delivery state
+    std::unordered_map<u32, Concat_Group> groups;       // long messages by group id
+    Reassembly inbound;                                 // long messages sent to us, in parts
+    SmsPeers *ppeers;                                   // the other binds of the pool, if any
+    size_t peer_index;                                  // and where this one is among them
     
 
     bool bdebug;                // used for dumping hex views
     bool bheartbeat;            // toggles heart beat on/off
+    bool bwait;                 // Wait_Window sleeps for room; see Set_Wait
 
     std::thread *phbeat;        // handle to heartbeat thread
 
-    char snd_buffer[SMS_BUFFER_SIZE];     // sending buffer
-    char rcv_buffer[SMS_BUFFER_SIZE];     // recieving buffer
+    mutable std::recursive_mutex sms_mutex;     // guards the send side and the queues
+    std::condition_variable_any window_cond;    // signaled whenever a window slot frees
+
+    u32 prefix_key;                       // the options submit_prefix was built for
+    size_t prefix_len;                    // bytes in submit_prefix; 0 when stale
+    char submit_prefix[Submit_Prefix_Layout::max_len];  // header space thru source_addr
+
+    RingBuffer rcv_ring;                  // raw stream from SMSC, framed on command_length
+    RingBuffer snd_ring;                  // PDUs encoded back to back awaiting the socket
+    u32 corked;                           // > 0 while writes are being held for a batch
     char err_desc[MAXLINE];               // buffer to store app specific errors
     
 }; // end class
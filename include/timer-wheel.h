@@ -0,0 +1,119 @@
+/**
+ * @file timer-wheel.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief A hierarchical timer wheel; a great many timeouts are armed, moved and
+ *  cancelled in constant time and the ones due are collected a tick at a time.
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "basics.h"
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define WHEEL_BITS          6                       // each level has 64 buckets
+#define WHEEL_SIZE          (1 << WHEEL_BITS)
+#define WHEEL_MASK          (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS        4                       // covers 64^4 ticks
+#define WHEEL_TICK_MS       100                     // default resolution; 64^4 of them is 19 days
+#define WHEEL_NIL           0xFFFFFFFF              // end of a bucket's list
+
+
+
+
+
+//===============================================================================|
+//          TYPES
+//===============================================================================|
+/**
+ * @brief What Advance hands back for every timer that went off; the key the
+ *  timer was armed with, and the timer itself so the owner can tell it from
+ *  one it has armed since under the same key.
+ *
+ */
+typedef struct TIMER_EVENT
+{
+    u64 key;            // as given to Schedule
+    u64 timer;          // as returned from Schedule
+} Timer_Event, *Timer_Event_Ptr;
+
+
+
+
+
+//===============================================================================|
+//          CLASS
+//===============================================================================|
+/**
+ * @brief Level 0 has a bucket per tick for the next 64 ticks, level 1 a bucket
+ *  per 64 ticks for the next 64^2 and so on. A timer is filed in the coarsest
+ *  level it needs and each time a level's turn comes up its bucket is emptied
+ *  into the finer levels below, so a timer is touched at most once per level
+ *  however far off it is. Timers live in a pool and are linked into their
+ *  bucket by index; a timer is known to its owner by its index and generation,
+ *  so cancelling one that has already gone off is harmless.
+ *
+ * Not thread safe; the owner is expected to hold its own lock.
+ *
+ */
+class TimerWheel
+{
+public:
+
+    TimerWheel(const u32 tick_ms = WHEEL_TICK_MS);
+
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+
+    u64 Schedule(const u64 key, const u64 delay_ms);
+    void Cancel(const u64 timer);
+    void Clear();
+
+    size_t Advance(const std::chrono::steady_clock::time_point now,
+        std::vector<Timer_Event> &fired);
+    size_t Size() const;
+
+private:
+
+    typedef struct NODE
+    {
+        u64 key{0};         // the owner's
+        u64 expires{0};     // the tick it's due
+        u32 gen{1};         // bumped each time the node is freed
+        u32 prev{WHEEL_NIL};
+        u32 next{WHEEL_NIL};
+        u32 bucket{WHEEL_NIL};  // level * WHEEL_SIZE + slot, or NIL when free
+    } Node;
+
+    void Place(const u32 index);
+    void Unlink(const u32 index);
+    void Release(const u32 index);
+    void Step(std::vector<Timer_Event> &fired);
+
+    std::vector<Node> nodes;        // the timer pool
+    std::vector<u32> free_list;     // unused nodes
+    u32 buckets[WHEEL_LEVELS * WHEEL_SIZE];    // heads of the bucket lists
+    u64 now_tick;                   // ticks since start
+    u32 tick_ms;                    // length of a tick
+    size_t count;                   // timers armed
+    std::chrono::steady_clock::time_point start;
+};
+
+
+#endif
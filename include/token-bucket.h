@@ -0,0 +1,72 @@
+/**
+ * @file token-bucket.h
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief A token bucket rate limiter. Tokens drip into the bucket at a fixed
+ *  rate up to a burst size; each unit of work takes one out and callers that
+ *  find the bucket empty sleep precisely until their token is due.
+ * @version 0.1
+ * @date 2024-03-06
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef TOKEN_BUCKET_H
+#define TOKEN_BUCKET_H
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "basics.h"
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define TB_UNLIMITED        0.0         // a rate of 0 turns throttling off
+
+
+
+
+
+//===============================================================================|
+//          CLASS
+//===============================================================================|
+/**
+ * @brief Callers that can't be served right away reserve their token by taking
+ *  the bucket into debt and then sleep on CLOCK_MONOTONIC with an absolute
+ *  deadline; so many threads may share a bucket, and neither of them burns CPU
+ *  while waiting. The rate can be changed at any time from another thread.
+ *
+ */
+class TokenBucket
+{
+public:
+
+    TokenBucket(const double rate = TB_UNLIMITED, const double burst = 1.0);
+
+    void Set_Rate(const double rate, const double burst = 0.0);
+    double Get_Rate() const;
+    double Get_Burst() const;
+
+    void Acquire(const double count = 1.0);
+    bool Try_Acquire(const double count = 1.0);
+
+private:
+
+    mutable std::mutex tb_mutex;    // guards all of the below
+    double rate;                    // tokens added per second
+    double burst;                   // most tokens the bucket can hold
+    double tokens;                  // tokens at hand; -ve when reserved ahead
+    u64 last_ns;                    // monotonic time of the last refill
+
+    void Refill(const u64 now_ns);
+};
+
+
+#endif
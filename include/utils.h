@@ -25,6 +25,7 @@
 //=====================================================================================|
 //          DEFINES
 //=====================================================================================|
+#define AMOUNT_BUFFER_SIZE      448     // fits any double as a grouped amount
 
 
 
@@ -62,6 +63,8 @@ std::vector<std::string> Split_String(const std::string &str, const char token);
 std::string Console_Out(const std::string app_name);
 std::string Replace_String(std::string str, const std::string patt, const std::string replace);
 std::string Format_Numerics(const double num);
+size_t Format_Amount(char *buf, const size_t size, const double num, const char group = ',', 
+    const char point = '.');
 
 
 #endif
\ No newline at end of file
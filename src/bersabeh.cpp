@@ -14,8 +14,14 @@
 //===============================================================================|
 //              INCLUDES
 //===============================================================================|
-#include "sms.h"
+#include "sms-pool.h"
+#include "event-loop.h"
 #include "messages.h"
+#include "outbox.h"
+#include "status-writer.h"
+#include "inbox-writer.h"
+#include "token-bucket.h"
+#include "mpsc-queue.h"
 #include "utils.h"
 #include "errors.h"
 using namespace std;
@@ -24,9 +30,40 @@ using namespace std;
 
 
 
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define TICK_INTERVAL       1000        // ms between checks for timed out submits
+#define DEFAULT_TPS         50          // messages per second when sms_address has none
+#define SUBMIT_QUEUE_SIZE   1024        // messages waiting on a reactor thread per SMSC
+
+
+// the http routes understood by the control port
+#define ROUTE_SEND_SMS      0
+#define ROUTE_SET_RATE      1
+
+
+
+
+
 //===============================================================================|
 //          TYPES
 //===============================================================================|
+/**
+ * @brief A message on its way to a reactor thread.
+ * 
+ */
+typedef struct SUBMISSION
+{
+    std::string msg;        // the text
+    std::string dst;        // the destination phone no
+    u32 row_id{0};          // its row in SmsOut
+    u32 parts{1};           // the window slots it takes
+} Submission, *Submission_Ptr;
+
+
+
+
 /**
  * @brief A little structure that organizes different object togther for the app.
  *  This is so because we don't want different SMS providers or better known as
@@ -37,7 +74,18 @@ using namespace std;
 typedef struct APP_CONTAINER
 {
     u32 id{0};
-    Sms sms;
+    SmsPool pool;               // the binds to the SMSC
+    u8 health{POOL_UP};         // how the pool was last seen; one of POOL_*
+    TokenBucket throttle;       // paces the sender to the SMSC's contracted TPS, times the binds
+    std::thread *psender{nullptr};
+
+    // used only when each SMSC runs on its own reactor thread
+    int cpu{-1};                // the core to pin the reactor to; -1 for any
+    std::thread *preactor{nullptr};
+    MpscQueue<Submission> submit_q{SUBMIT_QUEUE_SIZE};
+    Submission held;            // taken off submit_q, waiting for a window with room
+    bool holding{false};
+    EventNotifier wakeup;       // knocks on the reactor after a push
 
     std::string host;
     std::string port;
@@ -67,20 +115,99 @@ typedef struct SESSION_TAG
 
 
 
+//===============================================================================|
+//              CLASS
+//===============================================================================|
+/**
+ * @brief Watches the control port and hands every accepted connection to the
+ *  event loop as an Http_Session.
+ * 
+ */
+class Listener : public EventHandler
+{
+public:
+
+    Listener(const int fd, EventLoop &loop) : fd{fd}, loop{loop} {}
+
+    int Get_Fd() const override { return fd; }
+    int Handle_Event(const u32 events) override;
+
+private:
+
+    int fd;             // the listening socket
+    EventLoop &loop;    // where new sessions are registered
+};
+
+
+
+
+/**
+ * @brief A single http request on the control port. The session is created by
+ *  the Listener and releases itself once the request has been answered or the
+ *  peer goes away.
+ * 
+ */
+class Http_Session : public EventHandler
+{
+public:
+
+    Http_Session(const int fd, const std::string &ip, const std::string &port)
+        :session{fd, ip, port, 0, 0, 0, 0, 0, {0}} {}
+
+    int Get_Fd() const override { return session.fd; }
+    int Handle_Event(const u32 events) override;
+    void Handle_Close() override;
+
+private:
+
+    Session session;    // the request being read
+};
+
+
+
+
+/**
+ * @brief Routes traffic from one SMSC bind into its Sms object.
+ * 
+ */
+class Smsc_Handler : public EventHandler
+{
+public:
+
+    Smsc_Handler(AppContainer_Ptr app, Sms &sms) : app{app}, sms{sms} {}
+
+    int Get_Fd() const override { return sms.Get_Connection(); }
+    int Handle_Event(const u32 events) override;
+    void Handle_Close() override;
+
+private:
+
+    AppContainer_Ptr app;   // the SMSC
+    Sms &sms;               // the bind of its pool
+};
+
+
+
+
+
+
 //===============================================================================|
 //              GLOBALS
 //===============================================================================|
 int daemon_proc = 0;
 SYS_CONFIG sys_config;
 
-std::vector<AppContainer> app_container;     // list of SMS objects
-std::map<int, Session> session;              // session object mapped to its socket
-std::vector<SmsOut> db_messages;             // queue of db messages
+std::vector<AppContainer_Ptr> app_container; // list of SMS objects
+Outbox outbox;                               // unsent messages, streamed from db
 
 Messages db;
-bool sender_running{false};
-std::mutex _mutex;
-double msg_per_second{20.0 / (double)1'000};
+DbPool db_pool;                              // connections for the sender threads and reports
+StatusWriter status_writer;                  // message states, written behind the senders' backs
+InboxWriter inbox_writer;                    // messages sent to us, stored the same way
+std::atomic<bool> sender_running{false};
+
+bool use_reactor{false};                        // each SMSC on its own I/O thread?
+thread_local bool in_reactor{false};            // true on the reactor threads
 
 
 
@@ -100,12 +227,21 @@ int Get_Http_Request(Session_Ptr psession);
 int Parse_Header(char *buf);
 std::string Parse_Json_String(const char *buf, const std::string &key);
 int Parse_Json_Int(const char *buf, const std::string &key, int &value);
+int Set_Rate(const char *buf);
+int Parse_Rate(const std::string &rate, double &tps, double &burst);
 
 
 void Http_Ok(const int sockfd);
 void Http_Error(const int sockfd, const int err_code);
 
-void Sender_Thread(Sms *psms);
+void Sender_Thread(AppContainer_Ptr app);
+void Reactor_Thread(AppContainer_Ptr app);
+void Drain_Submissions(AppContainer_Ptr app);
+void Send_Out(Sms *psms, const std::string &msg, const std::string &dst, const u32 row_id);
+void Check_Timeouts(AppContainer_Ptr app);
+void Check_Binds(AppContainer_Ptr app, EventLoop &loop);
+void Watch_Binds(AppContainer_Ptr app, EventLoop &loop);
+void Watch_Bind(AppContainer_Ptr app, EventLoop &loop, Sms &sms);
 void Clean_Up();
 
 
@@ -122,8 +258,7 @@ int main(int argc, char *argv[])
     bool brun{true};
     struct sockaddr_in serv_addr;
 
-    std::vector<pollfd> vpoll;
-    pollfd tmppoll;
+    EventLoop loop;
     
 
     Print_Title();
@@ -137,16 +272,40 @@ int main(int argc, char *argv[])
         return -1;
     } // end if
 
+    // the sender threads and the reports lease their connections from here
+    u32 pool_size = atoi(sys_config.config["db_pool_size"].c_str());
+    if (db_pool.Open(sys_config.config["db_connection"], pool_size ? pool_size : DB_POOL_SIZE) < 0)
+    {
+        iQE::Dump_DB_Error();
+        return -1;
+    } // end if
+
+    db.Set_Pool(&db_pool);
+    u32 batch = atoi(sys_config.config["status_batch"].c_str());
+    u32 interval = atoi(sys_config.config["status_interval"].c_str());
+    status_writer.Start(&db_pool, batch, interval);
+    batch = atoi(sys_config.config["inbox_batch"].c_str());
+    interval = atoi(sys_config.config["inbox_interval"].c_str());
+    inbox_writer.Start(&db_pool, batch, interval);
+
     Print("Loading outgoing SMS from database.");
     db.Load_AID();
     db.Load_Current_Period();
     db.Load_Current_Period_Name();
     db.Load_SMS_Bill_Format();
     Print(db.Load_Unread_Format());
-    db_messages = db.Load_Messages();
+
+    // SmsOut is sent through on its own only when asked for
+    bool autosend = atoi(sys_config.config["sms_autosend"].c_str()) != 0;
+    if (autosend && outbox.Start(sys_config.config["db_connection"]) < 0)
+    {
+        iQE::Dump_DB_Error();
+        return -1;
+    } // end if
     //Print(std::to_string(db.Load_Reading_Period()));
-    //db_messages = db.Preview_Bill_SMS();
-    //db.Write_SMSOut(db_messages);
+    //SmsBatch previews;
+    //db.Preview_Bill_SMS(previews);
+    //db.Write_SMSOut(previews);
 
     Print("Starting server.");
     if ( (listen_fd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
@@ -165,146 +324,55 @@ int main(int argc, char *argv[])
         Dump_Err_Exit("failed to bind address to listening socket");
 
     
-    if ( listen(listen_fd, 32) < 0)
+    if ( listen(listen_fd, SOMAXCONN) < 0)
         Dump_Err_Exit("failed to listen");
 
+    if (Set_Non_Blocking(listen_fd) < 0)
+        Dump_Err_Exit("failed to make listening socket non-blocking");
+
     signal(SIGINT, Signal_Handler);
     Print("Now initializing SMS.");
     Init_SMS();
 
-    iZero(&tmppoll, sizeof(tmppoll));
-    tmppoll.events = POLLIN;
-    tmppoll.fd = listen_fd;
-    vpoll.push_back(tmppoll);
+    sender_running = true;      // the reactors go by it as well
+    if (autosend)
+    {
+        for (AppContainer_Ptr app : app_container)
+            app->psender = new std::thread(Sender_Thread, app);
+    } // end if
 
-    for ( size_t i{0}; i < app_container.size(); i++)
+    Listener listener{listen_fd, loop};
+    if (loop.Add(&listener) < 0)
+        Dump_Err_Exit("failed to watch the listening socket");
+
+    for (AppContainer_Ptr app : app_container)
     {
-        pollfd t2;
-        iZero(&t2, sizeof(t2));
-        t2.events = POLLIN;
-        t2.fd = app_container[i].sms.Get_Connection();
-        vpoll.push_back(t2);
+        if (use_reactor)
+            app->preactor = new std::thread(Reactor_Thread, app);
+        else
+            Watch_Binds(app, loop);
     } // end for all
 
 
     
     Print("Now listening on [*:" + std::to_string(port) + "]");
-    //int x{0};
+    auto last_tick = std::chrono::steady_clock::now();
     while (brun)
     {
-        //app_container[0].sms.Enquire();
-        int ret;
-        if ( (ret = POLL(vpoll.data(), vpoll.size())) <= 0)
-        {
-            if (ret < 0)
-                Dump_Err_Exit("poll error");
+        if (loop.Run_Once(TICK_INTERVAL) < 0)
+            Dump_Err_Exit("epoll error");
 
-            brun = false; 
-            break;
-        } // end if not cool
-
-        std::vector<pollfd> tmp{vpoll};
-        for (size_t i = 0; i < tmp.size(); i++)
+        auto now = std::chrono::steady_clock::now();
+        if (!use_reactor && now - last_tick >= std::chrono::milliseconds(TICK_INTERVAL))
         {
-            if (tmp[i].revents == 0 || !(tmp[i].revents & POLLIN))
-                continue;
-
-            if (tmp[i].fd == listen_fd)
-            {
-                // this is the listening socket, accept an incoming conn
-                sockaddr_in addr;
-                socklen_t addr_len = sizeof(sockaddr_in);
-                char ip[INET_ADDRSTRLEN];
-
-                int clifd = accept(listen_fd, (sockaddr*)&addr, &addr_len);
-                if (clifd < 0)
-                    Dump_Err("Accept error");
-
-
-                if (!inet_ntop(AF_INET, &addr.sin_addr, ip, INET_ADDRSTRLEN))
-                    Dump_Err("Converting address to human notation.");
-
-                Session s{clifd, ip, std::to_string(ntohs(addr.sin_port)), 0, 0, 0, 0, 0};
-                session.emplace(clifd, s);
-
-                pollfd t;
-                iZero(&t, sizeof(t));
-                t.events = POLLIN;
-                t.fd = clifd;
-                vpoll.push_back(t);
-
-                Print("New connection from " + s.ip + ":" + s.port);
-            } // end if listening socket
-            else 
+            for (AppContainer_Ptr app : app_container)
             {
-                bool issms{false};
-
-                // test which of the sms descriptors are ready
-                for (size_t item = 0; item < app_container.size(); item++)
-                {
-                    int n;
-                    if (tmp[i].fd == app_container[item].sms.Get_Connection())
-                    {
-                        char b[MAXLINE];
-                        if ( ( n = app_container[item].sms.Process_Incoming(b)) < 0)
-                        {
-                            if (n < 0)
-                            {
-                                if (n == -2)
-                                    Print(b);
-                                else
-                                   Dump_Err("Disconnected");
-                                // int fd = tmp[i].fd;
-                                // auto it = std::find_if(vpoll.begin(), vpoll.end(), [&fd](auto &v){ return v.fd == fd; });
-                                // if (it != vpoll.end())
-                                //     vpoll.erase(it);
-                                //Dump_Err_Exit("recv error");
-                            } // end if
-                        } // end if error
-    
-                        issms = true;
-                        // if (x++ < 1)
-                        //     for (size_t k{0}; k < db_messages.size(); k++)
-                        //     {
-                        //         app_container[0].sms.Send_Message(db_messages[k].message, db_messages[k].phoneno);
-                        //         if (k+1 % 10 == 0)
-                        //             break;
-                        //     } // end if
-                        break;
-                    } // end if among the sms
-                } // end for
-
-                if (!issms)
-                {
-                    // the ready descriptor by odd one out is a web request over http
-                    if (!Get_Http_Request(&session[tmp[i].fd]))
-                    {
-                        char *buf = session[tmp[i].fd].buf;
-                        int sockfd = tmp[i].fd;
-
-                        Print(buf);   
-                        //Print("Send Type = " + std::to_string(Parse_SendType(session[tmp[i].fd].buf)));
-                        //Print("SubscriberID = " + std::to_string(Parse_SubscriberID(session[tmp[i].fd].buf)));
-                        //Print("Message Format = " + Parse_Message_Format(session[tmp[i].fd].buf));
-                        //Print("Phone No = " + Parse_PhoneNo(session[tmp[i].fd].buf));
-                        
-                        if (Parse_Header(buf) < 0)
-                            Http_Error(sockfd, 504);
-                        else
-                            Http_Ok(sockfd);
-
-                        auto it = std::find_if(vpoll.begin(), vpoll.end(), 
-                            [&sockfd](auto &v){ return v.fd == sockfd; });
-
-                        if (it != vpoll.end())
-                            vpoll.erase(it);
-
-                        CLOSE(sockfd);
-                    } // end if 
-                } // end if not sms
-            } // end else either sms or http
-        } // end for
+                Check_Timeouts(app);
+                Check_Binds(app, loop);
+            } // end for
 
+            last_tick = now;
+        } // end if tick
     } // end while forever
 
     
@@ -362,7 +430,8 @@ void Init_Config(std::string &filename)
  * @brief This function connects to all SMCS providers listed in the config file
  *  by parsing first the semi-colons thus establishing count of sms objects and
  *  next by parsing the username@password@host:port format supplied in each 
- *  parameter.
+ *  parameter. Each SMSC gets as many binds as sms_binds asks for; those that
+ *  can't connect now are tried again later, see SmsPool::Reconnect.
  * 
  */
 void Init_SMS()
@@ -372,9 +441,29 @@ void Init_SMS()
     std::vector<std::string> host_addresses = Split_String(
             sys_config.config["sms_address"], ';');
 
+    // window and response timeouts are shared by all SMSC's; 0 means default
+    u32 window = atoi(sys_config.config["sms_window"].c_str());
+    u32 resp_timeout = atoi(sys_config.config["sms_resp_timeout"].c_str());
+    int retries = atoi(sys_config.config["sms_max_retries"].c_str());
+
+    // optionally give each SMSC a thread of its own, pinned to the cores listed
+    use_reactor = atoi(sys_config.config["sms_reactor"].c_str()) != 0;
+    std::vector<std::string> cpus = Split_String(sys_config.config["sms_cpus"], ',');
+
+    // how each SMSC takes long messages, in sms_address order; udh by default
+    std::vector<std::string> concats = Split_String(sys_config.config["sms_concat"], ',');
+
+    // the binds to each SMSC as tx[:rx], in sms_address order; one transceiver
+    //  by default. The messages are spread over the transmitters as sms_dispatch
+    //  says; to the least loaded unless it's round_robin
+    std::vector<std::string> binds = Split_String(sys_config.config["sms_binds"], ',');
+    const std::string &dispatch = sys_config.config["sms_dispatch"];
+    if (!dispatch.empty() && dispatch != "least" && dispatch != "round_robin")
+        Fatal("invalid value \"%s\" for key \"sms_dispatch\" in configuration file", dispatch.c_str());
+
     for (size_t i{0}; i < host_addresses.size(); i++)
     {
-        AppContainer app;
+        AppContainer_Ptr app = new AppContainer;
 
         std::vector<std::string> id_pw_host_port = 
             Split_String(host_addresses[i], '@');
@@ -392,25 +481,66 @@ void Init_SMS()
                 host_addresses[i].c_str());
         } // end if fatal error in config
 
+        // an optional 4th part gives the contracted rate as tps[:burst]
+        double tps{DEFAULT_TPS}, burst{0};
+        if (id_pw_host_port.size() > 3 && Parse_Rate(id_pw_host_port[3], tps, burst) < 0)
+        {
+            Fatal("invalid rate \"%s\" for key \"sms_address\" in configuration file", 
+                id_pw_host_port[3].c_str());
+        } // end if fatal error in config
+
         // save these for future ref
-        app.id = i + 1;
-        app.host = host_port[0];
-        app.port = host_port[1];
-        app.system_id = id_pw_host_port[0];
-        app.pwd = id_pw_host_port[1];
+        app->id = i + 1;
+        app->host = host_port[0];
+        app->port = host_port[1];
+        app->system_id = id_pw_host_port[0];
+        app->pwd = id_pw_host_port[1];
+        app->cpu = (i < cpus.size() && !cpus[i].empty() ? atoi(cpus[i].c_str()) : -1);
         app_container.push_back(app);
 
-        if ( (ret = app_container[i].sms.Startup(app.host, app.port, app.system_id, app.pwd)) < 0)
+        u32 tx{1}, rx{0};
+        if (i < binds.size() && !binds[i].empty())
         {
-            if (ret == -2)
-                Fatal(app_container[i].sms.Get_Err().c_str());
-            else
-            {
-                Dump_Err("failed to connect with SMCS #%d at %s:%s", app.id, 
-                    app.host.c_str(), app.port.c_str());
-                ++err;
-            } // end else
+            std::vector<std::string> tx_rx = Split_String(binds[i], ':');
+            tx = atoi(tx_rx[0].c_str());
+            rx = tx_rx.size() > 1 ? atoi(tx_rx[1].c_str()) : 0;
+        } // end if binds given
+
+        if (app->pool.Open(app->host, app->port, app->system_id, app->pwd, tx, rx) < 0)
+            Fatal("invalid value \"%s\" for key \"sms_binds\" in configuration file", binds[i].c_str());
+
+        // the contracted rate is a bind's; the pool goes as fast as its transmitters
+        app->throttle.Set_Rate(tps * tx, burst * tx);
+        app->pool.Set_Policy(dispatch == "round_robin" ? POOL_ROUND_ROBIN : POOL_LEAST_IN_FLIGHT);
+        app->pool.Set_Window(window == 0 ? SMPP_WINDOW_DEFAULT : window);
+        app->pool.Set_Resp_Timeout(resp_timeout == 0 ? SMPP_RESP_TIMEOUT : resp_timeout,
+            retries <= 0 ? SMPP_MAX_RETRIES : retries);
+
+        std::string concat = i < concats.size() ? concats[i] : "";
+        if (concat == "udh16")
+            app->pool.Set_Concat(CONCAT_UDH16);
+        else if (concat == "sar")
+            app->pool.Set_Concat(CONCAT_SAR);
+        else if (concat == "payload")
+            app->pool.Set_Concat(CONCAT_PAYLOAD);
+        else if (concat.empty() || concat == "udh")
+            app->pool.Set_Concat(CONCAT_UDH8);
+        else
+            Fatal("invalid value \"%s\" for key \"sms_concat\" in configuration file", 
+                concat.c_str());
+
+        if ( (ret = app->pool.Startup()) < 0)
+            Fatal(app->pool.Get_Err().c_str());
+
+        if (ret < (int)app->pool.Get_Size())
+        {
+            Dump_Err("failed to connect %d of %zu binds with SMCS #%d at %s:%s", 
+                (int)app->pool.Get_Size() - ret, app->pool.Get_Size(), app->id, 
+                app->host.c_str(), app->port.c_str());
         } // end if
+
+        if (ret == 0)
+            ++err;
     } // end for
 
     if (err == host_addresses.size())
@@ -430,7 +560,10 @@ void Init_SMS()
 void Signal_Handler(int signum)
 {
     std::cout << "\nInterrupted.\nShutting down." << std::endl;
-    app_container[0].sms.Shutdown();
+    for (AppContainer_Ptr app : app_container)
+        app->pool.Shutdown();
+    status_writer.Stop();
+    inbox_writer.Stop();
     iQE::Shutdown_ODBC();
     exit(1);
 } // end Signal_Handler
@@ -438,14 +571,45 @@ void Signal_Handler(int signum)
 
 
 //===============================================================================|
+/**
+ * @brief Reads whatever the peer has sent so far into the session's buffer. The
+ *  socket is edge triggered, so the function keeps reading until the kernel has
+ *  nothing more to give and then checks if the whole request is in.
+ * 
+ * @param psession the session to read for
+ * 
+ * @return int 0 when the request is complete, 1 when more is expected, -1 when
+ *  the peer is gone and -2 for a malformed or oversized request.
+ */
 int Get_Http_Request(Session_Ptr psession)
 {
     char *ptr;
-    int n = recv(psession->fd, psession->buf + psession->total, MAXLINE - psession->total, 0);
-    if (n < 0)
-        return -1;
+    int n;
+
+    for (;;)
+    {
+        if (psession->total >= MAXLINE - 1)
+            return -2;      // won't fit; we don't do big requests
+
+        n = recv(psession->fd, psession->buf + psession->total, 
+            MAXLINE - 1 - psession->total, 0);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EWOULDBLOCK || errno == EAGAIN)
+                break;      // drained
+
+            return -1;
+        } // end if
 
-    psession->total += n;
+        if (n == 0)
+            return -1;      // peer closed
+
+        psession->total += n;
+    } // end for
+
+    psession->buf[psession->total] = 0;
     if (!psession->header_full)
     {
         // processing header bytes
@@ -465,13 +629,8 @@ int Get_Http_Request(Session_Ptr psession)
         if (!ptr)
             return -2;      // invalid request
 
-        ptr += strlen("Content-Length:") + 1;
-        char *ptr2 = strstr(ptr, "\r\n");
-        int digits = ptr2 - ptr;
-        char l[12];
-        strncpy(l, ptr, digits);
-        psession->body_len = atoi(l);
-        if (psession->body_len >= (psession->total))
+        psession->body_len = atoi(ptr + strlen("Content-Length:"));
+        if (psession->total - psession->header_len < psession->body_len)
             return 1;
 
         psession->body_full = 1;
@@ -481,11 +640,20 @@ int Get_Http_Request(Session_Ptr psession)
         psession->header_full = psession->body_full = psession->total =  0;
     
     return 0;
-} // end Handle_HTTP
+} // end Get_Http_Request
 
 
 
 //===============================================================================|
+/**
+ * @brief Parses the request line of an http request and tells which of the
+ *  routes on the control port it's meant for.
+ * 
+ * @param buf the http request
+ * 
+ * @return int one of the ROUTE_* constants, -1 for unsupported methods and -2
+ *  when no such route exists.
+ */
 int Parse_Header(char *buf)
 {
     char *ptr = strstr(buf, "POST");
@@ -493,20 +661,110 @@ int Parse_Header(char *buf)
         return -1;      // protocol not accepted
 
     ptr += strlen("POST");
-    char *ptr2 = strstr(ptr, "/sendSMS");
-    if (!ptr2)
-        return -2;      // a 404 page not found
+    if (strstr(ptr, "/sendSMS"))
+        return ROUTE_SEND_SMS;
 
-    return 0;
+    if (strstr(ptr, "/setRate"))
+        return ROUTE_SET_RATE;
+
+    return -2;          // a 404 page not found
 } // end Parse_Header
 
 
 
+//===============================================================================|
+/**
+ * @brief Adjusts the throttle of an SMSC at runtime. The request body is Json
+ *  of the form {"smsc": 1, "tps": 100, "burst": 20}; where smsc is the 1 based
+ *  position of the SMSC in sms_address, and burst is optional. The rate is a
+ *  bind's, as in sms_address; the SMSC goes as fast as its transmitters. A tps
+ *  must be above 0; "tps": "unlimited" is how the throttle is lifted.
+ * 
+ * @param buf the http request
+ * 
+ * @return int 0 on success alas -1 for a bad request
+ */
+int Set_Rate(const char *buf)
+{
+    int smsc, tps{0}, burst{0};
+
+    if (Parse_Json_Int(buf, "\"smsc\"", smsc) < 0 || smsc < 1 || 
+        (size_t)smsc > app_container.size())
+    {
+        return -1;
+    } // end if no such SMSC
+
+    bool unlimited = Parse_Json_String(buf, "\"tps\"") == "unlimited";
+    if (!unlimited && (Parse_Json_Int(buf, "\"tps\"", tps) < 0 || tps <= 0))
+        return -1;
+
+    if (strstr(buf, "\"burst\"") && (Parse_Json_Int(buf, "\"burst\"", burst) < 0 || burst < 0))
+        return -1;
+
+    u32 tx = app_container[smsc - 1]->pool.Get_Transmitters();
+    if (unlimited)
+    {
+        app_container[smsc - 1]->throttle.Set_Rate(TB_UNLIMITED);
+        Print("SMSC #" + std::to_string(smsc) + " no longer throttled.");
+        return 0;
+    } // end if unlimited
+
+    app_container[smsc - 1]->throttle.Set_Rate((double)tps * tx, (double)burst * tx);
+    Print("SMSC #" + std::to_string(smsc) + " throttled to " + std::to_string((u64)tps * tx) + 
+        " msg/s, " + std::to_string(tps) + " on each of " + std::to_string(tx) + " binds.");
+    return 0;
+} // end Set_Rate
+
+
+
+//===============================================================================|
+/**
+ * @brief Parses the contracted rate of an sms_address entry; tps[:burst], where
+ *  tps is above 0 and burst isn't below it, or "unlimited" for no throttle.
+ * 
+ * @param rate the rate as written
+ * @param tps gets the messages per second; TB_UNLIMITED for no throttle
+ * @param burst gets the burst; 0 for the default
+ * 
+ * @return int 0 on success alas -1 when it isn't a rate
+ */
+int Parse_Rate(const std::string &rate, double &tps, double &burst)
+{
+    if (rate == "unlimited")
+    {
+        tps = TB_UNLIMITED;
+        burst = 0;
+        return 0;
+    } // end if no throttle
+
+    std::vector<std::string> tps_burst = Split_String(rate, ':');
+    if (tps_burst.empty() || tps_burst.size() > 2)
+        return -1;
+
+    char *end;
+    tps = strtod(tps_burst[0].c_str(), &end);
+    if (end == tps_burst[0].c_str() || *end || !(tps > 0) || std::isinf(tps))
+        return -1;
+
+    burst = 0;
+    if (tps_burst.size() > 1)
+    {
+        burst = strtod(tps_burst[1].c_str(), &end);
+        if (end == tps_burst[1].c_str() || *end || !(burst >= 0) || std::isinf(burst))
+            return -1;
+    } // end if burst given
+
+    return 0;
+} // end Parse_Rate
+
+
+
 //===============================================================================|
 /**
  * @brief This function parses the value part of a string from a Json encoded
  *  stream or buffer given it's key. The value to be parsed must adhere to strict
- *  Json regulation, alas the function will fail to parse.
+ *  Json regulation, alas the function will fail to parse; a value that isn't
+ *  a string is no string at all.
  * 
  * @param buf buffer containing Json data to parse
  * @param key the key to parse the value for
@@ -526,19 +784,20 @@ std::string Parse_Json_String(const char *buf, const std::string &key)
     if (!ptr2)
         return "";      // Json error
              
-    ptr = strchr(ptr2, '\"');
-    if (!ptr)
-        return "";
+    ++ptr2;
+    while (*ptr2 == ' ' || *ptr2 == '\t' || *ptr2 == '\n')
+        ++ptr2;
+
+    if (*ptr2 != '\"')
+        return "";      // not a string
 
-    ++ptr;              // the 1st char in string data
+    ptr = ptr2 + 1;     // the 1st char in string data
 
-    // from the first char, locate the last, quote(")
+    // from the first char, locate the closing quote(")
     ptr2 = strchr(ptr, '\"');
     if (!ptr2)
         return "";
 
-    --ptr2;             // the last char in string
-
     std::string ret{ptr, (size_t)(ptr2 - ptr)};
     return ret;
 } // end Parse_Json_String
@@ -547,8 +806,8 @@ std::string Parse_Json_String(const char *buf, const std::string &key)
 
 //===============================================================================|
 /**
- * @brief Parses the integer value from Json formatted stream or buffer. The 
- *  function assumes the caller already knows the parsed value is an integer.
+ * @brief Parses the integer value from Json formatted stream or buffer. A value
+ *  that isn't an integer, a string say, fails.
  * 
  * @param buf the buffer to parse
  * @param key the ky who's value are we looking for
@@ -586,8 +845,15 @@ int Parse_Json_Int(const char *buf, const std::string &key, int &value)
     // let's apply a hack, copy into a string then convert string
     //  since our pointer won't null terminate.
     std::string s{ptr2, (size_t)(ptr - ptr2)};
-    value = atoi(s.c_str());
+    char *end;
+    long l = strtol(s.c_str(), &end, 10);
+    while (*end == ' ' || *end == '\t' || *end == '\r' || *end == '\n')
+        ++end;
+
+    if (end == s.c_str() || *end || l < INT_MIN || l > INT_MAX)
+        return -1;
 
+    value = (int)l;
     return 0;
 } // end Parse_Json_Int
 
@@ -633,38 +899,435 @@ void Http_Error(const int sockfd, const int err_code)
 
 
 //===============================================================================|
-void Sender_Thread(Sms *psms)
+/**
+ * @brief Accepts every connection waiting on the listening socket and puts each
+ *  one into the event loop.
+ * 
+ * @param events the epoll events reported
+ * 
+ * @return int 0 always; the listener stays in the loop for good.
+ */
+int Listener::Handle_Event(const u32 events)
 {
-    std::chrono::duration<double>  time_span;
-    while (!db_messages.empty())
+    for (;;)
     {
-        std::chrono::high_resolution_clock::time_point start_t = 
-            std::chrono::high_resolution_clock::now();
+        sockaddr_in addr;
+        socklen_t addr_len = sizeof(sockaddr_in);
+        char ip[INET_ADDRSTRLEN];
 
-        SmsOut out = db_messages.back();
+        int clifd = accept4(fd, (sockaddr*)&addr, &addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (clifd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            if (errno != EWOULDBLOCK && errno != EAGAIN)
+                Dump_Err("Accept error");
 
-        if (psms->Send_Message(out.message, out.phoneno) < 0)
-            Dump_Err("Sending fail.");
+            break;
+        } // end if
+
+        if (!inet_ntop(AF_INET, &addr.sin_addr, ip, INET_ADDRSTRLEN))
+            Dump_Err("Converting address to human notation.");
+
+        Http_Session *psession = new Http_Session(clifd, ip, std::to_string(ntohs(addr.sin_port)));
+        if (loop.Add(psession) < 0)
+        {
+            Dump_Err("failed to watch connection");
+            psession->Handle_Close();
+            continue;
+        } // end if
+
+        Print("New connection from " + std::string{ip} + ":" + std::to_string(ntohs(addr.sin_port)));
+    } // end for
+
+    return 0;
+} // end Handle_Event
+
+
+
+//===============================================================================|
+/**
+ * @brief Reads the request and once it's all in, acts on it and answers. The
+ *  control port serves one request per connection.
+ * 
+ * @param events the epoll events reported
+ * 
+ * @return int 0 while the request is still coming, -1 when the session is done
+ */
+int Http_Session::Handle_Event(const u32 events)
+{
+    int ret;
+    if ( (ret = Get_Http_Request(&session)) == 1)
+        return 0;       // wait for the rest
+
+    if (ret == -1)
+        return -1;
+
+    char *buf = session.buf;
+    int sockfd = session.fd;
+
+    if (ret == -2)
+    {
+        Http_Error(sockfd, 400);
+        return -1;
+    } // end if malformed
+
+    Print(buf);   
+
+    int route;
+    if ( (route = Parse_Header(buf)) < 0)
+        Http_Error(sockfd, 504);
+    else if (route == ROUTE_SET_RATE && Set_Rate(buf) < 0)
+        Http_Error(sockfd, 400);
+    else
+        Http_Ok(sockfd);
+
+    return -1;
+} // end Handle_Event
+
+
+
+//===============================================================================|
+/**
+ * @brief Closes the connection and releases the session.
+ * 
+ */
+void Http_Session::Handle_Close()
+{
+    CLOSE(session.fd);
+    delete this;
+} // end Handle_Close
+
+
+
+//===============================================================================|
+/**
+ * @brief Drains and processes everything the SMSC has sent, and writes out what
+ *  was left queued for it when the socket last filled up.
+ * 
+ * @param events the epoll events reported
+ * 
+ * @return int 0 while the link is alive, -1 once it's lost
+ */
+int Smsc_Handler::Handle_Event(const u32 events)
+{
+    char b[MAXLINE];
+    int n;
+
+    if ((events & EPOLLOUT) && sms.Flush() < 0)
+    {
+        Dump_Err("Disconnected from SMCS #%d", app->id);
+        return -1;
+    } // end if writable
+
+    if ( !(events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP)))
+        return 0;
+
+    if ( (n = sms.Process_Incoming(b)) == -2)
+        Print(b);
+    else if (n < 0)
+    {
+        Dump_Err("Disconnected from SMCS #%d", app->id);
+        return -1;
+    } // end else if
+
+    return 0;
+} // end Handle_Event
 
-        db.Update_SMSOut(&out);
 
-        _mutex.lock();
-        db_messages.pop_back();
-        _mutex.unlock();
 
-        do
+//===============================================================================|
+/**
+ * @brief Tears down what's left of the link and releases the handler.
+ * 
+ */
+void Smsc_Handler::Handle_Close()
+{
+    if (sms.Get_Connection() >= 0)
+        sms.Shutdown();     // the pool connects it again in a while
+
+    delete this;
+} // end Handle_Close
+
+
+
+//===============================================================================|
+/**
+ * @brief Sends the database messages streamed in by the outbox through one SMSC.
+ *  The pace is kept by the container's token bucket, so the thread sleeps rather
+ *  than spins between messages. Each message goes out on the bind the pool
+ *  picks for it; or with reactors, on the one its reactor picks once it gets
+ *  there.
+ * 
+ * @param app the SMSC to send through
+ */
+void Sender_Thread(AppContainer_Ptr app)
+{
+    Outbox_Msg out;     // reused; its strings go back and forth with the outbox's
+    Sms *psms;
+    while (sender_running)
+    {
+        if ( (psms = app->pool.Pick()) == nullptr)
         {
-            std::chrono::high_resolution_clock::time_point end_t = 
-                std::chrono::high_resolution_clock::now();
+            // not bound yet or lost the link; check back in a while
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        } // end if not bound
 
-            time_span = std::chrono::duration_cast<std::chrono::duration<double>>(end_t - start_t);
-        } while (time_span.count() <= msg_per_second );
-        
+        if (!outbox.Pop(out, 100))
+            continue;       // nothing to send just yet
+
+        app->throttle.Acquire();
+        if (use_reactor)
+        {
+            // hand it over to the reactor; a full queue means the SMSC is
+            //  lagging, so hold back until it catches up.
+            Submission sub{out.message, out.phoneno, out.id};
+            sub.parts = (u32)psms->Count_Parts(out.message);
+            while (!app->submit_q.Push(std::move(sub)) && sender_running)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+            app->wakeup.Notify();
+        } // end if
+        else
+            Send_Out(app->pool.Pick(), out.message, out.phoneno, out.id);
     } // end while sending
 } // end Sender_Thread
 
 
 
+//===============================================================================|
+/**
+ * @brief Services a single SMSC on a thread of its own, so that one provider's
+ *  traffic (or a slow handler) never holds up another's. The thread owns its
+ *  own event loop; messages to send arrive through the container's submit_q
+ *  and receipts leave through the status writer.
+ * 
+ * @param app the SMSC to service
+ */
+void Reactor_Thread(AppContainer_Ptr app)
+{
+    in_reactor = true;
+    if (app->cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(app->cpu, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+            Dump_Err("failed to pin SMCS #%d to cpu %d", app->id, app->cpu);
+    } // end if pinned
+
+    app->pool.Set_Wait(false);
+    EventLoop loop;
+    if (loop.Add(&app->wakeup) < 0)
+    {
+        Dump_Err("failed to start reactor for SMCS #%d", app->id);
+        return;
+    } // end if
+
+    Watch_Binds(app, loop);
+
+    auto last_tick = std::chrono::steady_clock::now();
+    while (sender_running)
+    {
+        if (loop.Run_Once(TICK_INTERVAL) < 0)
+        {
+            Dump_Err("epoll error on SMCS #%d", app->id);
+            break;
+        } // end if
+
+        Drain_Submissions(app);
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_tick >= std::chrono::milliseconds(TICK_INTERVAL))
+        {
+            Check_Timeouts(app);
+            Check_Binds(app, loop);
+            last_tick = now;
+        } // end if tick
+    } // end while
+} // end Reactor_Thread
+
+
+
+//===============================================================================|
+/**
+ * @brief Sends as many of the queued submissions as the submit windows allow,
+ *  each on the bind the pool picks for it. The reactor must never wait on its
+ *  own windows, as it's the one that reads the responses that open them; so a
+ *  message goes only once the bind has room for all its parts, and one in more
+ *  parts than the window holds once the bind is idle. Whatever doesn't fit is
+ *  held over to the next round. The lot is corked so it leaves in as few
+ *  writes as possible.
+ * 
+ * @param app the SMSC
+ */
+void Drain_Submissions(AppContainer_Ptr app)
+{
+    Sms *psms;
+    app->pool.Cork();
+    while ( (psms = app->pool.Pick()))
+    {
+        if (!app->holding && !(app->holding = app->submit_q.Pop(app->held)))
+            break;
+
+        u32 window = psms->Get_Window();
+        u32 load = psms->Get_In_Flight();
+        u32 need = std::min(std::max<u32>(app->held.parts, 1), window);
+        if (load + need > window)
+            break;      // stays held; the responses will make room
+
+        Send_Out(psms, app->held.msg, app->held.dst, app->held.row_id);
+        app->holding = false;
+    } // end while
+
+    if (app->pool.Uncork() < 0)
+        Dump_Err("Sending fail.");
+} // end Drain_Submissions
+
+
+
+//===============================================================================|
+/**
+ * @brief Sends a message of SmsOut on a bind and files how that went: sent, or
+ *  failed when it couldn't be. What SMSC makes of it from there on the bind
+ *  reports as it hears.
+ * 
+ * @param psms the bind; nullptr when none is bound
+ * @param msg the text
+ * @param dst the destination phone no
+ * @param row_id its row in SmsOut
+ */
+void Send_Out(Sms *psms, const std::string &msg, const std::string &dst, const u32 row_id)
+{
+    if (psms == nullptr || psms->Send_Message(msg, dst, nullptr, row_id) < 0)
+    {
+        Dump_Err("Sending fail.");
+        status_writer.Enqueue(row_id, "", MSG_STATE_FAILED);
+        return;
+    } // end if
+
+    status_writer.Enqueue(row_id, "", MSG_STATE_SENT);
+} // end Send_Out
+
+
+
+//===============================================================================|
+/**
+ * @brief Resubmits whatever has gone unanswered for too long on one SMSC.
+ * 
+ * @param app the SMSC
+ */
+void Check_Timeouts(AppContainer_Ptr app)
+{
+    char b[MAXLINE];
+    if (app->pool.Check_Timeouts(b, MAXLINE) == -2)
+        Print(b);
+} // end Check_Timeouts
+
+
+
+//===============================================================================|
+/**
+ * @brief Connects again whichever binds of an SMSC are due, watching them on
+ *  loop, and tells when the SMSC as a whole has come up or gone down.
+ * 
+ * @param app the SMSC
+ * @param loop the loop its binds are on
+ */
+void Check_Binds(AppContainer_Ptr app, EventLoop &loop)
+{
+    static const char *states[] = {"down", "degraded", "up"};
+
+    app->pool.Reconnect([&](Sms &sms) { Watch_Bind(app, loop, sms); });
+
+    Pool_Health health = app->pool.Get_Health();
+    if (health.state != app->health)
+    {
+        Print("SMSC #" + std::to_string(app->id) + " is " + states[health.state] + "; " +
+            std::to_string(health.bound) + " of " + std::to_string(health.binds) + " binds bound.");
+        app->health = health.state;
+    } // end if changed
+} // end Check_Binds
+
+
+
+//===============================================================================|
+/**
+ * @brief Puts every bind of an SMSC that's connected on loop; the rest are
+ *  left to Check_Binds.
+ * 
+ * @param app the SMSC
+ * @param loop the loop to watch them on
+ */
+void Watch_Binds(AppContainer_Ptr app, EventLoop &loop)
+{
+    for (size_t i = 0; i < app->pool.Get_Size(); i++)
+    {
+        if (app->pool.Get_Session(i).Get_Connection() >= 0)
+            Watch_Bind(app, loop, app->pool.Get_Session(i));
+    } // end for
+} // end Watch_Binds
+
+
+
+//===============================================================================|
+/**
+ * @brief Puts a bind on loop. One that can't be watched is dropped, for the
+ *  pool to try again later.
+ * 
+ * @param app the SMSC
+ * @param loop the loop to watch it on
+ * @param sms the bind
+ */
+void Watch_Bind(AppContainer_Ptr app, EventLoop &loop, Sms &sms)
+{
+    Smsc_Handler *psmsc = new Smsc_Handler(app, sms);
+    if (loop.Add(psmsc, EVENT_READ_WRITE) < 0)
+    {
+        Dump_Err("failed to watch SMCS #%d", app->id);
+        sms.Shutdown();
+        delete psmsc;
+    } // end if
+} // end Watch_Bind
+
+
+
+//===============================================================================|
+/**
+ * @brief Called by Sms whenever an SMSC reports on a message we've sent. The
+ *  report is handed to the status writer, which coalesces it with whatever
+ *  else is pending for the message and writes it in a batch later on; so
+ *  neither main nor the reactors ever wait on the database.
+ * 
+ * @param row_id the message's row in SmsOut; 0 for a message no longer tracked
+ * @param msg_id the id assigned by SMSC; stored on the row once there's one
+ * @param status one of MSG_STATE_*
+ */
+void Update_Out_SMS_DB(const u32 row_id, const std::string_view msg_id, const u8 status)
+{
+    status_writer.Enqueue(row_id, msg_id, status);
+} // end Update_Out_SMS_DB
+
+
+
+//===============================================================================|
+/**
+ * @brief Called by Sms with every message sent to us, decoded to UTF-8 and put
+ *  together from its parts should it have come in some. It's handed to the
+ *  inbox writer, which inserts it into SmsIn along with the rest in a batch.
+ * 
+ * @param phone_no the number that sent it
+ * @param msg the text
+ * @param error 1 when it's short of parts or came garbled, alas 0
+ */
+void Write_In_SMS_DB(const std::string_view phone_no, const std::string_view msg, const u8 error)
+{
+    inbox_writer.Enqueue(phone_no, msg, error);
+} // end Write_In_SMS_DB
+
+
+
 //===============================================================================|
 /**
  * @brief Does house cleaning before the app terminates or is interrupted.
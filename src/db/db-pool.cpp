@@ -0,0 +1,292 @@
+/**
+ * @file db-pool.cpp
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Implementation details for db-pool.h
+ * @version 0.1
+ * @date 2024-03-23
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "db-pool.h"
+
+
+
+
+
+//===============================================================================|
+//          LEASE IMP
+//===============================================================================|
+DbLease::~DbLease()
+{
+    Release();
+} // end Destructor
+
+
+
+//===============================================================================|
+DbLease::DbLease(DbLease &&lease)
+    :ppool{lease.ppool}, pconn{lease.pconn}
+{
+    lease.ppool = nullptr;
+    lease.pconn = nullptr;
+} // end Move Constructor
+
+
+
+//===============================================================================|
+DbLease &DbLease::operator=(DbLease &&lease)
+{
+    if (this != &lease)
+    {
+        Release();
+        ppool = lease.ppool;
+        pconn = lease.pconn;
+        lease.ppool = nullptr;
+        lease.pconn = nullptr;
+    } // end if
+
+    return *this;
+} // end Move Assignment
+
+
+
+//===============================================================================|
+/**
+ * @brief Returns the statement prepared with sql on the leased connection;
+ *  it's prepared the first time it's asked for.
+ *
+ * @param sql the query
+ *
+ * @return HSTMT the statement alas nullptr with the error extracted
+ */
+HSTMT DbLease::Prepare(const char *sql)
+{
+    auto it = pconn->prepared.find(sql);
+    if (it != pconn->prepared.end())
+        return it->second;
+
+    HSTMT hstmt{nullptr};
+    if (!SQL_SUCCEEDED(DB_ALLOC_HANDLE(SQL_HANDLE_STMT, pconn->hdbc, hstmt)))
+    {
+        DB_EXTRACT_ERROR(SQL_HANDLE_DBC, pconn->hdbc);
+        return nullptr;
+    } // end if
+
+    if (!SQL_SUCCEEDED(DB_PREPARE_QUERY(hstmt, sql)))
+    {
+        DB_EXTRACT_ERROR(SQL_HANDLE_STMT, hstmt);
+        SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+        return nullptr;
+    } // end if
+
+    pconn->prepared.emplace(sql, hstmt);
+    return hstmt;
+} // end Prepare
+
+
+
+//===============================================================================|
+/**
+ * @brief Gives the connection back ahead of time
+ *
+ */
+void DbLease::Release()
+{
+    if (pconn)
+        ppool->Release(pconn);
+
+    ppool = nullptr;
+    pconn = nullptr;
+} // end Release
+
+
+
+
+
+//===============================================================================|
+//          POOL IMP
+//===============================================================================|
+/**
+ * @brief Construct a new Db Pool:: Db Pool object; Open connects it
+ *
+ */
+DbPool::DbPool()
+    :henv{nullptr}
+{
+} // end Constructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Destroy the Db Pool:: Db Pool object
+ *
+ */
+DbPool::~DbPool()
+{
+    Close();
+} // end Destructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Makes size connections to the database
+ *
+ * @param con_str ODBC formatted connection string
+ * @param size the connections to make
+ *
+ * @return int 0 on success alas -1 with the error extracted; the connections
+ *  made by then are closed
+ */
+int DbPool::Open(const std::string &con_str, const u32 size)
+{
+    if (henv)
+        return 0;
+
+    if (!SQL_SUCCEEDED(DB_ALLOC_HANDLE(SQL_HANDLE_ENV, NULL, henv)))
+    {
+        DB_EXTRACT_ERROR(SQL_HANDLE_ENV, henv);
+        henv = nullptr;
+        return -1;
+    } // end if
+
+    if (!SQL_SUCCEEDED(SQLSetEnvAttr(henv, SQL_ATTR_ODBC_VERSION, (void *)SQL_OV_ODBC3, 0)))
+    {
+        DB_EXTRACT_ERROR(SQL_HANDLE_ENV, henv);
+        Close();
+        return -1;
+    } // end if
+
+    conns.resize(size ? size : 1);
+    for (Db_Conn &conn : conns)
+    {
+        if (!SQL_SUCCEEDED(DB_ALLOC_HANDLE(SQL_HANDLE_DBC, henv, conn.hdbc)))
+        {
+            DB_EXTRACT_ERROR(SQL_HANDLE_ENV, henv);
+            conn.hdbc = nullptr;
+            Close();
+            return -1;
+        } // end if
+
+        if (iQE::Driver_Connect_DB((SQLCHAR *)con_str.c_str(), conn.hdbc, conn.hstmt) < 0)
+        {
+            Close();
+            return -1;
+        } // end if
+
+        idle.push_back(&conn);
+    } // end for
+
+    return 0;
+} // end Open
+
+
+
+//===============================================================================|
+/**
+ * @brief Closes every connection; none may be out on lease by now.
+ *
+ */
+void DbPool::Close()
+{
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        idle.clear();
+    } // end lock
+
+    for (Db_Conn &conn : conns)
+        Free_Conn(conn);
+
+    conns.clear();
+    if (henv)
+    {
+        SQLFreeHandle(SQL_HANDLE_ENV, henv);
+        henv = nullptr;
+    } // end if
+} // end Close
+
+
+
+//===============================================================================|
+/**
+ * @brief Leases an idle connection
+ *
+ * @param timeout_ms how long to wait when they're all out
+ *
+ * @return DbLease the lease; an empty one on time out
+ */
+DbLease DbPool::Acquire(const u32 timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(pool_mutex);
+    if (!returned.wait_for(lock, std::chrono::milliseconds(timeout_ms), 
+        [this] { return !idle.empty(); }))
+    {
+        return DbLease{};
+    } // end if none came back
+
+    Db_Conn_Ptr pconn = idle.back();
+    idle.pop_back();
+    return DbLease{this, pconn};
+} // end Acquire
+
+
+
+//===============================================================================|
+size_t DbPool::Get_Idle() const
+{
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    return idle.size();
+} // end Get_Idle
+
+
+
+//===============================================================================|
+/**
+ * @brief Takes back a leased connection
+ *
+ */
+void DbPool::Release(Db_Conn_Ptr pconn)
+{
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        idle.push_back(pconn);
+    } // end lock
+
+    returned.notify_one();
+} // end Release
+
+
+
+//===============================================================================|
+/**
+ * @brief Frees the statements of a connection, then the connection
+ *
+ */
+void DbPool::Free_Conn(Db_Conn &conn)
+{
+    for (auto &p : conn.prepared)
+        SQLFreeHandle(SQL_HANDLE_STMT, p.second);
+
+    conn.prepared.clear();
+    if (conn.hstmt)
+    {
+        SQLFreeHandle(SQL_HANDLE_STMT, conn.hstmt);
+        conn.hstmt = nullptr;
+    } // end if
+
+    if (conn.hdbc)
+    {
+        iQE::Disconnect_DB(conn.hdbc);
+        SQLFreeHandle(SQL_HANDLE_DBC, conn.hdbc);
+        conn.hdbc = nullptr;
+    } // end if
+} // end Free_Conn
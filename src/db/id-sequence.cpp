@@ -0,0 +1,177 @@
+/**
+ * @file id-sequence.cpp
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Implementation details for id-sequence.h
+ * @version 0.1
+ * @date 2024-03-25
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "id-sequence.h"
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define SQL_RESERVE_IDS     "UPDATE WSISApp.dbo.AutoIncrementFields SET LastValue = LastValue + ? \
+OUTPUT inserted.LastValue WHERE Name = ?"
+
+#define ID_NEXT(s)          ((u32)(s))
+#define ID_END(s)           ((u32)((s) >> 32))
+#define ID_STATE(next, end) (((u64)(end) << 32) | (u64)(next))
+
+
+
+
+
+//===============================================================================|
+//          CLASS IMP
+//===============================================================================|
+/**
+ * @brief Construct a new Id Sequence:: Id Sequence object; empty until the
+ *  first id is asked for.
+ *
+ * @param name the Name of the row in AutoIncrementFields; e.g. MessageID
+ * @param block_size ids reserved per round trip
+ */
+IdSequence::IdSequence(const char *name, const u32 block_size)
+    :name{name}, block_size{block_size ? block_size : 1}, ppool{nullptr}, state{0}, blocks{0}
+{
+} // end Constructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Sets where the blocks are reserved from
+ *
+ * @param ppool an open pool
+ */
+void IdSequence::Set_Pool(DbPool *ppool)
+{
+    this->ppool = ppool;
+} // end Set_Pool
+
+
+
+//===============================================================================|
+/**
+ * @brief Takes the next id; safe from any thread.
+ *
+ * @param id gets the id
+ *
+ * @return int 0 on success alas -2 when a block couldn't be reserved
+ */
+int IdSequence::Next(u32 &id)
+{
+    u64 s = state.load(std::memory_order_acquire);
+    for (;;)
+    {
+        if (ID_NEXT(s) < ID_END(s))
+        {
+            if (state.compare_exchange_weak(s, s + 1, std::memory_order_acq_rel))
+            {
+                id = ID_NEXT(s);
+                return 0;
+            } // end if taken
+
+            continue;       // s has what beat us to it
+        } // end if any left
+
+        if (Refill(s) < 0)
+            return -2;
+
+        s = state.load(std::memory_order_acquire);
+    } // end for
+} // end Next
+
+
+
+//===============================================================================|
+/**
+ * @brief The id Next would give, without taking it; reserves a block should
+ *  there be none.
+ *
+ * @return int 0 on success alas -2
+ */
+int IdSequence::Peek(u32 &id)
+{
+    u64 s = state.load(std::memory_order_acquire);
+    if (ID_NEXT(s) >= ID_END(s))
+    {
+        if (Refill(s) < 0)
+            return -2;
+
+        s = state.load(std::memory_order_acquire);
+    } // end if empty
+
+    id = ID_NEXT(s);
+    return 0;
+} // end Peek
+
+
+
+//===============================================================================|
+/**
+ * @brief Reserves the next block, unless someone else has done so since the
+ *  caller saw the sequence empty.
+ *
+ * @param seen the state the caller found used up
+ *
+ * @return int 0 on success alas -2
+ */
+int IdSequence::Refill(const u64 seen)
+{
+    std::lock_guard<std::mutex> lock(refill_mutex);
+    if (state.load(std::memory_order_acquire) != seen)
+        return 0;
+
+    if (!ppool)
+        return -2;
+
+    DbLease lease = ppool->Acquire();
+    HSTMT hreserve = lease ? lease.Prepare(SQL_RESERVE_IDS) : nullptr;
+    if (!hreserve)
+    {
+        iQE::Dump_DB_Error();
+        return -2;
+    } // end if
+
+    SQLINTEGER size = (SQLINTEGER)block_size, last{0};
+    SQLLEN name_len = (SQLLEN)name.size(), len{0};
+    SQLBindParameter(hreserve, 1, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0, &size, 0, nullptr);
+    SQLBindParameter(hreserve, 2, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, name.size(), 0,
+        (SQLPOINTER)name.c_str(), name_len, &name_len);
+    SQLBindCol(hreserve, 1, SQL_C_SLONG, &last, 0, &len);
+
+    int ret{0};
+    if (!SQL_SUCCEEDED(SQLExecute(hreserve)) || !SQL_SUCCEEDED(SQLFetch(hreserve)))
+    {
+        DB_EXTRACT_ERROR(SQL_HANDLE_STMT, hreserve);
+        iQE::Dump_DB_Error();
+        ret = -2;
+    } // end if
+    else
+    {
+        // LastValue is the last id taken; the block is the block_size after
+        //  what it used to be
+        state.store(ID_STATE((u32)last - block_size + 1, (u32)last + 1), std::memory_order_release);
+        ++blocks;
+    } // end else
+
+    SQLFreeStmt(hreserve, SQL_CLOSE);
+    SQLFreeStmt(hreserve, SQL_UNBIND);
+    SQLFreeStmt(hreserve, SQL_RESET_PARAMS);
+    return ret;
+} // end Refill
@@ -0,0 +1,317 @@
+/**
+ * @file inbox-writer.cpp
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Implementation details for inbox-writer.h
+ * @version 0.1
+ * @date 2024-03-28
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "inbox-writer.h"
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define SQL_INSERT_SMSIN    "INSERT INTO Subscriber.dbo.SmsIn (phoneNo, message, recvdTicks, error) \
+    VALUES (?, ?, ?, ?)"
+
+
+
+
+
+//===============================================================================|
+//          FUNCTIONS
+//===============================================================================|
+/**
+ * @brief Cuts UTF-8 down to at most len bytes, short of any character that
+ *  would be split
+ */
+static std::string_view Cut_Utf8(const std::string_view s, size_t len)
+{
+    if (s.size() <= len)
+        return s;
+
+    while (len > 0 && (s[len] & 0xC0) == 0x80)
+        len--;
+
+    return s.substr(0, len);
+} // end Cut_Utf8
+
+
+
+
+
+//===============================================================================|
+//          CLASS IMP
+//===============================================================================|
+/**
+ * @brief Construct a new Inbox Writer:: Inbox Writer object
+ *
+ */
+InboxWriter::InboxWriter()
+    :ppool{nullptr}, pwriter{nullptr}, running{false}, 
+    batch_size{INBOX_BATCH_SIZE}, interval_ms{INBOX_FLUSH_INTERVAL}, written{0}, dropped{0}
+{
+} // end Constructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Destroy the Inbox Writer:: Inbox Writer object
+ *
+ */
+InboxWriter::~InboxWriter()
+{
+    Stop();
+} // end Destructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Starts the writer thread
+ *
+ * @param ppool where the connections are leased from; must outlive the writer
+ * @param batch_size messages per execute; also the backlog that forces a flush
+ * @param interval_ms the longest a message waits to be stored
+ *
+ * @return int 0 on success alas -1
+ */
+int InboxWriter::Start(DbPool *ppool, const u32 batch_size, const u32 interval_ms)
+{
+    if (pwriter)
+        return 0;
+
+    if (!ppool)
+        return -1;
+
+    this->ppool = ppool;
+    this->batch_size = batch_size ? batch_size : INBOX_BATCH_SIZE;
+    this->interval_ms = interval_ms ? interval_ms : INBOX_FLUSH_INTERVAL;
+    running = true;
+    pwriter = new std::thread(&InboxWriter::Run, this);
+    return 0;
+} // end Start
+
+
+
+//===============================================================================|
+/**
+ * @brief Stores what's pending and stops the thread
+ *
+ */
+void InboxWriter::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(iw_mutex);
+        running = false;
+    } // end lock
+
+    wake.notify_one();
+    if (pwriter)
+    {
+        pwriter->join();
+        delete pwriter;
+        pwriter = nullptr;
+    } // end if
+} // end Stop
+
+
+
+//===============================================================================|
+/**
+ * @brief Files a message sent to us; safe from any thread and never waits on
+ *  the database. Text longer than SmsIn takes is cut short, on a character.
+ *
+ * @param phone_no the number that sent it
+ * @param msg the text in UTF-8
+ * @param error 0 for a message that came whole; 1 when parts of it are missing
+ *  or it came garbled
+ */
+void InboxWriter::Enqueue(const std::string_view phone_no, const std::string_view msg, const u8 error)
+{
+    Row row{std::string{Cut_Utf8(phone_no, INBOX_PHONE_SIZE - 1)}, 
+        std::string{Cut_Utf8(msg, INBOX_MESSAGE_SIZE - 1)}, (s64)time(NULL), error};
+
+    bool full;
+    {
+        std::lock_guard<std::mutex> lock(iw_mutex);
+        if (pending.size() >= INBOX_MAX_PENDING)
+        {
+            pending.pop_front();
+            dropped++;
+        } // end if no room
+
+        pending.push_back(std::move(row));
+        full = pending.size() >= batch_size;
+    } // end lock
+
+    if (full)
+        wake.notify_one();
+} // end Enqueue
+
+
+
+//===============================================================================|
+size_t InboxWriter::Get_Pending() const
+{
+    std::lock_guard<std::mutex> lock(iw_mutex);
+    return pending.size();
+} // end Get_Pending
+
+
+
+//===============================================================================|
+/**
+ * @brief The writer. Takes whatever's pending in one swap, so Enqueue is held
+ *  up no longer than that, and stores it.
+ *
+ */
+void InboxWriter::Run()
+{
+    std::deque<Row> rows;
+    for (;;)
+    {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(iw_mutex);
+            wake.wait_for(lock, std::chrono::milliseconds(interval_ms), 
+                [this] { return pending.size() >= batch_size || !running; });
+
+            stopping = !running;
+            rows.swap(pending);
+        } // end lock
+
+        if (!rows.empty())
+            Flush(rows);
+
+        if (stopping)
+            break;
+    } // end for
+} // end Run
+
+
+
+//===============================================================================|
+/**
+ * @brief Stores rows batch by batch and empties it. Should a batch fail, it
+ *  and the rest go back to the front of the line, ahead of whatever's come in
+ *  since; the line is cut back from the front should that make it too long.
+ *
+ */
+void InboxWriter::Flush(std::deque<Row> &rows)
+{
+    DbLease lease = ppool->Acquire();
+    auto it = rows.cbegin();
+    if (lease)
+    {
+        while (it != rows.cend())
+        {
+            size_t count = std::min((size_t)batch_size, (size_t)std::distance(it, rows.cend()));
+            if (Write_Batch(lease, it, count) < 0)
+                break;
+
+            it += count;
+            written += count;
+        } // end while
+    } // end if leased
+
+    if (it != rows.cend())
+    {
+        iQE::Dump_DB_Error();
+        rows.erase(rows.cbegin(), it);
+
+        std::lock_guard<std::mutex> lock(iw_mutex);
+        for (Row &row : pending)
+            rows.push_back(std::move(row));
+
+        pending.swap(rows);
+        while (pending.size() > INBOX_MAX_PENDING)
+        {
+            pending.pop_front();
+            dropped++;
+        } // end while
+    } // end if left over
+
+    rows.clear();
+} // end Flush
+
+
+
+//===============================================================================|
+/**
+ * @brief Inserts count rows from first on with a single execute and commits
+ *  them
+ *
+ * @return int 0 on success alas -1 with the error extracted and the batch
+ *  rolled back
+ */
+int InboxWriter::Write_Batch(DbLease &lease, std::deque<Row>::const_iterator first, const size_t count)
+{
+    HSTMT hinsert = lease.Prepare(SQL_INSERT_SMSIN);
+    if (!hinsert)
+        return -1;
+
+    phones.resize(count * INBOX_PHONE_SIZE);
+    phone_lens.resize(count);
+    messages.resize(count * INBOX_MESSAGE_SIZE);
+    message_lens.resize(count);
+    ticks.resize(count);
+    errors.resize(count);
+    for (size_t i = 0; i < count; i++, ++first)
+    {
+        iCpy(&phones[i * INBOX_PHONE_SIZE], first->phoneno.data(), first->phoneno.size());
+        phone_lens[i] = (SQLLEN)first->phoneno.size();
+        iCpy(&messages[i * INBOX_MESSAGE_SIZE], first->message.data(), first->message.size());
+        message_lens[i] = (SQLLEN)first->message.size();
+        ticks[i] = first->recvdTicks;
+        errors[i] = first->error;
+    } // end for
+
+    // column-wise arrays; the statement is shared with the other users of the
+    //  connection, so it's put back to single rows once done
+    SQLSetStmtAttr(hinsert, SQL_ATTR_PARAM_BIND_TYPE, (SQLPOINTER)SQL_PARAM_BIND_BY_COLUMN, 0);
+    SQLSetStmtAttr(hinsert, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)count, 0);
+    SQLBindParameter(hinsert, 1, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, INBOX_PHONE_SIZE - 1, 0,
+        (SQLPOINTER)phones.data(), INBOX_PHONE_SIZE, phone_lens.data());
+    SQLBindParameter(hinsert, 2, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, INBOX_MESSAGE_SIZE - 1, 0,
+        (SQLPOINTER)messages.data(), INBOX_MESSAGE_SIZE, message_lens.data());
+    SQLBindParameter(hinsert, 3, SQL_PARAM_INPUT, SQL_C_SBIGINT, SQL_BIGINT, 0, 0,
+        (SQLPOINTER)ticks.data(), 0, nullptr);
+    SQLBindParameter(hinsert, 4, SQL_PARAM_INPUT, SQL_C_UTINYINT, SQL_TINYINT, 0, 0,
+        (SQLPOINTER)errors.data(), 0, nullptr);
+
+    int ret{0};
+    DB_SET_CONN_ATTR(lease.Get_Dbc(), SQL_AUTOCOMMIT_OFF);
+    if (!SQL_SUCCEEDED(SQLExecute(hinsert)))
+    {
+        DB_EXTRACT_ERROR(SQL_HANDLE_STMT, hinsert);
+        SQLEndTran(SQL_HANDLE_DBC, lease.Get_Dbc(), SQL_ROLLBACK);
+        ret = -1;
+    } // end if
+    else if (!SQL_SUCCEEDED(SQLEndTran(SQL_HANDLE_DBC, lease.Get_Dbc(), SQL_COMMIT)))
+    {
+        DB_EXTRACT_ERROR(SQL_HANDLE_DBC, lease.Get_Dbc());
+        SQLEndTran(SQL_HANDLE_DBC, lease.Get_Dbc(), SQL_ROLLBACK);
+        ret = -1;
+    } // end else if
+
+    SQLFreeStmt(hinsert, SQL_CLOSE);
+    SQLFreeStmt(hinsert, SQL_RESET_PARAMS);
+    SQLSetStmtAttr(hinsert, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)1, 0);
+    DB_SET_CONN_ATTR(lease.Get_Dbc(), SQL_AUTOCOMMIT_ON);
+    return ret;
+} // end Write_Batch
@@ -25,6 +25,204 @@
 
 
 
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+// the placeholders of the formats, in the order of their slots
+#define BILL_SLOTS      {"$name", "$period", "$contractNo", "$cont", "$bill", \
+                         "$currentReading", "$consumption"}
+#define UNREAD_SLOTS    {"$name", "$date"}
+#define GENERAL_SLOTS   {"$name"}
+
+enum Bill_Slot {BILL_NAME, BILL_PERIOD, BILL_CONTRACT_NO, BILL_CONT, BILL_BILL, BILL_READING,
+    BILL_CONSUMPTION};
+enum Unread_Slot {UNREAD_NAME, UNREAD_DATE};
+
+
+
+
+
+//===============================================================================|
+//          TYPES
+//===============================================================================|
+/**
+ * @brief A column bound for block fetches; column-wise binding wants an array of
+ *  values and an array of lengths/indicators, one of each per row of the rowset.
+ */
+template <typename T>
+struct Fetch_Col
+{
+    T v[DB_BULK_FETCH_SIZE];
+    SQLLEN len[DB_BULK_FETCH_SIZE];
+
+    T Get(const SQLULEN row) const { return len[row] == SQL_NULL_DATA ? T{} : v[row]; }
+};
+
+
+
+/**
+ * @brief Same as Fetch_Col for character columns of up to N - 1 bytes
+ */
+template <size_t N>
+struct Fetch_Str
+{
+    char v[DB_BULK_FETCH_SIZE][N];
+    SQLLEN len[DB_BULK_FETCH_SIZE];
+
+    const char *Get(const SQLULEN row) const { return len[row] == SQL_NULL_DATA ? "" : v[row]; }
+};
+
+
+
+/**
+ * @brief A string parameter bound column-wise; the values sit width bytes apart
+ *  with their lengths alongside, so they needn't be terminated.
+ */
+typedef struct PARAM_STR
+{
+    std::vector<char> buf;
+    std::vector<SQLLEN> len;
+    size_t width{1};
+} Param_Str;
+
+
+
+
+
+//===============================================================================|
+//          FUNCTIONS
+//===============================================================================|
+template <typename T>
+static inline void Bind_Col(HSTMT hstmt, const SQLUSMALLINT col, const SQLSMALLINT type, 
+    Fetch_Col<T> &c)
+{
+    SQLBindCol(hstmt, col, type, (SQLPOINTER)c.v, sizeof(T), c.len);
+} // end Bind_Col
+
+
+
+template <size_t N>
+static inline void Bind_Col(HSTMT hstmt, const SQLUSMALLINT col, Fetch_Str<N> &c)
+{
+    SQLBindCol(hstmt, col, SQL_C_CHAR, (SQLPOINTER)c.v, N, c.len);
+} // end Bind_Col
+
+
+
+/**
+ * @brief Copies a fetched string into one of SmsOut's; cut short if need be.
+ */
+template <size_t N>
+static inline void Copy_Col(char (&dst)[N], const char *src)
+{
+    snprintf(dst, N, "%s", src);
+} // end Copy_Col
+
+
+
+/**
+ * @brief Writes n out in buf; no allocations
+ */
+template <size_t N>
+static inline std::string_view Int_View(char (&buf)[N], const s64 n)
+{
+    std::to_chars_result r = std::to_chars(buf, buf + N, n);
+    return std::string_view(buf, r.ptr - buf);
+} // end Int_View
+
+
+
+/**
+ * @brief Lays out one string field of rows messages of batch, from first on,
+ *  in p; the buffer only ever grows, so it's allocated a handful of times a
+ *  call at most.
+ */
+static void Stage_Str(Param_Str &p, const SmsBatch &batch, const size_t first, const size_t rows,
+    std::string_view (SmsBatch::*field)(const size_t) const)
+{
+    p.width = 1;
+    for (size_t i = 0; i < rows; i++)
+        p.width = std::max(p.width, (batch.*field)(first + i).size());
+
+    if (p.buf.size() < rows * p.width)
+        p.buf.resize(rows * p.width);
+
+    p.len.resize(rows);
+    for (size_t i = 0; i < rows; i++)
+    {
+        std::string_view v = (batch.*field)(first + i);
+        memcpy(p.buf.data() + i * p.width, v.data(), v.size());
+        p.len[i] = (SQLLEN)v.size();
+    } // end for
+} // end Stage_Str
+
+
+
+static inline void Bind_Str(HSTMT hstmt, const SQLUSMALLINT n, Param_Str &p)
+{
+    SQLBindParameter(hstmt, n, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, p.width, 0,
+        (SQLPOINTER)p.buf.data(), (SQLLEN)p.width, p.len.data());
+} // end Bind_Str
+
+
+
+/**
+ * @brief Fetches the result of the query just run on hstmt, whose columns have
+ *  been bound with Bind_Col, DB_BULK_FETCH_SIZE rows per SQLFetch; fn is called
+ *  with the index within the rowset of each row that came in good. hstmt is left
+ *  the way the rest of the queries expect it: closed, unbound and fetching one
+ *  row at a time.
+ * 
+ * @param hstmt the statement
+ * @param fn called as fn(row) for every row
+ * 
+ * @return int the rows given to fn alas -2 when the fetch failed; fn may have
+ *  seen some rows by then.
+ */
+template <typename Fn>
+static int Fetch_Rowsets(HSTMT hstmt, Fn &&fn)
+{
+    SQLULEN fetched{0};
+    SQLUSMALLINT status[DB_BULK_FETCH_SIZE];
+
+    SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_BIND_TYPE, (SQLPOINTER)SQL_BIND_BY_COLUMN, 0);
+    SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)DB_BULK_FETCH_SIZE, 0);
+    SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_STATUS_PTR, (SQLPOINTER)status, 0);
+    SQLSetStmtAttr(hstmt, SQL_ATTR_ROWS_FETCHED_PTR, (SQLPOINTER)&fetched, 0);
+
+    int rows{0};
+    SQLRETURN ret;
+    while ( SQL_SUCCEEDED(ret = SQLFetch(hstmt)))
+    {
+        for (SQLULEN i = 0; i < fetched; i++)
+        {
+            if (status[i] != SQL_ROW_SUCCESS && status[i] != SQL_ROW_SUCCESS_WITH_INFO)
+                continue;
+
+            fn(i);
+            rows++;
+        } // end for
+    } // end while
+
+    if (ret != SQL_NO_DATA)
+    {
+        DB_EXTRACT_ERROR(SQL_HANDLE_STMT, hstmt);
+        iQE::Dump_DB_Error();
+        rows = -2;
+    } // end if
+
+    SQLCloseCursor(hstmt);
+    SQLFreeStmt(hstmt, SQL_UNBIND);
+    SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)1, 0);
+    SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_STATUS_PTR, nullptr, 0);
+    SQLSetStmtAttr(hstmt, SQL_ATTR_ROWS_FETCHED_PTR, nullptr, 0);
+    return rows;
+} // end Fetch_Rowsets
+
+
+
+
+
 //===============================================================================|
 //          CLASS DEFINITION
 //===============================================================================|
@@ -34,9 +232,10 @@
  * 
  */
 Messages::Messages() 
-    :henv{nullptr}, hdbc{nullptr}, hstmt{nullptr} 
+    :henv{nullptr}, hdbc{nullptr}, hstmt{nullptr}, hinsert{nullptr}, ppool{nullptr},
+    msg_ids{"MessageID"}, audit_ids{"AuditID", 1}
 {
-    period_id = audit_id = last_msg_id = 0;
+    period_id = audit_id = 0;
 } // end Constructor
 
 
@@ -51,6 +250,7 @@ Messages::Messages()
  * @throw runtime_error when connection with db fails.
  */
 Messages::Messages(const std::string &con_str)
+    :hinsert{nullptr}, ppool{nullptr}, msg_ids{"MessageID"}, audit_ids{"AuditID", 1}
 {
     if (Connect_DB(con_str) < 0)
         throw std::runtime_error("DB connection failed.");
@@ -100,6 +300,12 @@ int Messages::Connect_DB(const std::string &con_str)
  */
 int Messages::Disconnect_DB()
 {
+    if (hinsert)
+    {
+        SQLFreeHandle(SQL_HANDLE_STMT, hinsert);
+        hinsert = nullptr;
+    } // end if prepared
+
     if (iQE::Shutdown_ODBC(henv, hdbc, hstmt) < 0)
         return -1;
 
@@ -108,45 +314,140 @@ int Messages::Disconnect_DB()
 
 
 
+//===============================================================================|
+/**
+ * @brief Has the calls that may come from any thread, such as Update_SMSOut,
+ *  lease their connection from ppool rather than use ours, which is only good
+ *  for one thread at a time. The id sequences reserve their blocks on it too;
+ *  they can't do without one.
+ * 
+ * @param ppool an open pool; nullptr goes back to our own connection
+ */
+void Messages::Set_Pool(DbPool *ppool)
+{
+    this->ppool = ppool;
+    msg_ids.Set_Pool(ppool);
+    audit_ids.Set_Pool(ppool);
+} // end Set_Pool
+
+
+
 //===============================================================================|
 /**
  * @brief Fetches the pre-kooked messages that are stored in WSIS databases and
- *  have not been delivered to user state.
+ *  have not been delivered to user state. The rows come DB_BULK_FETCH_SIZE at a
+ *  time into column buffers that are reused all the way through; each is handed
+ *  to fn as it's read, so nothing holds on to the whole of the result.
  * 
- * @return std::vector<SmsOut> a list of unsent messages stored in db
+ * @param fn gets every unsent message
+ * 
+ * @return int the number of messages alas -2 on error
  */
-std::vector<SmsOut> Messages::Load_Messages()
+int Messages::Load_Messages(const SmsOut_Fn &fn)
 {
-    SQLLEN len;
-    SmsOut sms_out;
-    std::vector<SmsOut> messages;
+    return Fetch_SMSOut("SELECT * FROM Subscriber.dbo.SmsOut WHERE status <= 2", fn);
+} // end Load_Messages
+
+
+
+//===============================================================================|
+/**
+ * @brief Fetches a page of the unsent messages; at most limit of them, in order
+ *  of id and starting right after after_id. Paging on the id rather than by an
+ *  offset keeps every page as cheap as the first however deep into the table.
+ * 
+ * @param after_id the id of the last message of the previous page; 0 for the first
+ * @param limit the page size
+ * @param fn gets every message
+ * 
+ * @return int the number of messages alas -2 on error; fewer than limit means
+ *  there's nothing more to be had for now
+ */
+int Messages::Load_Messages(const u32 after_id, const u32 limit, const SmsOut_Fn &fn)
+{
+    char buf[512]{0};
+    snprintf(buf, 512, "SELECT TOP (%u) * FROM Subscriber.dbo.SmsOut WHERE status <= 2 \
+        AND id > %u ORDER BY id", limit, after_id);
+
+    return Fetch_SMSOut(buf, fn);
+} // end Load_Messages
 
-    std::string sql{"SELECT * FROM Subscriber.dbo.SmsOut WHERE status <= 2"};
 
-    if (iQE::Run_Query_Direct((SQLCHAR *)sql.c_str(), hstmt) < 0)
+
+//===============================================================================|
+/**
+ * @brief Runs one of the SmsOut queries above and hands its rows to fn
+ * 
+ * @param sql a SELECT * over SmsOut
+ * @param fn gets every message
+ * 
+ * @return int the number of messages alas -2 on error
+ */
+int Messages::Fetch_SMSOut(const char *sql, const SmsOut_Fn &fn)
+{
+    if (iQE::Run_Query_Direct((SQLCHAR *)sql, hstmt) < 0)
     {
         iQE::Dump_DB_Error();
-        return messages;
-    } // end Get_Out_Sms
-
-    iZero(&sms_out, sizeof(sms_out));
-    SQLBindCol(hstmt, 1, SQL_C_SLONG, (SQLPOINTER)&sms_out.id, 0, &len);
-    SQLBindCol(hstmt, 2, SQL_C_CHAR, (SQLPOINTER)&sms_out.phoneno, sizeof(sms_out.phoneno), &len);
-    SQLBindCol(hstmt, 3, SQL_C_CHAR, (SQLPOINTER)&sms_out.message, sizeof(sms_out.message), &len);
-    SQLBindCol(hstmt, 4, SQL_C_SBIGINT, (SQLPOINTER)&sms_out.logTicks, 0, &len);
-    SQLBindCol(hstmt, 5, SQL_C_SLONG, (SQLPOINTER)&sms_out.status, 0, &len);
-    SQLBindCol(hstmt, 6, SQL_C_SLONG, (SQLPOINTER)&sms_out.statusTicks, 0, &len);
-    SQLBindCol(hstmt, 7, SQL_C_CHAR, (SQLPOINTER)&sms_out.statusMessage, sizeof(sms_out.statusMessage), &len);
-    SQLBindCol(hstmt, 8, SQL_C_SLONG, (SQLPOINTER)&sms_out.sequenceNo, 0, &len);
-    SQLBindCol(hstmt, 9, SQL_C_CHAR, (SQLPOINTER)&sms_out.messageID, sizeof(sms_out.messageID), &len);
-    SQLBindCol(hstmt, 10, SQL_C_SLONG, (SQLPOINTER)&sms_out.aid, 0, &len);
-
-    while ( SQL_SUCCEEDED(SQLFetch(hstmt)))
-        messages.push_back(sms_out);
+        return -2;
+    } // end if
 
-    SQLCloseCursor(hstmt);
-    return messages;
-} // end Get_Unsent_Messages
+    struct COLUMNS
+    {
+        Fetch_Col<s32> id;
+        Fetch_Str<sizeof(SmsOut::phoneno)> phoneno;
+        Fetch_Str<sizeof(SmsOut::message)> message;
+        Fetch_Col<s64> logTicks;
+        Fetch_Col<s32> status;
+        Fetch_Col<s64> statusTicks;
+        Fetch_Str<sizeof(SmsOut::statusMessage)> statusMessage;
+        Fetch_Col<s32> sequenceNo;
+        Fetch_Str<sizeof(SmsOut::messageID)> messageID;
+        Fetch_Col<s32> aid;
+    };
+
+    // about a megabyte at the current fetch size; too much for the stack
+    std::unique_ptr<COLUMNS> cols{new COLUMNS};
+    Bind_Col(hstmt, 1, SQL_C_SLONG, cols->id);
+    Bind_Col(hstmt, 2, cols->phoneno);
+    Bind_Col(hstmt, 3, cols->message);
+    Bind_Col(hstmt, 4, SQL_C_SBIGINT, cols->logTicks);
+    Bind_Col(hstmt, 5, SQL_C_SLONG, cols->status);
+    Bind_Col(hstmt, 6, SQL_C_SBIGINT, cols->statusTicks);
+    Bind_Col(hstmt, 7, cols->statusMessage);
+    Bind_Col(hstmt, 8, SQL_C_SLONG, cols->sequenceNo);
+    Bind_Col(hstmt, 9, cols->messageID);
+    Bind_Col(hstmt, 10, SQL_C_SLONG, cols->aid);
+
+    SmsOut sms_out;
+    return Fetch_Rowsets(hstmt, [&](const SQLULEN i) {
+        sms_out.id = (u32)cols->id.Get(i);
+        Copy_Col(sms_out.phoneno, cols->phoneno.Get(i));
+        Copy_Col(sms_out.message, cols->message.Get(i));
+        sms_out.logTicks = (u64)cols->logTicks.Get(i);
+        sms_out.status = (u32)cols->status.Get(i);
+        sms_out.statusTicks = (u64)cols->statusTicks.Get(i);
+        Copy_Col(sms_out.statusMessage, cols->statusMessage.Get(i));
+        sms_out.sequenceNo = (u32)cols->sequenceNo.Get(i);
+        Copy_Col(sms_out.messageID, cols->messageID.Get(i));
+        sms_out.aid = (u32)cols->aid.Get(i);
+        fn(sms_out);
+    });
+} // end Fetch_SMSOut
+
+
+
+//===============================================================================|
+/**
+ * @brief Same as above; only the messages are added to a batch.
+ * 
+ * @param batch gets every unsent message
+ * 
+ * @return int the number of messages alas -2 on error
+ */
+int Messages::Load_Messages(SmsBatch &batch)
+{
+    return Load_Messages([&batch](const SmsOut &out) { batch.Add(out); });
+} // end Load_Messages
 
 
 
@@ -290,38 +591,15 @@ std::string Messages::Load_Reading_Period_ToDate()
 //===============================================================================|
 /**
  * @brief Load's the AuditID from the manually maintained database id's stored in
- *  WSISApp database. The function also update's the ID to the next integer
+ *  WSISApp database. The id is taken with an atomic bump of the table, so no
+ *  two instances end up with the same one.
  * 
- * @return int the audit id used for auditing data
+ * @return int the audit id used for auditing data alas -2
  */
 int Messages::Load_AID()
 {
-    SQLLEN len;
-    std::string sql{"SELECT LastValue FROM WSISApp.dbo.AutoIncrementFields WHERE Name = 'AuditID'"};
-
-    if (iQE::Run_Query_Direct((SQLCHAR*)sql.c_str(), hstmt) < 0)
-    {
-        iQE::Dump_DB_Error();
-        return -2;
-    } // end if
-
-    SQLBindCol(hstmt, 1, SQL_C_SLONG, (SQLPOINTER)&audit_id, 0, &len);
-    if ( !SQL_SUCCEEDED(SQLFetch(hstmt)))
-    {
-        iQE::Dump_DB_Error();
+    if (audit_ids.Next(audit_id) < 0)
         return -2;
-    } // end if
-
-    SQLCloseCursor(hstmt);
-    audit_id++;
-    sql = "UPDATE WSISApp.dbo.AutoIncrementFields SET LastValue = " + std::to_string(audit_id) +
-        " WHERE Name = 'AuditID'";
-    
-    if (iQE::Run_Query_Direct((SQLCHAR*)sql.c_str(), hstmt) < 0)
-    {
-        iQE::Dump_DB_Error();
-        return -2;
-    } // end if
 
     return audit_id;
 } // end Load_AID
@@ -330,53 +608,32 @@ int Messages::Load_AID()
 
 //===============================================================================|
 /**
- * @brief Load's the last message ID from the manually kept AutoIncrementFields
- *  table of WSISApp database. 
+ * @brief Load's the next message ID to be handed out. The ids come out of
+ *  blocks reserved from the manually kept AutoIncrementFields table of WSISApp
+ *  database; a block is reserved should there be none at hand.
  * 
- * @return int the next messageID to use in the database
+ * @return int the next messageID to use in the database alas -2
  */
 int Messages::Load_Last_Message_ID()
 {
-    SQLLEN len;
-
-    std::string sql{"SELECT LastValue FROM WSISApp.dbo.AutoIncrementFields WHERE Name = 'MessageID'"};
-
-    if (iQE::Run_Query_Direct((SQLCHAR*)sql.c_str(), hstmt) < 0)
-    {
-        iQE::Dump_DB_Error();
+    u32 id;
+    if (msg_ids.Peek(id) < 0)
         return -2;
-    } // end if
 
-    SQLBindCol(hstmt, 1, SQL_C_SLONG, (SQLPOINTER)&last_msg_id, 0, &len);
-    if ( !SQL_SUCCEEDED(SQLFetch(hstmt)))
-    {
-        iQE::Dump_DB_Error();
-        return -2;
-    } // end if
-
-    SQLCloseCursor(hstmt);
-    return ++last_msg_id;
+    return id;
 } // end Load_Last_Message_ID
 
 
 
 //===============================================================================|
 /**
- * @brief Updates the content's of Database for MessageID for permanent effects.
+ * @brief Nothing left to do here; LastValue moves up a block at a time as the
+ *  blocks are reserved, and always stays ahead of the ids handed out.
  * 
- * @return int 0 on success -2 on fail
+ * @return int 0
  */
 int Messages::Update_Last_Message_ID() const
 {
-    std::string sql{"UPDATE WSISApp.dbo.AutoIncrementFields SET LastValue = " +
-        std::to_string(last_msg_id) + " WHERE Name = 'MessageID'"};
-
-    if (iQE::Run_Query_Direct((SQLCHAR*)sql.c_str(), hstmt) < 0)
-    {
-        iQE::Dump_DB_Error();
-        return -2;
-    } // end if
-
     return 0;
 } // end Update_Last_Message_ID
 
@@ -455,17 +712,16 @@ std::string Messages::Load_Unread_Format()
 //===============================================================================|
 /**
  * @brief Prepare's a cooked message for bills to be paid for customer under the
- *  current period
+ *  current period. Rows are block fetched as in Load_Messages and each message
+ *  is handed to fn as soon as it's cooked.
  * 
+ * @param fn gets every message
  * @param subscriber_id when this is used then the message is single user
  * 
- * @return std::vector<SmsOut> a vector of out messages to write to db
+ * @return int the number of messages alas -2 on error
  */
-std::vector<SmsOut> Messages::Preview_Bill_SMS(const int subscriber_id)
+int Messages::Preview_Bill_SMS(const SmsOut_Fn &fn, const int subscriber_id)
 {
-    SQLLEN len;
-    std::vector<SmsOut> out_sms;
-
     char buf[MAXLINE*4]{0};
     if (subscriber_id == -1)
     {
@@ -536,115 +792,147 @@ std::vector<SmsOut> Messages::Preview_Bill_SMS(const int subscriber_id)
     if (iQE::Run_Query_Direct((SQLCHAR*)buf, hstmt) < 0)
     {
         iQE::Dump_DB_Error();
-        return out_sms;
+        return -2;
     } // end if
 
-    int connectionID;
-    char phone[50];
-    char name[200];
-    double cur{0}, overd{0};
-    int reading{0}, consumption{0};
-    char customer_code[200];
-
-
-    SQLBindCol(hstmt, 1, SQL_C_SLONG, (SQLPOINTER)&connectionID, 0, &len);
-    SQLBindCol(hstmt, 2, SQL_C_CHAR, (SQLPOINTER)phone, 40, &len);
-    SQLBindCol(hstmt, 3, SQL_C_CHAR, (SQLPOINTER)name, 200, &len);
-    SQLBindCol(hstmt, 4, SQL_C_CHAR, (SQLPOINTER)customer_code, 200, &len);
-    SQLBindCol(hstmt, 5, SQL_C_SLONG, (SQLPOINTER)&reading, 0, &len);
-    SQLBindCol(hstmt, 6, SQL_C_SLONG, (SQLPOINTER)&consumption, 0, &len);
-    SQLBindCol(hstmt, 7, SQL_C_DOUBLE, (SQLPOINTER)&cur, 0, &len);
-    SQLBindCol(hstmt, 8, SQL_C_DOUBLE, (SQLPOINTER)&overd, 0, &len);;
-
-
-    while ( SQL_SUCCEEDED(SQLFetch(hstmt)))
-    {
-        std::string msg{bill_format};
-
-        msg = Replace_String(msg, "$name", name);
-        msg = Replace_String(msg, "$period", period_name);
-        msg = Replace_String(msg, "$contractNo", std::to_string(connectionID));
-        msg = Replace_String(msg, "$cont", std::to_string(connectionID));
-        msg = Replace_String(msg, "$bill", Format_Numerics(cur + overd));
-        msg = Replace_String(msg, "$currentReading", std::to_string(reading));
-        msg = Replace_String(msg, "$consumption", std::to_string(consumption));
-
-        SmsOut out;
-        out.id = last_msg_id;
-        iCpy(out.phoneno, phone, strlen(phone) + 1);
-        iCpy(out.message, msg.c_str(), msg.length()+1);
-        out.logTicks = time(NULL);
-        out.status = 0;
-        out.statusTicks = time(NULL);
-        iCpy(out.statusMessage, "Sending", strlen("Sending"));
-        out.sequenceNo = last_msg_id++;
-        out.aid = audit_id;
-
-        out_sms.push_back(out);
-    } // end while
-
-    SQLCloseCursor(hstmt);
-    return out_sms;
+    struct COLUMNS
+    {
+        Fetch_Col<s32> connectionID;
+        Fetch_Str<50> phone;
+        Fetch_Str<200> name;
+        Fetch_Str<200> customer_code;
+        Fetch_Col<s32> reading;
+        Fetch_Col<s32> consumption;
+        Fetch_Col<double> cur;
+        Fetch_Col<double> overd;
+    };
+
+    std::unique_ptr<COLUMNS> cols{new COLUMNS};
+    Bind_Col(hstmt, 1, SQL_C_SLONG, cols->connectionID);
+    Bind_Col(hstmt, 2, cols->phone);
+    Bind_Col(hstmt, 3, cols->name);
+    Bind_Col(hstmt, 4, cols->customer_code);
+    Bind_Col(hstmt, 5, SQL_C_SLONG, cols->reading);
+    Bind_Col(hstmt, 6, SQL_C_SLONG, cols->consumption);
+    Bind_Col(hstmt, 7, SQL_C_DOUBLE, cols->cur);
+    Bind_Col(hstmt, 8, SQL_C_DOUBLE, cols->overd);
+
+    MsgTemplate tpl{BILL_SLOTS};
+    tpl.Compile(bill_format);
+    tpl.Bind(BILL_PERIOD, period_name);
+
+    SmsOut out{};
+    std::string msg;
+    char contract[16], reading[16], consumption[16], amount[AMOUNT_BUFFER_SIZE];
+    int err{0};
+    int rows = Fetch_Rowsets(hstmt, [&](const SQLULEN i) {
+        if (err < 0)
+            return;         // out of ids; none of the rest can be numbered
+
+        std::string_view bill{amount, Format_Amount(amount, sizeof(amount), 
+            cols->cur.Get(i) + cols->overd.Get(i))};
+        std::string_view cont{Int_View(contract, cols->connectionID.Get(i))};
+        std::string_view values[] = {
+            cols->name.Get(i),
+            {},
+            cont,
+            cont,
+            bill,
+            Int_View(reading, cols->reading.Get(i)),
+            Int_View(consumption, cols->consumption.Get(i))
+        };
+
+        tpl.Render(msg, values);
+        if ((err = Fill_SmsOut(out, cols->phone.Get(i), msg)) == 0)
+            fn(out);
+    });
+
+    return err < 0 ? err : rows;
 } // end Preview_Bill_SMS
 
 
 
 //===============================================================================|
-std::vector<SmsOut> Messages::Preview_Reading_SMS(const int subscriber_id)
+/**
+ * @brief Prepare's a reminder for the customers whose meter hasn't been read
+ *  for the reading period.
+ * 
+ * @param fn gets every message
+ * @param subscriber_id when this is used then the message is single user
+ * 
+ * @return int the number of messages alas -2 on error
+ */
+int Messages::Preview_Reading_SMS(const SmsOut_Fn &fn, const int subscriber_id)
 {
+    // it's the same for everyone; and it has to be asked before the query below
+    //  takes up hstmt
+    std::string to_date{Load_Reading_Period_ToDate()};
+
     char buf[MAXLINE]{0};
     snprintf(buf, MAXLINE, "SELECT s.name, ss.contactNo, s.phoneNo, s.customerCode \
         FROM Subscriber.dbo.Subscription ss INNER JOIN Subscriber.dbo.Subscriber s \
         ON ss.subscriberID = s.id AND ss.ticksTo = -1 WHERE ss.subscriptionStatus = 2 \
         AND phoneNo IS NOT NULL AND LEN(phoneNo) > 9 AND ss.id NOT IN ( \
         SELECT SubscriptionID FROM Subscriber.dbo.BWFMeterReading WHERE periodID = %d \
-        AND bwfStatus = 1);", reading_period);
+        AND bwfStatus = 1)", reading_period);
 
     if (subscriber_id != -1)
-        snprintf(buf + strlen(buf), MAXLINE - strlen(buf), "AND s.id = %d", 
+        snprintf(buf + strlen(buf), MAXLINE - strlen(buf), " AND s.id = %d", 
         subscriber_id);
 
-    int connectionID;
-    char phone[50];
-    char name[200];
-    char customer_code[200];
-
-    SQLLEN len;
-    SQLBindCol(hstmt, 1, SQL_C_CHAR, (SQLPOINTER)name, 200, &len);
-    SQLBindCol(hstmt, 2, SQL_C_SLONG, (SQLPOINTER)&connectionID, 0, &len);
-    SQLBindCol(hstmt, 3, SQL_C_CHAR, (SQLPOINTER)phone, 200, &len);
-    SQLBindCol(hstmt, 4, SQL_C_CHAR, (SQLPOINTER)customer_code, 200, &len);
-
-    std::vector<SmsOut> vout;
-    while ( SQL_SUCCEEDED(SQLFetch(hstmt)))
-    {
-        std::string msg{unread_format};
-
-        msg = Replace_String(msg, "$name", name);
-        msg = Replace_String(msg, "$date", Load_Reading_Period_ToDate());
-
-        SmsOut out;
-        out.id = last_msg_id;
-        iCpy(out.phoneno, phone, strlen(phone) + 1);
-        iCpy(out.message, msg.c_str(), msg.length()+1);
-        out.logTicks = time(NULL);
-        out.status = 0;
-        out.statusTicks = time(NULL);
-        iCpy(out.statusMessage, "Sending", strlen("Sending"));
-        out.sequenceNo = last_msg_id++;
-        out.aid = audit_id;
-
-        vout.push_back(out);
-    } // end while
+    if (iQE::Run_Query_Direct((SQLCHAR*)buf, hstmt) < 0)
+    {
+        iQE::Dump_DB_Error();
+        return -2;
+    } // end if
 
-    SQLCloseCursor(hstmt);
-    return vout;
+    struct COLUMNS
+    {
+        Fetch_Str<200> name;
+        Fetch_Col<s32> connectionID;
+        Fetch_Str<50> phone;
+        Fetch_Str<200> customer_code;
+    };
+
+    std::unique_ptr<COLUMNS> cols{new COLUMNS};
+    Bind_Col(hstmt, 1, cols->name);
+    Bind_Col(hstmt, 2, SQL_C_SLONG, cols->connectionID);
+    Bind_Col(hstmt, 3, cols->phone);
+    Bind_Col(hstmt, 4, cols->customer_code);
+
+    MsgTemplate tpl{UNREAD_SLOTS};
+    tpl.Compile(unread_format);
+    tpl.Bind(UNREAD_DATE, to_date);
+
+    SmsOut out{};
+    std::string msg;
+    int err{0};
+    int rows = Fetch_Rowsets(hstmt, [&](const SQLULEN i) {
+        if (err < 0)
+            return;         // out of ids; none of the rest can be numbered
+
+        std::string_view values[] = {cols->name.Get(i), {}};
+
+        tpl.Render(msg, values);
+        if ((err = Fill_SmsOut(out, cols->phone.Get(i), msg)) == 0)
+            fn(out);
+    });
+
+    return err < 0 ? err : rows;
 } // end Preview_Reading_SMS
 
 
 
 //===============================================================================|
-std::vector<SmsOut> Messages::Preview_General_SMS(const int subscriber_id)
+/**
+ * @brief Prepare's the general message for every customer with a phone #
+ * 
+ * @param fn gets every message
+ * @param subscriber_id when this is used then the message is single user
+ * 
+ * @return int the number of messages alas -2 on error
+ */
+int Messages::Preview_General_SMS(const SmsOut_Fn &fn, const int subscriber_id)
 {
     char buf[MAXLINE]{0};
     snprintf(buf, MAXLINE, "SELECT phoneNo, name, customerCode FROM \
@@ -654,76 +942,292 @@ std::vector<SmsOut> Messages::Preview_General_SMS(const int subscriber_id)
         snprintf(buf + strlen(buf), MAXLINE - strlen(buf), " AND id = %d", 
         subscriber_id);
 
-    char phone[50];
-    char name[200];
-    char customer_code[200];
-
-    SQLLEN len;
-    SQLBindCol(hstmt, 1, SQL_C_CHAR, (SQLPOINTER)phone, 200, &len);
-    SQLBindCol(hstmt, 2, SQL_C_CHAR, (SQLPOINTER)name, 200, &len);
-    SQLBindCol(hstmt, 3, SQL_C_CHAR, (SQLPOINTER)customer_code, 200, &len);
+    if (iQE::Run_Query_Direct((SQLCHAR*)buf, hstmt) < 0)
+    {
+        iQE::Dump_DB_Error();
+        return -2;
+    } // end if
 
-    std::vector<SmsOut> vout;
-    while ( SQL_SUCCEEDED(SQLFetch(hstmt)))
+    struct COLUMNS
     {
-        std::string msg{msg_format};
+        Fetch_Str<50> phone;
+        Fetch_Str<200> name;
+        Fetch_Str<200> customer_code;
+    };
+
+    std::unique_ptr<COLUMNS> cols{new COLUMNS};
+    Bind_Col(hstmt, 1, cols->phone);
+    Bind_Col(hstmt, 2, cols->name);
+    Bind_Col(hstmt, 3, cols->customer_code);
+
+    MsgTemplate tpl{GENERAL_SLOTS};
+    tpl.Compile(msg_format);
+
+    SmsOut out{};
+    std::string msg;
+    int err{0};
+    int rows = Fetch_Rowsets(hstmt, [&](const SQLULEN i) {
+        if (err < 0)
+            return;         // out of ids; none of the rest can be numbered
+
+        std::string_view values[] = {cols->name.Get(i)};
+
+        tpl.Render(msg, values);
+        if ((err = Fill_SmsOut(out, cols->phone.Get(i), msg)) == 0)
+            fn(out);
+    });
+
+    return err < 0 ? err : rows;
+} // end Preview_General_SMS
 
-        msg = Replace_String(msg, "$name", name);
 
-        SmsOut out;
-        out.id = last_msg_id;
-        iCpy(out.phoneno, phone, strlen(phone) + 1);
-        iCpy(out.message, msg.c_str(), msg.length()+1);
-        out.logTicks = time(NULL);
-        out.status = 0;
-        out.statusTicks = time(NULL);
-        iCpy(out.statusMessage, "Sending", strlen("Sending"));
-        out.sequenceNo = last_msg_id++;
-        out.aid = audit_id;
 
-        vout.push_back(out);
-    } // end while
+//===============================================================================|
+/**
+ * @brief The batch taking versions of the above; the messages are added to a
+ *  batch for the likes of Write_SMSOut.
+ * 
+ * @param batch gets every message
+ * @param subscriber_id when this is used then the message is single user
+ * 
+ * @return int the number of messages alas -2 on error
+ */
+int Messages::Preview_Bill_SMS(SmsBatch &batch, const int subscriber_id)
+{
+    return Preview_Bill_SMS([&batch](const SmsOut &out) { batch.Add(out); }, subscriber_id);
+} // end Preview_Bill_SMS
 
-    SQLCloseCursor(hstmt);
-    return vout;
+
+
+int Messages::Preview_Reading_SMS(SmsBatch &batch, const int subscriber_id)
+{
+    return Preview_Reading_SMS([&batch](const SmsOut &out) { batch.Add(out); }, subscriber_id);
+} // end Preview_Reading_SMS
+
+
+
+int Messages::Preview_General_SMS(SmsBatch &batch, const int subscriber_id)
+{
+    return Preview_General_SMS([&batch](const SmsOut &out) { batch.Add(out); }, subscriber_id);
 } // end Preview_General_SMS
 
 
 
 //===============================================================================|
-void Messages::Write_SMSOut(std::vector<SmsOut> &msgs)
+/**
+ * @brief Fills in a fresh outgoing message; it takes the next message id.
+ * 
+ * @param out the message to fill
+ * @param phone where it's going
+ * @param msg what it says
+ * 
+ * @return int 0 on success alas -2 when there's no id to be had
+ */
+int Messages::Fill_SmsOut(SmsOut &out, const char *phone, const std::string &msg)
 {
-    char buf[MAXLINE*4]{0};
+    if (msg_ids.Next(out.id) < 0)
+        return -2;
+
+    Copy_Col(out.phoneno, phone);
+    Copy_Col(out.message, msg.c_str());
+    out.logTicks = time(NULL);
+    out.status = 0;
+    out.statusTicks = time(NULL);
+    Copy_Col(out.statusMessage, "Sending");
+    out.sequenceNo = out.id;
+    out.messageID[0] = '\0';
+    out.aid = audit_id;
+    return 0;
+} // end Fill_SmsOut
+
+
+
+//===============================================================================|
+/**
+ * @brief Writes the messages to SmsOut. Rather than one statement per message,
+ *  the insert is prepared once and sent DB_BULK_INSERT_SIZE rows at a time as
+ *  arrays of parameters, bound column-wise. Each chunk's strings are laid out
+ *  in staging buffers just wide enough for the longest of them; the buffers
+ *  last the whole of the call, so there's no allocation per message. Each
+ *  chunk is a transaction of its own.
+ * 
+ * @param batch the messages to write
+ * 
+ * @return int the number of messages written; should that be short of all of
+ *  them, the chunk that failed has been rolled back and the error dumped.
+ */
+int Messages::Write_SMSOut(const SmsBatch &batch)
+{
+    if (batch.Empty())
+        return 0;
 
-    for (size_t i{0}; i < msgs.size(); i++)
+    if (Prepare_SMSOut_Insert() < 0 || !SQL_SUCCEEDED(DB_SET_CONN_ATTR(hdbc, SQL_AUTOCOMMIT_OFF)))
     {
-        snprintf(buf, MAXLINE*4, "INSERT INTO Subscriber.dbo.SmsOut \
-            (phoneNo, message, logTicks, status, statusTicks, statusMessage, seqNo, messageID, __AID) \
-            VALUES ('%s', '%s', %ld, %d, %ld, '%s', %d, '%s', %d)",
-            msgs[i].phoneno, msgs[i].message, msgs[i].logTicks, msgs[i].status, 
-            msgs[i].statusTicks, msgs[i].statusMessage, msgs[i].sequenceNo, 
-            msgs[i].messageID, msgs[i].aid);
-        
-        if (iQE::Run_Query_Direct((SQLCHAR*)buf, hstmt) < 0)
+        iQE::Dump_DB_Error();
+        return 0;
+    } // end if
+
+    Param_Str phoneno, message, status_msg, msg_id;
+    std::vector<s64> log_ticks, status_ticks;
+    std::vector<s32> status, seq_no, aid;
+
+    size_t written{0};
+    while (written < batch.Size())
+    {
+        size_t rows = batch.Size() - written;
+        rows = rows > DB_BULK_INSERT_SIZE ? DB_BULK_INSERT_SIZE : rows;
+
+        Stage_Str(phoneno, batch, written, rows, &SmsBatch::Phone_No);
+        Stage_Str(message, batch, written, rows, &SmsBatch::Message);
+        Stage_Str(status_msg, batch, written, rows, &SmsBatch::Status_Message);
+        Stage_Str(msg_id, batch, written, rows, &SmsBatch::Message_ID);
+
+        log_ticks.resize(rows);
+        status_ticks.resize(rows);
+        status.resize(rows);
+        seq_no.resize(rows);
+        aid.resize(rows);
+        for (size_t i = 0; i < rows; i++)
         {
+            const Sms_Record &r = batch[written + i];
+            log_ticks[i] = (s64)r.logTicks;
+            status_ticks[i] = (s64)r.statusTicks;
+            status[i] = (s32)r.status;
+            seq_no[i] = (s32)r.sequenceNo;
+            aid[i] = (s32)r.aid;
+        } // end for
+
+        SQLSetStmtAttr(hinsert, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)rows, 0);
+        Bind_Str(hinsert, 1, phoneno);
+        Bind_Str(hinsert, 2, message);
+        SQLBindParameter(hinsert, 3, SQL_PARAM_INPUT, SQL_C_SBIGINT, SQL_BIGINT, 0, 0,
+            (SQLPOINTER)log_ticks.data(), 0, nullptr);
+        SQLBindParameter(hinsert, 4, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0,
+            (SQLPOINTER)status.data(), 0, nullptr);
+        SQLBindParameter(hinsert, 5, SQL_PARAM_INPUT, SQL_C_SBIGINT, SQL_BIGINT, 0, 0,
+            (SQLPOINTER)status_ticks.data(), 0, nullptr);
+        Bind_Str(hinsert, 6, status_msg);
+        SQLBindParameter(hinsert, 7, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0,
+            (SQLPOINTER)seq_no.data(), 0, nullptr);
+        Bind_Str(hinsert, 8, msg_id);
+        SQLBindParameter(hinsert, 9, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0,
+            (SQLPOINTER)aid.data(), 0, nullptr);
+
+        SQLRETURN rc = SQLExecute(hinsert);
+        if (!SQL_SUCCEEDED(rc))
+            DB_EXTRACT_ERROR(SQL_HANDLE_STMT, hinsert);
+
+        if (!SQL_SUCCEEDED(rc) || !SQL_SUCCEEDED(SQLEndTran(SQL_HANDLE_DBC, hdbc, SQL_COMMIT)))
+        {
+            if (SQL_SUCCEEDED(rc))
+                DB_EXTRACT_ERROR(SQL_HANDLE_DBC, hdbc);
+
             iQE::Dump_DB_Error();
-        } // end if
-    } // end for
+            SQLEndTran(SQL_HANDLE_DBC, hdbc, SQL_ROLLBACK);
+            break;
+        } // end if chunk failed
+
+        written += rows;
+    } // end while
+
+    // the rest of the queries expect every statement to stand on its own; and
+    //  the staging buffers are about to go
+    SQLFreeStmt(hinsert, SQL_RESET_PARAMS);
+    SQLSetStmtAttr(hinsert, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)1, 0);
+    DB_SET_CONN_ATTR(hdbc, SQL_AUTOCOMMIT_ON);
+    return (int)written;
 } // end Write_SMSOut
 
 
 
+//===============================================================================|
+/**
+ * @brief Gets the statement for Write_SMSOut ready the first time it's needed;
+ *  it stays prepared for as long as we're connected.
+ * 
+ * @return int 0 on success alas -1 with the error extracted
+ */
+int Messages::Prepare_SMSOut_Insert()
+{
+    if (hinsert)
+        return 0;
+
+    if (!SQL_SUCCEEDED(DB_ALLOC_HANDLE(SQL_HANDLE_STMT, hdbc, hinsert)))
+    {
+        DB_EXTRACT_ERROR(SQL_HANDLE_DBC, hdbc);
+        hinsert = nullptr;
+        return -1;
+    } // end if
+
+    if (!SQL_SUCCEEDED(SQLSetStmtAttr(hinsert, SQL_ATTR_PARAM_BIND_TYPE, (SQLPOINTER)SQL_PARAM_BIND_BY_COLUMN, 0)) ||
+        !SQL_SUCCEEDED(DB_PREPARE_QUERY(hinsert, "INSERT INTO Subscriber.dbo.SmsOut \
+            (phoneNo, message, logTicks, status, statusTicks, statusMessage, seqNo, messageID, __AID) \
+            VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)")))
+    {
+        DB_EXTRACT_ERROR(SQL_HANDLE_STMT, hinsert);
+        SQLFreeHandle(SQL_HANDLE_STMT, hinsert);
+        hinsert = nullptr;
+        return -1;
+    } // end if
+
+    return 0;
+} // end Prepare_SMSOut_Insert
+
+
+
 //===============================================================================|
 void Messages::Update_SMSOut(SmsOut_Ptr msg)
 {
-    char buf[512]{0};
-    snprintf(buf, 512, 
-        "UPDATE Subscriber.dbo.SmsOut SET status = %d WHERE messageID = '%s';",
-        msg->status, msg->messageID);
+    Update_SMSOut(msg->status, msg->messageID);
+} // end Update_SMSOut
+
+
 
-    if (iQE::Run_Query_Direct((SQLCHAR*)buf) < 0)
+//===============================================================================|
+/**
+ * @brief Sets the status of the message SMSC knows as msg_id. With a pool set
+ *  it's safe from any thread: the update runs as a statement prepared once per
+ *  pooled connection, with the message_id passed as a parameter.
+ * 
+ * @param status the new status
+ * @param msg_id the message_id
+ */
+void Messages::Update_SMSOut(const u32 status, const std::string_view msg_id)
+{
+    if (!ppool)
+    {
+        char buf[512]{0};
+        snprintf(buf, 512, 
+            "UPDATE Subscriber.dbo.SmsOut SET status = %u WHERE messageID = '%.*s';",
+            status, (int)msg_id.size(), msg_id.data());
+
+        if (iQE::Run_Query_Direct((SQLCHAR*)buf, hstmt) < 0)
+            iQE::Dump_DB_Error();
+
+        return;
+    } // end if on our own
+
+    DbLease lease = ppool->Acquire();
+    HSTMT hupdate = lease ? lease.Prepare("UPDATE Subscriber.dbo.SmsOut SET status = ? \
+        WHERE messageID = ?") : nullptr;
+    if (!hupdate)
     {
         iQE::Dump_DB_Error();
         return;
     } // end if
-} // end Update_Out_SMS_DB
\ No newline at end of file
+
+    SQLINTEGER st = (SQLINTEGER)status;
+    SQLLEN id_len = (SQLLEN)msg_id.size();
+    SQLBindParameter(hupdate, 1, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0, 
+        (SQLPOINTER)&st, 0, nullptr);
+    SQLBindParameter(hupdate, 2, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, 
+        sizeof(SmsOut::messageID) - 1, 0, (SQLPOINTER)msg_id.data(), id_len, &id_len);
+
+    if (!SQL_SUCCEEDED(SQLExecute(hupdate)))
+    {
+        DB_EXTRACT_ERROR(SQL_HANDLE_STMT, hupdate);
+        iQE::Dump_DB_Error();
+    } // end if
+
+    SQLFreeStmt(hupdate, SQL_CLOSE);
+} // end Update_SMSOut
@@ -0,0 +1,211 @@
+/**
+ * @file outbox.cpp
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Implementation details for outbox.h
+ * @version 0.1
+ * @date 2024-03-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "outbox.h"
+
+
+
+
+
+//===============================================================================|
+//          CLASS IMP
+//===============================================================================|
+/**
+ * @brief Construct a new Outbox:: Outbox object
+ *
+ * @param capacity the messages held ahead of the senders at most
+ * @param page_size the messages read per query
+ */
+Outbox::Outbox(const size_t capacity, const u32 page_size)
+    :pproducer{nullptr}, running{false}, page_size{page_size}, last_id{0}, 
+    ring(capacity ? capacity : 1), head{0}, count{0}
+{
+} // end Constructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Destroy the Outbox:: Outbox object
+ *
+ */
+Outbox::~Outbox()
+{
+    Stop();
+} // end Destructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Connects to the database and starts the producer; the first messages
+ *  are ready as soon as the first page is in.
+ *
+ * @param con_str ODBC formatted connection string
+ *
+ * @return int 0 on success alas -1
+ */
+int Outbox::Start(const std::string &con_str)
+{
+    if (pproducer)
+        return 0;
+
+    if (db.Connect_DB(con_str) < 0)
+        return -1;
+
+    running = true;
+    pproducer = new std::thread(&Outbox::Run, this);
+    return 0;
+} // end Start
+
+
+
+//===============================================================================|
+/**
+ * @brief Stops the producer and wakes up anyone waiting on the queue. What's
+ *  left in the queue can still be popped.
+ *
+ */
+void Outbox::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(ob_mutex);
+        running = false;
+    } // end lock
+
+    not_full.notify_all();
+    not_empty.notify_all();
+
+    if (pproducer)
+    {
+        pproducer->join();
+        delete pproducer;
+        pproducer = nullptr;
+        db.Disconnect_DB();
+    } // end if
+} // end Stop
+
+
+
+//===============================================================================|
+/**
+ * @brief Takes the next message off the queue, waiting up to timeout_ms for
+ *  one to come in.
+ *
+ * @param out the message is returned here
+ * @param timeout_ms how long to wait on an empty queue
+ *
+ * @return true when a message was taken, false on time out or once stopped
+ *  and drained
+ */
+bool Outbox::Pop(Outbox_Msg &out, const u32 timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(ob_mutex);
+    if (!not_empty.wait_for(lock, std::chrono::milliseconds(timeout_ms), 
+        [this] { return count > 0 || !running; }) || count == 0)
+    {
+        return false;
+    } // end if nothing
+
+    std::swap(out, ring[head]);
+    head = (head + 1) % ring.size();
+    --count;
+
+    lock.unlock();
+    not_full.notify_one();
+    return true;
+} // end Pop
+
+
+
+//===============================================================================|
+/**
+ * @brief The # of messages waiting on the senders
+ *
+ */
+u64 Outbox::Get_Queued() const
+{
+    std::lock_guard<std::mutex> lock(ob_mutex);
+    return count;
+} // end Get_Queued
+
+
+
+//===============================================================================|
+/**
+ * @brief The producer. Each page is read into a batch that's reused from page
+ *  to page, so the cursor is closed before the queue gets a chance to push
+ *  back; the messages are then queued one by one as room frees up.
+ *
+ */
+void Outbox::Run()
+{
+    SmsBatch page{page_size, (size_t)page_size * 256};
+
+    while (running)
+    {
+        page.Clear();
+        int rows = db.Load_Messages(last_id, page_size, 
+            [&page](const SmsOut &out) { page.Add(out); });
+
+        for (size_t i = 0; i < page.Size(); i++)
+        {
+            if (!Push(page, i))
+                return;     // stopped
+
+            last_id = page[i].id;
+        } // end for
+
+        if (rows >= 0 && (u32)rows >= page_size)
+            continue;       // there's more where that came from
+
+        // caught up, or the query failed; either way look again later
+        for (u32 waited = 0; waited < OUTBOX_POLL_INTERVAL && running; waited += 100)
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    } // end while
+} // end Run
+
+
+
+//===============================================================================|
+/**
+ * @brief Queues a message, waiting for as long as the queue is full
+ *
+ * @param page the page read last
+ * @param i the message on it
+ *
+ * @return true when queued, false when stopped while waiting
+ */
+bool Outbox::Push(const SmsBatch &page, const size_t i)
+{
+    std::unique_lock<std::mutex> lock(ob_mutex);
+    not_full.wait(lock, [this] { return count < ring.size() || !running; });
+    if (!running)
+        return false;
+
+    Outbox_Msg &slot = ring[(head + count) % ring.size()];
+    slot.id = page[i].id;
+    slot.status = page[i].status;
+    slot.phoneno.assign(page.Phone_No(i));
+    slot.message.assign(page.Message(i));
+    slot.messageID.assign(page.Message_ID(i));
+    ++count;
+
+    lock.unlock();
+    not_empty.notify_one();
+    return true;
+} // end Push
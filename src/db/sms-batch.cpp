@@ -0,0 +1,265 @@
+/**
+ * @file sms-batch.cpp
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Implementation details for sms-batch.h
+ * @version 0.1
+ * @date 2024-03-20
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "sms-batch.h"
+#include "messages.h"
+
+
+
+
+
+//===============================================================================|
+//          FUNCTIONS
+//===============================================================================|
+/**
+ * @brief The string in one of SmsOut's buffers; it needn't be terminated.
+ */
+template <size_t N>
+static inline std::string_view Field(const char (&buf)[N])
+{
+    return std::string_view(buf, strnlen(buf, N));
+} // end Field
+
+
+
+/**
+ * @brief Copies s into one of SmsOut's buffers; cut short if need be.
+ */
+template <size_t N>
+static inline void Copy_Field(char (&buf)[N], const std::string_view s)
+{
+    size_t len = s.size() < N ? s.size() : N - 1;
+    memcpy(buf, s.data(), len);
+    buf[len] = '\0';
+} // end Copy_Field
+
+
+
+
+
+//===============================================================================|
+//          CLASS IMP
+//===============================================================================|
+/**
+ * @brief Construct a new Sms Batch:: Sms Batch object
+ *
+ * @param rows messages to make room for up front
+ * @param bytes text to make room for up front
+ */
+SmsBatch::SmsBatch(const size_t rows, const size_t bytes)
+{
+    records.reserve(rows);
+    arena.reserve(bytes);
+    interned.emplace_back();    // index 0 is the empty string
+} // end Constructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Adds a copy of a message read from SmsOut
+ *
+ * @param out the message
+ *
+ * @return size_t its index in the batch
+ */
+size_t SmsBatch::Add(const SMSOUT_TABLE_TYPE &out)
+{
+    size_t i = Add(Field(out.phoneno), Field(out.message));
+    Sms_Record &r = records[i];
+    r.id = out.id;
+    r.messageID = Put(Field(out.messageID), r.messageID_len);
+    r.statusMessage = Intern(Field(out.statusMessage));
+    r.status = out.status;
+    r.sequenceNo = out.sequenceNo;
+    r.aid = out.aid;
+    r.logTicks = out.logTicks;
+    r.statusTicks = out.statusTicks;
+    return i;
+} // end Add
+
+
+
+//===============================================================================|
+/**
+ * @brief Adds a message with only its destination and text; the rest is left
+ *  zero for the caller to fill in through operator[] and the Set's.
+ *
+ * @param phoneno the destination
+ * @param message the text
+ *
+ * @return size_t its index in the batch
+ */
+size_t SmsBatch::Add(const std::string_view phoneno, const std::string_view message)
+{
+    Sms_Record &r = records.emplace_back();
+    r = Sms_Record{};
+    r.phoneno = Put(phoneno, r.phoneno_len);
+    r.message = Put(message, r.message_len);
+    r.messageID = (u32)arena.size();
+    return records.size() - 1;
+} // end Add
+
+
+
+//===============================================================================|
+/**
+ * @brief Forgets every message but keeps the memory for the next lot
+ *
+ */
+void SmsBatch::Clear()
+{
+    records.clear();
+    arena.clear();
+} // end Clear
+
+
+
+//===============================================================================|
+/**
+ * @brief Gives message i its message_id; the old one, if any, stays behind in
+ *  the arena until the batch is cleared.
+ *
+ */
+void SmsBatch::Set_Message_ID(const size_t i, const std::string_view id)
+{
+    records[i].messageID = Put(id, records[i].messageID_len);
+} // end Set_Message_ID
+
+
+
+//===============================================================================|
+void SmsBatch::Set_Status_Message(const size_t i, const std::string_view text)
+{
+    records[i].statusMessage = Intern(text);
+} // end Set_Status_Message
+
+
+
+//===============================================================================|
+std::string_view SmsBatch::Phone_No(const size_t i) const
+{
+    return std::string_view(arena.data() + records[i].phoneno, records[i].phoneno_len);
+} // end Phone_No
+
+
+
+//===============================================================================|
+std::string_view SmsBatch::Message(const size_t i) const
+{
+    return std::string_view(arena.data() + records[i].message, records[i].message_len);
+} // end Message
+
+
+
+//===============================================================================|
+std::string_view SmsBatch::Message_ID(const size_t i) const
+{
+    return std::string_view(arena.data() + records[i].messageID, records[i].messageID_len);
+} // end Message_ID
+
+
+
+//===============================================================================|
+std::string_view SmsBatch::Status_Message(const size_t i) const
+{
+    return interned[records[i].statusMessage];
+} // end Status_Message
+
+
+
+//===============================================================================|
+/**
+ * @brief Writes message i out in full as an SmsOut; for the odd place that
+ *  still wants one.
+ *
+ * @param i the message
+ * @param out where it's written
+ */
+void SmsBatch::To_SmsOut(const size_t i, SMSOUT_TABLE_TYPE &out) const
+{
+    const Sms_Record &r = records[i];
+    out.id = r.id;
+    Copy_Field(out.phoneno, Phone_No(i));
+    Copy_Field(out.message, Message(i));
+    out.logTicks = r.logTicks;
+    out.status = r.status;
+    out.statusTicks = r.statusTicks;
+    Copy_Field(out.statusMessage, Status_Message(i));
+    out.sequenceNo = r.sequenceNo;
+    Copy_Field(out.messageID, Message_ID(i));
+    out.aid = r.aid;
+} // end To_SmsOut
+
+
+
+//===============================================================================|
+/**
+ * @brief The bytes held by the batch, used or not
+ *
+ */
+size_t SmsBatch::Memory() const
+{
+    size_t bytes = records.capacity() * sizeof(Sms_Record) + arena.capacity();
+    for (const std::string &s : interned)
+        bytes += sizeof(s) + s.capacity();
+
+    return bytes;
+} // end Memory
+
+
+
+//===============================================================================|
+/**
+ * @brief Bumps the arena by s; strings longer than a record can tell are cut
+ *  at 64 KB.
+ *
+ * @param s the string
+ * @param len its length is returned here
+ *
+ * @return u32 its offset
+ */
+u32 SmsBatch::Put(const std::string_view s, u16 &len)
+{
+    u32 off = (u32)arena.size();
+    len = (u16)(s.size() > 0xFFFF ? 0xFFFF : s.size());
+    arena.insert(arena.end(), s.data(), s.data() + len);
+    return off;
+} // end Put
+
+
+
+//===============================================================================|
+/**
+ * @brief The index of s among the interned strings; added the first time it's
+ *  seen. There are few enough of them that a look through beats a hash.
+ *
+ */
+u16 SmsBatch::Intern(const std::string_view s)
+{
+    for (size_t i = 0; i < interned.size(); i++)
+    {
+        if (interned[i] == s)
+            return (u16)i;
+    } // end for
+
+    if (interned.size() > 0xFFFF)
+        return 0;       // out of room; treated as empty
+
+    interned.emplace_back(s);
+    return (u16)(interned.size() - 1);
+} // end Intern
@@ -0,0 +1,430 @@
+/**
+ * @file status-writer.cpp
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Implementation details for status-writer.h
+ * @version 0.1
+ * @date 2024-03-24
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "status-writer.h"
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define SQL_FINAL_STATES    "(2, 4, 5)"     // MSG_STATE_DELIVERED, _FAILED and _EXPIRED
+
+// as Outranks has it, against what an earlier batch left in the row
+#define SQL_OUTRANKS        " AND (? IN " SQL_FINAL_STATES " OR (status NOT IN " \
+    SQL_FINAL_STATES " AND status <= ?))"
+#define SQL_UPDATE_ROW      "UPDATE Subscriber.dbo.SmsOut SET status = ?, \
+    messageID = COALESCE(?, messageID) WHERE id = ?" SQL_OUTRANKS
+#define SQL_UPDATE_MSGID    "UPDATE Subscriber.dbo.SmsOut SET status = ? WHERE messageID = ?" \
+    SQL_OUTRANKS
+
+
+
+
+
+//===============================================================================|
+//          CLASS IMP
+//===============================================================================|
+/**
+ * @brief Construct a new Status Writer:: Status Writer object
+ *
+ */
+StatusWriter::StatusWriter()
+    :ppool{nullptr}, pwriter{nullptr}, running{false}, 
+    batch_size{STATUS_BATCH_SIZE}, interval_ms{STATUS_FLUSH_INTERVAL}, written{0}
+{
+} // end Constructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Destroy the Status Writer:: Status Writer object
+ *
+ */
+StatusWriter::~StatusWriter()
+{
+    Stop();
+} // end Destructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Starts the writer thread
+ *
+ * @param ppool where the connections are leased from; must outlive the writer
+ * @param batch_size updates per execute; also the backlog that forces a flush
+ * @param interval_ms the longest an update waits to be written
+ *
+ * @return int 0 on success alas -1
+ */
+int StatusWriter::Start(DbPool *ppool, const u32 batch_size, const u32 interval_ms)
+{
+    if (pwriter)
+        return 0;
+
+    if (!ppool)
+        return -1;
+
+    this->ppool = ppool;
+    this->batch_size = batch_size ? batch_size : STATUS_BATCH_SIZE;
+    this->interval_ms = interval_ms ? interval_ms : STATUS_FLUSH_INTERVAL;
+    running = true;
+    pwriter = new std::thread(&StatusWriter::Run, this);
+    return 0;
+} // end Start
+
+
+
+//===============================================================================|
+/**
+ * @brief Writes what's pending and stops the thread
+ *
+ */
+void StatusWriter::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(sw_mutex);
+        running = false;
+    } // end lock
+
+    wake.notify_one();
+    if (pwriter)
+    {
+        pwriter->join();
+        delete pwriter;
+        pwriter = nullptr;
+    } // end if
+} // end Stop
+
+
+
+//===============================================================================|
+/**
+ * @brief Files a status change; safe from any thread and never waits on the
+ *  database. A message is filed under its row whenever that's known, alas
+ *  under its message_id; with neither there's nothing to write it to.
+ *
+ * @param row_id the id of the message's row in SmsOut; 0 when not known
+ * @param msg_id the message_id SMSC knows the message as; empty until it's
+ *  given one
+ * @param status its new status; one of MSG_STATE_*
+ */
+void StatusWriter::Enqueue(const u32 row_id, const std::string_view msg_id, const u32 status)
+{
+    if (row_id == 0 && msg_id.empty())
+        return;
+
+    bool full;
+    {
+        std::lock_guard<std::mutex> lock(sw_mutex);
+        if (row_id != 0)
+            Merge(pending[row_id], status, msg_id);
+        else
+        {
+            auto it = pending_ids.find(std::string{msg_id});
+            if (it == pending_ids.end())
+                pending_ids.emplace(msg_id, status);
+            else if (Outranks(status, it->second))
+                it->second = status;
+        } // end else by message_id
+
+        full = pending.size() + pending_ids.size() >= batch_size;
+    } // end lock
+
+    if (full)
+        wake.notify_one();
+} // end Enqueue
+
+
+
+//===============================================================================|
+size_t StatusWriter::Get_Pending() const
+{
+    std::lock_guard<std::mutex> lock(sw_mutex);
+    return pending.size() + pending_ids.size();
+} // end Get_Pending
+
+
+
+//===============================================================================|
+/**
+ * @brief The writer. Takes whatever's pending in one swap, so Enqueue is held
+ *  up no longer than that, and writes it out.
+ *
+ */
+void StatusWriter::Run()
+{
+    Row_Updates rows;
+    Id_Updates ids;
+    for (;;)
+    {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(sw_mutex);
+            wake.wait_for(lock, std::chrono::milliseconds(interval_ms), 
+                [this] { return pending.size() + pending_ids.size() >= batch_size || !running; });
+
+            stopping = !running;
+            rows.swap(pending);
+            ids.swap(pending_ids);
+        } // end lock
+
+        if (!rows.empty() || !ids.empty())
+            Flush(rows, ids);
+
+        if (stopping)
+            break;
+    } // end for
+} // end Run
+
+
+
+//===============================================================================|
+/**
+ * @brief Writes the updates batch by batch, the rows before the message_id's,
+ *  and empties them. Should a batch fail, it and the rest are put back as
+ *  pending, save for the messages that have had a newer change filed since.
+ *
+ */
+void StatusWriter::Flush(Row_Updates &rows, Id_Updates &ids)
+{
+    DbLease lease = ppool->Acquire();
+    Row_Updates::const_iterator rit = rows.begin();
+    Id_Updates::const_iterator iit = ids.begin();
+    if (lease)
+    {
+        while (rit != rows.end())
+        {
+            size_t count = std::min((size_t)batch_size, (size_t)std::distance(rit, rows.cend()));
+            if (Write_Rows(lease, rit, count) < 0)
+                break;
+
+            std::advance(rit, count);
+            written += count;
+        } // end while
+
+        while (rit == rows.end() && iit != ids.end())
+        {
+            size_t count = std::min((size_t)batch_size, (size_t)std::distance(iit, ids.cend()));
+            if (Write_Ids(lease, iit, count) < 0)
+                break;
+
+            std::advance(iit, count);
+            written += count;
+        } // end while
+    } // end if leased
+
+    if (rit != rows.end() || iit != ids.end())
+    {
+        iQE::Dump_DB_Error();
+        std::lock_guard<std::mutex> lock(sw_mutex);
+        for (; rit != rows.end(); ++rit)
+        {
+            auto it = pending.find(rit->first);
+            if (it == pending.end())
+            {
+                pending.emplace(rit->first, rit->second);
+                continue;
+            } // end if nothing newer
+
+            Status_Update newer = std::move(it->second);
+            it->second = rit->second;
+            Merge(it->second, newer.status, newer.msg_id);
+        } // end for
+
+        for (; iit != ids.end(); ++iit)
+        {
+            auto it = pending_ids.find(iit->first);
+            if (it == pending_ids.end())
+                pending_ids.emplace(iit->first, iit->second);
+            else if (!Outranks(it->second, iit->second))
+                it->second = iit->second;
+        } // end for
+    } // end if left over
+
+    rows.clear();
+    ids.clear();
+} // end Flush
+
+
+
+//===============================================================================|
+/**
+ * @brief Sends count updates by row from first on with a single execute and
+ *  commits them; the message_id goes along where there's one
+ *
+ * @return int 0 on success alas -1 with the error extracted and the batch
+ *  rolled back
+ */
+int StatusWriter::Write_Rows(DbLease &lease, Row_Updates::const_iterator first, const size_t count)
+{
+    HSTMT hupdate = lease.Prepare(SQL_UPDATE_ROW);
+    if (!hupdate)
+        return -1;
+
+    ids.resize(count * STATUS_MSGID_SIZE);
+    id_lens.resize(count);
+    statuses.resize(count);
+    row_ids.resize(count);
+    for (size_t i = 0; i < count; i++, ++first)
+    {
+        const std::string &msg_id = first->second.msg_id;
+        size_t len = std::min(msg_id.size(), (size_t)STATUS_MSGID_SIZE - 1);
+        iCpy(&ids[i * STATUS_MSGID_SIZE], msg_id.data(), len);
+        id_lens[i] = msg_id.empty() ? SQL_NULL_DATA : (SQLLEN)len;
+        statuses[i] = (SQLINTEGER)first->second.status;
+        row_ids[i] = (SQLINTEGER)first->first;
+    } // end for
+
+    // column-wise arrays; the statement is shared with the other users of the
+    //  connection, so it's put back to single rows once done
+    SQLSetStmtAttr(hupdate, SQL_ATTR_PARAM_BIND_TYPE, (SQLPOINTER)SQL_PARAM_BIND_BY_COLUMN, 0);
+    SQLSetStmtAttr(hupdate, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)count, 0);
+    SQLBindParameter(hupdate, 1, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0,
+        (SQLPOINTER)statuses.data(), 0, nullptr);
+    SQLBindParameter(hupdate, 2, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, STATUS_MSGID_SIZE - 1, 0,
+        (SQLPOINTER)ids.data(), STATUS_MSGID_SIZE, id_lens.data());
+    SQLBindParameter(hupdate, 3, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0,
+        (SQLPOINTER)row_ids.data(), 0, nullptr);
+    SQLBindParameter(hupdate, 4, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0,
+        (SQLPOINTER)statuses.data(), 0, nullptr);
+    SQLBindParameter(hupdate, 5, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0,
+        (SQLPOINTER)statuses.data(), 0, nullptr);
+
+    return Execute(lease, hupdate);
+} // end Write_Rows
+
+
+
+//===============================================================================|
+/**
+ * @brief Sends count updates by message_id from first on with a single execute
+ *  and commits them
+ *
+ * @return int 0 on success alas -1 with the error extracted and the batch
+ *  rolled back
+ */
+int StatusWriter::Write_Ids(DbLease &lease, Id_Updates::const_iterator first, const size_t count)
+{
+    HSTMT hupdate = lease.Prepare(SQL_UPDATE_MSGID);
+    if (!hupdate)
+        return -1;
+
+    ids.resize(count * STATUS_MSGID_SIZE);
+    id_lens.resize(count);
+    statuses.resize(count);
+    for (size_t i = 0; i < count; i++, ++first)
+    {
+        size_t len = std::min(first->first.size(), (size_t)STATUS_MSGID_SIZE - 1);
+        iCpy(&ids[i * STATUS_MSGID_SIZE], first->first.data(), len);
+        id_lens[i] = (SQLLEN)len;
+        statuses[i] = (SQLINTEGER)first->second;
+    } // end for
+
+    SQLSetStmtAttr(hupdate, SQL_ATTR_PARAM_BIND_TYPE, (SQLPOINTER)SQL_PARAM_BIND_BY_COLUMN, 0);
+    SQLSetStmtAttr(hupdate, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)count, 0);
+    SQLBindParameter(hupdate, 1, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0,
+        (SQLPOINTER)statuses.data(), 0, nullptr);
+    SQLBindParameter(hupdate, 2, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, STATUS_MSGID_SIZE - 1, 0,
+        (SQLPOINTER)ids.data(), STATUS_MSGID_SIZE, id_lens.data());
+    SQLBindParameter(hupdate, 3, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0,
+        (SQLPOINTER)statuses.data(), 0, nullptr);
+    SQLBindParameter(hupdate, 4, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0,
+        (SQLPOINTER)statuses.data(), 0, nullptr);
+
+    return Execute(lease, hupdate);
+} // end Write_Ids
+
+
+
+//===============================================================================|
+/**
+ * @brief Runs a bound batch as a transaction of its own and puts the statement
+ *  back the way it was found
+ *
+ * @return int 0 on success alas -1 with the error extracted and the batch
+ *  rolled back
+ */
+int StatusWriter::Execute(DbLease &lease, HSTMT hupdate)
+{
+    int ret{0};
+    DB_SET_CONN_ATTR(lease.Get_Dbc(), SQL_AUTOCOMMIT_OFF);
+
+    // SQL_NO_DATA is every row having moved on already; nothing to write
+    SQLRETURN rc = SQLExecute(hupdate);
+    if (!SQL_SUCCEEDED(rc) && rc != SQL_NO_DATA)
+    {
+        DB_EXTRACT_ERROR(SQL_HANDLE_STMT, hupdate);
+        SQLEndTran(SQL_HANDLE_DBC, lease.Get_Dbc(), SQL_ROLLBACK);
+        ret = -1;
+    } // end if
+    else if (!SQL_SUCCEEDED(SQLEndTran(SQL_HANDLE_DBC, lease.Get_Dbc(), SQL_COMMIT)))
+    {
+        DB_EXTRACT_ERROR(SQL_HANDLE_DBC, lease.Get_Dbc());
+        SQLEndTran(SQL_HANDLE_DBC, lease.Get_Dbc(), SQL_ROLLBACK);
+        ret = -1;
+    } // end else if
+
+    SQLFreeStmt(hupdate, SQL_CLOSE);
+    SQLFreeStmt(hupdate, SQL_RESET_PARAMS);
+    SQLSetStmtAttr(hupdate, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)1, 0);
+    DB_SET_CONN_ATTR(lease.Get_Dbc(), SQL_AUTOCOMMIT_ON);
+    return ret;
+} // end Execute
+
+
+
+//===============================================================================|
+/**
+ * @brief Folds a change into what's pending for a row; the status as Outranks
+ *  has it and the first message_id given
+ *
+ */
+void StatusWriter::Merge(Status_Update &into, const u32 status, const std::string_view msg_id)
+{
+    if (Outranks(status, into.status))
+        into.status = status;
+
+    if (into.msg_id.empty())
+        into.msg_id = msg_id;
+} // end Merge
+
+
+
+//===============================================================================|
+/**
+ * @brief Tells whether a status is to replace another filed for the same
+ *  message. The passing states only move forward, sent then submitted; the
+ *  final ones replace each other and everything passing, but are never
+ *  replaced by a passing one. A sender reporting a message sent may well be
+ *  beaten by the bind reporting it submitted, or even delivered. The UPDATE's
+ *  hold to the same against what's already in SmsOut; see SQL_OUTRANKS.
+ *
+ */
+bool StatusWriter::Outranks(const u32 status, const u32 over)
+{
+    const bool final_status = status == MSG_STATE_DELIVERED || status == MSG_STATE_FAILED || 
+        status == MSG_STATE_EXPIRED;
+    const bool final_over = over == MSG_STATE_DELIVERED || over == MSG_STATE_FAILED || 
+        over == MSG_STATE_EXPIRED;
+
+    return final_status || (!final_over && status >= over);
+} // end Outranks
@@ -0,0 +1,156 @@
+/**
+ * @file msg-template.cpp
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Implementation details for msg-template.h
+ * @version 0.1
+ * @date 2024-03-21
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "msg-template.h"
+
+
+
+
+
+//===============================================================================|
+//          CLASS IMP
+//===============================================================================|
+/**
+ * @brief Construct a new Msg Template:: Msg Template object
+ *
+ * @param names the placeholders, as they're written in the text; the first is
+ *  slot 0 and so on
+ */
+MsgTemplate::MsgTemplate(std::initializer_list<std::string_view> names)
+{
+    for (const std::string_view name : names)
+        this->names.emplace_back(name);
+} // end Constructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Splits the text into literals and slots; anything compiled before is
+ *  dropped, bindings included.
+ *
+ * @param text the template, e.g. bill_format
+ *
+ * @return int the number of placeholders found
+ */
+int MsgTemplate::Compile(const std::string_view text)
+{
+    tokens.clear();
+    this->text.clear();
+
+    int found{0};
+    size_t lit{0};      // where the literal at hand starts
+    size_t i{0};
+    while ( (i = text.find('$', i)) != std::string_view::npos)
+    {
+        int slot{TPL_NO_SLOT};
+        size_t len{0};
+        for (size_t s = 0; s < names.size(); s++)
+        {
+            if (names[s].size() > len && text.compare(i, names[s].size(), names[s]) == 0)
+            {
+                slot = (int)s;
+                len = names[s].size();
+            } // end if longer match
+        } // end for
+
+        if (slot == TPL_NO_SLOT)
+        {
+            i++;
+            continue;   // a $ of no interest
+        } // end if
+
+        Add_Literal(text.substr(lit, i - lit));
+        tokens.push_back({slot, 0, 0});
+        found++;
+        i += len;
+        lit = i;
+    } // end while
+
+    Add_Literal(text.substr(lit));
+    return found;
+} // end Compile
+
+
+
+//===============================================================================|
+/**
+ * @brief Fixes the value of a slot for every row to come; e.g. the period name.
+ *  Its occurrences become literals and merge with their neighbours.
+ *
+ * @param slot the placeholder
+ * @param value what it stands for
+ */
+void MsgTemplate::Bind(const int slot, const std::string_view value)
+{
+    std::vector<Token> old;
+    std::string old_text;
+    old.swap(tokens);
+    old_text.swap(text);
+
+    for (const Token &t : old)
+    {
+        if (t.slot == TPL_NO_SLOT)
+            Add_Literal(std::string_view(old_text).substr(t.off, t.len));
+        else if (t.slot == slot)
+            Add_Literal(value);
+        else
+            tokens.push_back(t);
+    } // end for
+} // end Bind
+
+
+
+//===============================================================================|
+/**
+ * @brief Renders a row into out in one go
+ *
+ * @param out cleared and filled with the message
+ * @param values a value for every slot, in the order of the names; those of
+ *  bound slots are never read
+ */
+void MsgTemplate::Render(std::string &out, const std::string_view *values) const
+{
+    out.clear();
+    for (const Token &t : tokens)
+    {
+        if (t.slot == TPL_NO_SLOT)
+            out.append(text, t.off, t.len);
+        else
+            out.append(values[t.slot]);
+    } // end for
+} // end Render
+
+
+
+//===============================================================================|
+/**
+ * @brief Appends a literal, merging it with the last token if that's also one
+ *
+ */
+void MsgTemplate::Add_Literal(const std::string_view s)
+{
+    if (s.empty())
+        return;
+
+    if (!tokens.empty() && tokens.back().slot == TPL_NO_SLOT)
+        tokens.back().len += (u32)s.size();
+    else
+        tokens.push_back({TPL_NO_SLOT, (u32)text.size(), (u32)s.size()});
+
+    text.append(s);
+} // end Add_Literal
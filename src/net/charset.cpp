@@ -0,0 +1,934 @@
+/**
+ * @file charset.cpp
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Implementation details for charset.h
+ * @version 0.1
+ * @date 2024-03-27
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "charset.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define CHARSET_X86             // SSE2 is a given; AVX2 is looked for at run time
+#endif
+
+
+
+
+
+//===============================================================================|
+//          DEFINES
+//===============================================================================|
+#define GSM_NONE            0xFF        // not in the alphabet
+#define GSM_EXT             0x80        // from the extension table; code in the low bits
+#define GSM_ESC             0x1B        // leads a character of the extension table
+#define GSM_MAP_SIZE        0x400       // code points looked up; the euro is the only one past
+#define EURO_SIGN           0x20AC
+#define EURO_GSM            0x65
+
+// the SSE2 scans finish off what the AVX2 ones leave; inlined there they're
+//  VEX encoded as well and don't pay for switching between the two
+#define INLINE_KERNEL       inline __attribute__((always_inline))
+
+
+
+
+
+//===============================================================================|
+//          TYPES
+//===============================================================================|
+typedef size_t (*Span_Fn)(const u8 *p, const size_t len);
+typedef void (*Widen_Fn)(const u8 *p, const size_t len, u8 *out);
+typedef size_t (*Narrow_Fn)(const u8 *p, const size_t units, u8 *out);
+
+
+/**
+ * @brief The scans in use. Each span returns how many bytes from p on are of
+ *  its kind: gsm, taken as they are by the alphabet, though some take two
+ *  septets; plain, the same byte in the alphabet as in ASCII; ascii, any byte
+ *  under 0x80. widen puts ASCII bytes out as UCS-2 and narrow the other way
+ *  round, for as long as the UCS-2 is ASCII, returning how many it did.
+ */
+typedef struct CHARSET_KERNELS
+{
+    Span_Fn gsm_span;
+    Span_Fn plain_span;
+    Span_Fn ascii_span;
+    Widen_Fn widen;
+    Narrow_Fn narrow;
+} Charset_Kernels;
+
+
+
+
+
+//===============================================================================|
+//          GLOBALS
+//===============================================================================|
+// the default alphabet (3GPP TS 23.038) by GSM code; the escape has no character
+static const u16 gsm_basic[128] = {
+    0x0040, 0x00A3, 0x0024, 0x00A5, 0x00E8, 0x00E9, 0x00F9, 0x00EC,
+    0x00F2, 0x00C7, 0x000A, 0x00D8, 0x00F8, 0x000D, 0x00C5, 0x00E5,
+    0x0394, 0x005F, 0x03A6, 0x0393, 0x039B, 0x03A9, 0x03A0, 0x03A8,
+    0x03A3, 0x0398, 0x039E, 0xFFFF, 0x00C6, 0x00E6, 0x00DF, 0x00C9,
+    0x0020, 0x0021, 0x0022, 0x0023, 0x00A4, 0x0025, 0x0026, 0x0027,
+    0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+    0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037,
+    0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+    0x00A1, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047,
+    0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+    0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057,
+    0x0058, 0x0059, 0x005A, 0x00C4, 0x00D6, 0x00D1, 0x00DC, 0x00A7,
+    0x00BF, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067,
+    0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+    0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077,
+    0x0078, 0x0079, 0x007A, 0x00E4, 0x00F6, 0x00F1, 0x00FC, 0x00E0
+};
+
+
+// the extension table, as GSM code and character pairs; the euro is handled
+//  apart from the map
+static const u16 gsm_ext[][2] = {
+    {0x0A, 0x000C}, {0x14, 0x005E}, {0x28, 0x007B}, {0x29, 0x007D}, {0x2F, 0x005C},
+    {0x3C, 0x005B}, {0x3D, 0x007E}, {0x3E, 0x005D}, {0x40, 0x007C}
+};
+
+
+
+/**
+ * @brief Builds the map from characters to their GSM codes; GSM_EXT set for
+ *  the ones from the extension table and GSM_NONE for the rest.
+ */
+static std::vector<u8> Build_Gsm_Map()
+{
+    std::vector<u8> map(GSM_MAP_SIZE, GSM_NONE);
+    for (u8 code = 0; code < 128; code++)
+    {
+        if (gsm_basic[code] < GSM_MAP_SIZE)
+            map[gsm_basic[code]] = code;
+    } // end for basic
+
+    for (const auto &ext : gsm_ext)
+        map[ext[1]] = (u8)(GSM_EXT | ext[0]);
+
+    return map;
+} // end Build_Gsm_Map
+
+
+static const std::vector<u8> gsm_map = Build_Gsm_Map();
+
+
+
+/**
+ * @brief The other way round for the extension table; 0 for the codes that
+ *  aren't in it.
+ */
+static std::vector<u16> Build_Ext_Map()
+{
+    std::vector<u16> map(128, 0);
+    for (const auto &ext : gsm_ext)
+        map[ext[0]] = ext[1];
+
+    map[EURO_GSM] = EURO_SIGN;
+    return map;
+} // end Build_Ext_Map
+
+
+static const std::vector<u16> gsm_ext_map = Build_Ext_Map();
+
+
+
+
+
+//===============================================================================|
+//          FUNCTIONS
+//===============================================================================|
+/**
+ * @brief The GSM code of a character; see Build_Gsm_Map
+ */
+static inline u8 Gsm_Code(const u32 c)
+{
+    if (c < GSM_MAP_SIZE)
+        return gsm_map[c];
+
+    return c == EURO_SIGN ? (u8)(GSM_EXT | EURO_GSM) : GSM_NONE;
+} // end Gsm_Code
+
+
+
+//===============================================================================|
+/**
+ * @brief Writes a character out in UTF-8
+ *
+ * @return u8* past what was written; 4 bytes at most
+ */
+static inline u8 *Put_Utf8(const u32 c, u8 *o)
+{
+    if (c < 0x80)
+        *o++ = (u8)c;
+    else if (c < 0x800)
+    {
+        *o++ = (u8)(0xC0 | (c >> 6));
+        *o++ = (u8)(0x80 | (c & 0x3F));
+    } // end else if 2 bytes
+    else if (c < 0x10000)
+    {
+        *o++ = (u8)(0xE0 | (c >> 12));
+        *o++ = (u8)(0x80 | ((c >> 6) & 0x3F));
+        *o++ = (u8)(0x80 | (c & 0x3F));
+    } // end else if 3 bytes
+    else
+    {
+        *o++ = (u8)(0xF0 | (c >> 18));
+        *o++ = (u8)(0x80 | ((c >> 12) & 0x3F));
+        *o++ = (u8)(0x80 | ((c >> 6) & 0x3F));
+        *o++ = (u8)(0x80 | (c & 0x3F));
+    } // end else 4 bytes
+
+    return o;
+} // end Put_Utf8
+
+
+
+//===============================================================================|
+/**
+ * @brief Reads a character off UTF-8 text. A sequence that's cut short, over
+ *  long, a surrogate or past U+10FFFF comes back as U+FFFD, having consumed
+ *  the bytes up to where it went wrong.
+ *
+ * @param p the text; moved past the character
+ * @param end one past the end of the text
+ *
+ * @return u32 the code point
+ */
+static u32 Decode_Utf8(const u8 *&p, const u8 *end)
+{
+    u32 c = *p++;
+    if (c < 0x80)
+        return c;
+
+    int n;
+    u32 min;
+    if ((c & 0xE0) == 0xC0)
+    {
+        n = 1;
+        c &= 0x1F;
+        min = 0x80;
+    } // end if 2 bytes
+    else if ((c & 0xF0) == 0xE0)
+    {
+        n = 2;
+        c &= 0x0F;
+        min = 0x800;
+    } // end else if 3 bytes
+    else if ((c & 0xF8) == 0xF0)
+    {
+        n = 3;
+        c &= 0x07;
+        min = 0x10000;
+    } // end else if 4 bytes
+    else
+        return UCS2_REPLACEMENT;
+
+    for (int i = 0; i < n; i++, p++)
+    {
+        if (p == end || (*p & 0xC0) != 0x80)
+            return UCS2_REPLACEMENT;
+
+        c = (c << 6) | (*p & 0x3F);
+    } // end for
+
+    if (c < min || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+        return UCS2_REPLACEMENT;
+
+    return c;
+} // end Decode_Utf8
+
+
+
+//===============================================================================|
+//          SCALAR KERNELS
+//===============================================================================|
+static size_t Gsm_Span_Scalar(const u8 *p, const size_t len)
+{
+    size_t i{0};
+    while (i < len && p[i] >= 0x20 && p[i] < 0x7F && p[i] != 0x60)
+        i++;
+
+    return i;
+} // end Gsm_Span_Scalar
+
+
+static size_t Plain_Span_Scalar(const u8 *p, const size_t len)
+{
+    size_t i{0};
+    while (i < len && p[i] < 0x80 && gsm_map[p[i]] == p[i])
+        i++;
+
+    return i;
+} // end Plain_Span_Scalar
+
+
+static size_t Ascii_Span_Scalar(const u8 *p, const size_t len)
+{
+    size_t i{0};
+    while (i < len && p[i] < 0x80)
+        i++;
+
+    return i;
+} // end Ascii_Span_Scalar
+
+
+static void Widen_Scalar(const u8 *p, const size_t len, u8 *out)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        out[2 * i] = 0;
+        out[2 * i + 1] = p[i];
+    } // end for
+} // end Widen_Scalar
+
+
+static size_t Narrow_Scalar(const u8 *p, const size_t units, u8 *out)
+{
+    size_t i{0};
+    while (i < units && p[2 * i] == 0 && p[2 * i + 1] < 0x80)
+    {
+        out[i] = p[2 * i + 1];
+        i++;
+    } // end while
+
+    return i;
+} // end Narrow_Scalar
+
+
+
+#ifdef CHARSET_X86
+//===============================================================================|
+//          SSE2 KERNELS
+//===============================================================================|
+/**
+ * @brief The SIMD kernels work on the bytes as signed; so everything from 0x80
+ *  up is negative and falls short of every lower bound used here.
+ */
+static inline __m128i In_Range_SSE2(const __m128i v, const char lo, const char hi)
+{
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)),
+        _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+} // end In_Range_SSE2
+
+
+static INLINE_KERNEL size_t Gsm_Span_SSE2(const u8 *p, const size_t len)
+{
+    size_t i{0};
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i ok = _mm_andnot_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(0x60)),
+            In_Range_SSE2(v, 0x20, 0x7E));
+
+        u32 bad = ~(u32)_mm_movemask_epi8(ok) & 0xFFFF;
+        if (bad)
+            return i + __builtin_ctz(bad);
+    } // end for
+
+    return i + Gsm_Span_Scalar(p + i, len - i);
+} // end Gsm_Span_SSE2
+
+
+static INLINE_KERNEL size_t Plain_Span_SSE2(const u8 *p, const size_t len)
+{
+    size_t i{0};
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i ok = _mm_or_si128(
+            _mm_or_si128(In_Range_SSE2(v, 0x20, 0x23), In_Range_SSE2(v, 0x25, 0x3F)),
+            _mm_or_si128(In_Range_SSE2(v, 0x41, 0x5A), In_Range_SSE2(v, 0x61, 0x7A)));
+
+        u32 bad = ~(u32)_mm_movemask_epi8(ok) & 0xFFFF;
+        if (bad)
+            return i + __builtin_ctz(bad);
+    } // end for
+
+    return i + Plain_Span_Scalar(p + i, len - i);
+} // end Plain_Span_SSE2
+
+
+static INLINE_KERNEL size_t Ascii_Span_SSE2(const u8 *p, const size_t len)
+{
+    size_t i{0};
+    for (; i + 16 <= len; i += 16)
+    {
+        u32 bad = (u32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(p + i)));
+        if (bad)
+            return i + __builtin_ctz(bad);
+    } // end for
+
+    return i + Ascii_Span_Scalar(p + i, len - i);
+} // end Ascii_Span_SSE2
+
+
+static void Widen_SSE2(const u8 *p, const size_t len, u8 *out)
+{
+    size_t i{0};
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        _mm_storeu_si128((__m128i *)(out + 2 * i), _mm_unpacklo_epi8(zero, v));
+        _mm_storeu_si128((__m128i *)(out + 2 * i + 16), _mm_unpackhi_epi8(zero, v));
+    } // end for
+
+    Widen_Scalar(p + i, len - i, out + 2 * i);
+} // end Widen_SSE2
+
+
+static size_t Narrow_SSE2(const u8 *p, const size_t units, u8 *out)
+{
+    size_t i{0};
+
+    // big endian; the high bytes come first and must be 0, the low under 0x80
+    const __m128i not_ascii = _mm_set1_epi16((short)0x80FF);
+    for (; i + 8 <= units; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + 2 * i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(v, not_ascii),
+            _mm_setzero_si128())) != 0xFFFF)
+            break;
+
+        __m128i lows = _mm_srli_epi16(v, 8);
+        _mm_storel_epi64((__m128i *)(out + i), _mm_packus_epi16(lows, lows));
+    } // end for
+
+    return i + Narrow_Scalar(p + 2 * i, units - i, out + i);
+} // end Narrow_SSE2
+
+
+
+//===============================================================================|
+//          AVX2 KERNELS
+//===============================================================================|
+__attribute__((target("avx2")))
+static inline __m256i In_Range_AVX2(const __m256i v, const char lo, const char hi)
+{
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+} // end In_Range_AVX2
+
+
+__attribute__((target("avx2")))
+static size_t Gsm_Span_AVX2(const u8 *p, const size_t len)
+{
+    size_t i{0};
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i ok = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x60)),
+            In_Range_AVX2(v, 0x20, 0x7E));
+
+        u32 bad = ~(u32)_mm256_movemask_epi8(ok);
+        if (bad)
+            return i + __builtin_ctz(bad);
+    } // end for
+
+    return i + Gsm_Span_SSE2(p + i, len - i);
+} // end Gsm_Span_AVX2
+
+
+__attribute__((target("avx2")))
+static size_t Plain_Span_AVX2(const u8 *p, const size_t len)
+{
+    size_t i{0};
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i ok = _mm256_or_si256(
+            _mm256_or_si256(In_Range_AVX2(v, 0x20, 0x23), In_Range_AVX2(v, 0x25, 0x3F)),
+            _mm256_or_si256(In_Range_AVX2(v, 0x41, 0x5A), In_Range_AVX2(v, 0x61, 0x7A)));
+
+        u32 bad = ~(u32)_mm256_movemask_epi8(ok);
+        if (bad)
+            return i + __builtin_ctz(bad);
+    } // end for
+
+    return i + Plain_Span_SSE2(p + i, len - i);
+} // end Plain_Span_AVX2
+
+
+__attribute__((target("avx2")))
+static size_t Ascii_Span_AVX2(const u8 *p, const size_t len)
+{
+    size_t i{0};
+    for (; i + 32 <= len; i += 32)
+    {
+        u32 bad = (u32)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *)(p + i)));
+        if (bad)
+            return i + __builtin_ctz(bad);
+    } // end for
+
+    return i + Ascii_Span_SSE2(p + i, len - i);
+} // end Ascii_Span_AVX2
+#endif
+
+
+
+//===============================================================================|
+//          DISPATCH
+//===============================================================================|
+/**
+ * @brief The best the cpu we're on can do
+ */
+static u8 Cpu_Level()
+{
+#ifdef CHARSET_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? CHARSET_AVX2 : CHARSET_SSE2;
+#else
+    return CHARSET_SCALAR;
+#endif
+} // end Cpu_Level
+
+
+static Charset_Kernels Pick_Kernels(const u8 level)
+{
+#ifdef CHARSET_X86
+    if (level == CHARSET_AVX2)
+        return {Gsm_Span_AVX2, Plain_Span_AVX2, Ascii_Span_AVX2, Widen_SSE2, Narrow_SSE2};
+
+    if (level == CHARSET_SSE2)
+        return {Gsm_Span_SSE2, Plain_Span_SSE2, Ascii_Span_SSE2, Widen_SSE2, Narrow_SSE2};
+#endif
+
+    return {Gsm_Span_Scalar, Plain_Span_Scalar, Ascii_Span_Scalar, Widen_Scalar, Narrow_Scalar};
+} // end Pick_Kernels
+
+
+static u8 charset_level = Cpu_Level();
+static Charset_Kernels kernels = Pick_Kernels(charset_level);
+
+
+
+//===============================================================================|
+/**
+ * @brief Holds the scans to an instruction set; for the benchmarks to compare
+ *  them, or to rule one out. Not to be called while text is being converted.
+ *
+ * @param level one of CHARSET_*; more than the cpu has gets what it has
+ *
+ * @return u8 the level now in use
+ */
+u8 Set_Charset_Level(const u8 level)
+{
+    u8 best = Cpu_Level();
+    charset_level = level > best ? best : level;
+    kernels = Pick_Kernels(charset_level);
+    return charset_level;
+} // end Set_Charset_Level
+
+
+
+//===============================================================================|
+u8 Get_Charset_Level()
+{
+    return charset_level;
+} // end Get_Charset_Level
+
+
+
+//===============================================================================|
+//          CONVERSIONS
+//===============================================================================|
+/**
+ * @brief Tells whether every character of the text is in the GSM default
+ *  alphabet or its extension table; broken UTF-8 is not.
+ *
+ * @param utf8 the text
+ *
+ * @return true when it can go as GSM 7-bit
+ */
+bool Is_GSM7(const std::string_view utf8)
+{
+    const u8 *p = (const u8 *)utf8.data();
+    const u8 *end = p + utf8.size();
+    while (p < end)
+    {
+        if (*p < 0x80)
+            p += kernels.gsm_span(p, end - p);
+
+        if (p < end && Gsm_Code(Decode_Utf8(p, end)) == GSM_NONE)
+            return false;
+    } // end while
+
+    return true;
+} // end Is_GSM7
+
+
+
+//===============================================================================|
+/**
+ * @brief Converts text to GSM 7-bit, a septet to an octet; unpacked, as SMPP
+ *  has it in short_message under the default data_coding. The characters of
+ *  the extension table take two, the escape and their code.
+ *
+ * @param utf8 the text
+ * @param out where the septets go
+ * @param cap room in out; twice the text's length always does
+ *
+ * @return int the number of septets alas -1 when a character isn't in the
+ *  alphabet or out is too small
+ */
+int Utf8_To_Gsm7(const std::string_view utf8, char *out, const size_t cap)
+{
+    const u8 *p = (const u8 *)utf8.data();
+    const u8 *end = p + utf8.size();
+    size_t pos{0};
+    while (p < end)
+    {
+        size_t n = *p < 0x80 ? kernels.plain_span(p, end - p) : 0;
+        if (pos + n > cap)
+            return -1;
+
+        iCpy(out + pos, p, n);
+        pos += n;
+        p += n;
+        if (p == end)
+            break;
+
+        u8 code = Gsm_Code(Decode_Utf8(p, end));
+        if (code == GSM_NONE || pos + 1 + (code >> 7) > cap)
+            return -1;
+
+        if (code & GSM_EXT)
+            out[pos++] = GSM_ESC;
+
+        out[pos++] = (char)(code & 0x7F);
+    } // end while
+
+    return (int)pos;
+} // end Utf8_To_Gsm7
+
+
+
+//===============================================================================|
+/**
+ * @brief Packs septets eight to seven octets, as they go over the air. When
+ *  the last octet is left with seven spare bits they're zero, which reads as
+ *  an '@'; 23.038 has those who mind pad with a CR.
+ *
+ * @param septets one per octet, as Utf8_To_Gsm7 gives them
+ * @param count how many
+ * @param out where the octets go
+ * @param cap room in out
+ *
+ * @return int the number of octets alas -1 when out is too small
+ */
+int Pack_Gsm7(const char *septets, const size_t count, char *out, const size_t cap)
+{
+    if ((count * 7 + 7) / 8 > cap)
+        return -1;
+
+    u32 bits{0};
+    int have{0};
+    size_t pos{0};
+    for (size_t i = 0; i < count; i++)
+    {
+        bits |= (u32)(septets[i] & 0x7F) << have;
+        have += 7;
+        if (have >= 8)
+        {
+            out[pos++] = (char)bits;
+            bits >>= 8;
+            have -= 8;
+        } // end if a full octet
+    } // end for
+
+    if (have > 0)
+        out[pos++] = (char)bits;
+
+    return (int)pos;
+} // end Pack_Gsm7
+
+
+
+//===============================================================================|
+/**
+ * @brief Converts text to UCS-2, big endian as SMPP wants it. Characters past
+ *  the BMP go as UTF-16 surrogate pairs, which is what handsets make of them;
+ *  broken UTF-8 comes out as U+FFFD.
+ *
+ * @param utf8 the text
+ * @param out where the UCS-2 goes
+ * @param cap room in out; twice the text's length always does
+ *
+ * @return int the number of octets alas -1 when out is too small
+ */
+int Utf8_To_Ucs2(const std::string_view utf8, char *out, const size_t cap)
+{
+    const u8 *p = (const u8 *)utf8.data();
+    const u8 *end = p + utf8.size();
+    u8 *o = (u8 *)out;
+    size_t pos{0};
+    while (p < end)
+    {
+        size_t n = *p < 0x80 ? kernels.ascii_span(p, end - p) : 0;
+        if (pos + 2 * n > cap)
+            return -1;
+
+        kernels.widen(p, n, o + pos);
+        pos += 2 * n;
+        p += n;
+        if (p == end)
+            break;
+
+        u32 c = Decode_Utf8(p, end);
+        if (pos + (c > 0xFFFF ? 4 : 2) > cap)
+            return -1;
+
+        if (c > 0xFFFF)
+        {
+            c -= 0x10000;
+            u16 high = (u16)(0xD800 | (c >> 10)), low = (u16)(0xDC00 | (c & 0x3FF));
+            o[pos++] = (u8)(high >> 8);
+            o[pos++] = (u8)high;
+            o[pos++] = (u8)(low >> 8);
+            o[pos++] = (u8)low;
+        } // end if a surrogate pair
+        else
+        {
+            o[pos++] = (u8)(c >> 8);
+            o[pos++] = (u8)c;
+        } // end else
+    } // end while
+
+    return (int)pos;
+} // end Utf8_To_Ucs2
+
+
+
+//===============================================================================|
+/**
+ * @brief Appends GSM 7-bit text, unpacked as SMPP carries it, in UTF-8. An
+ *  escape with a code not in the extension table stands for the code's
+ *  character in the default alphabet, as 23.038 has it, and a double escape
+ *  for a space.
+ *
+ * @param septets the text; a septet an octet, the top bits ignored
+ * @param out where the UTF-8 is appended
+ */
+void Gsm7_To_Utf8(const std::string_view septets, std::string &out)
+{
+    const u8 *p = (const u8 *)septets.data();
+    const u8 *end = p + septets.size();
+    size_t start = out.size();
+    out.resize(start + 2 * septets.size());     // none takes more than 2 a septet
+    u8 *o = (u8 *)&out[start];
+
+    while (p < end)
+    {
+        if (*p < 0x80)
+        {
+            size_t n = kernels.plain_span(p, end - p);
+            iCpy(o, p, n);
+            o += n;
+            p += n;
+            if (p == end)
+                break;
+        } // end if
+
+        u8 code = *p++ & 0x7F;
+        u32 c = gsm_basic[code];
+        if (code == GSM_ESC)
+        {
+            if (p == end)
+                break;
+
+            code = *p++ & 0x7F;
+            c = gsm_ext_map[code] ? gsm_ext_map[code] : gsm_basic[code];
+            if (c == 0xFFFF)
+                c = ' ';
+        } // end if extension
+
+        o = Put_Utf8(c, o);
+    } // end while
+
+    out.resize(o - (u8 *)out.data());
+} // end Gsm7_To_Utf8
+
+
+
+//===============================================================================|
+/**
+ * @brief Appends UCS-2, big endian, in UTF-8; surrogate pairs are taken as
+ *  UTF-16 and any surrogate left on its own comes out as U+FFFD. An odd last
+ *  octet is dropped.
+ *
+ * @param ucs2 the text
+ * @param out where the UTF-8 is appended
+ */
+void Ucs2_To_Utf8(const std::string_view ucs2, std::string &out)
+{
+    const u8 *p = (const u8 *)ucs2.data();
+    size_t units = ucs2.size() / 2;
+    size_t start = out.size();
+    out.resize(start + 3 * units);      // 3 a unit at most; a pair of them takes 4
+    u8 *o = (u8 *)&out[start];
+
+    size_t i{0};
+    while (i < units)
+    {
+        size_t n = kernels.narrow(p + 2 * i, units - i, o);
+        o += n;
+        i += n;
+        if (i == units)
+            break;
+
+        u32 c = (p[2 * i] << 8) | p[2 * i + 1];
+        i++;
+        if (c >= 0xD800 && c <= 0xDFFF)
+        {
+            u32 low = i < units ? (u32)((p[2 * i] << 8) | p[2 * i + 1]) : 0;
+            if (c <= 0xDBFF && low >= 0xDC00 && low <= 0xDFFF)
+            {
+                c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                i++;
+            } // end if a pair
+            else
+                c = UCS2_REPLACEMENT;
+        } // end if a surrogate
+
+        o = Put_Utf8(c, o);
+    } // end while
+
+    out.resize(o - (u8 *)out.data());
+} // end Ucs2_To_Utf8
+
+
+
+//===============================================================================|
+/**
+ * @brief Appends Latin-1 in UTF-8; also what's made of IA5 and of octets
+ *  whose character set isn't known.
+ *
+ * @param latin1 the text
+ * @param out where the UTF-8 is appended
+ */
+void Latin1_To_Utf8(const std::string_view latin1, std::string &out)
+{
+    const u8 *p = (const u8 *)latin1.data();
+    const u8 *end = p + latin1.size();
+    size_t start = out.size();
+    out.resize(start + 2 * latin1.size());
+    u8 *o = (u8 *)&out[start];
+
+    while (p < end)
+    {
+        size_t n = kernels.ascii_span(p, end - p);
+        iCpy(o, p, n);
+        o += n;
+        p += n;
+        if (p < end)
+            o = Put_Utf8(*p++, o);
+    } // end while
+
+    out.resize(o - (u8 *)out.data());
+} // end Latin1_To_Utf8
+
+
+
+//===============================================================================|
+/**
+ * @brief Appends text received under data_coding in UTF-8. The values up to
+ *  0x0F are as SMPP has them; past that they're the GSM coding groups of
+ *  23.038, of which only the alphabet bits matter here. Binary and the
+ *  character sets we don't have are taken as Latin-1, so at least nothing
+ *  gets lost.
+ *
+ * @param body the text, sans any UDH
+ * @param data_coding as it came
+ * @param out where the UTF-8 is appended
+ */
+void Decode_Text(const std::string_view body, const u8 data_coding, std::string &out)
+{
+    u8 alphabet;
+    if (data_coding < 0x10)
+        alphabet = data_coding == DATA_CODE_DEFAULT || data_coding == DATA_CODE_UCS2 ? 
+            data_coding : DATA_CODE_LATIN1;
+    else
+    {
+        // 0 the default alphabet, 1 8-bit, 2 UCS-2 and 3 reserved
+        u8 group;
+        if (data_coding < 0x80)
+            group = (data_coding >> 2) & 0x03;      // general and auto deletion groups
+        else if (data_coding < 0xC0)
+            group = 3;
+        else if (data_coding < 0xE0)
+            group = 0;                              // message waiting
+        else if (data_coding < 0xF0)
+            group = 2;                              // message waiting, UCS-2
+        else
+            group = (data_coding >> 2) & 0x01;      // message class
+
+        alphabet = group == 0 ? DATA_CODE_DEFAULT : group == 2 ? DATA_CODE_UCS2 : DATA_CODE_LATIN1;
+    } // end else a coding group
+
+    if (alphabet == DATA_CODE_DEFAULT)
+        Gsm7_To_Utf8(body, out);
+    else if (alphabet == DATA_CODE_UCS2)
+        Ucs2_To_Utf8(body, out);
+    else
+        Latin1_To_Utf8(body, out);
+} // end Decode_Text
+
+
+
+//===============================================================================|
+/**
+ * @brief The data_coding text should go with; the default alphabet when it
+ *  can, alas UCS-2.
+ *
+ * @param utf8 the text
+ *
+ * @return u8 DATA_CODE_DEFAULT or DATA_CODE_UCS2
+ */
+u8 Select_Coding(const std::string_view utf8)
+{
+    return Is_GSM7(utf8) ? DATA_CODE_DEFAULT : DATA_CODE_UCS2;
+} // end Select_Coding
+
+
+
+//===============================================================================|
+/**
+ * @brief Converts text to what it should go as in one pass: GSM 7-bit,
+ *  unpacked, should it all be in the alphabet, alas UCS-2.
+ *
+ * @param utf8 the text
+ * @param out gets the converted text; its buffer is reused
+ *
+ * @return u8 the data_coding it's in; DATA_CODE_DEFAULT or DATA_CODE_UCS2
+ */
+u8 Encode_Text(const std::string_view utf8, std::string &out)
+{
+    out.resize(utf8.size() * 2);
+
+    int len;
+    if ( (len = Utf8_To_Gsm7(utf8, &out[0], out.size())) >= 0)
+    {
+        out.resize(len);
+        return DATA_CODE_DEFAULT;
+    } // end if gsm
+
+    out.resize(Utf8_To_Ucs2(utf8, &out[0], out.size()));
+    return DATA_CODE_UCS2;
+} // end Encode_Text
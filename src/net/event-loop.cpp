@@ -0,0 +1,258 @@
+/**
+ * @file event-loop.cpp
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Implementation details for event-loop.h
+ * @version 0.1
+ * @date 2024-03-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "event-loop.h"
+
+
+
+
+
+//===============================================================================|
+//          CLASS IMP
+//===============================================================================|
+/**
+ * @brief Construct a new Event Loop:: Event Loop object Creates the epoll
+ *  instance; throws when the kernel won't give us one as there is no running
+ *  without it.
+ *
+ * @param max_events the most events to reap at each call to Run_Once
+ */
+EventLoop::EventLoop(const int max_events)
+    :epfd{epoll_create1(EPOLL_CLOEXEC)}, count{0},
+     events(max_events > 0 ? max_events : EVENT_MAX_EVENTS)
+{
+    if (epfd < 0)
+        throw std::runtime_error("epoll_create1 failed.");
+} // end Constructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Destroy the Event Loop:: Event Loop object The handlers are not owned
+ *  by the loop and are left alone.
+ *
+ */
+EventLoop::~EventLoop()
+{
+    if (epfd >= 0)
+        CLOSE(epfd);
+} // end Destructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Starts watching the handler's descriptor.
+ *
+ * @param phandler the handler to notify; must outlive its registration
+ * @param events the epoll interest set; see EVENT_* for the usual ones
+ *
+ * @return int 0 on success alas -1 with errno set
+ */
+int EventLoop::Add(EventHandler *phandler, const u32 events)
+{
+    epoll_event ev;
+    iZero(&ev, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = phandler;
+
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, phandler->Get_Fd(), &ev) < 0)
+        return -1;
+
+    ++count;
+    return 0;
+} // end Add
+
+
+
+//===============================================================================|
+/**
+ * @brief Changes the interest set of a handler already in the loop; e.g. to
+ *  start or stop watching for EPOLLOUT.
+ *
+ * @param phandler the handler
+ * @param events the new interest set
+ *
+ * @return int 0 on success alas -1 with errno set
+ */
+int EventLoop::Modify(EventHandler *phandler, const u32 events)
+{
+    epoll_event ev;
+    iZero(&ev, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = phandler;
+
+    return epoll_ctl(epfd, EPOLL_CTL_MOD, phandler->Get_Fd(), &ev);
+} // end Modify
+
+
+
+//===============================================================================|
+/**
+ * @brief Stops watching the handler's descriptor. This must be done before the
+ *  descriptor is closed.
+ *
+ * @param phandler the handler
+ *
+ * @return int 0 on success alas -1 with errno set
+ */
+int EventLoop::Remove(EventHandler *phandler)
+{
+    // a descriptor that's already closed has left the epoll set on its own
+    if (epoll_ctl(epfd, EPOLL_CTL_DEL, phandler->Get_Fd(), NULL) < 0 && errno != EBADF)
+        return -1;
+
+    --count;
+    return 0;
+} // end Remove
+
+
+
+//===============================================================================|
+/**
+ * @brief Waits up to timeout_ms for events and hands each one to the handler
+ *  riding on it.
+ *
+ * @param timeout_ms how long to wait in milli-seconds; -1 is forever
+ *
+ * @return int the number of events handled, 0 on timeout or interruption, -1
+ *  for an error from epoll.
+ */
+int EventLoop::Run_Once(const int timeout_ms)
+{
+    int n;
+    if ( (n = epoll_wait(epfd, events.data(), (int)events.size(), timeout_ms)) < 0)
+        return errno == EINTR ? 0 : -1;
+
+    for (int i = 0; i < n; i++)
+    {
+        EventHandler *phandler = static_cast<EventHandler *>(events[i].data.ptr);
+        if (phandler->Handle_Event(events[i].events) < 0)
+        {
+            Remove(phandler);
+            phandler->Handle_Close();
+        } // end if done with
+    } // end for
+
+    return n;
+} // end Run_Once
+
+
+
+//===============================================================================|
+/**
+ * @brief Returns the number of handlers being watched
+ *
+ * @return size_t count of handlers
+ */
+size_t EventLoop::Get_Count() const
+{
+    return count;
+} // end Get_Count
+
+
+
+
+//===============================================================================|
+/**
+ * @brief Construct a new Event Notifier:: Event Notifier object
+ *
+ */
+EventNotifier::EventNotifier()
+    :efd{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)}
+{
+    if (efd < 0)
+        throw std::runtime_error("eventfd failed.");
+} // end Constructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Destroy the Event Notifier:: Event Notifier object
+ *
+ */
+EventNotifier::~EventNotifier()
+{
+    CLOSE(efd);
+} // end Destructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Returns the eventfd
+ *
+ * @return int the descriptor
+ */
+int EventNotifier::Get_Fd() const
+{
+    return efd;
+} // end Get_Fd
+
+
+
+//===============================================================================|
+/**
+ * @brief Resets the counter so the next Notify makes a fresh edge.
+ *
+ * @param events the epoll events reported
+ *
+ * @return int 0 always
+ */
+int EventNotifier::Handle_Event(const u32 events)
+{
+    eventfd_t value;
+    eventfd_read(efd, &value);
+    return 0;
+} // end Handle_Event
+
+
+
+//===============================================================================|
+/**
+ * @brief Wakes the loop watching this notifier; safe from any thread.
+ *
+ */
+void EventNotifier::Notify()
+{
+    eventfd_write(efd, 1);
+} // end Notify
+
+
+
+
+//===============================================================================|
+//          FUNCTIONS
+//===============================================================================|
+/**
+ * @brief Puts the descriptor in non-blocking mode; a must for anything handed
+ *  to an edge triggered loop.
+ *
+ * @param fd the descriptor
+ *
+ * @return int 0 on success alas -1
+ */
+int Set_Non_Blocking(const int fd)
+{
+    int flags;
+    if ( (flags = fcntl(fd, F_GETFL, 0)) < 0)
+        return -1;
+
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+} // end Set_Non_Blocking
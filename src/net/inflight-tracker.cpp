@@ -0,0 +1,353 @@
+/**
+ * @file inflight-tracker.cpp
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Implementation details for inflight-tracker.h
+ * @version 0.1
+ * @date 2024-03-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "inflight-tracker.h"
+
+
+
+
+
+//===============================================================================|
+//          FUNCTIONS
+//===============================================================================|
+/**
+ * @brief Scatters sequence #'s over the index; they come in order and would
+ *  otherwise pile up in neighbouring buckets whenever they wrap the mask.
+ */
+static inline u32 Hash_Seq(const u32 seq)
+{
+    u32 h = seq * 0x9E3779B1;
+    return h ^ (h >> 16);
+} // end Hash_Seq
+
+
+
+/**
+ * @brief FNV-1a over the message_id
+ */
+static inline u32 Hash_Id(const std::string_view id)
+{
+    u32 h = 2166136261;
+    for (const char c : id)
+    {
+        h ^= (u8)c;
+        h *= 16777619;
+    } // end for
+
+    return h;
+} // end Hash_Id
+
+
+
+
+
+//===============================================================================|
+//          CLASS IMP
+//===============================================================================|
+/**
+ * @brief Construct a new Inflight Tracker:: Inflight Tracker object
+ *
+ * @param capacity records to make room for up front; rounded up to a power of 2
+ */
+InflightTracker::InflightTracker(const size_t capacity)
+    :count{0}
+{
+    size_t cap{2};
+    while (cap < capacity)
+        cap <<= 1;
+
+    slab.reserve(cap);
+    by_seq.assign(cap << 1, INFLIGHT_NPOS);
+    by_id.assign(cap << 1, INFLIGHT_NPOS);
+    mask = (u32)(cap << 1) - 1;
+} // end Constructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Starts tracking a message sent with sequence # seq. Should seq still be
+ *  on record, which takes a wrap of the sequence, the caller is to settle the
+ *  stale record first; see Find_Seq.
+ *
+ * @param seq the sequence # of the submit
+ * @param info the message
+ *
+ * @return u32 the slot of the record alas INFLIGHT_NPOS when the tracker is full
+ *  or seq is still on record
+ */
+u32 InflightTracker::Add(const u32 seq, Single_Sms_Info &&info)
+{
+    u32 slot;
+    if (count >= INFLIGHT_MAX_SIZE || Find_Seq(seq) != INFLIGHT_NPOS)
+        return INFLIGHT_NPOS;
+
+    if ((count + 1) << 1 > (size_t)mask + 1)
+        Grow_Index();
+
+    if (!free_list.empty())
+    {
+        slot = free_list.back();
+        free_list.pop_back();
+    } // end if reusing
+    else
+    {
+        slot = (u32)slab.size();
+        slab.emplace_back();
+    } // end else
+
+    Slot &s = slab[slot];
+    s.seq = seq;
+    s.used = true;
+    s.has_id = false;
+    s.info = std::move(info);
+    ++count;
+
+    Index_Insert(by_seq, Hash_Seq(seq), slot);
+    return slot;
+} // end Add
+
+
+
+//===============================================================================|
+/**
+ * @brief Stops tracking the message at slot and frees whatever it held.
+ *
+ * @param slot as returned from Add or the Find's
+ */
+void InflightTracker::Remove(const u32 slot)
+{
+    Slot &s = slab[slot];
+    if (!s.used)
+        return;
+
+    Index_Erase(by_seq, slot, false);
+    if (s.has_id)
+        Index_Erase(by_id, slot, true);
+
+    s.info = Single_Sms_Info{};
+    s.used = s.has_id = false;
+    free_list.push_back(slot);
+    --count;
+} // end Remove
+
+
+
+//===============================================================================|
+/**
+ * @brief Forgets every message; used when the bind is lost.
+ *
+ */
+void InflightTracker::Clear()
+{
+    slab.clear();
+    free_list.clear();
+    std::fill(by_seq.begin(), by_seq.end(), INFLIGHT_NPOS);
+    std::fill(by_id.begin(), by_id.end(), INFLIGHT_NPOS);
+    count = 0;
+} // end Clear
+
+
+
+//===============================================================================|
+/**
+ * @brief Looks up a message by the sequence # it was last submitted with
+ *
+ * @param seq the sequence #
+ *
+ * @return u32 the slot alas INFLIGHT_NPOS
+ */
+u32 InflightTracker::Find_Seq(const u32 seq) const
+{
+    for (u32 i = Hash_Seq(seq) & mask; by_seq[i] != INFLIGHT_NPOS; i = (i + 1) & mask)
+    {
+        if (slab[by_seq[i]].seq == seq)
+            return by_seq[i];
+    } // end for
+
+    return INFLIGHT_NPOS;
+} // end Find_Seq
+
+
+
+//===============================================================================|
+/**
+ * @brief Looks up a message by the id SMSC has given it
+ *
+ * @param id the message_id
+ *
+ * @return u32 the slot alas INFLIGHT_NPOS
+ */
+u32 InflightTracker::Find_Id(const std::string_view id) const
+{
+    const u32 h = Hash_Id(id);
+    for (u32 i = h & mask; by_id[i] != INFLIGHT_NPOS; i = (i + 1) & mask)
+    {
+        const Slot &s = slab[by_id[i]];
+        if (s.id_hash == h && s.info.id == id)
+            return by_id[i];
+    } // end for
+
+    return INFLIGHT_NPOS;
+} // end Find_Id
+
+
+
+//===============================================================================|
+/**
+ * @brief Records the id SMSC gave the message at slot and indexes it by that.
+ *  An older record with the same id can only be stale, but it's the caller's
+ *  to settle; nothing is done till it's gone.
+ *
+ * @param slot the message
+ * @param id its message_id
+ *
+ * @return u32 INFLIGHT_NPOS once done, alas the slot of the older record
+ */
+u32 InflightTracker::Set_Id(const u32 slot, const std::string_view id)
+{
+    u32 old;
+    if ( (old = Find_Id(id)) != INFLIGHT_NPOS && old != slot)
+        return old;
+
+    Slot &s = slab[slot];
+    if (s.has_id)
+        Index_Erase(by_id, slot, true);
+
+    s.info.id = id;
+    s.id_hash = Hash_Id(id);
+    s.has_id = true;
+    Index_Insert(by_id, s.id_hash, slot);
+    return INFLIGHT_NPOS;
+} // end Set_Id
+
+
+
+//===============================================================================|
+/**
+ * @brief Files the message at slot under a new sequence #; e.g. that of a
+ *  query_sm sent about it, so the response finds its way back here. As with
+ *  Set_Id, a stale record still under seq is the caller's to settle first.
+ *
+ * @param slot the message
+ * @param seq the new sequence #
+ *
+ * @return u32 INFLIGHT_NPOS once done, alas the slot of the stale record
+ */
+u32 InflightTracker::Set_Seq(const u32 slot, const u32 seq)
+{
+    u32 old;
+    if ( (old = Find_Seq(seq)) != INFLIGHT_NPOS && old != slot)
+        return old;
+
+    Index_Erase(by_seq, slot, false);
+    slab[slot].seq = seq;
+    Index_Insert(by_seq, Hash_Seq(seq), slot);
+    return INFLIGHT_NPOS;
+} // end Set_Seq
+
+
+
+//===============================================================================|
+/**
+ * @brief Doubles both indexes and puts every record back in.
+ *
+ */
+void InflightTracker::Grow_Index()
+{
+    const size_t size = ((size_t)mask + 1) << 1;
+    mask = (u32)size - 1;
+    by_seq.assign(size, INFLIGHT_NPOS);
+    by_id.assign(size, INFLIGHT_NPOS);
+
+    for (u32 i = 0; i < (u32)slab.size(); i++)
+    {
+        if (!slab[i].used)
+            continue;
+
+        Index_Insert(by_seq, Hash_Seq(slab[i].seq), i);
+        if (slab[i].has_id)
+            Index_Insert(by_id, slab[i].id_hash, i);
+    } // end for
+} // end Grow_Index
+
+
+
+//===============================================================================|
+/**
+ * @brief Puts slot in the first free bucket from hash on
+ *
+ */
+void InflightTracker::Index_Insert(std::vector<u32> &index, const u32 hash, const u32 slot)
+{
+    u32 i = hash & mask;
+    while (index[i] != INFLIGHT_NPOS)
+        i = (i + 1) & mask;
+
+    index[i] = slot;
+} // end Index_Insert
+
+
+
+//===============================================================================|
+/**
+ * @brief Takes slot out of an index. The entries after it in the same cluster
+ *  are shifted back into the hole wherever that doesn't move them in front of
+ *  their home bucket, so every probe still finds what it's after without the
+ *  need for tombstones.
+ *
+ * @param index by_seq or by_id
+ * @param slot the record to take out
+ * @param on_id true when index is by_id
+ */
+void InflightTracker::Index_Erase(std::vector<u32> &index, const u32 slot, const bool on_id)
+{
+    u32 i = Home(slot, on_id) & mask;
+    while (index[i] != slot)
+    {
+        if (index[i] == INFLIGHT_NPOS)
+            return;     // not in here
+
+        i = (i + 1) & mask;
+    } // end while
+
+    for (u32 j = (i + 1) & mask; index[j] != INFLIGHT_NPOS; j = (j + 1) & mask)
+    {
+        // k is where the entry at j would like to be; it may move to i only
+        //  if k is not cyclically within (i, j]
+        u32 k = Home(index[j], on_id) & mask;
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+
+        index[i] = index[j];
+        i = j;
+    } // end for
+
+    index[i] = INFLIGHT_NPOS;
+} // end Index_Erase
+
+
+
+//===============================================================================|
+/**
+ * @brief The unmasked hash a record is filed under in one of the indexes
+ *
+ */
+u32 InflightTracker::Home(const u32 slot, const bool on_id) const
+{
+    return on_id ? slab[slot].id_hash : Hash_Seq(slab[slot].seq);
+} // end Home
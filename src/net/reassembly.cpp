@@ -0,0 +1,153 @@
+/**
+ * @file reassembly.cpp
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Implementation details for reassembly.h
+ * @version 0.1
+ * @date 2024-03-28
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "reassembly.h"
+
+
+
+
+
+//===============================================================================|
+//          CLASS IMP
+//===============================================================================|
+/**
+ * @brief Construct a new Reassembly:: Reassembly object
+ *
+ * @param max_messages messages put together at once; the oldest makes way
+ *  beyond that
+ * @param timeout_ms how long the rest of a message is waited on from when its
+ *  first part came
+ */
+Reassembly::Reassembly(const size_t max_messages, const u32 timeout_ms)
+    :max_messages{max_messages ? max_messages : REASSEMBLY_MAX}, 
+    timeout_ms{timeout_ms ? timeout_ms : REASSEMBLY_TIMEOUT}, incomplete{0}
+{
+} // end Constructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Files a part. The one that completes a message has the lot handed to
+ *  fn, as has the oldest message should there be no room for a new one. A
+ *  part that's come before is ignored.
+ *
+ * @param source the number that sent it
+ * @param concat its place in the message
+ * @param data_coding what the text is in; the first part's goes for the lot
+ * @param body its text, sans the UDH
+ * @param fn gets whatever message is done with
+ *
+ * @return int 1 when the message is whole, 0 while it's not alas -1 for a part
+ *  that can't be of one
+ */
+int Reassembly::Add(const std::string_view source, const Concat_Info &concat, const u8 data_coding,
+    const std::string_view body, const Reassembled_Fn &fn)
+{
+    if (concat.total < 2 || concat.seqnum == 0 || concat.seqnum > concat.total)
+        return -1;
+
+    key.assign(source);
+    key += '\0';
+    key += (char)(concat.ref >> 8);
+    key += (char)concat.ref;
+    key += (char)concat.total;
+
+    auto it = partials.find(key);
+    if (it == partials.end())
+    {
+        if (partials.size() >= max_messages)
+            Finish(partials.find(ages.front()), fn);
+
+        it = partials.emplace(key, Partial{}).first;
+        Partial &p = it->second;
+        p.source.assign(source);
+        p.data_coding = data_coding;
+        p.parts.resize(concat.total);
+        p.first = std::chrono::steady_clock::now();
+        p.age = ages.insert(ages.end(), key);
+    } // end if a new message
+
+    Partial &p = it->second;
+    std::string &part = p.parts[concat.seqnum - 1];
+    if (!part.empty() || body.empty())
+        return 0;
+
+    part.assign(body);
+    if (++p.have < concat.total)
+        return 0;
+
+    Finish(it, fn);
+    return 1;
+} // end Add
+
+
+
+//===============================================================================|
+/**
+ * @brief Hands over every message that's been waited on long enough, with the
+ *  parts it has, and forgets it. Meant to be called every so often.
+ *
+ * @param now the time now
+ * @param fn gets them
+ *
+ * @return size_t how many were given up on
+ */
+size_t Reassembly::Expire(const std::chrono::steady_clock::time_point now, const Reassembled_Fn &fn)
+{
+    size_t count{0};
+    auto timeout = std::chrono::milliseconds(timeout_ms);
+    while (!ages.empty())
+    {
+        auto it = partials.find(ages.front());
+        if (now - it->second.first < timeout)
+            break;
+
+        Finish(it, fn);
+        count++;
+    } // end while
+
+    return count;
+} // end Expire
+
+
+
+//===============================================================================|
+/**
+ * @brief Joins the parts of a message in order, hands it to fn and forgets it
+ *
+ */
+void Reassembly::Finish(Partials::iterator it, const Reassembled_Fn &fn)
+{
+    Partial &p = it->second;
+    joined.clear();
+    for (const std::string &part : p.parts)
+        joined += part;
+
+    bool whole = p.have == p.parts.size();
+    if (!whole)
+        incomplete++;
+
+    // off the books before fn gets it
+    std::string source;
+    source.swap(p.source);
+    u8 data_coding = p.data_coding;
+    ages.erase(p.age);
+    partials.erase(it);
+
+    fn(source, joined, data_coding, whole);
+} // end Finish
@@ -0,0 +1,163 @@
+/**
+ * @file ring-buffer.cpp
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Implementation details for ring-buffer.h
+ * @version 0.1
+ * @date 2024-03-04
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "ring-buffer.h"
+
+
+
+
+
+//===============================================================================|
+//          CLASS IMP
+//===============================================================================|
+/**
+ * @brief Construct a new Ring Buffer:: Ring Buffer object Allocates the storage
+ *  in one go; the ring never grows after this.
+ *
+ * @param capacity the size of the ring in bytes
+ */
+RingBuffer::RingBuffer(const size_t capacity)
+    :buf{new char[capacity]}, cap{capacity}, head{0}, tail{0} {}
+
+
+
+//===============================================================================|
+/**
+ * @brief Destroy the Ring Buffer:: Ring Buffer object
+ *
+ */
+RingBuffer::~RingBuffer()
+{
+    delete [] buf;
+} // end Destructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Returns the address where the next incoming bytes should be written.
+ *  If the unread bytes are sitting at the end of the storage they are first
+ *  slid back to the front so that the caller get's the largest possible space.
+ *
+ * @return char* pointer to free space of Write_Space() bytes
+ */
+char *RingBuffer::Write_Ptr()
+{
+    if (head == tail)
+        head = tail = 0;        // empty; start over from the top
+    else if (head > 0 && cap - tail < (cap >> 1))
+    {
+        memmove(buf, buf + head, tail - head);
+        tail -= head;
+        head = 0;
+    } // end else if running short at the end
+
+    return buf + tail;
+} // end Write_Ptr
+
+
+
+//===============================================================================|
+/**
+ * @brief Returns the free space available at the tail of the ring
+ *
+ * @return size_t space in bytes
+ */
+size_t RingBuffer::Write_Space() const
+{
+    return cap - tail;
+} // end Write_Space
+
+
+
+//===============================================================================|
+/**
+ * @brief Marks len bytes written at Write_Ptr() as readable.
+ *
+ * @param len the number of bytes written
+ */
+void RingBuffer::Commit(const size_t len)
+{
+    tail += (len > cap - tail ? cap - tail : len);
+} // end Commit
+
+
+
+//===============================================================================|
+/**
+ * @brief Returns the address of the first unread byte; there are Size() bytes
+ *  contiguous from this address.
+ *
+ * @return const char* pointer to unread data
+ */
+const char *RingBuffer::Read_Ptr() const
+{
+    return buf + head;
+} // end Read_Ptr
+
+
+
+//===============================================================================|
+/**
+ * @brief Returns the count of bytes written but not yet consumed
+ *
+ * @return size_t the unread bytes
+ */
+size_t RingBuffer::Size() const
+{
+    return tail - head;
+} // end Size
+
+
+
+//===============================================================================|
+/**
+ * @brief Releases len bytes from the head of the ring.
+ *
+ * @param len number of bytes to release
+ */
+void RingBuffer::Consume(const size_t len)
+{
+    head += (len > tail - head ? tail - head : len);
+    if (head == tail)
+        head = tail = 0;
+} // end Consume
+
+
+
+//===============================================================================|
+/**
+ * @brief Returns the total size of the ring
+ *
+ * @return size_t capacity in bytes
+ */
+size_t RingBuffer::Capacity() const
+{
+    return cap;
+} // end Capacity
+
+
+
+//===============================================================================|
+/**
+ * @brief Drops any unread data; used when the stream is torn down.
+ *
+ */
+void RingBuffer::Reset()
+{
+    head = tail = 0;
+} // end Reset
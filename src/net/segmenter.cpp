@@ -0,0 +1,172 @@
+/**
+ * @file segmenter.cpp
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Implementation details for segmenter.h
+ * @version 0.1
+ * @date 2024-03-26
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "segmenter.h"
+
+
+
+
+
+//===============================================================================|
+//          FUNCTIONS
+//===============================================================================|
+/**
+ * @brief Tells whether the data_coding takes a character to a septet; the text
+ *  then goes one octet per septet, unpacked, as SMSC's expect it in SMPP.
+ */
+static inline bool Is_7Bit(const u8 data_coding)
+{
+    return data_coding == DATA_CODE_DEFAULT || data_coding == DATA_CODE_IA5;
+} // end Is_7Bit
+
+
+
+//===============================================================================|
+/**
+ * @brief The length of the user data header the handset gets with each part;
+ *  SMSC's put a 16-bit reference into the one they build from the sar_* TLVs.
+ */
+static inline size_t UDH_Length(const u8 concat_mode)
+{
+    return concat_mode == CONCAT_UDH8 ? 6 : 7;
+} // end UDH_Length
+
+
+
+//===============================================================================|
+/**
+ * @brief The longest a message may be and still go as a single SMS; 160 GSM
+ *  characters alas 140 octets, i.e. 70 UCS-2 characters.
+ *
+ * @param data_coding the message's data_coding
+ *
+ * @return size_t octets of short_message
+ */
+size_t Single_Limit(const u8 data_coding)
+{
+    return Is_7Bit(data_coding) ? SMS_SEPTETS_MAX : SMS_USER_DATA_MAX;
+} // end Single_Limit
+
+
+
+//===============================================================================|
+/**
+ * @brief The longest a part of a concatenated message may be; what's left of
+ *  the 140 octets once the UDH is in, given in septets for the 7-bit codings
+ *  and in whole characters for UCS-2. So 153 GSM characters or 67 UCS-2 with
+ *  an 8-bit reference, and 152 or 66 with a 16-bit one.
+ *
+ * @param data_coding the message's data_coding
+ * @param concat_mode one of CONCAT_*
+ *
+ * @return size_t octets of short_message, not counting the UDH
+ */
+size_t Part_Limit(const u8 data_coding, const u8 concat_mode)
+{
+    size_t udh = UDH_Length(concat_mode);
+    if (Is_7Bit(data_coding))
+        return SMS_SEPTETS_MAX - (udh * 8 + 6) / 7;     // the UDH rounded up to septets
+
+    size_t octets = SMS_USER_DATA_MAX - udh;
+    return data_coding == DATA_CODE_UCS2 ? octets & ~(size_t)1 : octets;
+} // end Part_Limit
+
+
+
+//===============================================================================|
+/**
+ * @brief Brings the end of a part back so it doesn't cut a character in two:
+ *  an escape and the GSM character it leads, the halves of a UCS-2 unit or of
+ *  a surrogate pair. Text still in UTF-8 under the default coding isn't cut in
+ *  the middle of a sequence either; no GSM octet has the high bit set, so that
+ *  costs GSM text nothing.
+ *
+ * @param msg the whole message
+ * @param pos where the part starts
+ * @param len its length at most
+ * @param data_coding the message's data_coding
+ *
+ * @return size_t the length of the part
+ */
+static size_t Cut_Back(const std::string_view msg, const size_t pos, size_t len, 
+    const u8 data_coding)
+{
+    const u8 *p = (const u8 *)msg.data() + pos;
+    if (data_coding == DATA_CODE_UCS2)
+    {
+        len &= ~(size_t)1;
+        if (len > 2 && (p[len - 2] & 0xFC) == 0xD8)
+            len -= 2;       // a high surrogate; its low half goes along with it
+    } // end if ucs2
+    else if (Is_7Bit(data_coding))
+    {
+        size_t min = len / 2;
+        while (len > min && (p[len] & 0xC0) == 0x80)
+            --len;          // in the middle of a UTF-8 sequence
+
+        if (len > 1 && p[len - 1] == GSM_ESCAPE)
+            --len;
+    } // end else if 7-bit
+
+    return len;
+} // end Cut_Back
+
+
+
+//===============================================================================|
+/**
+ * @brief Cuts a message into the parts of a concatenated SMS. A message short
+ *  enough for a single SMS comes back whole as the only part. The parts point
+ *  into msg.
+ *
+ * @param msg the encoded text
+ * @param data_coding how it's encoded
+ * @param concat_mode one of CONCAT_*; tells the size of the UDH to leave room for
+ * @param parts gets the parts; room for max_parts
+ * @param max_parts the most parts allowed
+ *
+ * @return size_t the number of parts alas 0 when it takes more than max_parts
+ */
+size_t Segment_Message(const std::string_view msg, const u8 data_coding, const u8 concat_mode,
+    std::string_view *parts, const size_t max_parts)
+{
+    if (max_parts == 0)
+        return 0;
+
+    if (msg.size() <= Single_Limit(data_coding))
+    {
+        parts[0] = msg;
+        return 1;
+    } // end if whole
+
+    size_t limit = Part_Limit(data_coding, concat_mode);
+    size_t count{0};
+    for (size_t pos{0}; pos < msg.size(); count++)
+    {
+        if (count == max_parts)
+            return 0;
+
+        size_t len = msg.size() - pos;
+        if (len > limit)
+            len = Cut_Back(msg, pos, limit, data_coding);
+
+        parts[count] = msg.substr(pos, len);
+        pos += len;
+    } // end for
+
+    return count;
+} // end Segment_Message
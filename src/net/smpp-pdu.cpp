@@ -0,0 +1,750 @@
+/**
+ * @file smpp-pdu.cpp
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Implementation details for smpp-pdu.h
+ * @version 0.1
+ * @date 2024-03-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+
+
+//===============================================================================|
+//              INCLUDES
+//===============================================================================|
+#include "smpp-pdu.h"
+
+
+
+
+
+//===============================================================================|
+//              FUNCTIONS
+//===============================================================================|
+/**
+ * @brief Tells whether a part of a concatenated message carries its own user
+ *  data header.
+ *
+ * @param pconcat the part's place in the message; nullptr for a whole message
+ */
+static inline bool Has_UDH(const Concat_Info *pconcat)
+{
+    return pconcat && pconcat->total > 0 && 
+        (pconcat->mode == CONCAT_UDH8 || pconcat->mode == CONCAT_UDH16);
+} // end Has_UDH
+
+
+
+//===============================================================================|
+/**
+ * @brief Puts the message into the PDU; as short_message when it fits in 254
+ *  bytes alas as a message_payload TLV after an empty short_message. Canned
+ *  messages carry no text at all. A part with a UDH has the header put in
+ *  front of its text in short_message, and must fit there along with it.
+ *
+ * @param w the writer; positioned at sm_length
+ * @param msg the message text
+ * @param can_id the canned message id, 0 for none
+ * @param pconcat the part's place in a concatenated message, if it's one
+ */
+static void Put_Message(PduWriter &w, const std::string_view msg, const u8 can_id,
+    const Concat_Info *pconcat)
+{
+    if (can_id == 0 && Has_UDH(pconcat))
+    {
+        bool wide = pconcat->mode == CONCAT_UDH16;
+        size_t udh = wide ? 7 : 6;
+        if (msg.size() + udh > SMPP_SHORT_MSG_MAX)
+        {
+            w.Fail();
+            return;
+        } // end if too long
+
+        w.Put_U8((u8)(msg.size() + udh));       // sm_length
+        w.Put_U8((u8)(udh - 1));                // UDHL
+        w.Put_U8(wide ? UDH_IE_CONCAT_16BIT : UDH_IE_CONCAT_8BIT);
+        w.Put_U8((u8)(udh - 3));                // IEDL
+        if (wide)
+            w.Put_U16(pconcat->ref);
+        else
+            w.Put_U8((u8)pconcat->ref);
+
+        w.Put_U8(pconcat->total);
+        w.Put_U8(pconcat->seqnum);
+        w.Put_Octets(msg);
+    } // end if with a UDH
+    else if (can_id != 0 || msg.size() > SMPP_SHORT_MSG_MAX)
+        w.Put_U8(0);        // sm_length
+    else
+        Pdu_Short_Msg<SMPP_SHORT_MSG_MAX>::Put(w, msg);
+} // end Put_Message
+
+
+
+//===============================================================================|
+/**
+ * @brief Puts the optional parameters that follow a submit; the payload of a
+ *  long message, the user_message_reference and, for a part sent the SAR way,
+ *  the sar_* parameters.
+ *
+ * @param w the writer; positioned after the mandatory fields
+ * @param msg the message text
+ * @param can_id the canned message id, 0 for none
+ * @param seq the sequence # of the PDU, used as our reference
+ * @param pconcat the part's place in a concatenated message, if it's one
+ */
+static void Put_Submit_TLVs(PduWriter &w, const std::string_view msg, const u8 can_id,
+    const u32 seq, const Concat_Info *pconcat)
+{
+    if (can_id == 0 && msg.size() > SMPP_SHORT_MSG_MAX)
+    {
+        if (msg.size() > SMPP_PAYLOAD_MAX)
+            w.Fail();
+        else
+            w.Put_TLV(TLV_MESSAGE_PAYLOAD, msg);
+    } // end if long message
+
+    w.Put_TLV_U16(TLV_USER_MESSAGE_REFERENCE, (u16)seq);
+    if (pconcat && pconcat->total > 0 && pconcat->mode == CONCAT_SAR)
+    {
+        w.Put_TLV_U16(TLV_SAR_MSG_REF_NUM, pconcat->ref);
+        w.Put_TLV_U8(TLV_SAR_TOTAL_SEGMENTS, pconcat->total);
+        w.Put_TLV_U8(TLV_SAR_SEGMENT_SEQNUM, pconcat->seqnum);
+    } // end if sar
+} // end Put_Submit_TLVs
+
+
+
+//===============================================================================|
+/**
+ * @brief Reads the value of an integer TLV; it must be exactly as wide as the
+ *  integer it goes into.
+ *
+ * @param value the value part of the TLV
+ * @param n the integer is returned here
+ *
+ * @return true on success, false when the width is wrong
+ */
+static bool Get_TLV_Int(const std::string_view value, u8 &n)
+{
+    if (value.size() != sizeof(n))
+        return false;
+
+    n = (u8)value[0];
+    return true;
+} // end Get_TLV_Int
+
+
+static bool Get_TLV_Int(const std::string_view value, u16 &n)
+{
+    if (value.size() != sizeof(n))
+        return false;
+
+    iCpy(&n, value.data(), sizeof(n));
+    n = ntohs(n);
+    return true;
+} // end Get_TLV_Int
+
+
+
+//===============================================================================|
+/**
+ * @brief Tells whether the text at p starts with key, letters in any case
+ *
+ * @param key in lower case
+ */
+static inline bool Key_At(const char *p, const char *end, const std::string_view key)
+{
+    if ((size_t)(end - p) < key.size())
+        return false;
+
+    for (size_t i = 0; i < key.size(); i++)
+    {
+        char c = p[i];
+        if (c >= 'A' && c <= 'Z')
+            c |= 0x20;
+
+        if (c != key[i])
+            return false;
+    } // end for
+
+    return true;
+} // end Key_At
+
+
+
+//===============================================================================|
+/**
+ * @brief Finds which field of a receipt starts at p; the first letter picks the
+ *  keys to try, so there's at most three compares.
+ *
+ * @return size_t the length of the key, colon and all, with field pointing at
+ *  where its value goes; 0 for no key we know
+ */
+static inline size_t Receipt_Key(const char *p, const char *end, Dlr_Text &out,
+    std::string_view *&field)
+{
+    static constexpr struct { std::string_view key; std::string_view Dlr_Text::*field; } keys[] = {
+        {"id:", &Dlr_Text::id}, {"stat:", &Dlr_Text::stat}, {"sub:", &Dlr_Text::sub},
+        {"submit date:", &Dlr_Text::submit_date}, {"dlvrd:", &Dlr_Text::dlvrd},
+        {"done date:", &Dlr_Text::done_date}, {"err:", &Dlr_Text::err}, {"text:", &Dlr_Text::text}
+    };
+
+    size_t first, last;     // the keys starting with the letter at p
+    switch (*p | 0x20)
+    {
+        case 'i': first = 0; last = 1; break;
+        case 's': first = 1; last = 4; break;
+        case 'd': first = 4; last = 6; break;
+        case 'e': first = 6; last = 7; break;
+        case 't': first = 7; last = 8; break;
+        default: return 0;
+    } // end switch
+
+    for (size_t i = first; i < last; i++)
+    {
+        if (Key_At(p, end, keys[i].key))
+        {
+            field = &(out.*keys[i].field);
+            return keys[i].key.size();
+        } // end if
+    } // end for
+
+    return 0;
+} // end Receipt_Key
+
+
+
+//===============================================================================|
+/**
+ * @brief Reads stat as one of SMPP_*; by the first five letters, so the long
+ *  spellings some SMSC's use (DELIVERED, UNDELIVERABLE) do as well.
+ */
+static u8 Receipt_State(const std::string_view stat)
+{
+    static constexpr struct { std::string_view prefix; u8 state; } states[] = {
+        {"deliv", SMPP_DELIVERED}, {"undel", SMPP_UNDLIVERABLE}, {"expir", SMPP_EXPIRED},
+        {"rejec", SMPP_REJECTED}, {"enrou", SMPP_ENROUTE}, {"accep", SMPP_ACCEPTED},
+        {"delet", SMPP_DELETED}, {"unkno", SMPP_UNKOWN}, {"faile", SMPP_UNDLIVERABLE}
+    };
+
+    for (const auto &s : states)
+    {
+        if (Key_At(stat.data(), stat.data() + stat.size(), s.prefix))
+            return s.state;
+    } // end for
+
+    return 0;
+} // end Receipt_State
+
+
+
+//===============================================================================|
+/**
+ * @brief Encodes one of bind_transmitter, bind_receiver or bind_transceiver.
+ *
+ * @param buf where the PDU goes
+ * @param len size of buf
+ * @param command_id the bind_* command
+ * @param seq the sequence #
+ * @param system_id the ESME's system id; at most 15 chars
+ * @param pwd the password; at most 8 chars
+ * @param opts supplies system_type, interface version, ton and npi
+ *
+ * @return int length of the PDU alas -1 when something is too long
+ */
+int Encode_Bind(char *buf, const size_t len, const u32 command_id, const u32 seq,
+    const std::string_view system_id, const std::string_view pwd, const Smpp_Options &opts)
+{
+    PduWriter w{buf, len};
+    Bind_Layout::Put(w, system_id, pwd, opts.service_type, opts.interface_ver,
+        opts.src_ton, opts.src_npi, "");
+
+    return w.Finish(command_id, ESME_ROK, seq);
+} // end Encode_Bind
+
+
+
+//===============================================================================|
+/**
+ * @brief Encodes the leading fields shared by submit_sm and submit_multi; i.e.
+ *  the header space followed by service_type and the source address. These
+ *  depend only on the bind and its options, so the caller can keep the result
+ *  and copy it in front of every submit rather than encode it again.
+ *
+ * @param buf where the prefix goes
+ * @param len size of buf
+ * @param opts supplies service_type, ton and npi
+ * @param src_addr the source address
+ *
+ * @return size_t the length of the prefix; 0 if it didn't fit
+ */
+size_t Encode_Submit_Prefix(char *buf, const size_t len, const Smpp_Options &opts,
+    const std::string_view src_addr)
+{
+    PduWriter w{buf, len};
+    Submit_Prefix_Layout::Put(w, opts.service_type, opts.src_ton, opts.src_npi, src_addr);
+
+    return w.Ok() ? w.Length() : 0;
+} // end Encode_Submit_Prefix
+
+
+
+//===============================================================================|
+/**
+ * @brief Encodes a submit_sm behind the prefix the caller has already placed at
+ *  the start of buf.
+ *
+ * @param buf where the PDU goes; starts with the prefix
+ * @param len size of buf
+ * @param prefix_len the length of the prefix in buf
+ * @param seq the sequence #
+ * @param opts the message options
+ * @param dest_num the destination address
+ * @param msg the message; over 254 bytes it goes as message_payload
+ * @param can_id the canned message id, 0 for none
+ * @param pconcat when msg is a part of a longer message, its place in it
+ *
+ * @return int length of the PDU alas -1 when something is too long
+ */
+int Encode_Submit_Sm(char *buf, const size_t len, const size_t prefix_len, const u32 seq,
+    const Smpp_Options &opts, const std::string_view dest_num, const std::string_view msg,
+    const u8 can_id, const Concat_Info *pconcat)
+{
+    PduWriter w{buf, len, prefix_len};
+    Submit_Body_Layout::Put(w, opts.dest_ton, opts.dest_npi, dest_num, 
+        (u8)(opts.esm_class | (Has_UDH(pconcat) ? ESM_UDHI : 0)), opts.protocol_id, 
+        opts.priority_flag, opts.schedule_delivery_time, opts.validity_period, 
+        opts.registered_delivery, opts.replace_present, opts.data_coding, can_id);
+
+    Put_Message(w, msg, can_id, pconcat);
+    Put_Submit_TLVs(w, msg, can_id, seq, pconcat);
+    return w.Finish(submit_sm, ESME_ROK, seq);
+} // end Encode_Submit_Sm
+
+
+
+//===============================================================================|
+/**
+ * @brief Encodes a submit_multi behind the prefix the caller has already placed
+ *  at the start of buf.
+ *
+ * @param buf where the PDU goes; starts with the prefix
+ * @param len size of buf
+ * @param prefix_len the length of the prefix in buf
+ * @param seq the sequence #
+ * @param opts the message options
+ * @param dest_nums the destination addresses
+ * @param dest_count how many; 1 to 254
+ * @param msg the message; over 254 bytes it goes as message_payload
+ * @param can_id the canned message id, 0 for none
+ * @param pconcat when msg is a part of a longer message, its place in it
+ *
+ * @return int length of the PDU alas -1 when something is too long
+ */
+int Encode_Submit_Multi(char *buf, const size_t len, const size_t prefix_len, const u32 seq,
+    const Smpp_Options &opts, const std::string_view *dest_nums, const size_t dest_count,
+    const std::string_view msg, const u8 can_id, const Concat_Info *pconcat)
+{
+    if (dest_count == 0 || dest_count > SMPP_MULTI_DEST_MAX)
+        return -1;
+
+    PduWriter w{buf, len, prefix_len};
+    w.Put_U8((u8)dest_count);
+    for (size_t i = 0; i < dest_count; i++)
+        Multi_Dest_Layout::Put(w, DL_SME_ADDRESS, opts.dest_ton, opts.dest_npi, dest_nums[i]);
+
+    Multi_Body_Layout::Put(w, (u8)(opts.esm_class | (Has_UDH(pconcat) ? ESM_UDHI : 0)), 
+        opts.protocol_id, opts.priority_flag, opts.schedule_delivery_time, 
+        opts.validity_period, opts.registered_delivery, opts.replace_present, 
+        opts.data_coding, can_id);
+
+    Put_Message(w, msg, can_id, pconcat);
+    Put_Submit_TLVs(w, msg, can_id, seq, pconcat);
+    return w.Finish(submit_multi, ESME_ROK, seq);
+} // end Encode_Submit_Multi
+
+
+
+//===============================================================================|
+/**
+ * @brief Encodes a query_sm.
+ *
+ * @param buf where the PDU goes
+ * @param len size of buf
+ * @param seq the sequence #
+ * @param msg_id the id the SMSC gave the message
+ * @param opts supplies the source ton and npi
+ * @param src_addr the source address the message was sent with
+ *
+ * @return int length of the PDU alas -1 when something is too long
+ */
+int Encode_Query_Sm(char *buf, const size_t len, const u32 seq, const std::string_view msg_id,
+    const Smpp_Options &opts, const std::string_view src_addr)
+{
+    PduWriter w{buf, len};
+    Query_Layout::Put(w, msg_id, opts.src_ton, opts.src_npi, src_addr);
+
+    return w.Finish(query_sm, ESME_ROK, seq);
+} // end Encode_Query_Sm
+
+
+
+//===============================================================================|
+/**
+ * @brief Encodes a cancel_sm for a single message by its id; the destination
+ *  is left null as the id is enough.
+ *
+ * @param buf where the PDU goes
+ * @param len size of buf
+ * @param seq the sequence #
+ * @param msg_id the id the SMSC gave the message
+ * @param opts supplies service_type, ton and npi
+ * @param src_addr the source address the message was sent with
+ *
+ * @return int length of the PDU alas -1 when something is too long
+ */
+int Encode_Cancel_Sm(char *buf, const size_t len, const u32 seq, const std::string_view msg_id,
+    const Smpp_Options &opts, const std::string_view src_addr)
+{
+    PduWriter w{buf, len};
+    Cancel_Layout::Put(w, opts.service_type, msg_id, opts.src_ton, opts.src_npi, src_addr,
+        opts.dest_ton, opts.dest_npi, "");
+
+    return w.Finish(cancel_sm, ESME_ROK, seq);
+} // end Encode_Cancel_Sm
+
+
+
+//===============================================================================|
+/**
+ * @brief Encodes a replace_sm.
+ *
+ * @param buf where the PDU goes
+ * @param len size of buf
+ * @param seq the sequence #
+ * @param msg_id the id the SMSC gave the message
+ * @param opts supplies the source ton/npi, times and registered_delivery
+ * @param msg the new message; at most 254 bytes
+ * @param src_addr the source address the message was sent with
+ *
+ * @return int length of the PDU alas -1 when something is too long
+ */
+int Encode_Replace_Sm(char *buf, const size_t len, const u32 seq, const std::string_view msg_id,
+    const Smpp_Options &opts, const std::string_view msg, const std::string_view src_addr)
+{
+    PduWriter w{buf, len};
+    Replace_Layout::Put(w, msg_id, opts.src_ton, opts.src_npi, src_addr,
+        opts.schedule_delivery_time, opts.validity_period, opts.registered_delivery,
+        opts.sm_id, msg);
+
+    return w.Finish(replace_sm, ESME_ROK, seq);
+} // end Encode_Replace_Sm
+
+
+
+//===============================================================================|
+/**
+ * @brief Encodes a deliver_sm_resp.
+ *
+ * @param buf where the PDU goes
+ * @param len size of buf
+ * @param seq the sequence # of the deliver_sm being answered
+ * @param status the command status
+ *
+ * @return int length of the PDU alas -1 when buf is too small
+ */
+int Encode_Deliver_Rsp(char *buf, const size_t len, const u32 seq, const u32 status)
+{
+    PduWriter w{buf, len};
+    Deliver_Rsp_Layout::Put(w, "");
+
+    return w.Finish(deliver_sm_resp, status, seq);
+} // end Encode_Deliver_Rsp
+
+
+
+//===============================================================================|
+/**
+ * @brief Decodes a bind_*_resp. The body may well be missing when the bind was
+ *  turned down, so that is not taken as an error.
+ *
+ * @param pdu the whole PDU, header and all
+ * @param len its command_length
+ * @param out the decoded body; points into pdu
+ *
+ * @return int 0 on success alas -1 when a field overruns the PDU
+ */
+int Decode_Bind_Resp(const char *pdu, const size_t len, Bind_Resp_Pdu &out)
+{
+    PduReader r{pdu, len};
+    out = Bind_Resp_Pdu{};
+    if (r.Ok() && r.Remaining() > 0)
+        r.Get_CString(out.system_id);   // TLV's after it are of no use to us
+
+    return r.Ok() ? 0 : -1;
+} // end Decode_Bind_Resp
+
+
+
+//===============================================================================|
+/**
+ * @brief Decodes a submit_sm_resp; as with the binds an error response may come
+ *  without a body.
+ *
+ * @param pdu the whole PDU, header and all
+ * @param len its command_length
+ * @param out the decoded body; points into pdu
+ *
+ * @return int 0 on success alas -1 when a field overruns the PDU
+ */
+int Decode_Submit_Resp(const char *pdu, const size_t len, Submit_Resp_Pdu &out)
+{
+    PduReader r{pdu, len};
+    out = Submit_Resp_Pdu{};
+    if (r.Ok() && r.Remaining() > 0)
+        r.Get_CString(out.message_id);
+
+    return r.Ok() ? 0 : -1;
+} // end Decode_Submit_Resp
+
+
+
+//===============================================================================|
+/**
+ * @brief Decodes a submit_multi_resp; message_id and the count of destinations
+ *  that failed. The unsuccess_sme list itself is not looked into.
+ *
+ * @param pdu the whole PDU, header and all
+ * @param len its command_length
+ * @param out the decoded body; points into pdu
+ *
+ * @return int 0 on success alas -1 when a field overruns the PDU
+ */
+int Decode_Submit_Multi_Resp(const char *pdu, const size_t len, Submit_Resp_Pdu &out)
+{
+    PduReader r{pdu, len};
+    out = Submit_Resp_Pdu{};
+    if (r.Ok() && r.Remaining() > 0)
+    {
+        r.Get_CString(out.message_id);
+        if (r.Remaining() > 0)
+            r.Get_U8(out.no_unsuccess);
+    } // end if there's a body
+
+    return r.Ok() ? 0 : -1;
+} // end Decode_Submit_Multi_Resp
+
+
+
+//===============================================================================|
+/**
+ * @brief Decodes a query_sm_resp.
+ *
+ * @param pdu the whole PDU, header and all
+ * @param len its command_length
+ * @param out the decoded body; points into pdu
+ *
+ * @return int 0 on success alas -1 when the body is short or overruns the PDU
+ */
+int Decode_Query_Resp(const char *pdu, const size_t len, Query_Resp_Pdu &out)
+{
+    PduReader r{pdu, len};
+    out = Query_Resp_Pdu{};
+    Query_Resp_Layout::Get(r, out.message_id, out.final_date, out.message_state,
+        out.error_code);
+
+    return r.Ok() ? 0 : -1;
+} // end Decode_Query_Resp
+
+
+
+//===============================================================================|
+/**
+ * @brief Decodes a deliver_sm; the mandatory fields and then whichever of the
+ *  optional parameters we know of, skipping the rest. A TLV whose length runs
+ *  past the PDU fails the whole decode, as does a known one of the wrong size.
+ *
+ * @param pdu the whole PDU, header and all
+ * @param len its command_length
+ * @param out the decoded body; points into pdu
+ *
+ * @return int 0 on success alas -1 when the PDU is malformed
+ */
+int Decode_Deliver_Sm(const char *pdu, const size_t len, Deliver_Sm_Pdu &out)
+{
+    PduReader r{pdu, len};
+    out = Deliver_Sm_Pdu{};
+    Deliver_Sm_Layout::Get(r, out.service_type, out.src_ton, out.src_npi, out.source_addr,
+        out.dest_ton, out.dest_npi, out.destination_addr, out.esm_class, out.protocol_id,
+        out.priority_flag, out.schedule_delivery_time, out.validity_period,
+        out.registered_delivery, out.replace_present, out.data_coding, out.sm_id,
+        out.short_message);
+
+    while (r.Ok() && r.Remaining() > 0)
+    {
+        u16 tag, tlv_len;
+        std::string_view value;
+        r.Get_U16(tag);
+        r.Get_U16(tlv_len);
+        r.Get_Octets(tlv_len, value);
+        if (!r.Ok())
+            break;
+
+        bool good{true};    // a known TLV must have its right size
+        switch (tag)
+        {
+            case TLV_RECEIPTED_MESSAGE_ID:
+                // a C-Octet String, but don't count on the null being there
+                out.receipted_message_id = value.substr(0, value.find('\0'));
+                break;
+
+            case TLV_MESSAGE_PAYLOAD:
+                out.message_payload = value;
+                break;
+
+            case TLV_NETWORK_ERROR_CODE:
+                good = value.size() == 3;
+                out.network_error_code = value;
+                break;
+
+            case TLV_MESSAGE_STATE:
+                good = Get_TLV_Int(value, out.message_state);
+                break;
+
+            case TLV_USER_MESSAGE_REFERENCE:
+                good = Get_TLV_Int(value, out.user_message_reference);
+                break;
+
+            case TLV_SAR_MSG_REF_NUM:
+                good = Get_TLV_Int(value, out.sar_msg_ref_num);
+                break;
+
+            case TLV_SAR_TOTAL_SEGMENTS:
+                good = Get_TLV_Int(value, out.sar_total_segments);
+                break;
+
+            case TLV_SAR_SEGMENT_SEQNUM:
+                good = Get_TLV_Int(value, out.sar_segment_seqnum);
+                break;
+
+            default:
+                break;      // not one of ours
+        } // end switch
+
+        if (!good)
+            r.Fail();
+    } // end while TLV's
+
+    return r.Ok() ? 0 : -1;
+} // end Decode_Deliver_Sm
+
+
+
+//===============================================================================|
+/**
+ * @brief Gets at the text of a deliver_sm: the message_payload when there's
+ *  one alas short_message, sans the UDH when esm_class says there's one. Its
+ *  place in a concatenated message comes from the concatenation element of
+ *  the UDH, or else from the sar_* parameters.
+ *
+ * @param dlv the decoded deliver_sm
+ * @param body gets the text; points into the PDU
+ * @param concat gets the part's place; total is 0 for a message that's whole.
+ *  mode tells where it came from, as for sending.
+ *
+ * @return int 0 on success alas -1 when the UDH runs past the text
+ */
+int Decode_User_Data(const Deliver_Sm_Pdu &dlv, std::string_view &body, Concat_Info &concat)
+{
+    body = dlv.message_payload.empty() ? dlv.short_message : dlv.message_payload;
+    concat = Concat_Info{0, 0, 0, CONCAT_SAR};
+    if (dlv.sar_total_segments > 1)
+        concat = Concat_Info{dlv.sar_msg_ref_num, dlv.sar_total_segments, dlv.sar_segment_seqnum,
+            CONCAT_SAR};
+
+    if ( !(dlv.esm_class & ESM_UDHI))
+        return 0;
+
+    const u8 *udh = (const u8 *)body.data();
+    size_t udh_len = body.empty() ? 0 : udh[0] + 1;
+    if (udh_len == 0 || udh_len > body.size())
+        return -1;
+
+    // the information elements; the one we're after among them
+    for (size_t i = 1; i + 2 <= udh_len; )
+    {
+        u8 iei = udh[i], ie_len = udh[i + 1];
+        if (i + 2 + ie_len > udh_len)
+            return -1;
+
+        const u8 *ie = udh + i + 2;
+        if (iei == UDH_IE_CONCAT_8BIT && ie_len == 3 && ie[1] > 1)
+            concat = Concat_Info{ie[0], ie[1], ie[2], CONCAT_UDH8};
+        else if (iei == UDH_IE_CONCAT_16BIT && ie_len == 4 && ie[2] > 1)
+            concat = Concat_Info{(u16)((ie[0] << 8) | ie[1]), ie[2], ie[3], CONCAT_UDH16};
+
+        i += 2 + ie_len;
+    } // end for
+
+    body.remove_prefix(udh_len);
+    return 0;
+} // end Decode_User_Data
+
+
+
+//===============================================================================|
+/**
+ * @brief Reads a delivery receipt out of its text, in a single pass and
+ *  without allocating; the fields all point into text. Keys are taken in any
+ *  order and any case, and the ones we don't know are skipped; a value runs
+ *  up to the next space, save for text's, which is the rest. The text may be
+ *  null terminated.
+ *
+ * @param text the short_message, or message_payload, of the receipt
+ * @param out the fields
+ *
+ * @return int 0 on success alas -1 when there's no id or stat to be had
+ */
+int Parse_Receipt(const std::string_view text, Dlr_Text &out)
+{
+    out = Dlr_Text{};
+    const char *p = text.data();
+    const char *end = p + text.size();
+    while (p < end && *p)
+    {
+        if (*p == ' ')
+        {
+            p++;
+            continue;
+        } // end if
+
+        std::string_view *field{nullptr};
+        size_t key_len = Receipt_Key(p, end, out, field);
+        p += key_len;
+
+        const char *value = p;
+        if (field == &out.text)
+            p = end;
+        else
+        {
+            while (p < end && *p != ' ' && *p)
+                p++;
+        } // end else
+
+        if (field)
+            *field = std::string_view(value, p - value);
+    } // end while
+
+    out.text = out.text.substr(0, out.text.find('\0'));
+
+    if (out.id.empty() || out.stat.empty())
+        return -1;
+
+    out.message_state = Receipt_State(out.stat);
+    std::from_chars(out.err.data(), out.err.data() + out.err.size(), out.error);
+    return 0;
+} // end Parse_Receipt
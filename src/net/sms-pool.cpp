@@ -0,0 +1,485 @@
+/**
+ * @file sms-pool.cpp
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Implementation details for sms-pool.h
+ * @version 0.1
+ * @date 2024-03-30
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "sms-pool.h"
+
+
+
+
+
+//===============================================================================|
+//          CLASS IMP
+//===============================================================================|
+/**
+ * @brief Construct a new SmsPool:: SmsPool object; empty until Open
+ */
+SmsPool::SmsPool()
+    :tx_count{0}, policy{POOL_LEAST_IN_FLIGHT}, stagger_ms{POOL_STAGGER}, cursor{0},
+    reconnects{0}
+{
+} // end Constructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Destroy the SmsPool:: SmsPool object; every bind is let go
+ */
+SmsPool::~SmsPool()
+{
+    Shutdown();
+} // end Destructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Sets up the binds to an account, without connecting any; that's for
+ *  Startup, once the binds have been set the way they should. With no
+ *  receivers asked for, the transmitters bind as transceivers and take their
+ *  own receipts, as a lone bind always has.
+ *
+ * @param host the SMSC
+ * @param port and its port
+ * @param sys_id the account
+ * @param pwd its password
+ * @param tx binds that send
+ * @param rx binds that only receive
+ *
+ * @return int 0 on success alas -1 for counts the pool won't have
+ */
+int SmsPool::Open(const std::string &host, const std::string &port, const std::string &sys_id,
+    const std::string &pwd, const u32 tx, const u32 rx)
+{
+    if (tx == 0 || tx + rx > POOL_MAX_BINDS || !sessions.empty())
+        return -1;
+
+    this->host = host;
+    this->port = port;
+    this->system_id = sys_id;
+    this->pwd = pwd;
+    tx_count = tx;
+
+    for (u32 i = 0; i < tx + rx; i++)
+    {
+        std::unique_ptr<Pool_Session> ps{new Pool_Session};
+        ps->index = i;
+        ps->mode = rx == 0 ? bind_transceiver : (i < tx ? bind_transmitter : bind_receiver);
+        if (tx + rx > 1)
+            ps->sms.Set_Peers(this, i);
+
+        sessions.push_back(std::move(ps));
+    } // end for
+
+    return 0;
+} // end Open
+
+
+
+//===============================================================================|
+/**
+ * @brief Connects and binds every bind of the pool, one after the other. The
+ *  ones that can't connect are left to Reconnect.
+ *
+ * @return int the binds that connected, alas -2 when one was turned down for
+ *  what it was asked with; see Get_Err
+ */
+int SmsPool::Startup()
+{
+    int connected{0};
+    auto now = std::chrono::steady_clock::now();
+    for (auto &ps : sessions)
+    {
+        int ret;
+        if ( (ret = ps->sms.Startup(host, port, system_id, pwd, "", ps->mode)) == -2)
+        {
+            err = ps->sms.Get_Err();
+            return -2;
+        } // end if
+
+        if (ret < 0)
+        {
+            ps->sms.Shutdown();
+            Retry_Later(*ps, now);
+            continue;
+        } // end if
+
+        ps->down = false;
+        ++connected;
+    } // end for
+
+    return connected;
+} // end Startup
+
+
+
+//===============================================================================|
+/**
+ * @brief Drops every bind
+ */
+void SmsPool::Shutdown()
+{
+    for (auto &ps : sessions)
+    {
+        if (ps->sms.Get_Connection() >= 0)
+            ps->sms.Shutdown();
+    } // end for
+} // end Shutdown
+
+
+
+//===============================================================================|
+/**
+ * @brief Tries again the binds that have been lost, those whose turn it is;
+ *  one a call at the most, as the connect holds up the caller. A bind is
+ *  first tried POOL_RECONNECT_MIN after it's found lost, twice as long after
+ *  every attempt that fails up to POOL_RECONNECT_MAX, and on top of that
+ *  the stagger for every bind ahead of it in the pool. Meant to be called
+ *  every tick, from the thread that reads the pool.
+ *
+ * @param fn gets every bind that's connected again, to watch it
+ *
+ * @return size_t the binds connected again
+ */
+size_t SmsPool::Reconnect(const Rebound_Fn &fn)
+{
+    size_t made{0};
+    bool tried{false};
+    auto now = std::chrono::steady_clock::now();
+    for (auto &ps : sessions)
+    {
+        Pool_Session &s = *ps;
+        if (s.sms.Get_Connection() >= 0)
+        {
+            if (s.sms.Get_State() & SMS_BOUNDED)
+                s.failures = 0;
+
+            continue;
+        } // end if up
+
+        if (!s.down)
+        {
+            Retry_Later(s, now);
+            continue;
+        } // end if only just lost
+
+        if (tried || now < s.retry_at)
+            continue;
+
+        tried = true;
+        if (s.sms.Startup(host, port, system_id, pwd, "", s.mode) < 0)
+        {
+            s.sms.Shutdown();
+            ++s.failures;
+            Retry_Later(s, now);
+            continue;
+        } // end if
+
+        s.down = false;
+        ++reconnects;
+        ++made;
+        if (fn)
+            fn(s.sms);
+    } // end for
+
+    return made;
+} // end Reconnect
+
+
+
+//===============================================================================|
+/**
+ * @brief Picks the transmitter the next message goes out on, by the policy
+ *  set. Either way the search starts a bind on from where the last one did,
+ *  so binds as good as each other get turns.
+ *
+ * @return Sms* the bind; one with room in its window as long as any has,
+ *  alas nullptr with no transmitter bound
+ */
+Sms *SmsPool::Pick()
+{
+    Sms *pbest{nullptr};
+    u32 least{0};
+
+    const u32 start = cursor.fetch_add(1, std::memory_order_relaxed);
+    for (u32 k = 0; k < tx_count; k++)
+    {
+        Sms &sms = sessions[(start + k) % tx_count]->sms;
+        if ( !(sms.Get_State() & SMS_BOUNDED))
+            continue;
+
+        u32 load = sms.Get_In_Flight();
+        if (load < sms.Get_Window() && (policy == POOL_ROUND_ROBIN || load == 0))
+            return &sms;
+
+        if (!pbest || load < least)
+        {
+            pbest = &sms;
+            least = load;
+        } // end if less loaded
+    } // end for
+
+    return pbest;
+} // end Pick
+
+
+
+//===============================================================================|
+/**
+ * @brief Corks every transmitter; see Sms::Cork
+ */
+void SmsPool::Cork()
+{
+    for (u32 i = 0; i < tx_count; i++)
+        sessions[i]->sms.Cork();
+} // end Cork
+
+
+
+//===============================================================================|
+/**
+ * @brief Uncorks every transmitter; see Sms::Uncork
+ *
+ * @return int 0 on success alas -1 when any of them failed on its socket
+ */
+int SmsPool::Uncork()
+{
+    int ret{0};
+    for (u32 i = 0; i < tx_count; i++)
+    {
+        if (sessions[i]->sms.Uncork() < 0)
+            ret = -1;
+    } // end for
+
+    return ret;
+} // end Uncork
+
+
+
+//===============================================================================|
+/**
+ * @brief Sees to the timeouts of every bind that's connected. A lost bind's
+ *  wait until it's back, as it's only there they can be resubmitted.
+ *
+ * @param err gets the last error
+ * @param buf_len its size
+ *
+ * @return int 0 on success, -2 when a bind gave up on some messages and -1
+ *  when one failed on its socket; see Sms::Check_Timeouts
+ */
+int SmsPool::Check_Timeouts(char *err, const size_t buf_len)
+{
+    int ret{0};
+    for (auto &ps : sessions)
+    {
+        if (ps->sms.Get_Connection() < 0)
+            continue;
+
+        int r = ps->sms.Check_Timeouts(err, buf_len);
+        if (r == -2 || (r == -1 && ret == 0))
+            ret = r;
+    } // end for
+
+    return ret;
+} // end Check_Timeouts
+
+
+
+//===============================================================================|
+/**
+ * @brief Sets how messages are spread over the transmitters
+ *
+ * @param policy one of POOL_LEAST_IN_FLIGHT or POOL_ROUND_ROBIN
+ */
+void SmsPool::Set_Policy(const u8 policy)
+{
+    this->policy = policy == POOL_ROUND_ROBIN ? POOL_ROUND_ROBIN : POOL_LEAST_IN_FLIGHT;
+} // end Set_Policy
+
+
+
+//===============================================================================|
+/**
+ * @brief Sets how far apart the binds are tried again
+ *
+ * @param stagger_ms ms between one bind's attempts and the next's
+ */
+void SmsPool::Set_Stagger(const u32 stagger_ms)
+{
+    this->stagger_ms = stagger_ms;
+} // end Set_Stagger
+
+
+
+//===============================================================================|
+/**
+ * @brief Sets the submit window of every bind; see Sms::Set_Window
+ */
+void SmsPool::Set_Window(const u32 size)
+{
+    for (auto &ps : sessions)
+        ps->sms.Set_Window(size);
+} // end Set_Window
+
+
+
+//===============================================================================|
+/**
+ * @brief Sets whether every bind waits for room in its window; see Sms::Set_Wait
+ */
+void SmsPool::Set_Wait(const bool wait)
+{
+    for (auto &ps : sessions)
+        ps->sms.Set_Wait(wait);
+} // end Set_Wait
+
+
+
+//===============================================================================|
+/**
+ * @brief Sets the response timeout of every bind; see Sms::Set_Resp_Timeout
+ */
+void SmsPool::Set_Resp_Timeout(const u32 timeout, const u8 retries)
+{
+    for (auto &ps : sessions)
+        ps->sms.Set_Resp_Timeout(timeout, retries);
+} // end Set_Resp_Timeout
+
+
+
+//===============================================================================|
+/**
+ * @brief Sets how every bind sends long messages; see Sms::Set_Concat
+ */
+void SmsPool::Set_Concat(const u8 mode)
+{
+    for (auto &ps : sessions)
+        ps->sms.Set_Concat(mode);
+} // end Set_Concat
+
+
+
+//===============================================================================|
+/**
+ * @brief Tallies up the binds
+ *
+ * @return Pool_Health how they're doing
+ */
+Pool_Health SmsPool::Get_Health() const
+{
+    Pool_Health health;
+    health.binds = sessions.size();
+    health.reconnects = reconnects;
+    for (const auto &ps : sessions)
+    {
+        const Sms &sms = ps->sms;
+        health.in_flight += sms.Get_In_Flight();
+        if ( !(sms.Get_State() & SMS_BOUNDED))
+            continue;
+
+        ++health.bound;
+        if (ps->mode != bind_receiver)
+        {
+            ++health.tx_bound;
+            health.window += sms.Get_Window();
+        } // end if sends
+
+        if (ps->mode != bind_transmitter)
+            ++health.rx_bound;
+    } // end for
+
+    health.state = health.tx_bound == 0 ? POOL_DOWN :
+        (health.bound == health.binds ? POOL_UP : POOL_DEGRADED);
+    return health;
+} // end Get_Health
+
+
+
+//===============================================================================|
+/**
+ * @brief Hands a receipt that came in on one bind to the rest, till one of
+ *  them owns the message. One none of them does is kept, the oldest making
+ *  way past POOL_EARLY_MAX, for its response may be yet to come; see
+ *  Claim_Early.
+ *
+ * @param from the bind it came in on; it's been asked already
+ * @param msg_id the message
+ * @param status one of MSG_STATE_*
+ *
+ * @return int 0 when a bind took it in alas -1
+ */
+int SmsPool::Settle(const size_t from, const std::string_view msg_id, const u8 status)
+{
+    for (size_t i = 0; i < sessions.size(); i++)
+    {
+        if (i != from && sessions[i]->sms.Settle(msg_id, status) == 0)
+            return 0;
+    } // end for
+
+    std::lock_guard<std::mutex> lock(early_mutex);
+    if (early_order.size() >= POOL_EARLY_MAX)
+    {
+        early.erase(early_order.front());
+        early_order.pop_front();
+    } // end if full
+
+    early[std::string{msg_id}] = status;
+    early_order.emplace_back(msg_id);
+    return -1;
+} // end Settle
+
+
+
+//===============================================================================|
+/**
+ * @brief Asked by a bind with every response it gets, for a receipt that came
+ *  in before it
+ *
+ * @param msg_id the id the response gave the message
+ *
+ * @return u8 the state the receipt had, one of MSG_STATE_*, alas 0 for none
+ */
+u8 SmsPool::Claim_Early(const std::string_view msg_id)
+{
+    std::lock_guard<std::mutex> lock(early_mutex);
+    if (early.empty())
+        return 0;
+
+    auto it = early.find(std::string{msg_id});
+    if (it == early.end())
+        return 0;
+
+    u8 status = it->second;
+    early.erase(it);
+    return status;
+} // end Claim_Early
+
+
+
+//===============================================================================|
+/**
+ * @brief Sets when a lost bind is tried next; see Reconnect
+ *
+ * @param s the bind
+ * @param now the time it is
+ */
+void SmsPool::Retry_Later(Pool_Session &s, const std::chrono::steady_clock::time_point now)
+{
+    u32 wait = std::min<u32>(POOL_RECONNECT_MIN << std::min<u32>(s.failures, 6), POOL_RECONNECT_MAX);
+    s.retry_at = now + std::chrono::milliseconds(wait + s.index * stagger_ms);
+    s.down = true;
+} // end Retry_Later
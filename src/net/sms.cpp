@@ -74,10 +74,38 @@
 
 
 
+
+/**
+ * @brief Locks the send side of the object for the rest of the scope. The lock
+ *  is recursive since handlers running under it may send responses of their own.
+ * 
+ */
+#define SMS_LOCK    std::lock_guard<std::recursive_mutex> sms_guard(sms_mutex)
+
+
+
+/**
+ * @brief The timeouts kept on the wheel; a key is the kind of timeout over the
+ *  slot of a single message or the sequence # of a bulk.
+ * 
+ */
+#define TIMER_SUBMIT            1           // submit_sm_resp is due
+#define TIMER_MULTI             2           // submit_multi_resp is due
+#define TIMER_RECEIPT           3           // the delivery receipt is due
+#define TIMER_QUERY             4           // query_sm_resp is due
+#define TIMER_THROTTLE          5           // a throttled submit_sm is to go again
+
+#define TIMER_KEY(kind, ref)    (((u64)(kind) << 32) | (ref))
+
+
+
 //===============================================================================|
 //        GLOBALS
 //===============================================================================|
 void Heartbeat(Sms *psms);
+static u64 Validity_Seconds(const std::string &validity);
+static void Store_Inbound(const std::string_view source, const std::string_view body,
+    const u8 data_coding, const bool whole);
 
 
 
@@ -93,12 +121,23 @@ void Heartbeat(Sms *psms);
  * 
  */
 Sms::Sms()
-    :phbeat{nullptr}
+    :ppeers{nullptr}, peer_index{0}, phbeat{nullptr}, prefix_key{0}, prefix_len{0}, 
+     rcv_ring{SMS_RING_SIZE}, snd_ring{SMS_RING_SIZE}, corked{0}
 {
     heartbeat_interval = HEARTBEAT_INTERVAL;
     sms_state = SMS_DISCONNECTED;
     seq_num = 0;
 
+    window_size = window_cap = SMPP_WINDOW_DEFAULT;
+    in_flight = held = 0;
+    bwait = true;
+    resp_timeout = SMPP_RESP_TIMEOUT;
+    backoff = SMPP_THROTTLE_BACKOFF;
+    max_retries = SMPP_MAX_RETRIES;
+    concat_mode = CONCAT_UDH8;
+    concat_ref = 0;
+    group_seq = 0;
+
     bheartbeat = false;
     bdebug = false;
 
@@ -106,8 +145,6 @@ Sms::Sms()
     system_id = "";
     pwd = "";
 
-    iZero(snd_buffer, SMS_BUFFER_SIZE);
-    iZero(rcv_buffer, SMS_BUFFER_SIZE);
     iZero(err_desc, MAXLINE);
 } // end Constructor
 
@@ -132,19 +169,28 @@ Sms::Sms()
  */
 Sms::Sms(const std::string hostname, const std::string port, const std::string sys_id, 
     const std::string pwd, const std::string sms_no, const u32 mode, bool hbt, bool debug)
-    :phbeat{nullptr}
+    :ppeers{nullptr}, peer_index{0}, phbeat{nullptr}, prefix_key{0}, prefix_len{0}, 
+     rcv_ring{SMS_RING_SIZE}, snd_ring{SMS_RING_SIZE}, corked{0}
 {
     heartbeat_interval = HEARTBEAT_INTERVAL;
     sms_state = SMS_DISCONNECTED;
     seq_num = 0;
 
+    window_size = window_cap = SMPP_WINDOW_DEFAULT;
+    in_flight = held = 0;
+    bwait = true;
+    resp_timeout = SMPP_RESP_TIMEOUT;
+    backoff = SMPP_THROTTLE_BACKOFF;
+    max_retries = SMPP_MAX_RETRIES;
+    concat_mode = CONCAT_UDH8;
+    concat_ref = 0;
+    group_seq = 0;
+
     bheartbeat = hbt;
     bdebug = debug;
 
     smsc_id = "";
     
-    iZero(snd_buffer, SMS_BUFFER_SIZE);
-    iZero(rcv_buffer, SMS_BUFFER_SIZE);
     iZero(err_desc, MAXLINE);
 
     if (Startup(hostname, port, sys_id, pwd, sms_no, mode, hbt, debug) < 0)
@@ -198,10 +244,19 @@ int Sms::Startup(const std::string hostname, const std::string port,
     if (ioctl(tcp.Get_Socket(), FIONBIO, (char *)&on) < 0)
         return -1;
 
+    // PDUs are coalesced in snd_ring already; Nagle would only hold them back
+    //  waiting on SMSC's delayed ACK's
+    int nodelay{1};
+    if (setsockopt(tcp.Get_Socket(), IPPROTO_TCP, TCP_NODELAY, (const char *)&nodelay, 
+        sizeof(nodelay)) < 0)
+        return -1;
+
     sms_state = SMS_CONNECTED;
+    window_cap = window_size;   // a new bind hasn't been throttled yet
     this->system_id = sys_id;
     this->pwd = pwd;
     this->sms_id = (sms_no.length() > 20 ? "" : sms_no);
+    prefix_len = 0;     // source_addr may have changed
 
     if ( (ret = Bind(mode)) < 0)
         return ret;
@@ -215,7 +270,9 @@ int Sms::Startup(const std::string hostname, const std::string port,
 //===============================================================================|
 /**
  * @brief Disconnects the sms session, first it sends UNBIND_TRX signal to SMCS
- *  it then wait's for response and Disconnects the TCP session.
+ *  it then wait's for response and Disconnects the TCP session. The submits
+ *  still awaiting a response never get one on this link; they're held to go
+ *  again, as throttled ones are, once the bind is back.
  * 
  * @return int 0 on success alas a -1
  */
@@ -227,10 +284,26 @@ int Sms::Shutdown()
         phbeat = nullptr;
     } // end if heartbeat on
 
+    SMS_LOCK;
     if (tcp.Disconnect() < 0)
         return -1;
 
+    queued_msg.For_Each([this](const u32 slot, Single_Sms_Info &info) {
+        if (info.msg_state != MSG_STATE_SENT)
+            return;
+
+        info.msg_state = MSG_STATE_THROTTLED;
+        timers.Cancel(info.timer);
+        info.timer = timers.Schedule(TIMER_KEY(TIMER_THROTTLE, slot), backoff);
+        ++held;
+    });
+
+    in_flight = (u32)queued_blk_msg.size();     // bulks hold theirs till they time out
+    rcv_ring.Reset();
+    snd_ring.Reset();
+    corked = 0;
     sms_state = SMS_DISCONNECTED;
+    window_cond.notify_all();       // nobody should wait on a dead link
     return 0;
 } // end Shutdown
 
@@ -260,28 +333,82 @@ int Sms::Disconnect()
 
 //===============================================================================|
 /**
- * @brief Sends a single SMS message to recepient at dest_num.
+ * @brief Sends a single SMS message to recepient at dest_num. One too long for
+ *  a single SMS goes as the parts of a concatenated message, in the way set by
+ *  Set_Concat. The parts take a window slot each and every one waits for its
+ *  own; they're corked all the same, as Wait_Window writes out what's held
+ *  before it waits. Under CONCAT_PAYLOAD the
+ *  message goes whole as message_payload, in pieces of 65,534 bytes. Under the
+ *  default data_coding msg is taken as UTF-8 and goes in GSM 7-bit or UCS-2,
+ *  whichever it fits; see Encode.
  * 
  * @param msg The message to send no limit the on the length of message.
  * @param dest_num The destination number
  * @param poptions SMPP options controlling the specific message
+ * @param row_id the message's row in SmsOut, to report it under; 0 for none
  * 
  * @return int a 0 on success alas -ve on fail
  */
-int Sms::Send_Message(const std::string msg, const std::string dest_num, 
-    const Smpp_Options_Ptr poptions)
+int Sms::Send_Message(const std::string_view msg, const std::string_view dest_num, 
+    const Smpp_Options_Ptr poptions, const u32 row_id)
 {
     int ret;
     size_t sent{0};
+    std::string_view parts[SMPP_CONCAT_MAX];
+    std::string_view text{msg};
+    Smpp_Options coded;
 
-    Smpp_Options_Ptr popt = poptions == nullptr ? &options : poptions;
+    Smpp_Options_Ptr popt = Encode(text, poptions == nullptr ? &options : poptions, coded);
     if (sms_state & SMS_BOUNDED)
     {
-        size_t len = msg.length();
+        size_t count;
+        if ( (count = Split(text, popt, parts)) == 0)
+            return -2;
+
+        if (count > 1)
+        {
+            std::unique_lock<std::recursive_mutex> lock(sms_mutex);
+            Concat_Info concat{++concat_ref, (u8)count, 0, concat_mode};
+            u32 group = ++group_seq ? group_seq : ++group_seq;     // 0 is for none
+            Concat_Group &g = groups[group];
+            g.total = g.left = (u8)count;
+            g.row_id = row_id;
+
+            Cork();
+            size_t i{0};
+            for (; i < count; i++)
+            {
+                concat.seqnum = (u8)(i + 1);
+                if ( (ret = Wait_Window(lock)) < 0 ||
+                    (ret = Submit(parts[i], dest_num, popt, 0, &concat, row_id)) < 0)
+                {
+                    break;
+                } // end if
+
+                queued_msg.Get(queued_msg.Find_Seq(seq_num)).group = group;
+            } // end for
+
+            if (i < count)
+            {
+                // the rest won't go; the message as a whole has failed
+                Roll_Up(group, "", MSG_STATE_FAILED);
+                Leave_Group(group, (u8)(count - i));
+                Uncork();
+                return ret;
+            } // end if
+
+            return Uncork() < 0 ? -1 : 0;
+        } // end if in parts
+
+        size_t len = text.length();
         while (len > 0)
         {
-            size_t snd_len = (len > 65'534 ? 65'534 : len);
-            ret = Submit(msg.substr(sent, snd_len), dest_num, popt);
+            size_t snd_len = (len > SMPP_PAYLOAD_MAX ? SMPP_PAYLOAD_MAX : len);
+            std::unique_lock<std::recursive_mutex> lock(sms_mutex);
+            if ( (ret = Wait_Window(lock)) < 0)
+                return ret;
+
+            ret = Submit(text.substr(sent, snd_len), dest_num, popt, 0, nullptr, row_id);
             if (ret < 0)
                 return ret;
 
@@ -298,56 +425,115 @@ int Sms::Send_Message(const std::string msg, const std::string dest_num,
 
 
 
+//===============================================================================|
+/**
+ * @brief Counts the window slots a message takes when sent by Send_Message;
+ *  that is, the submits it goes in.
+ * 
+ * @param msg the message
+ * @param poptions SMPP options controlling the specific message
+ * 
+ * @return size_t the number of submits, alas 0 with err_desc set when it can't
+ *  be sent
+ */
+size_t Sms::Count_Parts(const std::string_view msg, const Smpp_Options_Ptr poptions)
+{
+    SMS_LOCK;
+    std::string_view parts[SMPP_CONCAT_MAX];
+    std::string_view text{msg};
+    Smpp_Options coded;
+
+    Smpp_Options_Ptr popt = Encode(text, poptions == nullptr ? &options : poptions, coded);
+    if (concat_mode == CONCAT_PAYLOAD)
+        return (text.length() + SMPP_PAYLOAD_MAX - 1) / SMPP_PAYLOAD_MAX;
+
+    return Split(text, popt, parts);
+} // end Count_Parts
+
+
+
 //===============================================================================|
 /**
  * @brief Sends a single message to multiple parites, upto 254 as defined by the
- *  protocol. The function also trims messages that exceed 65,535 characters and
- *  sends them in batches one after the other.
+ *  protocol. A message too long for a single SMS goes in parts as Send_Message
+ *  sends them, each part to every destination; under CONCAT_PAYLOAD messages
+ *  that exceed 65,535 characters are sent in batches one after the other.
  * 
  * @param msg the message to send at once
  * @param dest_nums list of destination numbers
  * @param poptions various smpp based options for the specific message
+ * @param row_id the message's row in SmsOut, to report it under; 0 for none
  * 
  * @return int 0 on success alas -ve on fail.
  */
-int Sms::Send_Bulk_Message(const std::string msg, std::list<std::string> &dest_nums,
-    const Smpp_Options_Ptr poptions)
+int Sms::Send_Bulk_Message(const std::string_view msg, std::list<std::string> &dest_nums,
+    const Smpp_Options_Ptr poptions, const u32 row_id)
 {
     int ret;
-    size_t sent{0};
-    std::queue<std::string> dst;         // destination of 254 queues
+    size_t count{0};
+    std::string_view dst[SMPP_MULTI_DEST_MAX];      // one submit_multi's worth
+    std::string_view parts[SMPP_CONCAT_MAX];
+    std::string_view text{msg};
+    Smpp_Options coded;
+
+    Smpp_Options_Ptr popt = Encode(text, poptions == nullptr ? &options : poptions, coded);
+    if ( !(sms_state & SMS_BOUNDED))
+    {
+        snprintf(err_desc, MAXLINE, "Not authorized. Please Bind interface first.");
+        return -2;
+    } // end if not bounded
+
+    size_t part_count;
+    if ( (part_count = Split(text, popt, parts)) == 0)
+        return -2;
+
+    Concat_Info concat{0, (u8)(part_count > 1 ? part_count : 0), 0, concat_mode};
+    if (part_count > 1)
+    {
+        SMS_LOCK;
+        concat.ref = ++concat_ref;
+    } // end if in parts
 
-    for (std::string s : dest_nums)
+    for (auto it = dest_nums.begin(); it != dest_nums.end(); )
     {
-        if (s.length() > 20)
+        if (it->length() > 20)
         {
-            snprintf(err_desc, MAXLINE, "Invalid length. Number %s is too long.", s.c_str());
+            snprintf(err_desc, MAXLINE, "Invalid length. Number %s is too long.", it->c_str());
             return -2;
         } // end if dest num
 
-        dst.emplace(s);
-    } // end for
+        dst[count++] = *it++;
+        if (count < SMPP_MULTI_DEST_MAX && it != dest_nums.end())
+            continue;
 
-    Smpp_Options_Ptr popt = poptions == nullptr ? &options : poptions;
-    if ( sms_state & SMS_BOUNDED)
-    {
-        size_t len = msg.length();
-        while (len > 0)
+        // a full list of destinations or the last of them; send the message
+        //  to these in as many pieces as it takes
+        for (size_t i = 0; part_count > 1 && i < part_count; i++)
         {
-            size_t snd_len = (len > 65'534 ? 65'534 : len);
-            ret = Submit_Multi(msg.substr(sent, snd_len), dst, popt);
-            if (ret < 0)
+            std::unique_lock<std::recursive_mutex> lock(sms_mutex);
+            if ( (ret = Wait_Window(lock)) < 0)
                 return ret;
 
-            sent += snd_len;
-            len -= snd_len;
-        } // end while
-        
-        return 0;
-    } // end if bounded
+            concat.seqnum = (u8)(i + 1);
+            if ( (ret = Submit_Multi(parts[i], dst, count, popt, 0, &concat, row_id)) < 0)
+                return ret;
+        } // end for parts
 
-    snprintf(err_desc, MAXLINE, "Not authorized. Please Bind interface first.");
-    return -2;
+        for (size_t sent{0}; part_count == 1 && sent < text.length(); sent += SMPP_PAYLOAD_MAX)
+        {
+            std::unique_lock<std::recursive_mutex> lock(sms_mutex);
+            if ( (ret = Wait_Window(lock)) < 0)
+                return ret;
+
+            if ( (ret = Submit_Multi(text.substr(sent, SMPP_PAYLOAD_MAX), dst, count, popt, 0, 
+                nullptr, row_id)) < 0)
+                return ret;
+        } // end for
+
+        count = 0;
+    } // end for
+        
+    return 0;
 } // end Send_Bulk_Message
 
 
@@ -397,6 +583,132 @@ u32 Sms::Get_HB_Interval() const
 
 
 
+//===============================================================================|
+/**
+ * @brief Set's the size of the submit window; i.e. how many submit_sm's may be
+ *  outstanding awaiting their submit_sm_resp before senders are made to wait.
+ * 
+ * @param size the window size clamped to 1 ... SMPP_WINDOW_MAX
+ */
+void Sms::Set_Window(const u32 size)
+{
+    SMS_LOCK;
+    window_size = (size == 0 ? 1 : (size > SMPP_WINDOW_MAX ? SMPP_WINDOW_MAX : size));
+    window_cap = window_size;
+    window_cond.notify_all();
+} // end Set_Window
+
+
+
+//===============================================================================|
+/**
+ * @brief Returns the size of the submit window, as throttling has left it;
+ *  what's set by Set_Window while SMSC hasn't asked us to back off.
+ * 
+ * @return u32 the window size
+ */
+u32 Sms::Get_Window() const
+{
+    return window_cap;
+} // end Get_Window
+
+
+
+//===============================================================================|
+/**
+ * @brief Returns the number of submits waiting for a response from SMSC, and
+ *  of those throttled waiting to go again; the latter go before anything new.
+ * 
+ * @return u32 count of occupied window slots
+ */
+u32 Sms::Get_In_Flight() const
+{
+    SMS_LOCK;
+    return in_flight + held;
+} // end Get_In_Flight
+
+
+
+//===============================================================================|
+/**
+ * @brief Set's whether sending waits for room in the window. Whoever reads this
+ *  bind's responses mustn't wait on it, for nothing would open it; a reactor
+ *  turns it off and sends only as much as the window has room for.
+ * 
+ * @param wait true to wait, the default
+ */
+void Sms::Set_Wait(const bool wait)
+{
+    SMS_LOCK;
+    bwait = wait;
+} // end Set_Wait
+
+
+
+//===============================================================================|
+/**
+ * @brief Set's how long a submit may go without a response before it's sent
+ *  again, and how many times that is tried before giving up on the message.
+ *  A throttled submit waits no longer than that to go again either.
+ * 
+ * @param timeout the response timeout in milliseconds
+ * @param retries the number of resubmits allowed
+ */
+void Sms::Set_Resp_Timeout(const u32 timeout, const u8 retries)
+{
+    SMS_LOCK;
+    resp_timeout = timeout;
+    backoff = std::min<u32>(SMPP_THROTTLE_BACKOFF, timeout);
+    max_retries = retries;
+} // end Set_Resp_Timeout
+
+
+
+//===============================================================================|
+/**
+ * @brief Set's how messages too long for a single SMS are sent; SMSC's differ
+ *  in what they take.
+ * 
+ * @param mode one of CONCAT_*; anything else is taken as CONCAT_UDH8
+ */
+void Sms::Set_Concat(const u8 mode)
+{
+    SMS_LOCK;
+    concat_mode = mode > CONCAT_PAYLOAD ? CONCAT_UDH8 : mode;
+} // end Set_Concat
+
+
+
+//===============================================================================|
+/**
+ * @brief Returns how long messages are sent
+ * 
+ * @return u8 one of CONCAT_*
+ */
+u8 Sms::Get_Concat() const
+{
+    return concat_mode;
+} // end Get_Concat
+
+
+
+//===============================================================================|
+/**
+ * @brief Set's who to ask about receipts for messages this session didn't
+ *  send; a receiver bind gets the receipts for its pool's transmitters.
+ * 
+ * @param ppeers the pool; nullptr for a lone bind
+ * @param index the place of this bind in it
+ */
+void Sms::Set_Peers(SmsPeers *ppeers, const size_t index)
+{
+    SMS_LOCK;
+    this->ppeers = ppeers;
+    peer_index = index;
+} // end Set_Peers
+
+
+
 //===============================================================================|
 /**
  * @brief Returns the current state of the sms
@@ -485,46 +797,26 @@ void Sms::Toggle_Debug()
  */
 int Sms::Bind(const u32 command_id)
 {
+    SMS_LOCK;
     if ( !(sms_state & SMS_CONNECTED))
     {
         snprintf(err_desc, MAXLINE, "Interface is not connected to a network.");
         return -2;
     } // end if not connected
-    
-    char *alias{snd_buffer+sizeof(cmd_hdr)};
 
-    if (system_id.length() > 15 || pwd.length() > 8)
+    char *pdu;
+    if ( (pdu = Reserve_Pdu(Bind_Layout::max_len)) == nullptr)
+        return -1;
+
+    int len = Encode_Bind(pdu, snd_ring.Write_Space(), command_id, ++seq_num, 
+        system_id, pwd, options);
+    if (len < 0)
     {
         snprintf(err_desc, MAXLINE, "System id and/or password is too long.");
         return -2;
     } // end if no good length
 
-    iCpy(alias, system_id.c_str(), system_id.length());
-    alias += system_id.length();
-    *alias++ = 0x0;
-
-    // password, followed by system types
-    iCpy(alias, pwd.c_str(), pwd.length());
-    alias += pwd.length();
-    *alias++ = 0x0;
-
-    // service type, interface version, type of number and numbering plan indicator
-    *alias++ = options.service_type;
-    *alias++ = options.interface_ver;
-    *alias++ = options.src_ton;
-    *alias++ = options.src_npi;
-    *alias++ = 0x0;    // for address range
-
-    SET_PDU_HEADR(cmd_hdr, alias - snd_buffer, command_id, 0, ++seq_num);
-    iCpy(snd_buffer, &cmd_hdr, sizeof(cmd_hdr));
-
-    if ( tcp.Send(snd_buffer, alias - snd_buffer) < 0)
-        return -1;
-
-    if (bdebug)
-      Dump_Hex(snd_buffer, alias - snd_buffer);
-
-    return 0;
+    return Commit_Pdu(len);
 } // end Bind
 
 
@@ -556,6 +848,7 @@ int Sms::Outbind()
  */
 int Sms::Unbind()
 {
+    SMS_LOCK;
     if ( !(sms_state & SMS_BOUNDED))
     {
         snprintf(err_desc, MAXLINE, "Not authorized. Please Bind interface first.");
@@ -563,11 +856,8 @@ int Sms::Unbind()
     } // end if
     
     SET_PDU_HEADR(cmd_hdr, sizeof(cmd_hdr), unbind, 0, ++seq_num);
-    if ( tcp.Send((const char*)&cmd_hdr, sizeof(cmd_hdr)) < 0)
+    if (Send_Pdu((const char*)&cmd_hdr, sizeof(cmd_hdr)) < 0)
         return -1;
-    
-    if (bdebug)
-      Dump_Hex((const char*)&cmd_hdr, sizeof(cmd_hdr));
 
     return 0;
 } // end UnBind
@@ -584,6 +874,7 @@ int Sms::Unbind()
  */
 int Sms::Unbind_Resp(const u32 resp)
 {
+    SMS_LOCK;
     if ( !(sms_state & SMS_CONNECTED))
     {
         snprintf(err_desc, MAXLINE, "Not authorized. Please Bind interface first.");
@@ -591,12 +882,9 @@ int Sms::Unbind_Resp(const u32 resp)
     } // end if not connected
     
     SET_PDU_HEADR(cmd_hdr, sizeof(cmd_hdr), unbind_resp, resp, cmd_rsp.sequence_num);
-    if ( tcp.Send((const char*)&cmd_hdr, sizeof(cmd_hdr)) < 0)
+    if (Send_Pdu((const char*)&cmd_hdr, sizeof(cmd_hdr)) < 0)
         return -1;
 
-    if (bdebug)
-      Dump_Hex((const char*)&cmd_hdr, sizeof(cmd_hdr));
-
     return 0;
 } // end Unbind_Resp
 
@@ -612,12 +900,10 @@ int Sms::Unbind_Resp(const u32 resp)
  */
 int Sms::Generic_Nack()
 {
+    SMS_LOCK;
     SET_PDU_HEADR(cmd_hdr, sizeof(cmd_hdr), generic_nack, ESME_ROK, ++seq_num);
-    if ( tcp.Send((const char*)&cmd_hdr, sizeof(cmd_hdr)) < 0)
+    if (Send_Pdu((const char*)&cmd_hdr, sizeof(cmd_hdr)) < 0)
         return -1;
-
-    if (bdebug)
-        Dump_Hex((const char*)&cmd_hdr, sizeof(cmd_hdr));
     
     return 0;
 } // end Generic_Nack
@@ -634,150 +920,67 @@ int Sms::Generic_Nack()
  * @param dest_num phone num of the receipent
  * @param poptions SMPP options controlling the specific message
  * @param can_id 0 default to mean not canned (1-255 SMSC specific canned messages)
+ * @param pconcat when msg is a part of a longer message, its place in it
+ * @param row_id the message's row in SmsOut, to report it under; 0 for none
  * 
  * @return int 0 on success alas -ve on fail
  */
-int Sms::Submit(const std::string &msg, const std::string &dest_num,
-    const Smpp_Options_Ptr poptions, const u8 can_id)
+int Sms::Submit(const std::string_view msg, const std::string_view dest_num,
+    const Smpp_Options_Ptr poptions, const u8 can_id, const Concat_Info *pconcat, 
+    const u32 row_id)
 {
+    SMS_LOCK;
     if ( !(sms_state & SMS_BOUNDED))
     {
         snprintf(err_desc, MAXLINE, "Not authorized. Please Bind interface first.");
         return -2;
     } // end if not bounded
 
-    if (dest_num.length() > 20)
-    {
-        snprintf(err_desc, MAXLINE, "Buffer overflow. Destination number exceeds space.");
+    size_t prefix;
+    if ( (prefix = Submit_Prefix(poptions)) == 0)
         return -2;
-    } // end if dest num
-
-    char *alias{snd_buffer + sizeof(cmd_hdr)};
 
-    // skip over source_addr_ton, source_addr_npi, source_addr
-    *alias++ = poptions->service_type;    // the service type
-    *alias++ = poptions->src_ton;         // the source type of number
-    *alias++ = poptions->src_npi;         // the source numbering plan indicator
+    char *pdu;
+    if ( (pdu = Reserve_Pdu(SUBMIT_SM_MAX_LEN)) == nullptr)
+        return -1;
 
-    if (sms_id.length() == 0)
-        *alias++ = 0x0;
-    else
+    iCpy(pdu, submit_prefix, prefix);
+    int len = Encode_Submit_Sm(pdu, snd_ring.Write_Space(), prefix, seq_num + 1, 
+        *poptions, dest_num, msg, can_id, pconcat);
+    if (len < 0)
     {
-        iCpy(alias, sms_id.c_str(), sms_id.length());
-        alias += sms_id.length();
-        *alias++ = 0x0;
-    } // end else
-
-    *alias++ = poptions->dest_ton;   // dest ton
-    *alias++ = poptions->dest_npi;   // dest npi
-
-    // copy the dest addr aka phone no
-    iCpy(alias, dest_num.c_str(), dest_num.length());
-    alias += dest_num.length();
-    *alias++ = 0x0;
-
-    *alias++ = poptions->esm_class;           // esm class
-    *alias++ = 0x0;                         // prtocol id
-    *alias++ = poptions->priority_flag;       // priority flag
-
-    if (poptions->schedule_delivery_time.length() == 0)
-        *alias++ = 0x0;               // schedule delivery time
-    else 
-    {
-        if (poptions->schedule_delivery_time.length() > 16)
-        {
-            snprintf(err_desc, MAXLINE, "Invalid time format in delivery time");
-            return -2;
-        } // end if bad newz
+        snprintf(err_desc, MAXLINE, "Destination, times or message too long for submit_sm.");
+        return -2;
+    } // end if bad newz
 
-        iCpy(alias, poptions->schedule_delivery_time.c_str(), 
-            poptions->schedule_delivery_time.length());
-        alias += poptions->schedule_delivery_time.length();
-        *alias++ = 0x0;
-    } // end else scheduling
+    ++seq_num;
 
-    if (poptions->validity_period.length() == 0)
-      *alias++ = 0x0;               // default validty period
-    else 
-    {
-        if (poptions->validity_period.length() > 16)
-        {
-            snprintf(err_desc, MAXLINE, "Invalid time format in validty period.");
-            return -2;
-        } // end if bad newz
+    // queue it before sending; the response may well beat us back here
+    Single_Sms_Info info{MSG_STATE_SENT, "", std::string{msg}, std::string{dest_num}};
+    CPY_OPTIONS(info.opts, poptions);
+    info.row_id = row_id;
+    if (pconcat)
+        info.concat = *pconcat;
 
-        iCpy(alias, poptions->validity_period.c_str(), 
-            poptions->validity_period.length());
-        alias += poptions->validity_period.length();
-        *alias++ = 0x0;
-    } // end else set validity period
-    
-    *alias++ = poptions->registered_delivery; // require delivery reports
-    *alias++ = poptions->replace_present;     // replace existing
-    *alias++ = poptions->data_coding;         // data coding
-    *alias++ = can_id;                      // sm default message id (for canned messages)
-    
-    // skip these if we are processing canned messages
-    if (can_id == 0)
+    u32 slot;
+    if ( (slot = queued_msg.Find_Seq(seq_num)) != INFLIGHT_NPOS)
+        Drop_Stale(slot);       // the sequence has come round on it
+
+    if ( (slot = queued_msg.Add(seq_num, std::move(info))) == INFLIGHT_NPOS)
     {
-        u32 len = msg.length() + 1;
-        if (len < 255)
-        {
-            iCpy(alias++, (u8*)&len, sizeof(u8));
-            iCpy(alias, msg.c_str(), len - 1);
-            alias += len;
-            *alias = 0x0;
-        } // end if message less than 255 chars long
-        else 
-        {
-            // message exceeds 254 characters. Send as payload optional data
-            *alias = 0x0;
-            *alias = 0x0;
-
-            // send large messages as TLV data
-            u16 param = MESSAGE_PAYLOAD;
-            iCpy(alias, &param, sizeof(u16));   // the parameter
-            alias += sizeof(16);
-            param = htons(len);
-            iCpy(alias, &param, sizeof(u16));   // the length
-            alias += sizeof(u16);
-            iCpy(alias, msg.c_str(), len - 1);  // the value
-            alias += (len);
-            *alias++ = 0x0;
-        } // end else long message
-    } // end if not canned
-    else
+        snprintf(err_desc, MAXLINE, "Too many messages awaiting receipts.");
+        return -2;
+    } // end if full
+
+    queued_msg.Get(slot).timer = timers.Schedule(TIMER_KEY(TIMER_SUBMIT, slot), resp_timeout);
+    ++in_flight;
+    if (Commit_Pdu(len) < 0)
     {
-        // we are processing canned messages from SMSC;
-        //  skip over the message len and message
-        *alias = 0x0;
-        *alias = 0x0;
-    } // end else canned
-
-    // let's add a reference number to this message sent.
-    u16 param = USER_MESSAGE_REFERENCE;
-    iCpy(alias, &param, sizeof(u16));
-    alias += sizeof(u16);
-    param = htons(sizeof(u16));
-    iCpy(alias, &param, sizeof(u16));
-    alias += sizeof(u16);
-    param = htons(++seq_num);
-    iCpy(alias, &param, sizeof(u16));
-    alias += sizeof(u16);
-
-    SET_PDU_HEADR(cmd_hdr, alias - snd_buffer, submit_sm, 0, seq_num);
-    iCpy(snd_buffer, &cmd_hdr, sizeof(cmd_hdr));
-
-    if ( tcp.Send(snd_buffer, alias - snd_buffer) < 0)
+        Forget(slot);
+        --in_flight;
         return -1;
+    } // end if
 
-    Single_Sms_Info info{MSG_STATE_SENT, "", msg, dest_num};
-    CPY_OPTIONS(info.opts, poptions);
-    queued_msg.emplace(ntohl(cmd_hdr.sequence_num), info);
-
-    if (bdebug)
-      Dump_Hex(snd_buffer, alias - snd_buffer);
-    
     return 0;
 } // end Submit
 
@@ -814,154 +1017,95 @@ int Sms::Submit(const std::string &msg, const std::string &dest_num,
  *  clients at once, upto 254 as defined by the protocol.
  * 
  * @param msg the message to send
- * @param dest_nums queue of destination numbers
+ * @param dest_nums the destination numbers
+ * @param dest_count the count of destinations; 1 to 254
  * @param poptions SMPP options controlling the specific message
  * @param can_id canned id if not 0
+ * @param pconcat when msg is a part of a longer message, its place in it
+ * @param row_id the message's row in SmsOut, to report it under; 0 for none
  * 
  * @return int 0 on success, -ve on fail.
  */
-int Sms::Submit_Multi(const std::string &msg, std::queue<std::string> dest_nums, 
-    const Smpp_Options_Ptr poptions, const u8 can_id)
+int Sms::Submit_Multi(const std::string_view msg, const std::string_view *dest_nums, 
+    const size_t dest_count, const Smpp_Options_Ptr poptions, const u8 can_id,
+    const Concat_Info *pconcat, const u32 row_id)
 {
-    char *alias{snd_buffer + sizeof(cmd_hdr)};
-    size_t len = dest_nums.size();
-
-    while ( len > 0)
+    SMS_LOCK;
+    if ( !(sms_state & SMS_BOUNDED))
     {
-        if (sms_state & SMS_BOUNDED)
-        {
-            // skip over source_addr_ton, source_addr_npi, source_addr
-            *alias++ = poptions->service_type;   // the service type
-            alias += 3;
+        snprintf(err_desc, MAXLINE, "Not authorized. Please Bind interface first.");
+        return -2;
+    } // end if not bounded
 
-            // set the number of dests for this round
-            u8 cpy_len = (len > 254 ? 254 : 254 - len);
-            *alias++ = cpy_len;
+    size_t prefix;
+    if ( (prefix = Submit_Prefix(poptions)) == 0)
+        return -2;
 
-            // SME Struct'ish'
-            for (u8 index = 0; index < cpy_len; index++)
-            {
-                std::string dest_num = dest_nums.front();
-                dest_nums.pop();
+    char *pdu;
+    if ( (pdu = Reserve_Pdu(SUBMIT_MULTI_MAX_LEN)) == nullptr)
+        return -1;
 
-                *alias++ = DL_SME_ADDRESS;    // always use sme address
-                *alias++ = poptions->dest_ton;   // dest ton
-                *alias++ = poptions->dest_npi;   // dest npi
+    iCpy(pdu, submit_prefix, prefix);
+    int len = Encode_Submit_Multi(pdu, snd_ring.Write_Space(), prefix, seq_num + 1,
+        *poptions, dest_nums, dest_count, msg, can_id, pconcat);
+    if (len < 0)
+    {
+        snprintf(err_desc, MAXLINE, "Destinations, times or message too long for submit_multi.");
+        return -2;
+    } // end if bad newz
 
-                // copy the dest addr aka phone no
-                iCpy(alias, dest_num.c_str(), dest_num.length());
-                alias += (dest_num.length() + 1);
-            } // end for
+    ++seq_num;
 
-            *(alias++) = poptions->esm_class;           // esm class
-            *(alias++) = 0x0;                 // prtocol id
-            *(alias++) = poptions->priority_flag;       // priority flag
+    Bulk_Sms_Info info{MSG_STATE_SENT, "", std::string{msg}};
+    for (size_t i = 0; i < dest_count; i++)
+        info.dst.emplace(dest_nums[i]);
 
-            if (poptions->schedule_delivery_time.length() == 0)
-                *(alias++) = 0x0;               // schedule delivery time
-            else 
-            {
-                if (poptions->schedule_delivery_time.length() > 16)
-                {
-                    snprintf(err_desc, MAXLINE, "Invalid time format in delivery time.");
-                    return -2;
-                } // end if bad newz
-
-                iCpy(alias, poptions->schedule_delivery_time.c_str(), 
-                    poptions->schedule_delivery_time.length());
-                alias += (poptions->schedule_delivery_time.length() + 1);
-            } // end else scheduling
-
-            if (poptions->validity_period.length() == 0)
-                *(alias++) = 0x0;               // default validty period
-            else 
-            {
-                if (poptions->validity_period.length() > 16)
-                {
-                    snprintf(err_desc, MAXLINE, "Invalid time format in validity period");
-                    return -2;
-                } // end if bad newz
-
-                iCpy(alias, poptions->validity_period.c_str(), 
-                    poptions->validity_period.length());
-                alias += (poptions->validity_period.length() + 1);
-            } // end else set validity period
-
-            *(alias++) = poptions->registered_delivery; // require delivery reports
-            *(alias++) = poptions->replace_present;     // replace existing
-            *(alias++) = poptions->data_coding;         // data coding
-            *(alias++) = can_id;              // sm default message id (for canned messages)
-
-            // skip these if we are processing canned messages
-            if (can_id == 0)
-            {
-                u16 msg_len = (u16)msg.length() + 1;
-                if (msg_len < 255)
-                {
-                    iCpy(alias++, (u8*)&msg_len, sizeof(u8));
-                    iCpy(alias, msg.c_str(), msg_len - 1);
-                    alias += (msg_len + 1);
-                } // end if message less than 255 chars long
-                else 
-                {
-                    // message exceeds 254 characters. Send as payload optional data
-                    alias += 2;
-
-                    // trim the message if it exceeds unreasonably
-                    u16 param = MESSAGE_PAYLOAD;
-                    iCpy(alias, &param, sizeof(u16));   // the parameter
-                    alias += sizeof(u16);
-                    param = htons(msg_len);
-                    iCpy(alias, &param, sizeof(u16)); // the length
-                    alias += sizeof(u16);
-                    iCpy(alias, msg.c_str(), msg_len - 1);  // the value
-                    alias += (msg_len + 1);
-                } // end else long message
-            } // end if not canned
-            else
-            {
-              // we are processing canned messages from SMSC;
-              //  skip over the message len and message
-              alias += 2;
-            } // end else canned
-
-            // let's add a reference number to this message sent.
-            u16 param = USER_MESSAGE_REFERENCE;
-            iCpy(alias, &param, sizeof(u16));
-            alias += sizeof(u16);
-            param = sizeof(u16);
-            iCpy(alias, &param, sizeof(u16));
-            alias += sizeof(u16);
-            param = htons(++seq_num);
-            iCpy(alias, &param, sizeof(u16));
-            alias += sizeof(u16);
-
-            SET_PDU_HEADR(cmd_hdr, alias - snd_buffer, submit_multi, 0, seq_num);
-            iCpy(snd_buffer, &cmd_hdr, sizeof(cmd_hdr));
-
-            if ( tcp.Send(snd_buffer, alias - snd_buffer) < 0)
-                return -1;
+    CPY_OPTIONS(info.opts, poptions);
+    info.row_id = row_id;
+    info.timer = timers.Schedule(TIMER_KEY(TIMER_MULTI, seq_num), resp_timeout);
+    queued_blk_msg[seq_num] = std::move(info);
+    ++in_flight;
 
-            Bulk_Sms_Info info{MSG_STATE_SENT, "", msg, dest_nums};
-            CPY_OPTIONS(info.opts, poptions);
-            queued_blk_msg.emplace(ntohl(cmd_hdr.sequence_num), info);
+    if (Commit_Pdu(len) < 0)
+    {
+        timers.Cancel(queued_blk_msg[seq_num].timer);
+        queued_blk_msg.erase(seq_num);
+        --in_flight;
+        return -1;
+    } // end if
 
-            if (bdebug)
-              Dump_Hex(snd_buffer, alias - snd_buffer);
+    return 0;
+} // end Submit_Multi
 
-            return 0;
-        } // end if bounded
-        else 
-        {
-            snprintf(err_desc, MAXLINE, "Not authorized. Please Bind interface first.");
-            return -2;
-        } // end else
 
-        len -= 254;
-    } // end while
 
-    return 0;
-} // end Submit_Multi
+//===============================================================================|
+/**
+ * @brief Returns the encoded leading fields of a submit for the options given,
+ *  (re)building them only when the options differ from those it was last built
+ *  for. In practice every submit on a bind shares the same prefix.
+ * 
+ * @param popts the options of the message being submitted
+ * 
+ * @return size_t the length of submit_prefix; 0 when the source address is too
+ *  long, with err_desc set.
+ */
+size_t Sms::Submit_Prefix(const Smpp_Options_Ptr popts)
+{
+    u32 key = (1u << 24) | (popts->service_type << 16) | (popts->src_ton << 8) | popts->src_npi;
+    if (prefix_len > 0 && key == prefix_key)
+        return prefix_len;
+
+    if ( (prefix_len = Encode_Submit_Prefix(submit_prefix, sizeof(submit_prefix), 
+        *popts, sms_id)) == 0)
+    {
+        snprintf(err_desc, MAXLINE, "Source address too long.");
+        return 0;
+    } // end if
+
+    prefix_key = key;
+    return prefix_len;
+} // end Submit_Prefix
 
 
 
@@ -976,127 +1120,110 @@ int Sms::Submit_Multi(const std::string &msg, std::queue<std::string> dest_nums,
  * 
  * @return int 0 on success, -ve on fail
  */
-int Sms::Query(const std::string &msg_id, const Smpp_Options_Ptr poptions, 
-    const std::string src_addr)
+int Sms::Query(const std::string_view msg_id, const Smpp_Options_Ptr poptions, 
+    const std::string_view src_addr)
 {
+    SMS_LOCK;
     if ( !(sms_state & SMS_BOUNDED))
         return -2;
 
-    char *alias{snd_buffer + sizeof(cmd_hdr)};
+    char *pdu;
+    if ( (pdu = Reserve_Pdu(Query_Layout::max_len)) == nullptr)
+        return -1;
 
-    // skip over source_addr_ton, source_addr_npi, source_addr
-    if (msg_id.length() > 64)
+    int len = Encode_Query_Sm(pdu, snd_ring.Write_Space(), seq_num + 1, msg_id, 
+        *poptions, src_addr);
+    if (len < 0)
     {
-        snprintf(err_desc, MAXLINE, "Invalid msg id to query %s", msg_id.c_str());
+        snprintf(err_desc, MAXLINE, "Invalid msg id to query %.*s", 
+            (int)msg_id.length(), msg_id.data());
         return -2;
     } // end if
 
-    iCpy(alias, msg_id.c_str(), msg_id.length());
-    alias += msg_id.length();
-    *alias++ = 0x0;
-    
-    *alias = poptions->src_ton;
-    *alias = poptions->src_npi;
-
-    if (src_addr.length() == 0)
-        *alias++ = 0x0;
-    else
-    {
-        iCpy(alias, src_addr.c_str(), src_addr.length());
-        alias += src_addr.length();
-        *alias++ = 0x0;
-    } // end else
-
-    SET_PDU_HEADR(cmd_hdr, alias - snd_buffer, query_sm, 0, ++seq_num);
-    iCpy(snd_buffer, &cmd_hdr, sizeof(cmd_hdr));
-    if ( tcp.Send(snd_buffer, alias - snd_buffer) < 0)
-        return -1;
-
-    if (bdebug)
-        Dump_Hex(snd_buffer, alias - snd_buffer);
-    
-    return 0;
+    ++seq_num;
+    return Commit_Pdu(len);
 } // end Query
 
 
 
 //===============================================================================|
 /**
- * @brief Handles a query response singal and takes on realtime actions based on
- *  the message feild shown
+ * @brief Handles the response to a query_sm we sent when a receipt was late. A
+ *  message in a final state is reported and forgotten; one that's still on its
+ *  way is asked about again after SMPP_QUERY_INTERVAL, up to max_retries times.
  * 
- * @param buffer the buffer containing the extra info
- * @param len length of buffer above
+ * @param pdu the query_sm_resp as it sits in the receive ring
+ * @param pdu_len its command_length
+ * @param err used to get error descriptions as a result of this call
+ * @param buf_len the length of buffer for storage
  * 
  * @return int 0 on success alias -ve. 
  */
-int Sms::Handle_Query(char *err, const size_t buf_len)
+int Sms::Handle_Query(const char *pdu, const size_t pdu_len, char *err, const size_t buf_len)
 {
-    if (cmd_rsp.command_status == ESME_ROK)
-    {
-        // skipping over msg_id and final_date
-        const char *alias = rcv_buffer + sizeof(cmd_hdr) + strlen(rcv_buffer);
-        std::string final_date = alias;
-        alias += final_date.length();
+    u32 slot = queued_msg.Find_Seq(cmd_rsp.sequence_num);
+    if (slot != INFLIGHT_NPOS && queued_msg.Get(slot).msg_state != MSG_STATE_QUERIED)
+        slot = INFLIGHT_NPOS;   // not one of our queries
 
-        // check the message states
-        switch (*((const u8 *)alias))
-        {
-            case SMPP_DELIVERED:
-            {
-                auto it = queued_msg.find(cmd_rsp.sequence_num);
-                if (it != queued_msg.end())
-                {
-                    queued_msg.erase(cmd_rsp.sequence_num);
+    if (cmd_rsp.command_status != ESME_ROK)
+    {
+        if (slot != INFLIGHT_NPOS)
+            Forget(slot, MSG_STATE_EXPIRED);    // SMSC no longer knows of it
 
-                    // signal db to update
+        snprintf(err, buf_len, "Handle_Query returned error: 0x%08X.\n", 
+            cmd_rsp.command_status);
 
-                    return 0;
-                } // end if
+        return -2;
+    } // end if
 
-                auto it2 = queued_blk_msg.find(cmd_rsp.sequence_num);
-                if (it2 != queued_blk_msg.end())
-                {
-                    queued_blk_msg.erase(cmd_hdr.sequence_num);
+    Query_Resp_Pdu rsp;
+    if (Decode_Query_Resp(pdu, pdu_len, rsp) < 0)
+    {
+        snprintf(err, buf_len, "Malformed query_sm_resp from SMSC.");
+        return -2;
+    } // end if
 
-                    // signal
+    if (slot == INFLIGHT_NPOS)
+        return 0;
 
-                    return 0;
-                } // end if
-            } break;
+    // check the message states
+    switch (rsp.message_state)
+    {
+        case SMPP_DELIVERED:
+            Forget(slot, MSG_STATE_DELIVERED);
+            break;
+
+        case SMPP_EXPIRED:
+            Forget(slot, MSG_STATE_EXPIRED);
+            break;
+
+        case SMPP_DELETED:
+        case SMPP_UNDLIVERABLE:
+        case SMPP_UNKOWN:
+        case SMPP_REJECTED:
+        {
+            snprintf(err, buf_len, 
+                "Message %s is either deleted, undliverable, invalid, or rejected. "
+                "Error code = %d", queued_msg.Get(slot).id.c_str(), rsp.error_code);
+            Forget(slot, MSG_STATE_FAILED);
+            return -2;
+        } break;
 
-            case SMPP_EXPIRED:
-            case SMPP_DELETED:
-            case SMPP_UNDLIVERABLE:
-            case SMPP_UNKOWN:
-            case SMPP_REJECTED:
+        default:
+        {
+            // still enroute; give it some more time
+            Single_Sms_Info &info = queued_msg.Get(slot);
+            if (++info.retries > max_retries)
             {
-                auto it = queued_msg.find(cmd_rsp.sequence_num);
-                if (it != queued_msg.end())
-                    queued_msg.erase(cmd_rsp.sequence_num);
-
-                if (it == queued_msg.end())
-                {
-                    auto it2 = queued_blk_msg.find(cmd_rsp.sequence_num);
-                    if (it2 != queued_blk_msg.end())
-                        queued_blk_msg.erase(cmd_rsp.sequence_num);
-
-                    snprintf(err, buf_len, 
-                        "Message is either deleted, expired, undliverable, \
-                        invalid, or rejected. Error code = %d", *((const u8 *)alias));
-                } // end if not from single
-                return -2;
-            } break;
-
-        } // end switch
-    } // end if
-    else
-    {
-        snprintf(err, buf_len, "Handle_Query returned error: 0x%08X.\n", 
-            cmd_rsp.command_status);
+                Forget(slot, MSG_STATE_EXPIRED);
+                break;
+            } // end if given up
 
-        return -2;
-    } // end else
+            info.msg_state = MSG_STATE_SUBMIT;
+            info.timer = timers.Schedule(TIMER_KEY(TIMER_RECEIPT, slot), 
+                (u64)SMPP_QUERY_INTERVAL * 1000);
+        } break;
+    } // end switch
 
     return 0;
 } // end Query_Rsp
@@ -1113,43 +1240,30 @@ int Sms::Handle_Query(char *err, const size_t buf_len)
  * 
  * @return int 0 on success alas -ve
  */
-int Sms::Cancel(const std::string msg_id, const Smpp_Options_Ptr popts, 
-    const std::string src_addr)
+int Sms::Cancel(const std::string_view msg_id, const Smpp_Options_Ptr popts, 
+    const std::string_view src_addr)
 {
+    SMS_LOCK;
     if (!(sms_state & SMS_BOUNDED))
     {
         snprintf(err_desc, MAXLINE, "Not authorized. Please Bind interface first.");
         return -2;
     } // end if not bounded
 
-    char *alias{snd_buffer + sizeof(cmd_hdr)};
-
-    *alias++ = popts->service_type;
-    iCpy(alias, msg_id.c_str(), msg_id.length());
-    alias += msg_id.length();
-    *alias++ = 0x0;
-
-    *alias++ = popts->src_ton;
-    *alias++ = popts->src_npi;
-    iCpy(alias, src_addr.c_str(), src_addr.length());
-    alias += src_addr.length();
-    *alias++ = 0x0;
-
-    *alias++ = popts->dest_ton;
-    *alias++ = popts->dest_npi;
-    *alias = 0x0;       // null dests since we've message id
-
-    SET_PDU_HEADR(cmd_hdr, (alias - snd_buffer), cancel_sm, 
-        ESME_ROK, ++seq_num);
-    iCpy(snd_buffer, &cmd_hdr, sizeof(cmd_hdr));
-
-    if ( tcp.Send(snd_buffer, alias - snd_buffer) < 0)
+    char *pdu;
+    if ( (pdu = Reserve_Pdu(Cancel_Layout::max_len)) == nullptr)
         return -1;
 
-    if (bdebug)
-        Dump_Hex(snd_buffer, alias - snd_buffer);
+    int len = Encode_Cancel_Sm(pdu, snd_ring.Write_Space(), seq_num + 1, msg_id, 
+        *popts, src_addr);
+    if (len < 0)
+    {
+        snprintf(err_desc, MAXLINE, "Message id or source address too long to cancel.");
+        return -2;
+    } // end if
 
-    return 0;
+    ++seq_num;
+    return Commit_Pdu(len);
 } // end Cancel
 
 
@@ -1166,52 +1280,30 @@ int Sms::Cancel(const std::string msg_id, const Smpp_Options_Ptr popts,
  * 
  * @return int 0 on success alas -1 on fai;/ 
  */
-int Sms::Replace(const std::string msg_id, const Smpp_Options_Ptr popts, 
-    const std::string msg, const std::string src_addr)
+int Sms::Replace(const std::string_view msg_id, const Smpp_Options_Ptr popts, 
+    const std::string_view msg, const std::string_view src_addr)
 {
+    SMS_LOCK;
     if (!(sms_state & SMS_BOUNDED))
     {
         snprintf(err_desc, MAXLINE, "Not authorized. Please Bind interface first.");
         return -2;
     } // end if not bounded
 
-    char *alias{snd_buffer + sizeof(cmd_hdr)};
-
-    iCpy(alias, msg_id.c_str(), msg_id.length());
-    alias += msg_id.length();
-    *alias++ = 0x0;
-
-    *alias++ = popts->src_ton;
-    *alias++ = popts->src_npi;
-    iCpy(alias, src_addr.c_str(), src_addr.length());
-    alias += src_addr.length();
-    *alias++ = 0x0;
-
-    iCpy(alias, popts->schedule_delivery_time.c_str(), popts->schedule_delivery_time.length());
-    alias += popts->schedule_delivery_time.length();
-    *alias++ = 0x0;
-
-    iCpy(alias, popts->validity_period.c_str(), popts->validity_period.length());
-    alias += popts->validity_period.length();
-    *alias++ = 0x0;
-
-    *alias++ = popts->registered_delivery;
-    *alias++ = 0;
-    *alias++ = msg.length();
-    iCpy(alias, msg.c_str(), msg.length());
-    *alias = 0x0;
-
-    SET_PDU_HEADR(cmd_hdr, (alias - snd_buffer), replace_sm, 
-        ESME_ROK, ++seq_num);
-    iCpy(snd_buffer, &cmd_hdr, sizeof(cmd_hdr));
-
-    if ( tcp.Send(snd_buffer, alias - snd_buffer) < 0)
+    char *pdu;
+    if ( (pdu = Reserve_Pdu(Replace_Layout::max_len)) == nullptr)
         return -1;
 
-    if (bdebug)
-        Dump_Hex(snd_buffer, alias - snd_buffer);
-    
-    return 0;
+    int len = Encode_Replace_Sm(pdu, snd_ring.Write_Space(), seq_num + 1, msg_id, 
+        *popts, msg, src_addr);
+    if (len < 0)
+    {
+        snprintf(err_desc, MAXLINE, "Message id, times or message too long to replace.");
+        return -2;
+    } // end if
+
+    ++seq_num;
+    return Commit_Pdu(len);
 } // end Replace
 
 
@@ -1224,6 +1316,7 @@ int Sms::Replace(const std::string msg_id, const Smpp_Options_Ptr popts,
  */
 int Sms::Enquire()
 {
+    SMS_LOCK;
     if ( !(sms_state & SMS_BOUNDED))
     {
         snprintf(err_desc, MAXLINE, "Not authorized. Please Bind interface first.");
@@ -1231,12 +1324,9 @@ int Sms::Enquire()
     } // end if not connected
 
     SET_PDU_HEADR(cmd_hdr, sizeof(cmd_hdr), enquire_link, 0, ++seq_num);
-    if ( tcp.Send((const char*)&cmd_hdr, sizeof(cmd_hdr)) < 0)
+    if (Send_Pdu((const char*)&cmd_hdr, sizeof(cmd_hdr)) < 0)
         return -1;
 
-    if (bdebug)
-      Dump_Hex((const char*)&cmd_hdr, sizeof(cmd_hdr));
-
     return 0;
 } // end Enquire
 
@@ -1253,18 +1343,16 @@ int Sms::Enquire()
  */
 int Sms::Enquire_Rsp(const u32 resp)
 {
+    SMS_LOCK;
     if ( !(sms_state & SMS_BOUNDED))
         return -2;
 
     SET_PDU_HEADR(cmd_hdr, sizeof(cmd_hdr), enquire_link_resp, resp, 
         cmd_hdr.sequence_num);
 
-    if ( tcp.Send((const char*)&cmd_hdr, sizeof(cmd_hdr)) < 0)
+    if (Send_Pdu((const char*)&cmd_hdr, sizeof(cmd_hdr)) < 0)
         return -1;
 
-    if (bdebug)
-      Dump_Hex((const char*)&cmd_hdr, sizeof(cmd_hdr));
-
     return 0;
 } // end Enquire_Rsp
 
@@ -1281,47 +1369,286 @@ int Sms::Enquire_Rsp(const u32 resp)
  */
 int Sms::Deliver_Rsp(const u32 resp)
 {
+    SMS_LOCK;
     if ( !(sms_state & SMS_BOUNDED))
         return -2;
     
-    iZero(snd_buffer, sizeof(cmd_hdr) + 1);
-    SET_PDU_HEADR(cmd_hdr, sizeof(cmd_hdr) + 1, deliver_sm_resp, 
-        resp, cmd_hdr.sequence_num);
-
-    iCpy(snd_buffer, (char *)&cmd_hdr, sizeof(cmd_hdr));
-    if ( tcp.Send(snd_buffer, sizeof(cmd_hdr) + 1) < 0)
+    char *pdu;
+    if ( (pdu = Reserve_Pdu(Deliver_Rsp_Layout::max_len)) == nullptr)
         return -1;
 
-    return 0;
+    return Commit_Pdu(Encode_Deliver_Rsp(pdu, snd_ring.Write_Space(), cmd_rsp.sequence_num, resp));
 } // end Deliver_Rsp
 
 
 
 //===============================================================================|
 /**
- * @brief Processes incomming messages using a switch table. This is fired on async
- *  and in realtime as messages arrive.
- *  The function persumes that cmd_rsp now store's the responses as sent from
- *  the connected SMCS and they are arranged in the host-byte-order.
+ * @brief Holds back writing to SMSC; PDUs keep piling up in the send ring until
+ *  the matching Uncork, or until SMS_FLUSH_BYTES of them are waiting. Calls nest.
+ * 
+ */
+void Sms::Cork()
+{
+    SMS_LOCK;
+    ++corked;
+} // end Cork
+
+
+
+//===============================================================================|
+/**
+ * @brief Undoes a Cork; the last one writes out whatever has piled up meanwhile.
+ * 
+ * @return int 0 on success alas -1 on socket error
+ */
+int Sms::Uncork()
+{
+    SMS_LOCK;
+    if (corked > 0 && --corked > 0)
+        return 0;
+
+    return Flush();
+} // end Uncork
+
+
+
+//===============================================================================|
+/**
+ * @brief Writes the send ring out to SMSC, all of it in as few send() calls as
+ *  the socket would take. Should the socket fill up, what's left is kept in the
+ *  ring to be written the next time the socket is ready for it (EPOLLOUT).
+ * 
+ * @return int 0 on success or when the rest must wait, -1 on socket error
+ */
+int Sms::Flush()
+{
+    SMS_LOCK;
+    while (snd_ring.Size() > 0)
+    {
+        int n;
+        if ( (n = tcp.Send(snd_ring.Read_Ptr(), snd_ring.Size())) < 0)
+            return -1;
+
+        if (n == 0)
+            break;      // socket is full; EPOLLOUT gets the rest
+
+        snd_ring.Consume(n);
+    } // end while
+
+    return 0;
+} // end Flush
+
+
+
+//===============================================================================|
+/**
+ * @brief Makes room for a PDU of up to len bytes at the tail of the send ring,
+ *  writing out what's already queued to get it. Only when the socket won't take
+ *  any of that do we wait on it, for at most SMS_SEND_TIMEOUT.
+ * 
+ * @param len the most the PDU could take up
  * 
- * @param buffer buffer containing any extra info depending on the message type
- * @param len length of the extra info above
- * @return int 
+ * @return char* where to encode the PDU alas nullptr on error; with err_desc set
+ *  when SMSC stopped reading altogether
+ */
+char *Sms::Reserve_Pdu(const size_t len)
+{
+    for (;;)
+    {
+        char *p = snd_ring.Write_Ptr();
+        if (snd_ring.Write_Space() >= len)
+            return p;
+
+        const size_t before = snd_ring.Size();
+        if (Flush() < 0)
+            return nullptr;
+
+        if (snd_ring.Size() < before)
+            continue;   // some went out; see if that's enough
+
+        struct pollfd pfd{tcp.Get_Socket(), POLLOUT, 0};
+        int n;
+        while ( (n = POLL_TIMEOUT(&pfd, 1, SMS_SEND_TIMEOUT)) < 0 && errno == EINTR);
+        if (n < 0)
+            return nullptr;
+
+        if (n == 0)
+        {
+            snprintf(err_desc, MAXLINE, "SMSC hasn't read anything for %d ms.", SMS_SEND_TIMEOUT);
+            return nullptr;
+        } // end if timeout
+    } // end for ever
+} // end Reserve_Pdu
+
+
+
+//===============================================================================|
+/**
+ * @brief Queues the PDU just encoded at Reserve_Pdu for sending. It goes out
+ *  right away unless the bind is corked, in which case it waits for the rest of
+ *  the batch.
+ * 
+ * @param len the encoded length; the encoders return -ve when it didn't fit
+ * 
+ * @return int 0 on success, -1 on socket error and -2 on a bad PDU
+ */
+int Sms::Commit_Pdu(const int len)
+{
+    if (len < 0)
+    {
+        snprintf(err_desc, MAXLINE, "PDU doesn't fit its layout.");
+        return -2;
+    } // end if
+
+    snd_ring.Commit(len);
+    if (bdebug)
+    {
+        Dump_Hex(snd_ring.Read_Ptr() + snd_ring.Size() - len, len);
+    } // end if
+
+    if (corked == 0 || snd_ring.Size() >= SMS_FLUSH_BYTES)
+        return Flush();
+
+    return 0;
+} // end Commit_Pdu
+
+
+
+//===============================================================================|
+/**
+ * @brief Queues an already encoded PDU for sending; e.g. the header only ones.
+ * 
+ * @param pdu the PDU
+ * @param len its length
+ * 
+ * @return int 0 on success, -1 on socket error
+ */
+int Sms::Send_Pdu(const char *pdu, const size_t len)
+{
+    char *p;
+    if ( (p = Reserve_Pdu(len)) == nullptr)
+        return -1;
+
+    iCpy(p, pdu, len);
+    return Commit_Pdu((int)len);
+} // end Send_Pdu
+
+
+
+//===============================================================================|
+/**
+ * @brief Drains the SMSC socket into the receive ring and dispatches every
+ *  complete PDU found there. Whatever the handlers send back in the meantime,
+ *  the responses to deliver_sm's and any resubmits, is corked and written out
+ *  in one go once the socket is drained.
+ * 
+ * @param err buffer to get application error descriptions
+ * @param buf_len length of the buffer above
+ * 
+ * @return int 0 on success, -1 on socket error/disconnect and -2 when one or
+ *  more PDUs failed with err describing the last of them.
  */
 int Sms::Process_Incoming(char *err, const size_t buf_len)
 {
-    // let's get ready to handle this sms message, we'll do it in two parts, first
-    //  we read the command header struct, followed by any extra data.
-    iZero((char *)&cmd_rsp, sizeof(cmd_rsp));
-    int n = tcp.Recv(rcv_buffer, SMS_BUFFER_SIZE);
-    if (n < 0)
-        return n;
+    Cork();
+    int ret = Read_Pdus(err, buf_len);
+    if (Uncork() < 0)
+        return -1;
+
+    return ret;
+} // end Process_Incoming
+
+
+
+//===============================================================================|
+/**
+ * @brief Does the reading for Process_Incoming. SMPP is a stream of length
+ *  prefixed PDUs; one read may carry many of them coalesced or only part of
+ *  one, so the stream is split on command_length and any partial tail is left
+ *  in the ring for the next readiness event.
+ * 
+ * @param err buffer to get application error descriptions
+ * @param buf_len length of the buffer above
+ * 
+ * @return int same as Process_Incoming
+ */
+int Sms::Read_Pdus(char *err, const size_t buf_len)
+{
+    int n;              // bytes read at one stroke
+    int ret{0};         // the overall return value
+
+    for (;;)
+    {
+        if ( (n = tcp.Recv(rcv_ring.Write_Ptr(), rcv_ring.Write_Space())) < 0)
+            return -1;
+        
+        if (n == 0)
+            break;      // socket is drained
 
-    iCpy(&cmd_rsp, rcv_buffer, sizeof(cmd_rsp));
+        rcv_ring.Commit(n);
+
+        // now walk over every complete PDU sitting in the ring
+        while (rcv_ring.Size() >= SMPP_HDR_LEN)
+        {
+            u32 pdu_len;
+            iCpy(&pdu_len, rcv_ring.Read_Ptr(), sizeof(u32));
+            pdu_len = ntohl(pdu_len);
+
+            if (pdu_len < SMPP_HDR_LEN || pdu_len > SMPP_MAX_PDU_LEN)
+            {
+                // we have lost track of the stream; nothing after this can be
+                //  trusted so start over.
+                snprintf(err, buf_len, "Invalid command_length %u from SMSC.", pdu_len);
+                rcv_ring.Reset();
+                Generic_Nack();
+                return -2;
+            } // end if broken stream
+
+            if (rcv_ring.Size() < pdu_len)
+                break;      // partial PDU; wait for the rest of it
+
+            // the PDU is decoded right where it sits; it's consumed only
+            //  after dispatch as the decoded fields point into it
+            int r = Dispatch_Pdu(rcv_ring.Read_Ptr(), pdu_len, err, buf_len);
+            rcv_ring.Consume(pdu_len);
+            if (r < 0)
+            {
+                if (r != -2)
+                    return r;
+
+                ret = -2;   // remember it, but keep going with the rest
+            } // end if
+        } // end while framing
+    } // end for ever
+
+    return ret;
+} // end Read_Pdus
+
+
+
+//===============================================================================|
+/**
+ * @brief Processes a single framed PDU using a switch table. The PDU is read in
+ *  place from the receive ring; its header is converted into host-byte-order at
+ *  cmd_rsp before acting on it and the body is decoded by the handlers into
+ *  views over the ring, so only what must outlive the PDU gets copied.
+ * 
+ * @param pdu the PDU, header and all
+ * @param pdu_len its command_length; already checked by the framing
+ * @param err buffer to get application error descriptions
+ * @param buf_len length of the buffer above
+ * 
+ * @return int 0 on success, -ve on fail.
+ */
+int Sms::Dispatch_Pdu(const char *pdu, const size_t pdu_len, char *err, const size_t buf_len)
+{
+    SMS_LOCK;
+    iCpy(&cmd_rsp, pdu, sizeof(cmd_rsp));
     HOST_ENDIAN(cmd_rsp);
     if (bdebug)
     {
-        Dump_Hex(rcv_buffer, n);
+        Dump_Hex(pdu, pdu_len);
     } // end if
 
 
@@ -1334,9 +1661,12 @@ int Sms::Process_Incoming(char *err, const size_t buf_len)
         case bind_receiver_resp:
         case bind_transceiver_resp:
         {
-            if ( (ret = Handle_Bind(err, buf_len) < 0))
+            if ( (ret = Handle_Bind(pdu, pdu_len, err, buf_len)) < 0)
                 return ret;
 
+            if ( !(sms_state & SMS_BOUNDED))
+                break;      // retrying as a transmitter
+
             Print("Interface bound to SMSC: " + smsc_id);
         } break;
 
@@ -1358,44 +1688,35 @@ int Sms::Process_Incoming(char *err, const size_t buf_len)
 
         case submit_sm_resp:
         {
-            if (Handle_Submit(err, buf_len) < 0)
-                return -1;
+            if ( (ret = Handle_Submit(pdu, pdu_len, err, buf_len)) < 0)
+                return ret;
 
-            Print("Submit Response. Message ID = " + 
-                queued_msg[cmd_rsp.sequence_num].id);
+            u32 slot = queued_msg.Find_Seq(cmd_rsp.sequence_num);
+            if (slot != INFLIGHT_NPOS)
+                Print("Submit Response. Message ID = " + queued_msg.Get(slot).id);
         } break;
 
         case submit_multi_resp:
         {
-            std::cout << "Submit multi response" << std::endl;
-            if (cmd_rsp.command_status != ESME_ROK)
-            {
-                snprintf(err_desc, MAXLINE, "Submit mulit failed with error code: 0x%08X",
-                    cmd_rsp.command_status);
-                return -2;
-            } // end if not cool
+            if ( (ret = Handle_Submit_Multi(pdu, pdu_len, err, buf_len)) < 0)
+                return ret;
 
-            auto it = queued_blk_msg.find(cmd_rsp.sequence_num);
-            if (it != queued_blk_msg.end())
-            {
-                it->second.id = rcv_buffer;
-                it->second.msg_state = MSG_STATE_SUBMIT;
-            } // end if message found
+            Print("Submit multi response.");
         } break;
 
         case deliver_sm:
         {
-            std::string phone_no;
-            if ( (ret = Handle_Deliver(err, buf_len, phone_no)) < 0)
+            std::string_view phone_no;
+            if ( (ret = Handle_Deliver(pdu, pdu_len, err, buf_len, phone_no)) < 0)
                 return ret;
 
-            Print("Delivery confirmation from number: " + phone_no);
+            Print("deliver_sm from number: " + std::string(phone_no));
         } break;
 
         case query_sm_resp:
         {
-            if (Handle_Query(err, buf_len) < 0)
-                return -1;
+            if ( (ret = Handle_Query(pdu, pdu_len, err, buf_len)) < 0)
+                return ret;
 
             Print("Query response.");
         } break;
@@ -1444,42 +1765,47 @@ int Sms::Process_Incoming(char *err, const size_t buf_len)
     } // end switch
 
     return 0;
-} // end Process_Incomming
+} // end Dispatch_Pdu
 
 
 
 //===============================================================================|
 /**
- * @brief Handles the bind_resp signal sent from SMCS.
+ * @brief Handles the bind_resp signal sent from SMCS. When SMSC turns down
+ *  bind_transceiver as unknown we ask again as a plain transmitter, and stay
+ *  unbound until that one is answered.
  * 
+ * @param pdu the bind_*_resp as it sits in the receive ring
+ * @param pdu_len its command_length
  * @param err used to get error codes as a result of this call
  * @param buf_len the length of buffer for storage
  * 
  * @return int 0 on success, -ve on fail. 
  */
-int Sms::Handle_Bind(char *err, const size_t len)
+int Sms::Handle_Bind(const char *pdu, const size_t pdu_len, char *err, const size_t len)
 {
     if (cmd_rsp.command_status != ESME_ROK)
     {
-        if (cmd_rsp.command_status == ESME_RINVCMDID)
+        if (cmd_rsp.command_status == ESME_RINVCMDID && cmd_rsp.command_id == bind_transceiver_resp)
         {
             snprintf(err, len, "SMCS does not support bind_trx.");
-            int ret;
-            if ( (ret = Bind(bind_transmitter)) < 0)
-                return ret;
+            return Bind(bind_transmitter);
         } // end if bind trx fail
-        else 
-        {
-            snprintf(err, len, "Bind failed with error code = 0x%X", 
-                cmd_rsp.command_status);
-            return -2;
-        } // end else bind fail for other reason
+        
+        snprintf(err, len, "Bind failed with error code = 0x%X", 
+            cmd_rsp.command_status);
+        return -2;
     } // end if status not ok
 
-    sms_state |= SMS_BOUNDED;
-    smsc_id = rcv_buffer + sizeof(cmd_rsp);
+    Bind_Resp_Pdu rsp;
+    if (Decode_Bind_Resp(pdu, pdu_len, rsp) < 0)
+    {
+        snprintf(err, len, "Malformed bind response from SMSC.");
+        return -2;
+    } // end if
 
-    // igonre TLV if any
+    sms_state |= SMS_BOUNDED;
+    smsc_id = rsp.system_id;
 
     return 0;
 } // end Handle_Bind
@@ -1512,28 +1838,82 @@ int Sms::Handle_Unbind(char *err, const size_t buf_len)
  *  from the SMCS into the application queue for later tracking and changes the
  *  message state to MSG_STATE_SUBMIT.
  * 
+ * @param pdu the submit_sm_resp as it sits in the receive ring
+ * @param pdu_len its command_length
  * @param err used to get error codes as a result of this call
  * @param buf_len the length of buffer for storage
  * 
  * @return int 0 on success -ve on fail, when -2 the parameter contains a null
  *  terminated string containing the error description.
  */
-int Sms::Handle_Submit(char *err, const size_t buf_len)
+int Sms::Handle_Submit(const char *pdu, const size_t pdu_len, char *err, const size_t buf_len)
 {
-    if (cmd_rsp.command_status == ESME_ROK)
+    u32 slot = queued_msg.Find_Seq(cmd_rsp.sequence_num);
+    if (slot == INFLIGHT_NPOS || queued_msg.Get(slot).msg_state != MSG_STATE_SENT)
+        return 0;       // a late response to something we've already resubmitted
+
+    Single_Sms_Info &info = queued_msg.Get(slot);
+    --in_flight;
+    if (cmd_rsp.command_status == ESME_RTHROTTLED || cmd_rsp.command_status == ESME_RMSGQFUL)
     {
-        auto imsg = queued_msg.find(cmd_rsp.sequence_num);
-        if (imsg != queued_msg.end())
+        // SMSC wants us to back off. The message lets go of its slot and goes
+        //  again after a short while, which isn't counted as a retry; the
+        //  window halves, and grows back by a slot with every other response.
+        window_cap = window_cap > 1 ? window_cap / 2 : 1;
+        ++held;
+        info.msg_state = MSG_STATE_THROTTLED;
+        timers.Cancel(info.timer);
+        info.timer = timers.Schedule(TIMER_KEY(TIMER_THROTTLE, slot), backoff);
+        return 0;
+    } // end if throttled
+
+    if (window_cap < window_size)
+        ++window_cap;
+
+    window_cond.notify_one();
+
+    Submit_Resp_Pdu rsp;
+    if (cmd_rsp.command_status == ESME_ROK && Decode_Submit_Resp(pdu, pdu_len, rsp) == 0)
+    {
+        u32 old;
+        if ( (old = queued_msg.Set_Id(slot, rsp.message_id)) != INFLIGHT_NPOS)
+        {
+            Drop_Stale(old);    // SMSC has given its id out again
+            queued_msg.Set_Id(slot, rsp.message_id);
+        } // end if
+        Report(info, MSG_STATE_SUBMIT);
+        if (info.opts.registered_delivery == 0)
         {
-            imsg->second.id = rcv_buffer + sizeof(cmd_rsp);
-            imsg->second.msg_state = MSG_STATE_SUBMIT;
-        } // end if on queue
+            Forget(slot);       // no receipt is coming for it
+            return 0;
+        } // end if
 
+        u8 early;
+        if (ppeers && (early = ppeers->Claim_Early(rsp.message_id)) != 0)
+        {
+            Forget(slot, early);    // its receipt beat it here, on another bind
+            return 0;
+        } // end if
+
+        // only the id is needed from here on; the receipt should come by the
+        //  time the message expires at SMSC.
+        info.msg_state = MSG_STATE_SUBMIT;
+        info.retries = 0;
+        std::string().swap(info.msg);
+        std::string().swap(info.dst);
+
+        timers.Cancel(info.timer);
+        info.timer = timers.Schedule(TIMER_KEY(TIMER_RECEIPT, slot), 
+            (Validity_Seconds(info.opts.validity_period) + SMPP_DLR_GRACE) * 1000);
         return 0;
     } // end if all is OK
 
-    snprintf(err, buf_len, "Submit failed with code: 0x%08X", 
-        cmd_rsp.command_status);
+    Forget(slot, MSG_STATE_FAILED);     // SMSC turned it down; SmsOut hears it failed
+    if (cmd_rsp.command_status == ESME_ROK)
+        snprintf(err, buf_len, "Malformed submit_sm_resp from SMSC.");
+    else
+        snprintf(err, buf_len, "Submit failed with code: 0x%08X", 
+            cmd_rsp.command_status);
 
     return -2;
 } // end Handle_Submit
@@ -1541,75 +1921,619 @@ int Sms::Handle_Submit(char *err, const size_t buf_len)
 
 
 //===============================================================================|
-int Sms::Handle_Deliver(char *err, const size_t buf_len, std::string &phone_no)
+/**
+ * @brief Handles submit_multi_resp sent from SMSC; frees the window slot of the
+ *  bulk and lets go of it, as receipts aren't tracked for bulks. A bulk sent
+ *  for a row of SmsOut is reported submitted, under the id SMSC gave it, or
+ *  failed.
+ * 
+ * @param pdu the submit_multi_resp as it sits in the receive ring
+ * @param pdu_len its command_length
+ * @param err used to get error codes as a result of this call
+ * @param buf_len the length of buffer for storage
+ * 
+ * @return int 0 on success -ve on fail, when -2 the parameter contains a null
+ *  terminated string containing the error description.
+ */
+int Sms::Handle_Submit_Multi(const char *pdu, const size_t pdu_len, char *err, 
+    const size_t buf_len)
 {
-    u32 payload_length = cmd_rsp.command_length - sizeof(cmd_rsp);
+    auto it = queued_blk_msg.find(cmd_rsp.sequence_num);
+    if (it == queued_blk_msg.end() || it->second.msg_state != MSG_STATE_SENT)
+        return 0;       // late or unknown
+
+    --in_flight;
+    window_cond.notify_one();
+    timers.Cancel(it->second.timer);
+    const u32 row_id = it->second.row_id;
+    queued_blk_msg.erase(it);
+
+    Submit_Resp_Pdu rsp;
+    if (cmd_rsp.command_status == ESME_ROK && Decode_Submit_Multi_Resp(pdu, pdu_len, rsp) == 0)
+    {
+        if (row_id)
+            Update_Out_SMS_DB(row_id, rsp.message_id, MSG_STATE_SUBMIT);
 
+        if (rsp.no_unsuccess > 0)
+        {
+            snprintf(err, buf_len, "Submit multi failed for %u destinations.", 
+                rsp.no_unsuccess);
+            return -2;
+        } // end if some failed
 
-    DeliverQueue dq;
+        return 0;
+    } // end if all is OK
 
-    // now get the source phone no and msg
-    char *alias = rcv_buffer + sizeof(cmd_rsp);
-    alias += strlen(rcv_buffer) + 3;     // skip over the service type, src_npi and
-        //  src_ton
+    if (row_id)
+        Update_Out_SMS_DB(row_id, "", MSG_STATE_FAILED);
 
-    phone_no = alias;  // should be pointing at phone #
-    alias += strlen(alias) + 3; // skip src phone, dest_npi & ton
+    if (cmd_rsp.command_status == ESME_ROK)
+        snprintf(err, buf_len, "Malformed submit_multi_resp from SMSC.");
+    else
+        snprintf(err, buf_len, "Submit multi failed with error code: 0x%08X", 
+            cmd_rsp.command_status);
 
-    alias += strlen(alias) + 10;    // skip over esm_class, protocol_id, priorty_flag,
-        // schedule_delivery_time, validity_period, registered_delivery, replace_if_present_flag,
-        //  data_coding, sm_default_message_id
+    return -2;
+} // end Handle_Submit_Multi
 
-    u8 len = *((u8 *)alias);         // length of message
-    // if (len == 0)
-    // {
-    //     snprintf(err, buf_len, "Driver does not support long message reception.");
-    //     return -2;
-    // } // end if not cool
 
-    std::string msg = ++alias;
-    
-    // find a message id if there is one...
-    alias += len;       // to the start of TLV
 
-    u16 tlv_code = *((u16*)alias);
-    while (tlv_code != RECIEPTED_MESSAGE_ID && (alias - rcv_buffer) < payload_length)
+//===============================================================================|
+/**
+ * @brief Moves the timer wheel up to now and deals with every timeout that has
+ *  come due on the way; see Expire. This is meant to be called periodically
+ *  from the I/O loop, every so often as the wheel's tick or slower.
+ * 
+ * @param err used to get error descriptions as a result of this call
+ * @param buf_len the length of buffer for storage
+ * 
+ * @return int 0 on success, -2 when some messages have been given up on and
+ *  -1 when resubmitting failed on the socket.
+ */
+int Sms::Check_Timeouts(char *err, const size_t buf_len)
+{
+    SMS_LOCK;
+    int ret{0};
+
+    fired.clear();
+    auto now = std::chrono::steady_clock::now();
+    timers.Advance(now, fired);
+    inbound.Expire(now, Store_Inbound);
+    Cork();         // resubmits and queries go out as one batch
+    for (const Timer_Event &event : fired)
+    {
+        // the wheel has let go of these; each must be dealt with here and now
+        int r = Expire(event, err, buf_len);
+        if (r == -1 || (r == -2 && ret == 0))
+            ret = r;
+    } // end for
+
+    if (Uncork() < 0)
+        ret = -1;
+
+    if (!fired.empty())
+        window_cond.notify_all();
+
+    return ret;
+} // end Check_Timeouts
+
+
+
+//===============================================================================|
+/**
+ * @brief Takes in a receipt that came in on another bind, for a message that
+ *  went out on this one; it's acted on just as Receipt would have.
+ * 
+ * @param msg_id the id SMSC gave the message
+ * @param status one of MSG_STATE_*
+ * 
+ * @return int 0 when the message is ours alas -1
+ */
+int Sms::Settle(const std::string_view msg_id, const u8 status)
+{
+    SMS_LOCK;
+    u32 slot;
+    if ( (slot = queued_msg.Find_Id(msg_id)) == INFLIGHT_NPOS)
+        return -1;
+
+    Forget(slot, status);
+    return 0;
+} // end Settle
+
+
+
+//===============================================================================|
+/**
+ * @brief Acts on a single timeout:
+ *  - a submit_sm that went unanswered is sent again, or given up on after
+ *      max_retries
+ *  - a submit_sm that was throttled, or lost with the link, is sent again once
+ *      the window has room; when the link stays down, it's given up on after
+ *      max_retries response timeouts
+ *  - a submit_multi that went unanswered is given up on
+ *  - a message whose receipt is late is asked after with query_sm
+ *  - a message whose query went unanswered is reported expired
+ *  Whatever's given up on, or can't be sent again, is reported failed.
+ * 
+ * @param event the timeout
+ * @param err used to get error descriptions as a result of this call
+ * @param buf_len the length of buffer for storage
+ * 
+ * @return int 0 on success, -2 when a message is given up on and -1 when
+ *  resubmitting failed on the socket.
+ */
+int Sms::Expire(const Timer_Event &event, char *err, const size_t buf_len)
+{
+    const u32 kind = (u32)(event.key >> 32);
+    const u32 ref = (u32)event.key;
+
+    if (kind == TIMER_MULTI)
     {
-        alias += 2;
-        u16 tl = *((u16*)alias);
-        alias += htons(tl) + 2;
-        tlv_code = *((u16*)alias);
-    } // end while looking for RECIPTED_MESSAGE_ID
+        auto it = queued_blk_msg.find(ref);
+        if (it == queued_blk_msg.end() || it->second.timer != event.timer)
+            return 0;
 
-    if (tlv_code == RECIEPTED_MESSAGE_ID)
+        const u32 row_id = it->second.row_id;
+        queued_blk_msg.erase(it);
+        --in_flight;
+        if (row_id)
+            Update_Out_SMS_DB(row_id, "", MSG_STATE_FAILED);
+
+        snprintf(err, buf_len, "submit_multi timed out without response.");
+        return -2;
+    } // end if bulk
+
+    if (!queued_msg.Has(ref) || queued_msg.Get(ref).timer != event.timer)
+        return 0;       // the message has moved on since
+
+    Single_Sms_Info &info = queued_msg.Get(ref);
+    info.timer = 0;
+    switch (kind)
     {
-        alias += 4; // skips T and L and points at V
-        std::string msg_id = alias;
+        case TIMER_SUBMIT:
+        case TIMER_THROTTLE:
+        {
+            if (kind == TIMER_THROTTLE && (sms_state & SMS_BOUNDED) && in_flight >= window_cap)
+            {
+                info.timer = timers.Schedule(TIMER_KEY(TIMER_THROTTLE, ref), backoff);
+                break;
+            } // end if no room yet
 
-        //Update_SMS_DB(msg_id, 4);
-        
-        // now remove item from queue
-        auto it = std::find_if(queued_msg.begin(), queued_msg.end(), [msg_id](const auto &m){
-            return m.second.id == msg_id;
+            if (kind == TIMER_THROTTLE && !(sms_state & SMS_BOUNDED) && info.retries < max_retries)
+            {
+                // the link is down; it's waited for as a response would be
+                ++info.retries;
+                info.timer = timers.Schedule(TIMER_KEY(TIMER_THROTTLE, ref), resp_timeout);
+                break;
+            } // end if not bound yet
+
+            Single_Sms_Info expired = std::move(info);
+            queued_msg.Remove(ref);
+            if (kind == TIMER_SUBMIT)
+                --in_flight;
+            else
+                --held;         // it gave its slot up when it was throttled
+
+            if (kind == TIMER_SUBMIT && expired.retries >= max_retries)
+            {
+                Report(expired, MSG_STATE_FAILED);
+                Leave_Group(expired.group);
+                snprintf(err, buf_len, "Giving up on message to %s after %d retries.", 
+                    expired.dst.c_str(), expired.retries);
+                return -2;
+            } // end if giving up
+
+            if ( !(sms_state & SMS_BOUNDED) || Submit(expired.msg, expired.dst, &expired.opts, 0,
+                expired.group ? &expired.concat : nullptr, expired.row_id) < 0)
+            {
+                Report(expired, MSG_STATE_FAILED);
+                Leave_Group(expired.group);
+                return -1;
+            } // end if
+
+            u32 slot;
+            if ( (slot = queued_msg.Find_Seq(seq_num)) != INFLIGHT_NPOS)
+            {
+                queued_msg.Get(slot).retries = expired.retries + (kind == TIMER_SUBMIT);
+                queued_msg.Get(slot).group = expired.group;
+            } // end if
+        } break;
+
+        case TIMER_RECEIPT:
+        {
+            if (Query(info.id, &info.opts, sms_id) < 0)
+            {
+                Forget(ref, MSG_STATE_EXPIRED);
+                break;
+            } // end if can't ask
+
+            u32 old;
+            if ( (old = queued_msg.Set_Seq(ref, seq_num)) != INFLIGHT_NPOS)
+            {
+                Drop_Stale(old);
+                queued_msg.Set_Seq(ref, seq_num);
+            } // end if
+
+            info.msg_state = MSG_STATE_QUERIED;
+            info.timer = timers.Schedule(TIMER_KEY(TIMER_QUERY, ref), resp_timeout);
+        } break;
+
+        case TIMER_QUERY:
+            Forget(ref, MSG_STATE_EXPIRED);
+            break;
+    } // end switch
+
+    return 0;
+} // end Expire
+
+
+
+//===============================================================================|
+/**
+ * @brief Stops tracking a message; its timeout is disarmed and, when asked
+ *  to, its final state is written to the database.
+ * 
+ * @param slot the message in queued_msg
+ * @param report one of MSG_STATE_*; MSG_STATE_SENT for no report
+ */
+void Sms::Forget(const u32 slot, const u8 report)
+{
+    Single_Sms_Info &info = queued_msg.Get(slot);
+    timers.Cancel(info.timer);
+    if (report != MSG_STATE_SENT)
+        Report(info, report);
+
+    Leave_Group(info.group);
+    queued_msg.Remove(slot);
+} // end Forget
+
+
+
+//===============================================================================|
+/**
+ * @brief Lets go of a message still tracked under a sequence # or id that's
+ *  wanted for another; one of them having come round again. Nothing more will
+ *  be heard of it, so it's reported expired and gives back its window slot.
+ * 
+ * @param slot the message in queued_msg
+ */
+void Sms::Drop_Stale(const u32 slot)
+{
+    const u8 state = queued_msg.Get(slot).msg_state;
+    if (state == MSG_STATE_SENT)
+        --in_flight;
+    else if (state == MSG_STATE_THROTTLED)
+        --held;
+
+    Forget(slot, MSG_STATE_EXPIRED);
+} // end Drop_Stale
+
+
+
+//===============================================================================|
+/**
+ * @brief Puts a message given in UTF-8 into the character set it goes in,
+ *  when its options have the default data_coding; the GSM 7-bit alphabet
+ *  should every character be there, alas UCS-2. Messages under any other
+ *  data_coding are taken to be encoded already and left as they are.
+ * 
+ * @param msg the message; left viewing the encoded text, which lasts until
+ *  the next message is encoded on this thread
+ * @param popt its options
+ * @param coded gets a copy of the options with the data_coding chosen
+ * 
+ * @return Smpp_Options_Ptr the options to send the message with
+ */
+Smpp_Options_Ptr Sms::Encode(std::string_view &msg, const Smpp_Options_Ptr popt,
+    Smpp_Options &coded)
+{
+    thread_local std::string text;
+    if (popt->data_coding != DATA_CODE_DEFAULT)
+        return popt;
+
+    coded = *popt;
+    coded.data_coding = Encode_Text(msg, text);
+    msg = text;
+    return &coded;
+} // end Encode
+
+
+
+//===============================================================================|
+/**
+ * @brief Cuts a message up the way it's going to be sent; see Send_Message.
+ * 
+ * @param msg the message
+ * @param popt its options; the data_coding tells how long a part can be
+ * @param parts gets the parts; room for SMPP_CONCAT_MAX
+ * 
+ * @return size_t the number of parts, 1 for a message sent whole, alas 0 with
+ *  err_desc set when it takes too many
+ */
+size_t Sms::Split(const std::string_view msg, const Smpp_Options_Ptr popt, 
+    std::string_view *parts)
+{
+    if (concat_mode == CONCAT_PAYLOAD)
+    {
+        parts[0] = msg;
+        return 1;
+    } // end if SMSC splits
+
+    size_t count;
+    if ( (count = Segment_Message(msg, popt->data_coding, concat_mode, parts)) == 0)
+    {
+        snprintf(err_desc, MAXLINE, "Message too long for %d parts.", SMPP_CONCAT_MAX);
+        return 0;
+    } // end if
+
+    return count;
+} // end Split
+
+
+
+//===============================================================================|
+/**
+ * @brief Reports a new state for a message; a message of its own straight
+ *  to the database, a part of a long message to the message.
+ * 
+ * @param info the message; in queued_msg or just taken out of it
+ * @param status one of MSG_STATE_*
+ */
+void Sms::Report(const Single_Sms_Info &info, const u8 status)
+{
+    if (info.group)
+        Roll_Up(info.group, info.id, status);
+    else if (info.row_id || !info.id.empty())
+        Update_Out_SMS_DB(info.row_id, info.id, status);
+} // end Report
+
+
+
+//===============================================================================|
+/**
+ * @brief Counts a part's new state towards its long message, reporting the
+ *  message whenever that moves it on; see Concat_Group. Once the message has
+ *  failed or expired, nothing more is heard of it.
+ * 
+ * @param group the long message; 0 is none and does nothing
+ * @param id the id SMSC gave the part, if any
+ * @param status one of MSG_STATE_*
+ */
+void Sms::Roll_Up(const u32 group, const std::string_view id, const u8 status)
+{
+    auto it = groups.find(group);
+    if (it == groups.end())
+        return;
+
+    Concat_Group &g = it->second;
+    if (g.id.empty())
+        g.id = id;
+
+    if (g.state == MSG_STATE_FAILED || g.state == MSG_STATE_EXPIRED)
+        return;
+
+    switch (status)
+    {
+        case MSG_STATE_SUBMIT:
+            if (++g.accepted < g.total)
+                return;
+            break;
+
+        case MSG_STATE_DELIVERED:
+            if (++g.delivered < g.total)
+                return;
+            break;
+
+        case MSG_STATE_FAILED:
+        case MSG_STATE_EXPIRED:
+            break;
+
+        default:
+            return;
+    } // end switch
+
+    g.state = status;
+    if (g.row_id || !g.id.empty())
+        Update_Out_SMS_DB(g.row_id, g.id, status);
+} // end Roll_Up
+
+
+
+//===============================================================================|
+/**
+ * @brief Lets go of parts of a long message; the message goes along with the
+ *  last of them.
+ * 
+ * @param group the long message; 0 is none and does nothing
+ * @param parts how many are let go of
+ */
+void Sms::Leave_Group(const u32 group, const u8 parts)
+{
+    auto it = groups.find(group);
+    if (it == groups.end())
+        return;
+
+    if (it->second.left <= parts)
+        groups.erase(it);
+    else
+        it->second.left -= parts;
+} // end Leave_Group
+
+
+
+//===============================================================================|
+/**
+ * @brief Waits until there is room in the submit window. sms_mutex is released
+ *  while waiting, so the caller must hold it exactly once through lock. Any
+ *  corked submits are written out first; their responses are what we wait on.
+ *  A bind set not to wait (see Set_Wait) only writes them out and carries on.
+ * 
+ * @param lock the caller's lock on sms_mutex
+ * 
+ * @return int 0 when a slot is available, -1 on socket error and -2 when the
+ *  link is no longer bound
+ */
+int Sms::Wait_Window(std::unique_lock<std::recursive_mutex> &lock)
+{
+    if (in_flight + held >= window_cap && Flush() < 0)
+        return -1;
+
+    if (bwait)
+    {
+        window_cond.wait(lock, [this] { 
+            return in_flight + held < window_cap || !(sms_state & SMS_BOUNDED); 
         });
+    } // end if
 
-        if (it != queued_msg.end())
-            queued_msg.erase(it->first);
+    if ( !(sms_state & SMS_BOUNDED))
+    {
+        snprintf(err_desc, MAXLINE, "Not authorized. Please Bind interface first.");
+        return -2;
+    } // end if
 
-        if (Deliver_Rsp() < 0)
+    return 0;
+} // end Wait_Window
+
+
+
+//===============================================================================|
+/**
+ * @brief Handles deliver_sm; either a delivery receipt for one of our messages
+ *  or a message sent to us, which goes on to Receive. Every deliver_sm is
+ *  answered, including the ones we couldn't make sense of, lest SMSC keeps on
+ *  sending it again.
+ * 
+ * @param pdu the deliver_sm as it sits in the receive ring
+ * @param pdu_len its command_length
+ * @param err used to get error codes as a result of this call
+ * @param buf_len the length of buffer for storage
+ * @param phone_no returns the source address; points into pdu
+ * 
+ * @return int 0 on success -ve on fail
+ */
+int Sms::Handle_Deliver(const char *pdu, const size_t pdu_len, char *err, const size_t buf_len, 
+    std::string_view &phone_no)
+{
+    Deliver_Sm_Pdu dlv;
+    if (Decode_Deliver_Sm(pdu, pdu_len, dlv) < 0)
+    {
+        if (Deliver_Rsp(ESME_RINVMSGLEN) == -1)
             return -1;
 
-    } // end if delivery confirmation
+        snprintf(err, buf_len, "Malformed deliver_sm from SMSC.");
+        return -2;
+    } // end if
+
+    phone_no = dlv.source_addr;
+    if ( !(dlv.esm_class & ESM_TYPE_MASK) && dlv.receipted_message_id.empty())
+        Receive(dlv);
     else
-    {
-        
-    } // end else rcvd message
+        Receipt(dlv);
+
+    if (Deliver_Rsp() == -1)
+        return -1;
 
     return 0;
 } // end Handle_Deliver
 
 
 
+//===============================================================================|
+/**
+ * @brief Acts on a delivery receipt. The message it's about and its fate are
+ *  taken from the receipted_message_id and message_state TLV's; SMSC's that
+ *  leave those out have them read from the text of the receipt instead, see
+ *  Parse_Receipt. A receipt that doesn't say otherwise counts as delivered,
+ *  one that says the message is still on its way is let be.
+ * 
+ * @param dlv the deliver_sm
+ */
+void Sms::Receipt(const Deliver_Sm_Pdu &dlv)
+{
+    std::string_view id = dlv.receipted_message_id;
+    u8 state = dlv.message_state;
+
+    Dlr_Text dlr;
+    if ((id.empty() || state == 0) && (dlv.esm_class & ESM_TYPE_MASK) == ESM_SMSC_RECEIPT &&
+        Parse_Receipt(dlv.message_payload.empty() ? dlv.short_message : dlv.message_payload, dlr) == 0)
+    {
+        if (id.empty())
+            id = dlr.id;
+
+        if (state == 0)
+            state = dlr.message_state;
+    } // end if read from the text
+
+    if (id.empty())
+        return;
+
+    u8 status;
+    switch (state)
+    {
+        case SMPP_ENROUTE:
+        case SMPP_ACCEPTED:
+            return;         // the final word is yet to come
+
+        case SMPP_EXPIRED:
+            status = MSG_STATE_EXPIRED;
+            break;
+
+        case SMPP_DELETED:
+        case SMPP_UNDLIVERABLE:
+        case SMPP_UNKOWN:
+        case SMPP_REJECTED:
+            status = MSG_STATE_FAILED;
+            break;
+
+        default:
+            status = MSG_STATE_DELIVERED;
+            break;
+    } // end switch
+
+    // a part of a long message counts towards the message; the rest are
+    //  reported as they come, tracked or not
+    u32 slot;
+    if ( (slot = queued_msg.Find_Id(id)) != INFLIGHT_NPOS)
+        Forget(slot, status);
+    else if (!ppeers || ppeers->Settle(peer_index, id, status) < 0)
+        Update_Out_SMS_DB(0, id, status);
+} // end Receipt
+
+
+
+//===============================================================================|
+/**
+ * @brief Takes in a message sent to us. A whole one is decoded to UTF-8
+ *  straight out of the receive ring and handed over to be stored; a part of a
+ *  long one waits in inbound for the rest, see Reassembly. One whose UDH
+ *  doesn't add up is stored as it came, marked in error.
+ * 
+ * @param dlv the deliver_sm
+ */
+void Sms::Receive(const Deliver_Sm_Pdu &dlv)
+{
+    std::string_view body;
+    Concat_Info concat;
+    if (Decode_User_Data(dlv, body, concat) < 0)
+    {
+        Store_Inbound(dlv.source_addr, dlv.short_message, dlv.data_coding, false);
+        return;
+    } // end if
+
+    if (concat.total > 1)
+    {
+        SMS_LOCK;
+        if (inbound.Add(dlv.source_addr, concat, dlv.data_coding, body, Store_Inbound) < 0)
+            Store_Inbound(dlv.source_addr, body, dlv.data_coding, false);
+
+        return;
+    } // end if a part
+
+    Store_Inbound(dlv.source_addr, body, dlv.data_coding, true);
+} // end Receive
+
+
+
 //===============================================================================|
 /**
  * @brief Sends application specific keep-alive signal every set interval; i.e.
@@ -1633,4 +2557,77 @@ void Heartbeat(Sms *psms)
     } // end if bounded
 
     psms->bheartbeat = false;
-} // end Heartbeat
\ No newline at end of file
+} // end Heartbeat
+
+
+//===============================================================================|
+/**
+ * @brief Works out how long SMSC keeps trying a message from its validity_period;
+ *  given in SMPP's "YYMMDDhhmmsstnnp" format, either relative (p is 'R') or as an
+ *  absolute time nn quarter hours ahead of (p is '+') or behind ('-') UTC. Months
+ *  and years are taken as 30 and 365 days when relative.
+ * 
+ * @param validity the validity_period
+ * 
+ * @return u64 seconds from now; SMPP_DLR_TIMEOUT when not given or unreadable
+ */
+static u64 Validity_Seconds(const std::string &validity)
+{
+    if (validity.length() != 16)
+        return SMPP_DLR_TIMEOUT;
+
+    int f[7];   // YY, MM, DD, hh, mm, ss and nn
+    const int at[7] = {0, 2, 4, 6, 8, 10, 13};
+    for (int i = 0; i < 7; i++)
+    {
+        const char *p = validity.c_str() + at[i];
+        if (!isdigit(p[0]) || !isdigit(p[1]))
+            return SMPP_DLR_TIMEOUT;
+
+        f[i] = (p[0] - '0') * 10 + (p[1] - '0');
+    } // end for
+
+    if (validity[15] == 'R')
+        return (((u64)f[0] * 365 + f[1] * 30 + f[2]) * 24 + f[3]) * 3600 + f[4] * 60 + f[5];
+
+    if (validity[15] != '+' && validity[15] != '-')
+        return SMPP_DLR_TIMEOUT;
+
+    struct tm tm{};
+    tm.tm_year = 100 + f[0];
+    tm.tm_mon = f[1] - 1;
+    tm.tm_mday = f[2];
+    tm.tm_hour = f[3];
+    tm.tm_min = f[4];
+    tm.tm_sec = f[5];
+
+    time_t expires = timegm(&tm);
+    time_t offset = (time_t)f[6] * 900;
+    expires += validity[15] == '+' ? -offset : offset;
+
+    time_t now = time(nullptr);
+    return expires > now ? (u64)(expires - now) : 0;
+} // end Validity_Seconds
+
+
+
+//===============================================================================|
+/**
+ * @brief Decodes a message sent to us into UTF-8 and hands it over to be
+ *  stored; see Write_In_SMS_DB. The text is decoded into a buffer kept per
+ *  thread, so there's no allocating once it's grown to fit.
+ * 
+ * @param source the number that sent it
+ * @param body its text as it came
+ * @param data_coding what the text is in
+ * @param whole false for a long message short of some of its parts, or one
+ *  that came garbled; stored all the same, marked in error
+ */
+static void Store_Inbound(const std::string_view source, const std::string_view body,
+    const u8 data_coding, const bool whole)
+{
+    thread_local std::string text;
+    text.clear();
+    Decode_Text(body, data_coding, text);
+    Write_In_SMS_DB(source, text, whole ? 0 : 1);
+} // end Store_Inbound
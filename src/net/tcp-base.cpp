@@ -46,22 +46,38 @@ TcpBase::TcpBase()
 
 //===============================================================================|
 /**
- * @brief Send's the buffer to peer as tcp streaming data
+ * @brief Send's the buffer to peer as tcp streaming data. The function writes
+ *  as much of the buffer as the socket would take; on a non-blocking socket
+ *  that is full it returns what went out so far (possibly 0) so that the
+ *  callers keep the rest for when the socket is writable again.
  * 
  * @param buffer data to send 
  * @param len length of data in bytes
  * 
- * @return int total bytes sent on success or -1 on error 
+ * @return int total bytes sent on success, which may be short of len or 0 when
+ *  the call would block, and -1 on error 
  */
 int TcpBase::Send(const char *buffer, const size_t len)
 {
-    int total{0};
+    size_t total{0};
     int n;
 
-    while ( (n = send(fds, buffer + total, len - total, 0)) > 0 && ((size_t)total < len))
+    while (total < len)
+    {
+        if ( (n = send(fds, buffer + total, len - total, MSG_NOSIGNAL)) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EWOULDBLOCK || errno == EAGAIN)
+                break;
+
+            return -1;
+        } // end if
+
         total += n;
+    } // end while
 
-    return total;
+    return (int)total;
 } // end Send
 
 
@@ -69,24 +85,33 @@ int TcpBase::Send(const char *buffer, const size_t len)
 //===============================================================================|
 /**
  * @brief retuns a buffer of data from the peer over tcp enabled network. The 
- *  function reads until the number of bytes sent is read or EWOULBLOCK error is
- *  sent by the socket.
+ *  function reads whatever is available up to len bytes; on a non-blocking
+ *  socket that has nothing to offer it returns 0 rather than an error so the
+ *  callers can tell a drained socket from a dead one.
  * 
  * @param buffer space to get data from peer
  * @param len length of sent space in bytes
  * 
- * @return int number of bytes received on success -1 on error
+ * @return int number of bytes received on success, 0 when the call would block
+ *  and -1 on error or when the peer has closed the connection.
  */
 int TcpBase::Recv(char *buffer, const size_t len)
 {
     int n;              // the bytes recieved at one stroke
 
-    if ( (n = recv(fds, buffer, len, MSG_WAITALL)) <= 0)
+    while ( (n = recv(fds, buffer, len, 0)) < 0)
     {
-        if (errno != EWOULDBLOCK)
-            return -1;
+        if (errno == EINTR)
+            continue;
+        if (errno == EWOULDBLOCK || errno == EAGAIN)
+            return 0;
+
+        return -1;
     } // end if
 
+    if (n == 0 && len > 0)
+        return -1;      // orderly shutdown from peer
+
     return n;
 } // end Recv
 
@@ -98,9 +98,14 @@ int TcpClient::Connect(const std::string &hostname, const std::string &port)
         if (connect(fds, p_alias->ai_addr, p_alias->ai_addrlen) == 0)
             return 0;       // success
 
+        CLOSE(fds);         // lest a failed attempt passes for a connection
+        fds = -1;
     } while ( (p_alias = p_alias->ai_next) != NULL);
     
-    // at the end of the day if socket is null
+    // at the end of the day if socket is null; the address goes too, as the
+    //  next attempt looks it up afresh
+    freeaddrinfo(paddr);
+    paddr = nullptr;
     return -1;
 } // end Connect
 
@@ -122,8 +127,9 @@ int TcpClient::Disconnect()
             paddr = nullptr;    // Andre style but with c++11 taste
         } // end if addr
 
+        int ret = CLOSE(fds);
         fds = -1;
-        return CLOSE(fds);
+        return ret;
     } // end closing socket
 
     return 0;
@@ -0,0 +1,283 @@
+/**
+ * @file timer-wheel.cpp
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Implementation details for timer-wheel.h
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "timer-wheel.h"
+
+
+
+
+
+//===============================================================================|
+//          CLASS IMP
+//===============================================================================|
+/**
+ * @brief Construct a new Timer Wheel:: Timer Wheel object; time starts now.
+ *
+ * @param tick_ms the resolution of the wheel in milli-seconds
+ */
+TimerWheel::TimerWheel(const u32 tick_ms)
+    :now_tick{0}, tick_ms{tick_ms > 0 ? tick_ms : 1}, count{0},
+     start{std::chrono::steady_clock::now()}
+{
+    for (u32 &head : buckets)
+        head = WHEEL_NIL;
+} // end Constructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Arms a timer to go off delay_ms from now; rounded up to the next tick
+ *  and capped at what the wheel can hold.
+ *
+ * @param key anything the owner wants back when it goes off
+ * @param delay_ms how long from now
+ *
+ * @return u64 the timer; never 0, so owners may use 0 for none
+ */
+u64 TimerWheel::Schedule(const u64 key, const u64 delay_ms)
+{
+    u32 index;
+    if (!free_list.empty())
+    {
+        index = free_list.back();
+        free_list.pop_back();
+    } // end if reusing
+    else
+    {
+        index = (u32)nodes.size();
+        nodes.emplace_back();
+    } // end else
+
+    // the current tick's bucket has been dealt with already, so the soonest a
+    //  timer can go off is the next tick.
+    u64 ticks = (delay_ms + tick_ms - 1) / tick_ms;
+    const u64 max_ticks = (1ull << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+    ticks = ticks < 1 ? 1 : (ticks > max_ticks ? max_ticks : ticks);
+
+    Node &n = nodes[index];
+    n.key = key;
+    n.expires = now_tick + ticks;
+    Place(index);
+    ++count;
+
+    return ((u64)n.gen << 32) | index;
+} // end Schedule
+
+
+
+//===============================================================================|
+/**
+ * @brief Disarms a timer; one that has gone off or been cancelled already is
+ *  left alone.
+ *
+ * @param timer as returned from Schedule; 0 is ignored
+ */
+void TimerWheel::Cancel(const u64 timer)
+{
+    const u32 index = (u32)timer;
+    if (timer == 0 || index >= nodes.size())
+        return;
+
+    Node &n = nodes[index];
+    if (n.gen != (u32)(timer >> 32) || n.bucket == WHEEL_NIL)
+        return;
+
+    Unlink(index);
+    Release(index);
+} // end Cancel
+
+
+
+//===============================================================================|
+/**
+ * @brief Disarms every timer
+ *
+ */
+void TimerWheel::Clear()
+{
+    for (u32 i = 0; i < (u32)nodes.size(); i++)
+    {
+        if (nodes[i].bucket != WHEEL_NIL)
+        {
+            Unlink(i);
+            Release(i);
+        } // end if armed
+    } // end for
+} // end Clear
+
+
+
+//===============================================================================|
+/**
+ * @brief Moves the wheel up to now and appends every timer that has come due
+ *  on the way to fired. The timers are disarmed before they're handed out, so
+ *  the owner may arm new ones for the same keys while working through them.
+ *
+ * @param now the current time
+ * @param fired where the due timers go
+ *
+ * @return size_t the number of timers that went off
+ */
+size_t TimerWheel::Advance(const std::chrono::steady_clock::time_point now,
+    std::vector<Timer_Event> &fired)
+{
+    const size_t before = fired.size();
+    const u64 target = std::chrono::duration_cast<std::chrono::milliseconds>(
+        now - start).count() / tick_ms;
+
+    while (now_tick < target)
+    {
+        if (count == 0)
+        {
+            now_tick = target;  // nothing to cascade; just catch up
+            break;
+        } // end if idle
+
+        Step(fired);
+    } // end while
+
+    return fired.size() - before;
+} // end Advance
+
+
+
+//===============================================================================|
+/**
+ * @brief Returns the number of armed timers
+ *
+ */
+size_t TimerWheel::Size() const
+{
+    return count;
+} // end Size
+
+
+
+//===============================================================================|
+/**
+ * @brief Files a node in the coarsest level whose span still reaches it. At
+ *  level l the bucket is picked by the l'th group of bits of the due tick; the
+ *  level's bucket comes up when the ticks below it wrap, which is never later
+ *  than the timer is due.
+ *
+ * @param index the node
+ */
+void TimerWheel::Place(const u32 index)
+{
+    Node &n = nodes[index];
+    const u64 delta = n.expires > now_tick ? n.expires - now_tick : 0;
+
+    u32 level{0};
+    while (level < WHEEL_LEVELS - 1 && delta >= (1ull << (WHEEL_BITS * (level + 1))))
+        ++level;
+
+    const u32 bucket = level * WHEEL_SIZE + (u32)((n.expires >> (WHEEL_BITS * level)) & WHEEL_MASK);
+    n.bucket = bucket;
+    n.prev = WHEEL_NIL;
+    n.next = buckets[bucket];
+    if (n.next != WHEEL_NIL)
+        nodes[n.next].prev = index;
+
+    buckets[bucket] = index;
+} // end Place
+
+
+
+//===============================================================================|
+/**
+ * @brief Takes a node out of its bucket's list
+ *
+ * @param index the node
+ */
+void TimerWheel::Unlink(const u32 index)
+{
+    Node &n = nodes[index];
+    if (n.prev != WHEEL_NIL)
+        nodes[n.prev].next = n.next;
+    else
+        buckets[n.bucket] = n.next;
+
+    if (n.next != WHEEL_NIL)
+        nodes[n.next].prev = n.prev;
+
+    n.prev = n.next = n.bucket = WHEEL_NIL;
+} // end Unlink
+
+
+
+//===============================================================================|
+/**
+ * @brief Puts an unlinked node back in the pool; its generation moves on so the
+ *  old handle no longer matches.
+ *
+ * @param index the node
+ */
+void TimerWheel::Release(const u32 index)
+{
+    ++nodes[index].gen;
+    free_list.push_back(index);
+    --count;
+} // end Release
+
+
+
+//===============================================================================|
+/**
+ * @brief Moves time on by a single tick. Whenever the ticks below a level wrap
+ *  around, that level's current bucket is spread over the finer ones; then the
+ *  level 0 bucket for the tick is fired.
+ *
+ * @param fired where the due timers go
+ */
+void TimerWheel::Step(std::vector<Timer_Event> &fired)
+{
+    ++now_tick;
+
+    for (u32 level = 1; level < WHEEL_LEVELS; level++)
+    {
+        if ((now_tick & ((1ull << (WHEEL_BITS * level)) - 1)) != 0)
+            break;      // the level below hasn't wrapped
+
+        const u32 bucket = level * WHEEL_SIZE +
+            (u32)((now_tick >> (WHEEL_BITS * level)) & WHEEL_MASK);
+        u32 index = buckets[bucket];
+        buckets[bucket] = WHEEL_NIL;
+
+        while (index != WHEEL_NIL)
+        {
+            u32 next = nodes[index].next;
+            Place(index);
+            index = next;
+        } // end while cascading
+    } // end for levels
+
+    const u32 bucket = (u32)(now_tick & WHEEL_MASK);
+    u32 index = buckets[bucket];
+    buckets[bucket] = WHEEL_NIL;
+
+    while (index != WHEEL_NIL)
+    {
+        Node &n = nodes[index];
+        u32 next = n.next;
+
+        fired.push_back({n.key, ((u64)n.gen << 32) | index});
+        n.prev = n.next = n.bucket = WHEEL_NIL;
+        Release(index);
+        index = next;
+    } // end while firing
+} // end Step
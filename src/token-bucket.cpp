@@ -0,0 +1,200 @@
+/**
+ * @file token-bucket.cpp
+ * @author Rediet Worku aka Aethiopis II ben Zahab (aethiopis2rises@gmail.com)
+ *
+ * @brief Implementation details for token-bucket.h
+ * @version 0.1
+ * @date 2024-03-06
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+
+
+//===============================================================================|
+//          INCLUDES
+//===============================================================================|
+#include "token-bucket.h"
+
+
+
+
+
+//===============================================================================|
+//          MACROS
+//===============================================================================|
+#define NS_PER_SEC      1'000'000'000ULL
+
+
+
+
+
+//===============================================================================|
+//          FUNCTIONS
+//===============================================================================|
+/**
+ * @brief Returns the current monotonic time in nanoseconds
+ *
+ * @return u64 nanoseconds since some unspecified point
+ */
+static u64 Now_Ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+} // end Now_Ns
+
+
+
+
+
+//===============================================================================|
+//          CLASS IMP
+//===============================================================================|
+/**
+ * @brief Construct a new Token Bucket:: Token Bucket object The bucket starts
+ *  out full.
+ *
+ * @param rate tokens per second; TB_UNLIMITED for no limit
+ * @param burst the most tokens that can be spent at once
+ */
+TokenBucket::TokenBucket(const double rate, const double burst)
+    :rate{TB_UNLIMITED}, burst{1.0}, tokens{0}, last_ns{0}
+{
+    Set_Rate(rate, burst);
+    tokens = this->burst;
+} // end Constructor
+
+
+
+//===============================================================================|
+/**
+ * @brief Changes the rate of the bucket. Whoever is already sleeping on a
+ *  reserved token keeps its deadline; the new rate applies from now on.
+ *
+ * @param rate tokens per second; TB_UNLIMITED for no limit
+ * @param burst the bucket size; 0 picks a tenth of a second's worth of tokens
+ */
+void TokenBucket::Set_Rate(const double rate, const double burst)
+{
+    std::lock_guard<std::mutex> lock(tb_mutex);
+    u64 now = Now_Ns();
+
+    if (this->rate > 0)
+        Refill(now);
+
+    this->rate = (rate < 0 ? TB_UNLIMITED : rate);
+    this->burst = (burst > 0 ? burst : (rate / 10.0 > 1.0 ? rate / 10.0 : 1.0));
+    last_ns = now;
+
+    if (tokens > this->burst)
+        tokens = this->burst;
+} // end Set_Rate
+
+
+
+//===============================================================================|
+/**
+ * @brief Returns the current rate of the bucket
+ *
+ * @return double tokens per second
+ */
+double TokenBucket::Get_Rate() const
+{
+    std::lock_guard<std::mutex> lock(tb_mutex);
+    return rate;
+} // end Get_Rate
+
+
+
+//===============================================================================|
+/**
+ * @brief Returns the size of the bucket
+ *
+ * @return double the most tokens that can be spent in a burst
+ */
+double TokenBucket::Get_Burst() const
+{
+    std::lock_guard<std::mutex> lock(tb_mutex);
+    return burst;
+} // end Get_Burst
+
+
+
+//===============================================================================|
+/**
+ * @brief Takes count tokens out of the bucket, sleeping until they are due if
+ *  the bucket does not have them.
+ *
+ * @param count the tokens to take
+ */
+void TokenBucket::Acquire(const double count)
+{
+    u64 deadline;
+    {
+        std::lock_guard<std::mutex> lock(tb_mutex);
+        if (rate <= 0)
+            return;
+
+        u64 now = Now_Ns();
+        Refill(now);
+
+        tokens -= count;
+        if (tokens >= 0)
+            return;
+
+        // we're in debt; sleep until the debt has been paid off
+        deadline = now + (u64)(-tokens / rate * NS_PER_SEC);
+    } // end lock
+
+    timespec ts;
+    ts.tv_sec = deadline / NS_PER_SEC;
+    ts.tv_nsec = deadline % NS_PER_SEC;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+} // end Acquire
+
+
+
+//===============================================================================|
+/**
+ * @brief Takes count tokens out of the bucket only if they are at hand.
+ *
+ * @param count the tokens to take
+ *
+ * @return true when the tokens are taken, false if the caller must wait
+ */
+bool TokenBucket::Try_Acquire(const double count)
+{
+    std::lock_guard<std::mutex> lock(tb_mutex);
+    if (rate <= 0)
+        return true;
+
+    Refill(Now_Ns());
+    if (tokens < count)
+        return false;
+
+    tokens -= count;
+    return true;
+} // end Try_Acquire
+
+
+
+//===============================================================================|
+/**
+ * @brief Adds the tokens that have dripped in since the last refill. Must be
+ *  called with tb_mutex held.
+ *
+ * @param now_ns the current monotonic time
+ */
+void TokenBucket::Refill(const u64 now_ns)
+{
+    if (now_ns > last_ns)
+    {
+        tokens += (double)(now_ns - last_ns) * rate / NS_PER_SEC;
+        if (tokens > burst)
+            tokens = burst;
+
+        last_ns = now_ns;
+    } // end if
+} // end Refill
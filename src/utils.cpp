@@ -203,26 +203,69 @@ std::string Replace_String(std::string str, const std::string patt, const std::s
  */
 std::string Format_Numerics(const double num)
 {
-    std::ostringstream ostream;
-    ostream << std::setprecision(2) << std::fixed << num;
+    char buf[AMOUNT_BUFFER_SIZE];
+    return std::string(buf, Format_Amount(buf, sizeof(buf), num));
+} // end Format_Numerics
 
-    std::string s{ostream.str()};
-    int pos = s.find(".");
 
-    for (int i = pos - 3; i >= 1; i -= 3)
-    {
-        char t = s[i];
-
-        for (int j = i + 1; j < (int)s.length(); j++)
-        {
-            char k = s[j];
-            s[j] = t;
-            t = k;
-        } // end nested for
 
-        s[i] = ',';
-        s += t;
+//=====================================================================================|
+/**
+ * @brief Writes num as an amount with 2 decimals and its whole part in groups of three;
+ *  e.g. 1,234,567.89. It's rounded as printf's %.2f would, and nothing's allocated, so
+ *  it can go straight into a message being rendered. The buffer isn't terminated.
+ * 
+ * @param buf where the amount goes
+ * @param size the room in buf; AMOUNT_BUFFER_SIZE fits any double
+ * @param num the amount
+ * @param group the separator between groups; 0 for none
+ * @param point the decimal separator
+ * 
+ * @return size_t the length written alas 0 when it doesn't fit
+ */
+size_t Format_Amount(char *buf, const size_t size, const double num, const char group, 
+    const char point)
+{
+    char tmp[AMOUNT_BUFFER_SIZE];
+    std::to_chars_result r = std::to_chars(tmp, tmp + sizeof(tmp), num, std::chars_format::fixed, 2);
+    if (r.ec != std::errc())
+        return 0;
+
+    size_t len = r.ptr - tmp;
+    const char *dot = (const char *)memchr(tmp, '.', len);
+    if (!dot)
+    {
+        // inf or nan; nothing to group
+        if (len > size)
+            return 0;
+
+        iCpy(buf, tmp, len);
+        return len;
+    } // end if
+
+    size_t sign = tmp[0] == '-' ? 1 : 0;
+    size_t digits = dot - tmp - sign;
+    size_t groups = group ? (digits - 1) / 3 : 0;
+    if (len + groups > size)
+        return 0;
+
+    char *p = buf;
+    if (sign)
+        *p++ = '-';
+
+    // the first group takes what's left over from the threes
+    size_t run = digits % 3 ? digits % 3 : 3;
+    const char *d = tmp + sign;
+    for (size_t left = digits; left > 0; left -= run, run = 3)
+    {
+        iCpy(p, d, run);
+        p += run;
+        d += run;
+        if (group && left > run)
+            *p++ = group;
     } // end for
 
-    return s;
-} // end Format_Numerics
\ No newline at end of file
+    *p++ = point;
+    iCpy(p, dot + 1, 2);
+    return p + 2 - buf;
+} // end Format_Amount
\ No newline at end of file
@@ -0,0 +1,293 @@
+//==========================================================================================================|
+// bench-charset.cpp:
+//  checks the SSE2 and AVX2 scans of charset.cpp against the scalar ones over random text, the UCS-2
+//  against iconv's UTF-16BE, the GSM tables against a few known encodings and the decoders against
+//  the encoders; then times converting bill texts, Latin, Amharic and mixed, at each level the cpu has
+//
+// Date Created:
+//  27th of March 2024, Wednesday.
+//
+// Last Updated:
+//  28th of March 2024, Thursday.
+//
+// Program Authors:
+//  Rediet Worku aka Aethiopis II ben Zahab
+//==========================================================================================================|
+
+
+//==========================================================================================================|
+// INCLUDES
+//==========================================================================================================|
+#include "charset.h"
+#include "bench.h"
+#include <iconv.h>
+using namespace std;
+
+
+
+
+//==========================================================================================================|
+// DEFINES
+//==========================================================================================================|
+#define RANDOM_TEXTS        200'000         // per level
+#define ROUNDS              1'000'000       // bodies per timing
+
+
+
+
+//==========================================================================================================|
+// GLOBALS
+//==========================================================================================================|
+static const char *level_names[] = {"scalar", "sse2", "avx2"};
+
+// what random text is made of; mostly plain ASCII as bills are, a few of everything else
+static const char *pieces[] = {
+    "Dear customer, your bill for ", "Birr ", "0123456789", "abcdefghij ", "KLMNOPQRST", "\n", "\r",
+    "@", "$", "`", "{", "}", "[", "]", "~", "^", "|", "\\", "\x0c", "\x7f",
+    "\xc2\xa3", "\xc3\xa9", "\xc3\x84", "\xc3\x9f", "\xce\x94", "\xce\xa3", "\xe2\x82\xac",
+    "\xe1\x8b\x8d\xe1\x8b\xb5", "\xe1\x88\x98\xe1\x88\x8d", "\xf0\x9f\x98\x80", "\xc3\xbf",
+    "\x80", "\xc3", "\xe1\x88", "\xed\xa0\x80", "\xc0\xaf", "\xf4\x90\x80\x80"
+};
+#define PIECES_VALID        31              // the ones before are well formed UTF-8
+
+static const string latin_bill{"Dear Abebe Kebede, your water bill for Megabit 2016 is Birr 1,234.56 "
+    "for 23 m3 read on 12/07/2016. Please pay by 30/07/2016 at any branch. Thank you."};
+static const string amharic_bill{"\xe1\x8b\x8d\xe1\x8b\xb5 \xe1\x8b\xb0\xe1\x8a\x95\xe1\x89\xa0\xe1\x8a\x9b "
+    "\xe1\x8b\xa8\xe1\x88\x98\xe1\x8c\x8b\xe1\x89\xa2\xe1\x89\xb5 \xe1\x8b\x88\xe1\x88\xad \xe1\x8b\xa8"
+    "\xe1\x8b\x8d\xe1\x88\x83 \xe1\x88\x82\xe1\x88\xb3\xe1\x89\xa5 \xe1\x89\xa5\xe1\x88\xad 1,234.56 "
+    "\xe1\x8a\x90\xe1\x8b\x8d\xe1\x8d\xa2"};
+static const string mixed_bill{"Dear Abebe Kebede, \xe1\x8b\x8d\xe1\x8b\xb5 \xe1\x8b\xb0\xe1\x8a\x95"
+    "\xe1\x89\xa0\xe1\x8a\x9b, your water bill for Megabit 2016 is Birr 1,234.56 for 23 m3."};
+static const string euro_bill{"Dear Zoe M\xc3\xbcller, your bill for M\xc3\xa4rz is \xe2\x82\xac"
+    "12.50 [ref 0042]; ~23 m3 read on 12/03. Gr\xc3\xbc\xc3\x9f""e."};
+
+
+
+
+//==========================================================================================================|
+// FUNCTIONS
+//==========================================================================================================|
+/**
+ * @brief Everything the functions of charset.h make of a text, and of that back again
+ */
+typedef struct CONVERTED
+{
+    bool gsm;
+    int septets_len;
+    string septets, ucs2, from_gsm, from_ucs2;
+
+    bool operator==(const CONVERTED &o) const
+    {
+        return gsm == o.gsm && septets_len == o.septets_len && septets == o.septets && ucs2 == o.ucs2 &&
+            from_gsm == o.from_gsm && from_ucs2 == o.from_ucs2;
+    } // end operator==
+} Converted;
+
+
+
+/**
+ * @brief Converts text at the level in use
+ */
+static Converted Convert(const string &text)
+{
+    Converted c;
+    string out(text.size() * 4 + 8, '\0');
+    c.gsm = Is_GSM7(text);
+
+    c.septets_len = Utf8_To_Gsm7(text, &out[0], out.size());
+    c.septets.assign(out, 0, c.septets_len < 0 ? 0 : c.septets_len);
+    c.ucs2.assign(out, 0, Utf8_To_Ucs2(text, &out[0], out.size()));
+
+    Gsm7_To_Utf8(c.septets, c.from_gsm);
+    Ucs2_To_Utf8(c.ucs2, c.from_ucs2);
+    return c;
+} // end Convert
+
+
+
+/**
+ * @brief UTF-16BE by iconv; the reference Utf8_To_Ucs2 is held against
+ */
+static string Iconv_Ucs2(iconv_t cd, const string &text)
+{
+    string out(text.size() * 2 + 8, '\0');
+    char *in = (char *)text.data(), *o = &out[0];
+    size_t in_left = text.size(), out_left = out.size();
+    iconv(cd, nullptr, nullptr, nullptr, nullptr);
+    if (iconv(cd, &in, &in_left, &o, &out_left) == (size_t)-1)
+        return "!iconv";
+
+    out.resize(out.size() - out_left);
+    return out;
+} // end Iconv_Ucs2
+
+
+
+/**
+ * @brief The known encodings
+ *
+ * @return int 0 when they're right alas -1
+ */
+static int Spot_Checks()
+{
+    struct { const char *text; const char *gsm; size_t len; } known[] = {
+        {"@\xc2\xa3$", "\x00\x01\x02", 3},
+        {"\xe2\x82\xac", "\x1b\x65", 2},
+        {"[x]", "\x1b\x3cx\x1b\x3e", 5},
+        {"\xce\x94\xc3\xa0\n", "\x10\x7f\x0a", 3},
+        {"\xc2\xa1\xc2\xbf\xc2\xa7", "\x40\x60\x5f", 3}
+    };
+
+    char out[32];
+    for (auto &k : known)
+    {
+        int len = Utf8_To_Gsm7(k.text, out, sizeof(out));
+        if (len != (int)k.len || memcmp(out, k.gsm, k.len) != 0)
+        {
+            printf("\"%s\" didn't encode as expected\n", k.text);
+            return -1;
+        } // end if
+    } // end for
+
+    if (Is_GSM7("`") || Is_GSM7("\xc3\xbf") || Is_GSM7("\xe1\x8b\x8d") || !Is_GSM7("{}\\"))
+    {
+        printf("Is_GSM7 is off\n");
+        return -1;
+    } // end if
+
+    // the example of 23.038; hellohello packs to nine octets
+    if (Pack_Gsm7("hellohello", 10, out, sizeof(out)) != 9 ||
+        memcmp(out, "\xe8\x32\x9b\xfd\x46\x97\xd9\xec\x37", 9) != 0 ||
+        Pack_Gsm7("hellohello", 10, out, 8) != -1)
+    {
+        printf("Pack_Gsm7 is off\n");
+        return -1;
+    } // end if
+
+    // an escape before a code the extension table hasn't, a double one, and the coding groups
+    string decoded;
+    Gsm7_To_Utf8(string_view{"a\x1b\x41\x1b\x1b\x1b\x65", 7}, decoded);
+    Decode_Text(string_view{"\x00\x41\xd8\x3d\xde\x00\xdc\x00", 8}, DATA_CODE_UCS2, decoded);
+    Decode_Text("\xe9", DATA_CODE_LATIN1, decoded);
+    Decode_Text(string_view{"\x00\xe9", 2}, 0x18, decoded);
+    Decode_Text("\x05", 0xF1, decoded);
+    Decode_Text("\xe9", 0xF4, decoded);
+    if (decoded != "aA \xe2\x82\xac" "A\xf0\x9f\x98\x80\xef\xbf\xbd" "\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9")
+    {
+        printf("decoding is off\n");
+        return -1;
+    } // end if
+
+    string text;
+    if (Encode_Text(latin_bill, text) != DATA_CODE_DEFAULT || text != latin_bill ||
+        Encode_Text(amharic_bill, text) != DATA_CODE_UCS2 || Select_Coding(euro_bill) != DATA_CODE_DEFAULT)
+    {
+        printf("Encode_Text picked the wrong data_coding\n");
+        return -1;
+    } // end if
+
+    return 0;
+} // end Spot_Checks
+
+
+
+/**
+ * @brief Converts every level's worth of random text and holds it to the scalar and iconv
+ *
+ * @return int 0 when they agree alas -1
+ */
+static int Check_Levels(const u8 best)
+{
+    iconv_t cd = iconv_open("UTF-16BE", "UTF-8");
+    u64 rng{88172645463325252ull};
+    size_t iconv_checked{0};
+
+    for (u32 i = 0; i < RANDOM_TEXTS; i++)
+    {
+        string text;
+        bool valid{true};
+        u32 n = 1 + (rng % 48);
+        for (u32 j = 0; j < n; j++)
+        {
+            rng ^= rng << 13;
+            rng ^= rng >> 7;
+            rng ^= rng << 17;
+
+            // mostly ASCII, so the vector loops get long runs
+            u32 k = rng % 8 < 5 ? rng % 7 : (rng >> 8) % (sizeof(pieces) / sizeof(pieces[0]));
+            valid = valid && k < PIECES_VALID;
+            text += pieces[k];
+        } // end for
+
+        Converted result[CHARSET_AVX2 + 1];
+        for (u8 level = CHARSET_SCALAR; level <= best; level++)
+        {
+            Set_Charset_Level(level);
+            result[level] = Convert(text);
+            if ((result[level].septets_len >= 0) != result[level].gsm || !(result[level] == result[0]))
+            {
+                printf("%s and scalar disagree over text %u\n", level_names[level], i);
+                return -1;
+            } // end if
+        } // end for
+
+        // GSM and UCS-2 both come back to the text as it was, when it was good to begin with
+        if (valid && ((result[0].gsm && result[0].from_gsm != text) || result[0].from_ucs2 != text))
+        {
+            printf("text %u didn't come back from GSM or UCS-2 as it was\n", i);
+            return -1;
+        } // end if
+
+        if (valid && cd != (iconv_t)-1)
+        {
+            if (result[0].ucs2 != Iconv_Ucs2(cd, text))
+            {
+                printf("UCS-2 of text %u differs from iconv's\n", i);
+                return -1;
+            } // end if
+
+            iconv_checked++;
+        } // end if
+    } // end for
+
+    if (cd != (iconv_t)-1)
+        iconv_close(cd);
+
+    printf("Levels agree on %d random texts, there and back; %zu of them held to iconv as well\n", RANDOM_TEXTS,
+        iconv_checked);
+    return 0;
+} // end Check_Levels
+
+
+
+/**
+ * @brief Encodes a body ROUNDS times and prints how many go a second
+ */
+static void Time_It(const char *name, const string &body)
+{
+    string out;
+    double secs = Time_Rounds(ROUNDS, [&](u32) { return Encode_Text(body, out) + out.size(); });
+    printf("  %-8s %-10s %8.1f ns/body %8.2f M bodies/s\n", level_names[Get_Charset_Level()], name,
+        secs * 1e9 / ROUNDS, ROUNDS / secs / 1e6);
+} // end Time_It
+
+
+
+int main()
+{
+    const u8 best = Get_Charset_Level();
+    if (Spot_Checks() < 0 || Check_Levels(best) < 0)
+        return 1;
+
+    printf("Encoding bills, %d rounds each:\n", ROUNDS);
+    for (u8 level = CHARSET_SCALAR; level <= best; level++)
+    {
+        Set_Charset_Level(level);
+        Time_It("latin", latin_bill);
+        Time_It("euro", euro_bill);
+        Time_It("amharic", amharic_bill);
+        Time_It("mixed", mixed_bill);
+    } // end for
+
+    return 0;
+} // end main
@@ -0,0 +1,203 @@
+//==========================================================================================================|
+// bench-dlr.cpp:
+//  checks Parse_Receipt over the receipt texts SMSC's are known to send, the spec's own, upper and
+//  mixed case keys, fields out of order or missing, NUL terminated and broken ones; holds it to an
+//  sscanf of the spec's format over random receipts, and then times both
+//
+// Date Created:
+//  29th of March 2024, Friday.
+//
+// Last Updated:
+//  29th of March 2024, Friday.
+//
+// Program Authors:
+//  Rediet Worku aka Aethiopis II ben Zahab
+//==========================================================================================================|
+
+
+//==========================================================================================================|
+// INCLUDES
+//==========================================================================================================|
+#include "smpp-pdu.h"
+#include "bench.h"
+using namespace std;
+
+
+
+
+//==========================================================================================================|
+// DEFINES
+//==========================================================================================================|
+#define RANDOM_RECEIPTS     200'000         // held to sscanf
+#define ROUNDS              5'000'000       // parses per timing
+
+
+
+
+//==========================================================================================================|
+// GLOBALS
+//==========================================================================================================|
+static const char *stats[] = {"DELIVRD", "UNDELIV", "EXPIRED", "REJECTD", "ENROUTE", "ACCEPTD", "DELETED",
+    "UNKNOWN"};
+static const u8 states[] = {SMPP_DELIVERED, SMPP_UNDLIVERABLE, SMPP_EXPIRED, SMPP_REJECTED, SMPP_ENROUTE,
+    SMPP_ACCEPTED, SMPP_DELETED, SMPP_UNKOWN};
+
+static const string spec_receipt{"id:0123456789 sub:001 dlvrd:001 submit date:2403291015 "
+    "done date:2403291016 stat:DELIVRD err:000 text:Dear Abebe Kebede, y"};
+
+
+
+
+//==========================================================================================================|
+// FUNCTIONS
+//==========================================================================================================|
+/**
+ * @brief The receipts SMSC's send, with what they should come to
+ *
+ * @return int 0 when they're right alas -1
+ */
+static int Spot_Checks()
+{
+    struct { string text; int ret; const char *id, *stat, *done, *text_field; u8 state; u16 error; } known[] = {
+        {spec_receipt, 0, "0123456789", "DELIVRD", "2403291016", "Dear Abebe Kebede, y", SMPP_DELIVERED, 0},
+        {"ID:AB12 SUB:001 DLVRD:000 SUBMIT DATE:2403291015 DONE DATE:2403291016 STAT:UNDELIV ERR:034 "
+            "TEXT:hello", 0, "AB12", "UNDELIV", "2403291016", "hello", SMPP_UNDLIVERABLE, 34},
+        {"stat:EXPIRED err:001 Id:77 done date:2403300000", 0, "77", "EXPIRED", "2403300000", "",
+            SMPP_EXPIRED, 1},
+        {"id:9 stat:DELIVERED err:0", 0, "9", "DELIVERED", "", "", SMPP_DELIVERED, 0},
+        {"id:9 stat:REJECTED", 0, "9", "REJECTED", "", "", SMPP_REJECTED, 0},
+        {"id:9 stat:FAILED err:x", 0, "9", "FAILED", "", "", SMPP_UNDLIVERABLE, 0},
+        {"id:9 stat:WHATEVER", 0, "9", "WHATEVER", "", "", 0, 0},
+        {string{"id:42 stat:DELIVRD err:000\0garbage", 33}, 0, "42", "DELIVRD", "", "", SMPP_DELIVERED, 0},
+        {string{"id:42 stat:DELIVRD text:ab\0cd", 29}, 0, "42", "DELIVRD", "", "ab", SMPP_DELIVERED, 0},
+        {"  id:1   foo:bar stat:ACCEPTD  ", 0, "1", "ACCEPTD", "", "", SMPP_ACCEPTED, 0},
+        {"sub:001 dlvrd:001 stat:DELIVRD", -1, "", "DELIVRD", "", "", 0, 0},
+        {"id:1 err:000", -1, "1", "", "", "", 0, 0},
+        {"", -1, "", "", "", "", 0, 0},
+        {"Your message has been delivered", -1, "", "", "", "", 0, 0}
+    };
+
+    Dlr_Text dlr;
+    for (auto &k : known)
+    {
+        int ret = Parse_Receipt(k.text, dlr);
+        if (ret != k.ret || dlr.id != k.id || dlr.stat != k.stat || dlr.done_date != k.done ||
+            dlr.text != k.text_field || (ret == 0 && (dlr.message_state != k.state || dlr.error != k.error)))
+        {
+            printf("\"%s\" didn't parse as expected\n", k.text.c_str());
+            return -1;
+        } // end if
+    } // end for
+
+    return 0;
+} // end Spot_Checks
+
+
+
+/**
+ * @brief The spec's format by sscanf; the way receipts are commonly read
+ *
+ * @return int 0 when it got id and stat alas -1
+ */
+static int Scanf_Receipt(const char *text, char *id, char *stat, char *done, u16 &error)
+{
+    char sub[4], dlvrd[4], submit[16];
+    unsigned err{0};
+    if (sscanf(text, "id:%64s sub:%3s dlvrd:%3s submit date:%15s done date:%15s stat:%7s err:%u", id, sub,
+        dlvrd, submit, done, stat, &err) < 6)
+        return -1;
+
+    error = (u16)err;
+    return 0;
+} // end Scanf_Receipt
+
+
+
+/**
+ * @brief Random receipts in the spec's format
+ */
+static vector<string> Make_Receipts(const u32 count)
+{
+    vector<string> receipts;
+    receipts.reserve(count);
+    u64 rng{88172645463325252ull};
+    char buf[256];
+    for (u32 i = 0; i < count; i++)
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+
+        snprintf(buf, sizeof(buf), "id:%llx sub:001 dlvrd:%03u submit date:24%08u done date:24%08u "
+            "stat:%s err:%03u text:Dear customer, your", (unsigned long long)(rng >> 8), (u32)(rng & 1),
+            (u32)(rng % 100'000'000), (u32)((rng >> 20) % 100'000'000), stats[(rng >> 40) % 8],
+            (u32)((rng >> 48) % 1000));
+        receipts.emplace_back(buf);
+    } // end for
+
+    return receipts;
+} // end Make_Receipts
+
+
+
+/**
+ * @brief Holds Parse_Receipt to sscanf over random receipts
+ *
+ * @return int 0 when they agree alas -1
+ */
+static int Check_Scanf(const vector<string> &receipts)
+{
+    for (size_t i = 0; i < receipts.size(); i++)
+    {
+        char id[65], stat[8], done[16];
+        u16 error{0};
+        Dlr_Text dlr;
+        if (Parse_Receipt(receipts[i], dlr) != 0 || Scanf_Receipt(receipts[i].c_str(), id, stat, done, error) != 0 ||
+            dlr.id != id || dlr.stat != stat || dlr.done_date != done || dlr.error != error)
+        {
+            printf("Parse_Receipt and sscanf disagree over \"%s\"\n", receipts[i].c_str());
+            return -1;
+        } // end if
+
+        size_t k = find(begin(stats), end(stats), dlr.stat) - begin(stats);
+        if (k == 8 || dlr.message_state != states[k])
+        {
+            printf("\"%s\" came to state %u\n", receipts[i].c_str(), dlr.message_state);
+            return -1;
+        } // end if
+    } // end for
+
+    printf("Parse_Receipt agrees with sscanf on %zu random receipts\n", receipts.size());
+    return 0;
+} // end Check_Scanf
+
+
+
+int main()
+{
+    vector<string> receipts = Make_Receipts(RANDOM_RECEIPTS);
+    if (Spot_Checks() < 0 || Check_Scanf(receipts) < 0)
+        return 1;
+
+    printf("Parsing receipts, %d rounds each:\n", ROUNDS);
+
+    Dlr_Text dlr;
+    double secs = Time_Rounds(ROUNDS, [&](u32 i) {
+        Parse_Receipt(receipts[i % RANDOM_RECEIPTS], dlr);
+        return dlr.id.size() + dlr.message_state + dlr.error;
+    });
+
+    printf("  %-14s %8.1f ns/receipt %8.2f M receipts/s\n", "Parse_Receipt", secs * 1e9 / ROUNDS,
+        ROUNDS / secs / 1e6);
+
+    char id[65], stat[8], done[16];
+    u16 error{0};
+    secs = Time_Rounds(ROUNDS, [&](u32 i) {
+        Scanf_Receipt(receipts[i % RANDOM_RECEIPTS].c_str(), id, stat, done, error);
+        return id[0] + stat[0] + error;
+    });
+
+    printf("  %-14s %8.1f ns/receipt %8.2f M receipts/s\n", "sscanf", secs * 1e9 / ROUNDS, ROUNDS / secs / 1e6);
+
+    return 0;
+} // end main
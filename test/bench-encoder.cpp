@@ -0,0 +1,157 @@
+//==========================================================================================================|
+// bench-encoder.cpp:
+//  times the SMPP PDU encoder on the submit path and checks the bytes it puts out
+//
+// Date Created:
+//  12th of March 2024, Tuesday.
+//
+// Last Updated:
+//  12th of March 2024, Tuesday.
+//
+// Program Authors:
+//  Rediet Worku aka Aethiopis II ben Zahab
+//==========================================================================================================|
+
+
+//==========================================================================================================|
+// INCLUDES
+//==========================================================================================================|
+#include "smpp-pdu.h"
+#include "bench.h"
+using namespace std;
+
+
+
+
+//==========================================================================================================|
+// DEFINES
+//==========================================================================================================|
+#define ROUNDS          2'000'000       // encodes per run
+
+
+
+
+//==========================================================================================================|
+// GLOBALS
+//==========================================================================================================|
+static char pdu[SMS_BUFFER_SIZE];       // where the PDUs go
+
+
+
+
+//==========================================================================================================|
+// FUNCTIONS
+//==========================================================================================================|
+/**
+ * @brief Reads a big endian u32 out of buf
+ */
+static u32 Get_U32(const char *buf)
+{
+    u32 n;
+    iCpy(&n, buf, sizeof(n));
+    return ntohl(n);
+} // end Get_U32
+
+
+
+/**
+ * @brief Runs fn ROUNDS times and prints the average time of a round
+ */
+template <typename Fn>
+static void Time_It(const char *name, Fn fn)
+{
+    double ns = Time_Rounds(ROUNDS, fn) * 1e9;
+    printf("  %-36s %8.1f ns/pdu\n", name, ns / ROUNDS);
+} // end Time_It
+
+
+
+/**
+ * @brief Encodes one submit_sm and verifies its layout field by field
+ */
+static int Check_Submit_Sm(const Smpp_Options &opts, const size_t prefix_len, const char *prefix)
+{
+    string msg(160, 'x');
+    iCpy(pdu, prefix, prefix_len);
+    int len = Encode_Submit_Sm(pdu, sizeof(pdu), prefix_len, 7, opts, "0911223344", msg);
+
+    // header + service_type, ton, npi, "8011" + ton, npi, dest + 9 flags and two empty
+    //  times + sm_length + text + user_message_reference
+    int expect = SMPP_HDR_LEN + 3 + 5 + 2 + 11 + 3 + 2 + 4 + 1 + 160 + 6;
+    if (len != expect || Get_U32(pdu) != (u32)len || Get_U32(pdu + 4) != submit_sm ||
+        Get_U32(pdu + 12) != 7 || strcmp(pdu + 19, "8011") != 0 ||
+        strcmp(pdu + 26, "0911223344") != 0 || (u8)pdu[len - 161 - 6] != 160)
+    {
+        printf("submit_sm encoded wrong; length %d, expected %d\n", len, expect);
+        return -1;
+    } // end if
+
+    // over 254 bytes the text must move to message_payload with sm_length 0
+    string big(600, 'y');
+    len = Encode_Submit_Sm(pdu, sizeof(pdu), prefix_len, 8, opts, "0911223344", big);
+    if (len != expect - 161 + 1 + 4 + 600 || pdu[expect - 161 - 6] != 0)
+    {
+        printf("long submit_sm encoded wrong; length %d\n", len);
+        return -1;
+    } // end if
+
+    // and nothing may slip through too long
+    if (Encode_Submit_Sm(pdu, sizeof(pdu), prefix_len, 9, opts, string(21, '9'), msg) != -1)
+    {
+        printf("an over long destination was accepted\n");
+        return -1;
+    } // end if
+
+    return 0;
+} // end Check_Submit_Sm
+
+
+
+int main()
+{
+    Smpp_Options opts;
+    char prefix[Submit_Prefix_Layout::max_len];
+    size_t prefix_len = Encode_Submit_Prefix(prefix, sizeof(prefix), opts, "8011");
+
+    if (prefix_len == 0 || Check_Submit_Sm(opts, prefix_len, prefix) < 0)
+        return 1;
+
+    string sms(160, 'a');
+    string sms_long(600, 'b');
+    string dest{"0911223344"};
+
+    vector<string> dests;
+    std::string_view dest_views[100];
+    for (int i = 0; i < 100; i++)
+    {
+        dests.push_back("09" + to_string(10000000 + i));
+        dest_views[i] = dests.back();
+    } // end for
+
+    printf("SMPP encoder, %d rounds each:\n", ROUNDS);
+    Time_It("submit_sm, 160 chars", [&](u32 i) {
+        iCpy(pdu, prefix, prefix_len);
+        return Encode_Submit_Sm(pdu, sizeof(pdu), prefix_len, i, opts, dest, sms);
+    });
+
+    Time_It("submit_sm, 600 chars as payload", [&](u32 i) {
+        iCpy(pdu, prefix, prefix_len);
+        return Encode_Submit_Sm(pdu, sizeof(pdu), prefix_len, i, opts, dest, sms_long);
+    });
+
+    Time_It("submit_sm, prefix encoded each time", [&](u32 i) {
+        size_t n = Encode_Submit_Prefix(pdu, sizeof(pdu), opts, "8011");
+        return Encode_Submit_Sm(pdu, sizeof(pdu), n, i, opts, dest, sms);
+    });
+
+    Time_It("submit_multi, 100 destinations", [&](u32 i) {
+        iCpy(pdu, prefix, prefix_len);
+        return Encode_Submit_Multi(pdu, sizeof(pdu), prefix_len, i, opts, dest_views, 100, sms);
+    });
+
+    Time_It("query_sm", [&](u32 i) {
+        return Encode_Query_Sm(pdu, sizeof(pdu), i, "0A1B2C3D4E", opts, "8011");
+    });
+
+    return 0;
+} // end main
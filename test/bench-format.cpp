@@ -0,0 +1,155 @@
+//==========================================================================================================|
+// bench-format.cpp:
+//  checks Format_Amount against the ostringstream based Format_Numerics it replaced, over every amount
+//  up to twenty thousand to the cent and a spread of bigger ones, and then times them
+//
+// Date Created:
+//  22nd of March 2024, Friday.
+//
+// Last Updated:
+//  22nd of March 2024, Friday.
+//
+// Program Authors:
+//  Rediet Worku aka Aethiopis II ben Zahab
+//==========================================================================================================|
+
+
+//==========================================================================================================|
+// INCLUDES
+//==========================================================================================================|
+#include "utils.h"
+#include "bench.h"
+#include <cmath>
+using namespace std;
+
+
+
+
+//==========================================================================================================|
+// DEFINES
+//==========================================================================================================|
+#define EXHAUSTIVE_CENTS    2'000'000       // 0.00 through 19,999.99
+#define RANDOM_AMOUNTS      1'000'000       // drawn over 1 to 1e15, either sign
+#define ROUNDS              2'000'000       // formats per timing
+
+
+
+
+//==========================================================================================================|
+// GLOBALS
+//==========================================================================================================|
+int daemon_proc{0};
+SYS_CONFIG sys_config;
+
+
+
+
+//==========================================================================================================|
+// FUNCTIONS
+//==========================================================================================================|
+/**
+ * @brief Format_Numerics as it was; the reference the new one's held against
+ */
+static string Old_Format_Numerics(const double num)
+{
+    std::ostringstream ostream;
+    ostream << std::setprecision(2) << std::fixed << num;
+
+    std::string s{ostream.str()};
+    int pos = s.find(".");
+
+    for (int i = pos - 3; i >= 1; i -= 3)
+    {
+        char t = s[i];
+
+        for (int j = i + 1; j < (int)s.length(); j++)
+        {
+            char k = s[j];
+            s[j] = t;
+            t = k;
+        } // end nested for
+
+        s[i] = ',';
+        s += t;
+    } // end for
+
+    return s;
+} // end Old_Format_Numerics
+
+
+
+/**
+ * @brief Compares the two on num
+ *
+ * @return int 0 when they agree alas -1
+ */
+static int Check(const double num)
+{
+    char buf[AMOUNT_BUFFER_SIZE];
+    string_view now{buf, Format_Amount(buf, sizeof(buf), num)};
+    string then{Old_Format_Numerics(num)};
+
+    // the old one put a comma right after the sign of -123.45 and the like
+    if (then.compare(0, 2, "-,") == 0)
+        then.erase(1, 1);
+
+    if (now != then)
+    {
+        printf("%.17g formatted as \"%.*s\"; expected \"%s\"\n", num, (int)now.size(), now.data(),
+            then.c_str());
+        return -1;
+    } // end if
+
+    return 0;
+} // end Check
+
+
+
+/**
+ * @brief Runs fn ROUNDS times and prints the average time of a round
+ */
+template <typename Fn>
+static void Time_It(const char *name, Fn fn)
+{
+    double ns = Time_Rounds(ROUNDS, fn) * 1e9;
+    printf("  %-36s %8.1f ns/amount\n", name, ns / ROUNDS);
+} // end Time_It
+
+
+
+int main()
+{
+    for (u32 c = 0; c < EXHAUSTIVE_CENTS; c++)
+    {
+        if (Check(c / 100.0) < 0 || Check(-(c / 100.0)) < 0)
+            return 1;
+    } // end for
+
+    u64 rng{88172645463325252ull};
+    for (u32 i = 0; i < RANDOM_AMOUNTS; i++)
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        double num = pow(10.0, (rng % 15000) / 1000.0) * (rng & (1ull << 40) ? -1 : 1);
+        if (Check(num) < 0)
+            return 1;
+    } // end for
+
+    char buf[AMOUNT_BUFFER_SIZE];
+    size_t len = Format_Amount(buf, sizeof(buf), -1234567.891, '.', ',');
+    if (string_view(buf, len) != "-1.234.567,89" || Format_Amount(buf, 5, 1234.5) != 0)
+    {
+        printf("separators or the size check are off\n");
+        return 1;
+    } // end if
+
+    printf("Amounts agree with the old Format_Numerics; %d exhaustive and %d random, both signs\n",
+        EXHAUSTIVE_CENTS, RANDOM_AMOUNTS);
+    printf("Formatting, %d rounds each:\n", ROUNDS);
+    Time_It("old Format_Numerics", [](u32 i) { return Old_Format_Numerics(i * 1.37).size(); });
+    Time_It("Format_Numerics", [](u32 i) { return Format_Numerics(i * 1.37).size(); });
+    Time_It("Format_Amount", [&](u32 i) { return Format_Amount(buf, sizeof(buf), i * 1.37); });
+
+    return 0;
+} // end main
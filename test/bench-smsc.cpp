@@ -0,0 +1,314 @@
+//==========================================================================================================|
+// bench-smsc.cpp:
+//  drives a pool of Sms binds against the local SMSC simulator and reports the throughput along with
+//  the submit to response and submit to receipt latencies; so throughput regressions show up without
+//  an operator, and how throughput goes with the binds
+//
+// Date Created:
+//  18th of March 2024, Monday.
+//
+// Last Updated:
+//  18th of March 2024, Monday.
+//
+// Program Authors:
+//  Rediet Worku aka Aethiopis II ben Zahab
+//==========================================================================================================|
+
+
+//==========================================================================================================|
+// INCLUDES
+//==========================================================================================================|
+#include "sms-pool.h"
+#include "utils.h"
+#include "token-bucket.h"
+#include "smsc-sim.h"
+using namespace std;
+
+
+
+
+//==========================================================================================================|
+// DEFINES
+//==========================================================================================================|
+#define DRAIN_TIMEOUT       30          // s to wait on the last responses and receipts
+#define BULK_DESTS          50          // destinations per submit_multi
+
+
+
+
+//==========================================================================================================|
+// TYPES
+//==========================================================================================================|
+typedef struct SCENARIO
+{
+    const char *name;
+    Sim_Config sim;
+    u32 window;                 // Sms' submit window
+    bool corked;                // send a window's worth at a time as the reactor does
+    u32 bulk;                   // destinations per submit_multi; 0 sends submit_sm's
+    u32 count;                  // messages
+    u32 tx{1};                  // binds that send
+    u32 rx{0};                  // and that take receipts; 0 has the senders take their own
+} Scenario;
+
+
+
+
+//==========================================================================================================|
+// GLOBALS
+//==========================================================================================================|
+int daemon_proc{0};
+SYS_CONFIG sys_config;
+
+static vector<u64> sent_at;         // us, by message #
+static vector<u64> resp_at;
+static vector<u64> dlr_at;
+static atomic<u32> resps{0};
+static atomic<u32> dlrs{0};
+
+
+
+
+//==========================================================================================================|
+// FUNCTIONS
+//==========================================================================================================|
+static u64 Now_Us()
+{
+    return chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+} // end Now_Us
+
+
+
+void Print(const std::string) {}
+
+
+
+/**
+ * @brief Sms reports here what the database would be told. The message_id's the simulator gives
+ *  out are the message #'s; so that's how the times are matched.
+ */
+void Update_Out_SMS_DB(const u32 row_id, const std::string_view msg_id, const u8 status)
+{
+    u64 now = Now_Us();
+    u32 i = (u32)strtoul(std::string{msg_id}.c_str(), nullptr, 10);
+    if (i >= sent_at.size())
+        return;
+
+    if (status == MSG_STATE_SUBMIT && resp_at[i] == 0)
+    {
+        resp_at[i] = now;
+        ++resps;
+    } // end if response
+    else if (status == MSG_STATE_DELIVERED && dlr_at[i] == 0)
+    {
+        dlr_at[i] = now;
+        ++dlrs;
+    } // end else if receipt
+} // end Update_Out_SMS_DB
+
+
+
+/**
+ * @brief Where Sms stores the messages sent to us; the simulator sends none
+ */
+void Write_In_SMS_DB(const std::string_view, const std::string_view, const u8)
+{
+} // end Write_In_SMS_DB
+
+
+
+/**
+ * @brief Prints the p50, p99 and p999 of the gaps between from and to, over the messages that have
+ *  both
+ */
+static void Print_Latency(const char *name, const vector<u64> &from, const vector<u64> &to)
+{
+    vector<u64> gaps;
+    for (size_t i = 0; i < from.size(); i++)
+    {
+        if (from[i] && to[i])
+            gaps.push_back(to[i] - from[i]);
+    } // end for
+
+    if (gaps.empty())
+        return;
+
+    sort(gaps.begin(), gaps.end());
+    auto at = [&](double q) { return gaps[(size_t)(q * (gaps.size() - 1))] / 1000.0; };
+    printf("    %-16s p50 %8.3f ms   p99 %8.3f ms   p999 %8.3f ms   (%zu)\n", name, at(0.5), at(0.99),
+        at(0.999), gaps.size());
+} // end Print_Latency
+
+
+
+/**
+ * @brief Runs one scenario end to end: brings up a simulator and a bound pool with a thread doing the
+ *  reading as the event loop would, sends every message and waits for the last of the responses
+ *  and the receipts.
+ *
+ * @return int 0 on success alas -1
+ */
+static int Run(const Scenario &s)
+{
+    SmscSim sim{s.sim};
+    if (sim.Start() < 0)
+    {
+        printf("  %s: can't start the simulator\n", s.name);
+        return -1;
+    } // end if
+
+    sent_at.assign(s.count, 0);
+    resp_at.assign(s.count, 0);
+    dlr_at.assign(s.count, 0);
+    resps = dlrs = 0;
+
+    SmsPool pool;
+    pool.Open("127.0.0.1", to_string(sim.Get_Port()), "bench", "bench", s.tx, s.rx);
+    pool.Set_Window(s.window);
+    pool.Set_Resp_Timeout(200, 20);     // throttled submits come back quick
+    if (pool.Startup() < (int)pool.Get_Size())
+    {
+        printf("  %s: can't connect to the simulator\n", s.name);
+        return -1;
+    } // end if
+
+    atomic<bool> reading{true};
+    thread reader([&] {
+        char err[MAXLINE];
+        vector<struct pollfd> pfds(pool.Get_Size());
+        while (reading)
+        {
+            for (size_t i = 0; i < pfds.size(); i++)
+                pfds[i] = {pool.Get_Session(i).Get_Connection(), POLLIN, 0};
+
+            if (poll(pfds.data(), pfds.size(), 1) > 0)
+            {
+                for (size_t i = 0; i < pfds.size(); i++)
+                {
+                    if (pfds[i].revents)
+                        pool.Get_Session(i).Process_Incoming(err);
+                } // end for
+            } // end if
+
+            for (size_t i = 0; i < pfds.size(); i++)
+                pool.Get_Session(i).Flush();
+
+            pool.Check_Timeouts(err, MAXLINE);
+        } // end while
+    });
+
+    while (pool.Get_Health().state != POOL_UP)
+        this_thread::sleep_for(chrono::milliseconds(1));
+
+    Smpp_Options opts;
+    string pad(160, 'x');
+    list<string> dests;
+    for (u32 i = 0; i < s.bulk; i++)
+        dests.push_back("09" + to_string(10000000 + i));
+
+    TokenBucket throttle;           // unlimited; as Sender_Thread does it with no rate set
+    u64 start = Now_Us();
+    u32 sent{0};
+    while (sent < s.count)
+    {
+        if (s.corked)
+            pool.Cork();
+
+        // a window's worth at a time on the bind picked, as the reactor does
+        Sms *psms = pool.Pick();
+        u32 room = s.corked && psms->Get_In_Flight() < s.window ? s.window - psms->Get_In_Flight() : 1;
+        for (u32 k = 0; k < room && sent < s.count; k++, sent++)
+        {
+            string msg = "#" + to_string(sent) + " ";
+            msg += pad.substr(msg.size());
+
+            throttle.Acquire();
+            sent_at[sent] = Now_Us();
+            int r = s.bulk ? psms->Send_Bulk_Message(msg, dests, &opts) :
+                psms->Send_Message(msg, "0911223344", &opts);
+            if (r == -1)
+            {
+                printf("  %s: lost the link after %u messages\n", s.name, sent);
+                break;
+            } // end if
+        } // end for
+
+        if (s.corked)
+            pool.Uncork();
+    } // end while
+
+    // wait for the responses, or the failures which the simulator counts, then for the receipts
+    u64 deadline = Now_Us() + DRAIN_TIMEOUT * 1000000ull;
+    while (Now_Us() < deadline && (pool.Get_Health().in_flight > 0 ||
+        (!s.bulk && resps + sim.Get_Stats().failed < s.count)))
+    {
+        this_thread::sleep_for(chrono::microseconds(100));
+    } // end while
+
+    u64 done = Now_Us();
+    for (Sim_Stats st = sim.Get_Stats(); Now_Us() < deadline &&
+        (st.queued > 0 || st.receipts > st.receipt_resps); st = sim.Get_Stats())
+    {
+        this_thread::sleep_for(chrono::microseconds(100));
+    } // end for
+
+    reading = false;
+    reader.join();
+    pool.Shutdown();
+    sim.Stop();
+
+    Sim_Stats st = sim.Get_Stats();
+    u64 msgs = (u64)s.count * (s.bulk ? s.bulk : 1);
+    printf("  %s\n", s.name);
+    printf("    %-16s %10.0f msgs/s   (%" PRIu64 " in %.1f ms; %" PRIu64 " failed, %" PRIu64
+        " throttled, %" PRIu64 " receipts)\n", "throughput", msgs * 1e6 / (done - start), msgs,
+        (done - start) / 1000.0, st.failed, st.throttled, st.receipts);
+    Print_Latency("submit->resp", sent_at, resp_at);
+    Print_Latency("submit->receipt", sent_at, dlr_at);
+    return 0;
+} // end Run
+
+
+
+int main()
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    Sim_Config fast;
+    Sim_Config slow;
+    slow.resp_latency_us = 200;
+    slow.dlr_latency_us = 5000;
+    slow.error_rate = 0.01;
+    slow.throttle_rate = 0.01;
+    Sim_Config tight;
+    tight.window = 50;
+    Sim_Config text_dlr;
+    text_dlr.dlr_tlvs = false;
+    Sim_Config per_bind;            // an operator that caps each bind
+    per_bind.resp_latency_us = 1000;
+    per_bind.window = 10;
+
+    Scenario scenarios[] = {
+        {"submit_sm one at a time, window 10", fast, 10, false, 0, 100'000},
+        {"submit_sm corked, window 100", fast, 100, true, 0, 100'000},
+        {"submit_sm corked, window 100, 200us/5ms, 1% failed, 1% throttled", slow, 100, true, 0,
+            50'000},
+        {"submit_sm corked, window 100 over an SMSC window of 50", tight, 100, true, 0, 50'000},
+        {"submit_sm corked, window 100, receipts in the text alone", text_dlr, 100, true, 0, 100'000},
+        {"submit_multi x50, window 20", fast, 20, false, BULK_DESTS, 2'000},
+        {"submit_sm corked, 1 bind, 1ms and a window of 10 a bind", per_bind, 10, true, 0, 20'000},
+        {"submit_sm corked, 2 binds, 1ms and a window of 10 a bind", per_bind, 10, true, 0, 40'000, 2},
+        {"submit_sm corked, 4 tx + 1 rx, 1ms and a window of 10 a bind", per_bind, 10, true, 0, 80'000,
+            4, 1},
+    };
+
+    printf("Sms against the local SMSC simulator:\n");
+    for (const Scenario &s : scenarios)
+    {
+        if (Run(s) < 0)
+            return 1;
+    } // end for
+
+    return 0;
+} // end main
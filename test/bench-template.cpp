@@ -0,0 +1,128 @@
+//==========================================================================================================|
+// bench-template.cpp:
+//  renders bill messages with the compiled MsgTemplate against the Replace_String chain it replaced,
+//  after checking that it puts out what it should
+//
+// Date Created:
+//  21st of March 2024, Thursday.
+//
+// Last Updated:
+//  21st of March 2024, Thursday.
+//
+// Program Authors:
+//  Rediet Worku aka Aethiopis II ben Zahab
+//==========================================================================================================|
+
+
+//==========================================================================================================|
+// INCLUDES
+//==========================================================================================================|
+#include "msg-template.h"
+#include "utils.h"
+#include "bench.h"
+using namespace std;
+
+
+
+
+//==========================================================================================================|
+// DEFINES
+//==========================================================================================================|
+#define ROWS            1'000'000       // rows rendered per run
+
+#define BILL_FORMAT     "Dear $name, your bill for $period on contract $contractNo is $bill Birr. " \
+                        "Reading $currentReading, consumption $consumption m3. Pay before the end of " \
+                        "$period to avoid disconnection of $cont."
+
+
+
+
+//==========================================================================================================|
+// GLOBALS
+//==========================================================================================================|
+int daemon_proc{0};
+SYS_CONFIG sys_config;
+
+
+
+
+//==========================================================================================================|
+// FUNCTIONS
+//==========================================================================================================|
+/**
+ * @brief Runs fn ROWS times and prints the rate
+ */
+template <typename Fn>
+static void Time_It(const char *name, Fn fn)
+{
+    double s = Time_Rounds(ROWS, fn);
+    printf("  %-36s %10.0f rows/s   %6.1f ns/row\n", name, ROWS / s, s * 1e9 / ROWS);
+} // end Time_It
+
+
+
+int main()
+{
+    MsgTemplate tpl{"$name", "$period", "$contractNo", "$cont", "$bill", "$currentReading",
+        "$consumption"};
+    if (tpl.Compile(BILL_FORMAT) != 8)
+    {
+        printf("template compiled wrong; %zu tokens\n", tpl.Get_Tokens());
+        return 1;
+    } // end if
+
+    tpl.Bind(1, "Megabit 2016");
+
+    string msg;
+    string_view check[] = {"Abebe Kebede", {}, "12345", "12345", "1,234.50", "4411", "17"};
+    tpl.Render(msg, check);
+    if (msg != "Dear Abebe Kebede, your bill for Megabit 2016 on contract 12345 is 1,234.50 Birr. "
+        "Reading 4411, consumption 17 m3. Pay before the end of Megabit 2016 to avoid disconnection "
+        "of 12345.")
+    {
+        printf("template rendered wrong:\n%s\n", msg.c_str());
+        return 1;
+    } // end if
+
+    vector<string> names;
+    for (int i = 0; i < 1024; i++)
+        names.push_back("Customer #" + to_string(i));
+
+    printf("Bill messages, %d rows each:\n", ROWS);
+    Time_It("Replace_String chain", [&](u32 i) {
+        string out{BILL_FORMAT};
+        string cont{to_string(i)};
+        out = Replace_String(out, "$name", names[i & 1023]);
+        out = Replace_String(out, "$period", "Megabit 2016");
+        out = Replace_String(out, "$contractNo", cont);
+        out = Replace_String(out, "$cont", cont);
+        out = Replace_String(out, "$bill", Format_Numerics(i * 0.25));
+        out = Replace_String(out, "$currentReading", to_string(i >> 2));
+        out = Replace_String(out, "$consumption", to_string(i & 63));
+        return out.size();
+    });
+
+    char cont[16], reading[16], consumption[16];
+    char amount[AMOUNT_BUFFER_SIZE];
+    Time_It("MsgTemplate", [&](u32 i) {
+        string_view bill{amount, Format_Amount(amount, sizeof(amount), i * 0.25)};
+        string_view c{cont, (size_t)(to_chars(cont, cont + 16, i).ptr - cont)};
+        string_view values[] = {names[i & 1023], {}, c, c, bill,
+            {reading, (size_t)(to_chars(reading, reading + 16, i >> 2).ptr - reading)},
+            {consumption, (size_t)(to_chars(consumption, consumption + 16, i & 63).ptr - consumption)}};
+        tpl.Render(msg, values);
+        return msg.size();
+    });
+
+    // how much of the above is the amount
+    Time_It("MsgTemplate, amount given", [&](u32 i) {
+        string_view c{cont, (size_t)(to_chars(cont, cont + 16, i).ptr - cont)};
+        string_view values[] = {names[i & 1023], {}, c, c, "1,234.50",
+            {reading, (size_t)(to_chars(reading, reading + 16, i >> 2).ptr - reading)},
+            {consumption, (size_t)(to_chars(consumption, consumption + 16, i & 63).ptr - consumption)}};
+        tpl.Render(msg, values);
+        return msg.size();
+    });
+
+    return 0;
+} // end main
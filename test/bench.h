@@ -0,0 +1,54 @@
+//==========================================================================================================|
+// bench.h:
+//  what the micro benchmarks share; the sink their results go to and the timed loop they run
+//
+// Date Created:
+//  30th of March 2024, Saturday.
+//
+// Last Updated:
+//  30th of March 2024, Saturday.
+//
+// Program Authors:
+//  Rediet Worku aka Aethiopis II ben Zahab
+//==========================================================================================================|
+#ifndef BENCH_H
+#define BENCH_H
+
+
+
+//==========================================================================================================|
+// INCLUDES
+//==========================================================================================================|
+#include "basics.h"
+
+
+
+
+//==========================================================================================================|
+// GLOBALS
+//==========================================================================================================|
+static volatile size_t sink;                // keeps the compiler from dropping the work
+
+
+
+
+//==========================================================================================================|
+// FUNCTIONS
+//==========================================================================================================|
+/**
+ * @brief Runs fn(i) for i from 0 to rounds, adding what it returns to the sink
+ *
+ * @return double the seconds it took
+ */
+template <typename Fn>
+static double Time_Rounds(const u32 rounds, Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (u32 i = 0; i < rounds; i++)
+        sink = sink + fn(i);
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+} // end Time_Rounds
+
+
+#endif
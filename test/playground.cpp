@@ -6,7 +6,7 @@
 //  20th of July 2023, Thursday.
 //
 // Last Updated:
-//  20th of July 2023, Thursday.
+//  18th of March 2024, Monday.
 //
 // Program Authors:
 //  Rediet Worku aka Aethiopis II ben Zahab
@@ -23,6 +23,7 @@ using namespace std;
 #include "sms.h"
 #include "utils.h"
 #include "errors.h"
+#include "smsc-sim.h"
 
 
 
@@ -32,36 +33,95 @@ using namespace std;
 //==========================================================================================================|
 int daemon_proc{0};
 SYS_CONFIG sys_config;      // curses of the black pearl
+static atomic<bool> delivered{false};
 
 
 
 //==========================================================================================================|
 // FUNCTIONS
 //==========================================================================================================|
-int main()
+void Print(const std::string text)
+{
+    cout << text << endl;
+} // end Print
+
+
+
+void Update_Out_SMS_DB(const u32 row_id, const std::string_view msg_id, const u8 status)
 {
-    string sms_ip{"192.168.1.13"};
-    string port{"2775"};
+    cout << "Message " << msg_id << " is now in state " << (int)status << endl;
+    if (status == MSG_STATE_DELIVERED)
+        delivered = true;
+} // end Update_Out_SMS_DB
+
+
+
+void Write_In_SMS_DB(const std::string_view phone_no, const std::string_view msg, const u8 error)
+{
+    cout << "Message from " << phone_no << (error ? " (incomplete)" : "") << ": " << msg << endl;
+} // end Write_In_SMS_DB
+
+
+
+/**
+ * @brief Sends a message through the SMSC at argv[1]:argv[2], or through the local simulator when
+ *  none is given, and waits for its receipt.
+ */
+int main(int argc, char *argv[])
+{
+    string sms_ip{"127.0.0.1"};
+    string port;
     string sys_id{"RedTst"};
     string pwd{"12345"};
 
-    cout << "Connecting to Short Message Service Center (SMCS) ..." << endl;
-    if (Connect_Tcp(sms_ip, port) < 0)
+    Sim_Config config;
+    config.resp_latency_us = 1000;
+    config.dlr_latency_us = 500000;
+    SmscSim sim{config};
+    if (argc > 2)
+    {
+        sms_ip = argv[1];
+        port = argv[2];
+    } // end if
+    else if (sim.Start() < 0)
+        Dump_Err_Exit("can't start the SMSC simulator");
+    else
+        port = to_string(sim.Get_Port());
+
+    cout << "Connecting to Short Message Service Center (SMCS) at " << sms_ip << ":" << port << endl;
+    Sms sms;
+    if (sms.Startup(sms_ip, port, sys_id, pwd) < 0)
         Dump_Err_Exit("connect error");
 
-    cout << "Connected to SMSC." << endl;
-    
-    if (Bind_Trx(sys_id, pwd) < 0)
-        Dump_App_Err("Err");
-
-    int j = 0;
-    while (++j < 100'000'000);
+    atomic<bool> running{true};
+    thread reader([&] {
+        char err[MAXLINE];
+        while (running)
+        {
+            struct pollfd pfd{sms.Get_Connection(), POLLIN, 0};
+            int ret = poll(&pfd, 1, 100) > 0 ? sms.Process_Incoming(err) : 0;
+            if (ret == -2)
+                cout << err << endl;
+            else if (ret < 0)
+                break;
+
+            sms.Check_Timeouts(err, MAXLINE);
+        } // end while
+    });
+
+    for (int i = 0; i < 50 && !(sms.Get_State() & SMS_BOUNDED); i++)
+        this_thread::sleep_for(chrono::milliseconds(100));
 
     cout << "Sending text" << endl;
-    if (Submit("This is a hello message", "0911486301", 1) < 0)
-        Dump_App_Err("Err");
+    if (sms.Send_Message("This is a hello message", "0911486301") < 0)
+        cout << "Err: " << sms.Get_Err() << endl;
+
+    for (int i = 0; i < 100 && !delivered; i++)
+        this_thread::sleep_for(chrono::milliseconds(100));
 
-    while (true);       // wait forever for now...
+    running = false;
+    reader.join();
+    sms.Shutdown();
     return 0;
 } // end main
 
@@ -0,0 +1,579 @@
+//==========================================================================================================|
+// smsc-sim.cpp:
+//  implementation details for smsc-sim.h
+//
+// Date Created:
+//  18th of March 2024, Monday.
+//
+// Last Updated:
+//  18th of March 2024, Monday.
+//
+// Program Authors:
+//  Rediet Worku aka Aethiopis II ben Zahab
+//==========================================================================================================|
+
+
+//==========================================================================================================|
+// INCLUDES
+//==========================================================================================================|
+#include "smsc-sim.h"
+
+
+
+
+//==========================================================================================================|
+// DEFINES
+//==========================================================================================================|
+#define SIM_ESM_RECEIPT     0x04        // esm_class of an SMSC delivery receipt
+#define SIM_POLL_MS         10          // longest nap; how quickly Stop is noticed
+#define SIM_SYSTEM_ID       "SIMSC"
+
+
+
+
+//==========================================================================================================|
+// FUNCTIONS
+//==========================================================================================================|
+/**
+ * @brief Microseconds on the steady clock
+ */
+static u64 Now_Us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+} // end Now_Us
+
+
+
+/**
+ * @brief Reads a big endian u32 out of buf
+ */
+static u32 Get_U32(const char *buf)
+{
+    u32 n;
+    iCpy(&n, buf, sizeof(n));
+    return ntohl(n);
+} // end Get_U32
+
+
+
+/**
+ * @brief A header only PDU; the responses to enquire_link, unbind and such
+ */
+static std::string Header_Pdu(const u32 command_id, const u32 status, const u32 seq)
+{
+    u32 hdr[4] = {htonl(SMPP_HDR_LEN), htonl(command_id), htonl(status), htonl(seq)};
+    return std::string{(const char *)hdr, SMPP_HDR_LEN};
+} // end Header_Pdu
+
+
+
+/**
+ * @brief A response carrying a message_id; bind_*_resp, submit_sm_resp, submit_multi_resp. The latter
+ *  gets an empty unsuccess_sme list.
+ */
+static std::string Id_Resp_Pdu(const u32 command_id, const u32 status, const u32 seq,
+    const std::string_view id)
+{
+    char buf[SMPP_HDR_LEN + 66 + 1];
+    PduWriter w{buf, sizeof(buf)};
+    w.Put_CString(id, 66);
+    if (command_id == submit_multi_resp)
+        w.Put_U8(0);
+
+    int len = w.Finish(command_id, status, seq);
+    return len < 0 ? Header_Pdu(command_id, status, seq) : std::string{buf, (size_t)len};
+} // end Id_Resp_Pdu
+
+
+
+/**
+ * @brief A delivery receipt for message id sent to dest, written the way most SMSC's do it; the
+ *  classic text as well as, with tlvs, the receipted_message_id and message_state TLV's.
+ */
+static std::string Receipt_Pdu(const u32 seq, const std::string_view id, const std::string_view src,
+    const std::string_view dest, const bool tlvs)
+{
+    char text[SMPP_SHORT_MSG_MAX];
+    int n = snprintf(text, sizeof(text), "id:%.*s sub:001 dlvrd:001 submit date:2403180000 "
+        "done date:2403180000 stat:DELIVRD err:000 text:", (int)id.size(), id.data());
+
+    char buf[Deliver_Sm_Layout::max_len + 80];
+    PduWriter w{buf, sizeof(buf)};
+    Deliver_Sm_Layout::Put(w, "", 1, 1, dest, 1, 1, src, SIM_ESM_RECEIPT, 0, 0, "", "", 0, 0, 0, 0,
+        std::string_view{text, (size_t)n});
+
+    if (tlvs)
+    {
+        std::string rid{id};
+        rid.push_back('\0');
+        w.Put_TLV(TLV_RECEIPTED_MESSAGE_ID, rid);
+        w.Put_U16(TLV_MESSAGE_STATE);
+        w.Put_U16(1);
+        w.Put_U8(SMPP_DELIVERED);
+    } // end if
+
+    int len = w.Finish(deliver_sm, ESME_ROK, seq);
+    return len < 0 ? std::string{} : std::string{buf, (size_t)len};
+} // end Receipt_Pdu
+
+
+
+
+//==========================================================================================================|
+// CLASS IMP
+//==========================================================================================================|
+SmscSim::SmscSim(const Sim_Config &config)
+    :config{config}, listen_fd{-1}, port{0}, prunner{nullptr}, running{false}, next_id{1}, next_rx{0},
+     rng{config.seed ? config.seed : 1} {}
+
+
+
+SmscSim::~SmscSim()
+{
+    Stop();
+} // end Destructor
+
+
+
+/**
+ * @brief Listens on 127.0.0.1 and starts serving on a thread of its own
+ *
+ * @return int 0 on success alas -1
+ */
+int SmscSim::Start()
+{
+    if ( (listen_fd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+        return -1;
+
+    int on{1};
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    struct sockaddr_in addr{};
+    socklen_t addr_len = sizeof(addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(config.port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listen_fd, 8) < 0 ||
+        getsockname(listen_fd, (struct sockaddr *)&addr, &addr_len) < 0)
+    {
+        CLOSE(listen_fd);
+        listen_fd = -1;
+        return -1;
+    } // end if
+
+    port = ntohs(addr.sin_port);
+    running = true;
+    prunner = new std::thread(&SmscSim::Run, this);
+    return 0;
+} // end Start
+
+
+
+/**
+ * @brief Stops serving and drops every client
+ */
+void SmscSim::Stop()
+{
+    running = false;
+    if (prunner)
+    {
+        prunner->join();
+        delete prunner;
+        prunner = nullptr;
+    } // end if
+
+    for (Client &c : clients)
+        CLOSE(c.fd);
+
+    clients.clear();
+    if (listen_fd >= 0)
+    {
+        CLOSE(listen_fd);
+        listen_fd = -1;
+    } // end if
+} // end Stop
+
+
+
+u16 SmscSim::Get_Port() const
+{
+    return port;
+} // end Get_Port
+
+
+
+Sim_Stats SmscSim::Get_Stats() const
+{
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return stats;
+} // end Get_Stats
+
+
+
+/**
+ * @brief The simulator's thread; waits on the sockets for no longer than the next due PDU.
+ */
+void SmscSim::Run()
+{
+    std::vector<struct pollfd> fds;
+    while (running)
+    {
+        fds.clear();
+        fds.push_back({listen_fd, POLLIN, 0});
+        for (const Client &c : clients)
+            fds.push_back({c.fd, POLLIN, 0});
+
+        int timeout = SIM_POLL_MS;
+        if (!due.empty())
+        {
+            u64 now = Now_Us();
+            u64 wait = due.top().at > now ? (due.top().at - now + 999) / 1000 : 0;
+            timeout = wait < (u64)timeout ? (int)wait : timeout;
+        } // end if
+
+        if (POLL_TIMEOUT(fds.data(), fds.size(), timeout) < 0 && errno != EINTR)
+            break;
+
+        if (fds[0].revents & POLLIN)
+            Accept();
+
+        for (size_t i = 1; i < fds.size(); i++)
+        {
+            if (fds[i].revents == 0)
+                continue;
+
+            Client *pc = Find(fds[i].fd);
+            if (pc && Read(*pc) < 0)
+            {
+                CLOSE(pc->fd);
+                clients.erase(clients.begin() + (pc - clients.data()));
+            } // end if gone
+        } // end for
+
+        Send_Due(Now_Us());
+        for (Client &c : clients)
+            Write(c);
+    } // end while
+} // end Run
+
+
+
+void SmscSim::Accept()
+{
+    int fd;
+    if ( (fd = accept(listen_fd, nullptr, nullptr)) < 0)
+        return;
+
+    int on{1};
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    clients.push_back(Client{fd});
+} // end Accept
+
+
+
+/**
+ * @brief Takes in what the client has sent and acts on every complete PDU
+ *
+ * @return int 0 while the client is there, -1 once it's gone
+ */
+int SmscSim::Read(Client &c)
+{
+    char buf[65536];
+    int n;
+    while ( (n = recv(c.fd, buf, sizeof(buf), MSG_DONTWAIT)) < 0 && errno == EINTR);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+        return -1;
+
+    if (n > 0)
+        c.in.append(buf, n);
+
+    size_t pos{0};
+    while (c.in.size() - pos >= SMPP_HDR_LEN)
+    {
+        u32 len = Get_U32(c.in.data() + pos);
+        if (len < SMPP_HDR_LEN || len > SMPP_MAX_PDU_LEN)
+            return -1;      // not SMPP
+
+        if (c.in.size() - pos < len)
+            break;
+
+        Handle_Pdu(c, c.in.data() + pos, len);
+        pos += len;
+    } // end while
+
+    c.in.erase(0, pos);
+    return 0;
+} // end Read
+
+
+
+void SmscSim::Handle_Pdu(Client &c, const char *pdu, const u32 len)
+{
+    const u32 command_id = Get_U32(pdu + 4);
+    const u32 seq = Get_U32(pdu + 12);
+
+    switch (command_id)
+    {
+        case bind_transmitter:
+        case bind_receiver:
+        case bind_transceiver:
+        {
+            c.mode = command_id;
+            c.out += Id_Resp_Pdu(command_id | generic_nack, ESME_ROK, seq, SIM_SYSTEM_ID);
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            ++stats.binds;
+        } break;
+
+        case submit_sm:
+        case submit_multi:
+            Handle_Submit(c, pdu, len, command_id, seq);
+            break;
+
+        case enquire_link:
+        {
+            c.out += Header_Pdu(enquire_link_resp, ESME_ROK, seq);
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            ++stats.enquires;
+        } break;
+
+        case unbind:
+            c.mode = 0;
+            c.out += Header_Pdu(unbind_resp, ESME_ROK, seq);
+            break;
+
+        case deliver_sm_resp:
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            ++stats.receipt_resps;
+        } break;
+
+        case enquire_link_resp:
+        case generic_nack:
+            break;
+
+        default:
+            if ( !(command_id & generic_nack))
+                c.out += Header_Pdu(generic_nack, ESME_RINVCMDID, seq);
+    } // end switch
+} // end Handle_Pdu
+
+
+
+/**
+ * @brief Decides the fate of a submit_sm or submit_multi and schedules its response, and the receipts
+ *  when it's accepted and asks for them.
+ */
+void SmscSim::Handle_Submit(Client &c, const char *pdu, const u32 len, const u32 command_id,
+    const u32 seq)
+{
+    const u32 resp_id = command_id | generic_nack;
+    std::string_view service_type, src, dest, sched, validity, text;
+    std::vector<std::string_view> dests;
+    u8 ton, npi, esm, pid, prio, reg, replace, dcs, sm_id;
+
+    PduReader r{pdu, len};
+    r.Get_CString(service_type);
+    r.Get_U8(ton);
+    r.Get_U8(npi);
+    r.Get_CString(src);
+    if (command_id == submit_sm)
+    {
+        r.Get_U8(ton);
+        r.Get_U8(npi);
+        r.Get_CString(dest);
+        dests.push_back(dest);
+    } // end if single
+    else
+    {
+        u8 count, flag;
+        r.Get_U8(count);
+        for (u8 i = 0; i < count && r.Ok(); i++)
+        {
+            r.Get_U8(flag);
+            if (flag != 2)
+            {
+                r.Get_U8(ton);
+                r.Get_U8(npi);
+            } // end if an SME address rather than a list name
+
+            r.Get_CString(dest);
+            dests.push_back(dest);
+        } // end for
+    } // end else
+
+    r.Get_U8(esm);
+    r.Get_U8(pid);
+    r.Get_U8(prio);
+    r.Get_CString(sched);
+    r.Get_CString(validity);
+    r.Get_U8(reg);
+    r.Get_U8(replace);
+    r.Get_U8(dcs);
+    r.Get_U8(sm_id);
+    Pdu_Short_Msg<SMPP_SHORT_MSG_MAX>::Get(r, text);
+
+    while (r.Ok() && r.Remaining() > 0 && text.empty())
+    {
+        u16 tag, tlv_len;
+        std::string_view value;
+        r.Get_U16(tag);
+        r.Get_U16(tlv_len);
+        r.Get_Octets(tlv_len, value);
+        if (tag == TLV_MESSAGE_PAYLOAD)
+            text = value;
+    } // end while looking for message_payload
+
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    ++(command_id == submit_sm ? stats.submits : stats.multis);
+
+    if (!r.Ok() || dests.empty())
+    {
+        c.out += Id_Resp_Pdu(resp_id, ESME_RINVMSGLEN, seq, "");
+        return;
+    } // end if malformed
+
+    // draw the fate; a fraction in [0, 1)
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    const double draw = (rng >> 11) * (1.0 / 9007199254740992.0);
+
+    u32 status{ESME_ROK};
+    if (c.mode == 0 || c.mode == bind_receiver)
+        status = ESME_RINVBNDSTS;
+    else if ((config.window > 0 && c.held >= config.window) || draw < config.throttle_rate)
+        status = ESME_RTHROTTLED;
+    else if (draw < config.throttle_rate + config.error_rate)
+        status = ESME_RSYSERR;
+
+    if (status != ESME_ROK)
+    {
+        if (status == ESME_RTHROTTLED)
+            ++stats.throttled;
+        else
+            ++stats.failed;
+
+        c.out += Id_Resp_Pdu(resp_id, status, seq, "");     // turned away at the door; no waiting
+        return;
+    } // end if not accepted
+
+    std::string id;
+    if (text.size() > 1 && text[0] == '#')
+        id = text.substr(1, text.find(' ') - 1);
+    else
+        id = std::to_string(next_id++);
+
+    const u64 at = Now_Us() + config.resp_latency_us;
+    ++c.held;
+    ++stats.queued;
+    due.push({at, c.fd, true, Id_Resp_Pdu(resp_id, ESME_ROK, seq, id)});
+
+    // a second draw keeps the receipts independent of the fate above
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    if ((reg & REG_DELV_RSRVD) == 0 || (rng >> 11) * (1.0 / 9007199254740992.0) >= config.dlr_rate)
+        return;
+
+    const int rx_fd = Receiver_For(c);
+    Client *prx = Find(rx_fd);
+    for (const std::string_view d : dests)
+    {
+        std::string receipt = Receipt_Pdu(++prx->seq, id, src, d, config.dlr_tlvs);
+        if (receipt.empty())
+            continue;
+
+        ++stats.queued;
+        due.push({at + config.dlr_latency_us, rx_fd, false, std::move(receipt)});
+    } // end for
+} // end Handle_Submit
+
+
+
+/**
+ * @brief Moves every response and receipt that's due onto its client's output
+ */
+void SmscSim::Send_Due(const u64 now)
+{
+    while (!due.empty() && due.top().at <= now)
+    {
+        const Due &d = due.top();
+        Client *pc = Find(d.fd);
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        --stats.queued;
+        if (pc)
+        {
+            pc->out += d.pdu;
+            if (d.is_resp && pc->held > 0)
+                --pc->held;
+            else if (!d.is_resp)
+                ++stats.receipts;
+        } // end if still there
+
+        due.pop();
+    } // end while
+} // end Send_Due
+
+
+
+/**
+ * @brief Writes out whatever's waiting for the client; the socket is blocking, as the peer is local
+ *  and reads on a thread of its own.
+ */
+void SmscSim::Write(Client &c)
+{
+    size_t sent{0};
+    while (sent < c.out.size())
+    {
+        int n;
+        if ( (n = send(c.fd, c.out.data() + sent, c.out.size() - sent, MSG_NOSIGNAL)) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            break;      // gone; the next read finds out
+        } // end if
+
+        sent += n;
+    } // end while
+
+    c.out.clear();
+} // end Write
+
+
+
+/**
+ * @brief Where the receipts for a client's messages go: the client itself unless it's bound as a
+ *  transmitter, alas the receivers and transceivers in turn. With none of those it keeps them, as
+ *  there's nowhere else to send them here.
+ *
+ * @return int the descriptor of the client
+ */
+int SmscSim::Receiver_For(const Client &c)
+{
+    if (c.mode != bind_transmitter)
+        return c.fd;
+
+    for (size_t k = 0; k < clients.size(); k++)
+    {
+        const Client &rx = clients[next_rx++ % clients.size()];
+        if (rx.mode == bind_receiver || rx.mode == bind_transceiver)
+            return rx.fd;
+    } // end for
+
+    return c.fd;
+} // end Receiver_For
+
+
+
+SmscSim::Client *SmscSim::Find(const int fd)
+{
+    for (Client &c : clients)
+    {
+        if (c.fd == fd)
+            return &c;
+    } // end for
+
+    return nullptr;
+} // end Find
@@ -0,0 +1,143 @@
+//==========================================================================================================|
+// smsc-sim.h:
+//  a stand in SMSC for the benchmarks and the playground; it listens on the loopback and speaks
+//  just enough SMPP to keep an Sms busy: bind, submit_sm, submit_multi, enquire_link, unbind and
+//  deliver_sm receipts, with configurable latency, error rates and window. The window is a bind's;
+//  a client may hold many binds, and receipts for a transmitter go to the receivers.
+//
+// Date Created:
+//  18th of March 2024, Monday.
+//
+// Last Updated:
+//  18th of March 2024, Monday.
+//
+// Program Authors:
+//  Rediet Worku aka Aethiopis II ben Zahab
+//==========================================================================================================|
+#ifndef SMSC_SIM_H
+#define SMSC_SIM_H
+
+
+
+//==========================================================================================================|
+// INCLUDES
+//==========================================================================================================|
+#include "smpp-pdu.h"
+
+
+
+
+//==========================================================================================================|
+// TYPES
+//==========================================================================================================|
+/**
+ * @brief How the simulator behaves. The rates are fractions from 0 to 1 and are drawn per submit; a
+ *  submit that's neither failed nor throttled is accepted.
+ */
+typedef struct SIM_CONFIG
+{
+    u16 port{0};                    // 0 picks any free port; see Get_Port
+    u32 resp_latency_us{0};         // from submit to its response
+    u32 dlr_latency_us{0};          // from the response to the receipt
+    double error_rate{0.0};         // submits answered ESME_RSYSERR
+    double throttle_rate{0.0};      // submits answered ESME_RTHROTTLED
+    double dlr_rate{1.0};           // accepted messages asking for a receipt that get one
+    bool dlr_tlvs{true};            // receipts carry receipted_message_id and message_state; the text alone when not
+    u32 window{0};                  // submits held unanswered at a time; more are throttled. 0 is no limit
+    u32 seed{1};                    // for the draws above
+} Sim_Config;
+
+
+
+/**
+ * @brief What the simulator has seen and done so far
+ */
+typedef struct SIM_STATS
+{
+    u64 binds{0};
+    u64 submits{0};                 // submit_sm's
+    u64 multis{0};                  // submit_multi's
+    u64 failed{0};                  // answered ESME_RSYSERR
+    u64 throttled{0};               // answered ESME_RTHROTTLED, by rate or window
+    u64 enquires{0};
+    u64 receipts{0};                // deliver_sm's sent
+    u64 receipt_resps{0};           // deliver_sm_resp's back
+    u64 queued{0};                  // responses and receipts not yet due
+} Sim_Stats;
+
+
+
+
+//==========================================================================================================|
+// CLASS
+//==========================================================================================================|
+/**
+ * @brief Runs on a thread of its own. Responses and receipts are kept on a heap by the time they're
+ *  due and whatever's due is written out in one go per client. The message_id given to a message is
+ *  the tag in front of its text ("#123 ...") when it has one, so a driver can tell which receipt is
+ *  which; otherwise it's a running count.
+ */
+class SmscSim
+{
+public:
+
+    SmscSim(const Sim_Config &config);
+    ~SmscSim();
+
+    SmscSim(const SmscSim &) = delete;
+    SmscSim &operator=(const SmscSim &) = delete;
+
+    int Start();
+    void Stop();
+
+    u16 Get_Port() const;
+    Sim_Stats Get_Stats() const;
+
+private:
+
+    typedef struct CLIENT
+    {
+        int fd;
+        std::string in;             // the stream as it came, framed on command_length
+        std::string out;            // PDUs due to be written
+        u32 seq{0};                 // for our own deliver_sm's
+        u32 held{0};                // submits not yet answered
+        u32 mode{0};                // the bind_* it's bound with; 0 till it is
+    } Client;
+
+    typedef struct DUE
+    {
+        u64 at;                     // us on the steady clock
+        int fd;                     // the client it's for
+        bool is_resp;               // a submit response, as opposed to a receipt
+        std::string pdu;
+        bool operator>(const DUE &d) const { return at > d.at; }
+    } Due;
+
+    void Run();
+    void Accept();
+    int Read(Client &c);
+    void Handle_Pdu(Client &c, const char *pdu, const u32 len);
+    void Handle_Submit(Client &c, const char *pdu, const u32 len, const u32 command_id, const u32 seq);
+    void Send_Due(const u64 now);
+    void Write(Client &c);
+    Client *Find(const int fd);
+    int Receiver_For(const Client &c);
+
+    Sim_Config config;
+    int listen_fd;
+    u16 port;
+    std::thread *prunner;
+    std::atomic<bool> running;
+    std::vector<Client> clients;
+    std::priority_queue<Due, std::vector<Due>, std::greater<Due>> due;
+    u64 next_id;                    // message_id's for untagged messages
+    u32 next_rx;                    // the receiver the next receipt off a transmitter goes to
+    u64 rng;                        // xorshift state for the draws
+
+    mutable std::mutex stats_mutex;
+    Sim_Stats stats;
+};
+
+
+#endif